@@ -0,0 +1,203 @@
+// Benchmark: cross-camera capture skew, free-running capture threads vs
+// --sync-capture (all cameras grab() together, then decode in parallel).
+//
+// Each simulated camera produces frames on its own clock (same rate, its own
+// phase) into a one-frame driver buffer. grab() takes the newest buffered
+// frame, or waits for the next one; retrieve() costs a decode time with
+// jitter. Frames go through CameraStream as in Program 3, and the consumer
+// pairs them with the SkewTracker the engine uses.
+//
+// Reported per mode: paired sets, skew of the capture timestamps the program
+// sees (avg / max / histogram), unmatched frames, and the skew of the true
+// sensor times of the paired frames.
+//
+// Usage: bench_capture_skew [seconds=3] [cameras=2] [fps=30] [decodeMs=8] [toleranceMs=10]
+
+#include "camera_stream.hpp"
+#include "frame_signal.hpp"
+#include "frame_source.hpp"
+#include "frame_sync.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+// Sensor time of every frame handed out, keyed by the pixel value written
+// into it, so the consumer can look up when a frame was really exposed.
+struct SensorLog
+{
+    mutex m;
+    map<uint32_t, clock_type::time_point> times;
+};
+
+class SimCamera : public FrameSource
+{
+public:
+    SimCamera(clock_type::time_point origin, double fps, double phaseMs, double decodeMs, int id, SensorLog& log)
+        : origin(origin),
+          period(chrono::duration_cast<clock_type::duration>(chrono::duration<double>(1.0 / fps))),
+          phase(chrono::duration_cast<clock_type::duration>(chrono::duration<double, milli>(phaseMs))),
+          decodeMs(decodeMs),
+          id(id),
+          rng((unsigned)id * 7919u + 1u),
+          log(log)
+    {
+    }
+
+    bool isOpened() const override { return true; }
+    bool read(Mat& frame) override { return grab() && retrieve(frame); }
+
+    bool grab() override
+    {
+        // Newest frame in the driver buffer, or wait for the next one
+        long long tick = ticksAt(clock_type::now());
+        if (tick <= lastTick)
+        {
+            tick = lastTick + 1;
+            this_thread::sleep_until(timeOf(tick));
+        }
+        lastTick = tick;
+        return true;
+    }
+
+    bool retrieve(Mat& frame) override
+    {
+        uniform_real_distribution<double> jitter(0.5, 1.5);
+        this_thread::sleep_for(chrono::duration<double, milli>(decodeMs * jitter(rng)));
+
+        if (frame.empty()) frame.create(4, 4, CV_8UC3);
+        const uint32_t key = (uint32_t)(id << 24) | (uint32_t)(lastTick & 0xFFFFFF);
+        *(uint32_t*)frame.ptr<uchar>(0) = key;
+        {
+            lock_guard<mutex> lock(log.m);
+            log.times[key] = timeOf(lastTick);
+        }
+        return true;
+    }
+
+    double fps() const override { return 0.0; }
+    string describe() const override { return "sim camera " + to_string(id); }
+
+private:
+    long long ticksAt(clock_type::time_point t) const
+    {
+        return (t - origin - phase) / period;
+    }
+    clock_type::time_point timeOf(long long tick) const { return origin + phase + tick * period; }
+
+    clock_type::time_point origin;
+    clock_type::duration period, phase;
+    double decodeMs;
+    int id;
+    mt19937 rng;
+    SensorLog& log;
+    long long lastTick = -1;
+};
+
+static void runMode(const char* name, bool synced, double seconds, int cameras, double fps, double decodeMs,
+                    double toleranceMs)
+{
+    SensorLog log;
+    CaptureBarrier barrier;
+    FrameSignal signal;
+    const auto origin = clock_type::now();
+
+    vector<unique_ptr<CameraStream>> streams;
+    for (int c = 0; c < cameras; c++)
+    {
+        // Free-running cameras: their own phase, and clocks that drift apart
+        // by 0.2% per camera
+        const double phaseMs = 1000.0 / fps * c / (2 * cameras);
+        const double camFps = fps * (1.0 + 0.002 * c);
+        streams.push_back(make_unique<CameraStream>(
+            make_unique<SimCamera>(origin, camFps, phaseMs, decodeMs, c, log), 3, synced ? &barrier : nullptr));
+        streams.back()->setSignal(&signal);
+    }
+
+    SkewTracker tracker(toleranceMs);
+    tracker.resize(cameras);
+
+    // True sensor skew of each set the tracker pairs: sets complete in order,
+    // so track the sensor times of the frames added since the last set
+    vector<vector<clock_type::time_point>> sensorPending(cameras);
+    double sensorTotal = 0.0, sensorMax = 0.0;
+    uint64_t sensorSets = 0;
+
+    uint64_t seen = 0;
+    const auto end = clock_type::now() + chrono::duration_cast<clock_type::duration>(chrono::duration<double>(seconds));
+    while (clock_type::now() < end)
+    {
+        seen = signal.wait(seen, chrono::milliseconds(50));
+        for (int c = 0; c < cameras; c++)
+        {
+            Mat f;
+            bool isNew = false;
+            clock_type::time_point t;
+            if (!streams[c]->read(f, &isNew, &t) || !isNew) continue;
+
+            const uint64_t before = tracker.stats().sets;
+            tracker.add(c, t);
+
+            clock_type::time_point sensor;
+            {
+                lock_guard<mutex> lock(log.m);
+                sensor = log.times[*(const uint32_t*)f.ptr<uchar>(0)];
+            }
+            sensorPending[c].push_back(sensor);
+
+            if (tracker.stats().sets > before)
+            {
+                // Newest sensor time per camera is the one that completed the set
+                clock_type::time_point lo = clock_type::time_point::max(), hi = clock_type::time_point::min();
+                for (auto& q : sensorPending)
+                {
+                    if (q.empty()) continue;
+                    lo = min(lo, q.back());
+                    hi = max(hi, q.back());
+                    q.clear();
+                }
+                const double ms = chrono::duration<double, milli>(hi - lo).count();
+                sensorTotal += ms;
+                sensorMax = max(sensorMax, ms);
+                sensorSets++;
+            }
+        }
+    }
+    for (auto& s : streams) s->stop();
+
+    const SkewStats s = tracker.stats();
+    printf("%-6s %s\n", name, formatSkewStats(s, toleranceMs).c_str());
+    printf("%-6s sensor-time skew of paired sets: avg %.2f ms, max %.2f ms\n", "",
+           sensorSets ? sensorTotal / sensorSets : 0.0, sensorMax);
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds   = (argc > 1) ? atof(argv[1]) : 3.0;
+    const int    cameras   = (argc > 2) ? max(2, atoi(argv[2])) : 2;
+    const double fps       = (argc > 3) ? atof(argv[3]) : 30.0;
+    const double decodeMs  = (argc > 4) ? atof(argv[4]) : 8.0;
+    const double tolerance = (argc > 5) ? atof(argv[5]) : 10.0;
+
+    cout << "Capture skew benchmark: " << cameras << " simulated cameras at " << fps << " fps, ~" << decodeMs
+         << " ms decode, " << seconds << " s per mode\n";
+    runMode("free", false, seconds, cameras, fps, decodeMs, tolerance);
+    runMode("synced", true, seconds, cameras, fps, decodeMs, tolerance);
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Benchmark: main-loop time per frame with the live window, a decimated
+// preview and --headless.
+//
+// Runs the per-frame work of the programs (motion detection on a synthetic
+// moving scene) followed by the display calls, as fast as it can, and reports
+// the loop time per frame (avg / p99) and what it saves against refreshing
+// the window every frame (imshow + waitKey(1), the original behavior).
+//
+// The GUI modes need a display; without one (no DISPLAY / WAYLAND_DISPLAY,
+// or a MOTION_HEADLESS build) only the headless row is printed.
+//
+// Usage: bench_display_loop [frames=300] [width=1920] [height=1080] [previewFps=10]
+
+#include "display.hpp"
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+struct LoopTimes
+{
+    double avgMs = 0, p99Ms = 0;
+};
+
+static LoopTimes summarize(vector<double> ms)
+{
+    LoopTimes t;
+    if (ms.empty()) return t;
+    double sum = 0;
+    for (double v : ms) sum += v;
+    sort(ms.begin(), ms.end());
+    t.avgMs = sum / ms.size();
+    t.p99Ms = ms[min(ms.size() - 1, (size_t)(ms.size() * 0.99))];
+    return t;
+}
+
+static bool guiAvailable()
+{
+#ifdef MOTION_HEADLESS
+    return false;
+#elif defined(_WIN32) || defined(__APPLE__)
+    return true;
+#else
+    return getenv("DISPLAY") != nullptr || getenv("WAYLAND_DISPLAY") != nullptr;
+#endif
+}
+
+static LoopTimes runLoop(const vector<Mat>& frames, int count, const DisplayOptions& options, DisplayStats& outStats)
+{
+    Display display(options);
+    MotionDetector detector(25, 0.02);
+    detector.reset(frames[0]);
+
+    vector<double> ms;
+    ms.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        const Mat& f = frames[i % frames.size()];
+        auto t0 = clock_type::now();
+
+        detector.process(f);
+        display.show("bench_display_loop", f);
+        display.pollKey();
+
+        ms.push_back(chrono::duration<double, milli>(clock_type::now() - t0).count());
+    }
+    display.closeAll();
+    outStats = display.stats();
+    return summarize(ms);
+}
+
+int main(int argc, char** argv)
+{
+    const int    count   = (argc > 1) ? atoi(argv[1]) : 300;
+    const int    w       = (argc > 2) ? atoi(argv[2]) : 1920;
+    const int    h       = (argc > 3) ? atoi(argv[3]) : 1080;
+    const double preview = (argc > 4) ? atof(argv[4]) : 10.0;
+
+    // A second of frames with a moving block
+    vector<Mat> frames;
+    for (int i = 0; i < 30; i++)
+    {
+        Mat f(h, w, CV_8UC3, Scalar(90, 100, 110));
+        rectangle(f, Rect((i * 41) % (w * 3 / 4), h / 3, w / 8, h / 4), Scalar(40, 40, 200), FILLED);
+        frames.push_back(f);
+    }
+
+    cout << "Display loop benchmark: " << count << " frames, " << w << "x" << h << "\n";
+    printf("%-18s %10s %10s %10s %10s\n", "mode", "avg ms", "p99 ms", "refreshes", "saved ms");
+
+    double baselineMs = -1.0;
+    auto report = [&](const string& name, const DisplayOptions& options) {
+        DisplayStats s;
+        LoopTimes t = runLoop(frames, count, options, s);
+        if (baselineMs < 0.0) baselineMs = t.avgMs;
+        printf("%-18s %10.2f %10.2f %10llu %10.2f\n", name.c_str(), t.avgMs, t.p99Ms,
+               (unsigned long long)s.refreshes, baselineMs - t.avgMs);
+    };
+
+    if (guiAvailable())
+    {
+        DisplayOptions every;
+        report("every frame", every);
+
+        DisplayOptions decimated;
+        decimated.previewFps = preview;
+        char name[32];
+        snprintf(name, sizeof(name), "preview %.0f fps", preview);
+        report(name, decimated);
+    }
+    else
+    {
+        cout << "(no display: GUI modes skipped, saved is relative to headless)\n";
+    }
+
+    DisplayOptions headless;
+    headless.headless = true;
+    report("headless", headless);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Benchmark: aggregate detection throughput of the MotionEngine as cameras
+// and worker threads are added.
+//
+// Each camera is a synthetic reader that hands out pre-rendered frames of a
+// moving block (always "new"), so the numbers are the CPU work of the engine
+// step: recorder hand-off (not recording) and motion detection. For 1, 2, 4
+// and 8 cameras the engine runs with 1 .. N threads (N = hardware threads)
+// and reports frames/s over all cameras and the speedup over one thread.
+//
+// Usage: bench_engine_scaling [steps=200] [width=1280] [height=720] [maxThreads=hardware]
+
+#include "motion_engine.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+// Frames/s over all cameras for one engine configuration
+static double runEngine(const vector<Mat>& frames, int cameras, int threads, int steps)
+{
+    EngineOptions engineOptions;
+    engineOptions.threads = threads;
+    MotionEngine engine(25, 0.02, engineOptions, DetectorOptions(), RecorderOptions(), WriterOptions(), EventOptions());
+
+    for (int c = 0; c < cameras; c++)
+    {
+        // Offset each camera in the clip so they don't all see the same frame
+        size_t next = (size_t)c * 7;
+        engine.addCamera(
+            "Cam" + to_string(c + 1),
+            [&frames, next](Mat& frame, clock_type::time_point& captureTime, bool& isNew) mutable {
+                frame = frames[next++ % frames.size()];
+                captureTime = clock_type::now();
+                isNew = true;
+                return true;
+            },
+            []() { return string(); });
+    }
+
+    // Warm-up step builds the detector buffers, then the baselines
+    engine.step(false, 0);
+    engine.resetDetectors();
+
+    auto t0 = clock_type::now();
+    for (int i = 0; i < steps; i++) engine.step(true, 1);
+    double sec = chrono::duration<double>(clock_type::now() - t0).count();
+
+    engine.stop();
+    return (sec > 0.0) ? (double)cameras * steps / sec : 0.0;
+}
+
+int main(int argc, char** argv)
+{
+    const int steps = (argc > 1) ? atoi(argv[1]) : 200;
+    const int w     = (argc > 2) ? atoi(argv[2]) : 1280;
+    const int h     = (argc > 3) ? atoi(argv[3]) : 720;
+    const int cores = (int)max(1u, thread::hardware_concurrency());
+    const int maxThreads = (argc > 4) ? max(1, atoi(argv[4])) : cores;
+
+    // A second of frames with a moving block
+    vector<Mat> frames;
+    for (int i = 0; i < 30; i++)
+    {
+        Mat f(h, w, CV_8UC3, Scalar(90, 100, 110));
+        rectangle(f, Rect((i * 41) % (w * 3 / 4), h / 3, w / 8, h / 4), Scalar(40, 40, 200), FILLED);
+        frames.push_back(f);
+    }
+
+    cout << "Engine scaling benchmark: " << steps << " steps, " << w << "x" << h << ", " << cores
+         << " hardware thread(s)\n";
+    printf("%-8s %-8s %12s %12s %10s\n", "cameras", "threads", "frames/s", "ms/step", "speedup");
+
+    const int cameraCounts[] = { 1, 2, 4, 8 };
+    for (int cameras : cameraCounts)
+    {
+        double single = 0.0;
+        for (int threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            double fps = runEngine(frames, cameras, threads, steps);
+            if (threads == 1) single = fps;
+            printf("%-8d %-8d %12.1f %12.2f %9.2fx\n", cameras, threads, fps,
+                   (fps > 0.0) ? 1000.0 * cameras / fps : 0.0, (single > 0.0) ? fps / single : 0.0);
+
+            // Also try the exact core count when it isn't a power of two
+            if (threads < maxThreads && threads * 2 > maxThreads)
+            {
+                fps = runEngine(frames, cameras, maxThreads, steps);
+                printf("%-8d %-8d %12.1f %12.2f %9.2fx\n", cameras, maxThreads, fps,
+                       (fps > 0.0) ? 1000.0 * cameras / fps : 0.0, (single > 0.0) ? fps / single : 0.0);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+// Benchmark: CameraStream frame hand-off, old mutex + copyTo() mailbox vs FrameRing.
+//
+// A synthetic "camera" thread produces 1080p BGR frames at a fixed rate; the
+// consumer polls like Program 3's main loop does (read, ~1 ms of work, repeat).
+// For each hand-off strategy we report capture-to-consume latency of every new
+// frame the consumer sees, plus full-frame copies per consumed frame.
+//
+// Usage: bench_frame_ring [seconds=5] [fps=60] [width=1920] [height=1080]
+
+#include "frame_ring.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+// ------------------------------------------------------------
+// The pre-ring hand-off, reproduced as it was in Program 3
+// ------------------------------------------------------------
+class LegacyMailbox
+{
+public:
+    void publish(const Mat& tmp, clock_type::time_point t)
+    {
+        lock_guard<mutex> lk(mtx);
+        frame = tmp;
+        captureTime = t;
+        seq++;
+    }
+
+    bool read(Mat& out, uint64_t& outSeq, clock_type::time_point& outTime)
+    {
+        lock_guard<mutex> lk(mtx);
+        if (frame.empty()) return false;
+        frame.copyTo(out);
+        copies++;
+        outSeq = seq;
+        outTime = captureTime;
+        return true;
+    }
+
+    uint64_t copies = 0;
+
+private:
+    mutex mtx;
+    Mat frame;
+    uint64_t seq = 0;
+    clock_type::time_point captureTime{};
+};
+
+struct Result
+{
+    vector<double> latencyUs;
+    uint64_t produced = 0;
+    uint64_t consumed = 0;
+    uint64_t copies = 0;
+    uint64_t reads = 0;
+};
+
+// Stand-in for cap.read(): the driver writes every byte of the frame.
+static void fillFrame(Mat& frame, int w, int h, uint64_t seq)
+{
+    frame.create(h, w, CV_8UC3);
+    frame.setTo(Scalar((double)(seq & 0xFF), 64, 128));
+}
+
+static double percentile(vector<double> v, double p)
+{
+    if (v.empty()) return 0.0;
+    sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (double)(v.size() - 1));
+    return v[i];
+}
+
+static void report(const string& name, const Result& r, int w, int h)
+{
+    double mean = 0.0;
+    for (double x : r.latencyUs) mean += x;
+    if (!r.latencyUs.empty()) mean /= (double)r.latencyUs.size();
+
+    double copiesPerFrame = r.consumed ? (double)r.copies / (double)r.consumed : 0.0;
+    double mbCopied = (double)r.copies * (double)w * (double)h * 3.0 / (1024.0 * 1024.0);
+
+    printf("%-8s produced=%6llu consumed=%6llu reads=%7llu  latency us: mean=%8.1f p50=%8.1f p99=%8.1f max=%8.1f  copies/frame=%5.2f (%.0f MB copied)\n",
+           name.c_str(),
+           (unsigned long long)r.produced, (unsigned long long)r.consumed, (unsigned long long)r.reads,
+           mean, percentile(r.latencyUs, 0.50), percentile(r.latencyUs, 0.99), percentile(r.latencyUs, 1.0),
+           copiesPerFrame, mbCopied);
+}
+
+// ------------------------------------------------------------
+// Runs
+// ------------------------------------------------------------
+static Result runLegacy(double seconds, double fps, int w, int h)
+{
+    LegacyMailbox box;
+    atomic<bool> running{true};
+    atomic<uint64_t> produced{0};
+
+    thread producer([&] {
+        auto period = chrono::duration<double>(1.0 / fps);
+        auto next = clock_type::now();
+        uint64_t seq = 0;
+        while (running)
+        {
+            Mat tmp; // fresh allocation per frame, like the old capture loop
+            fillFrame(tmp, w, h, ++seq);
+            box.publish(tmp, clock_type::now());
+            produced++;
+            next += chrono::duration_cast<clock_type::duration>(period);
+            this_thread::sleep_until(next);
+        }
+    });
+
+    Result r;
+    Mat out;
+    uint64_t lastSeq = 0;
+    auto end = clock_type::now() + chrono::duration_cast<clock_type::duration>(chrono::duration<double>(seconds));
+    while (clock_type::now() < end)
+    {
+        uint64_t seq = 0;
+        clock_type::time_point t;
+        if (box.read(out, seq, t))
+        {
+            r.reads++;
+            if (seq != lastSeq)
+            {
+                r.latencyUs.push_back(chrono::duration<double, micro>(clock_type::now() - t).count());
+                r.consumed++;
+                lastSeq = seq;
+            }
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    running = false;
+    producer.join();
+    r.produced = produced;
+    r.copies = box.copies;
+    return r;
+}
+
+static Result runRing(double seconds, double fps, int w, int h, int slots)
+{
+    FrameRing ring(slots);
+    atomic<bool> running{true};
+    atomic<uint64_t> produced{0};
+
+    thread producer([&] {
+        auto period = chrono::duration<double>(1.0 / fps);
+        auto next = clock_type::now();
+        uint64_t seq = 0;
+        while (running)
+        {
+            fillFrame(ring.writeBuffer(), w, h, ++seq);
+            ring.publish(clock_type::now());
+            produced++;
+            next += chrono::duration_cast<clock_type::duration>(period);
+            this_thread::sleep_until(next);
+        }
+    });
+
+    Result r;
+    uint64_t lastSeq = 0;
+    auto end = clock_type::now() + chrono::duration_cast<clock_type::duration>(chrono::duration<double>(seconds));
+    while (clock_type::now() < end)
+    {
+        const FrameSlot* slot = ring.acquireLatest();
+        if (slot)
+        {
+            r.reads++;
+            if (slot->seq != lastSeq)
+            {
+                r.latencyUs.push_back(chrono::duration<double, micro>(clock_type::now() - slot->captureTime).count());
+                r.consumed++;
+                lastSeq = slot->seq;
+            }
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    ring.release();
+
+    running = false;
+    producer.join();
+    r.produced = produced;
+    r.copies = 0;
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 5.0;
+    double fps     = (argc > 2) ? atof(argv[2]) : 60.0;
+    int w          = (argc > 3) ? atoi(argv[3]) : 1920;
+    int h          = (argc > 4) ? atoi(argv[4]) : 1080;
+
+    cout << "Frame hand-off benchmark: " << w << "x" << h << " BGR @ " << fps
+         << " fps for " << seconds << " s per run\n";
+
+    report("mutex", runLegacy(seconds, fps, w, h), w, h);
+    report("ring3", runRing(seconds, fps, w, h, 3), w, h);
+    report("ring4", runRing(seconds, fps, w, h, 4), w, h);
+
+    return 0;
+}
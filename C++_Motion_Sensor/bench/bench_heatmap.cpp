@@ -0,0 +1,155 @@
+// Benchmark: what the per-tile heatmap (--heatmap) adds to detection.
+//
+// Runs MotionDetector with and without a cols x rows grid over the same clip
+// (previous-frame and background baselines, full resolution and decimated)
+// and reports ms per frame and the overhead. Also checks that the tile counts
+// add up to the frame counts, and prints the busiest tile of the last second,
+// which should sit on the moving block's path. Then lays grids over small
+// and decimated planes (down to finer than the plane) and checks that every
+// tile covers pixels; exits 1 if one doesn't.
+//
+// Usage: bench_heatmap [frames=100] [width=1920] [height=1080] [grid=16x12]
+
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const int    DIFF_THRESH  = 25;
+static const double MOTION_RATIO = 0.02;
+
+using clock_type = chrono::steady_clock;
+
+int main(int argc, char** argv)
+{
+    const int frames = (argc > 1) ? max(2, atoi(argv[1])) : 100;
+    const int width  = (argc > 2) ? max(64, atoi(argv[2])) : 1920;
+    const int height = (argc > 3) ? max(64, atoi(argv[3])) : 1080;
+    int cols = 16, rows = 12;
+    if (argc > 4 && (sscanf(argv[4], "%dx%d", &cols, &rows) != 2 || cols < 1 || rows < 1))
+    {
+        cols = 16;
+        rows = 12;
+    }
+
+    // A few noisy frames with a block moving along the middle third, cycled
+    vector<Mat> clip;
+    for (int i = 0; i < 8; i++)
+    {
+        Mat f(height, width, CV_8UC3);
+        randu(f, Scalar::all(60), Scalar::all(90));
+        rectangle(f, Rect((i * width / 10) % (width - width / 4), height / 3, width / 4, height / 3),
+                  Scalar(220, 220, 220), FILLED);
+        clip.push_back(f);
+    }
+
+    cout << "Heatmap benchmark: " << width << "x" << height << " BGR, " << frames << " frames, " << cols << "x"
+         << rows << " grid, kernel " << motion::kernelIsa() << " (ms per frame)\n";
+    printf("%-11s %9s %8s %8s %9s %s\n", "baseline", "decimate", "off", "heatmap", "overhead", "busiest tile");
+
+    for (bool useBackground : {false, true})
+    {
+        for (int decimate : {1, 4})
+        {
+            DetectorOptions options;
+            options.background = useBackground;
+            options.decimation = decimate;
+            MotionDetector plain(DIFF_THRESH, MOTION_RATIO, options);
+            options.heatmapCols = cols;
+            options.heatmapRows = rows;
+            MotionDetector tiled(DIFF_THRESH, MOTION_RATIO, options);
+
+            // Tiles without pixels of their own repeat a neighbour
+            const Size plane = motion::decimatedSize(Size(width, height), decimate);
+            const bool fits = cols <= plane.width && rows <= plane.height;
+
+            double plainMs = 0.0, tiledMs = 0.0;
+            bool sumsMatch = true;
+            plain.process(clip[0]);
+            tiled.process(clip[0]);
+            for (int i = 1; i <= frames; i++)
+            {
+                const Mat& f = clip[i % clip.size()];
+
+                auto t0 = clock_type::now();
+                const MotionResult a = plain.process(f);
+                plainMs += chrono::duration<double, milli>(clock_type::now() - t0).count();
+
+                t0 = clock_type::now();
+                const MotionResult b = tiled.process(f);
+                tiledMs += chrono::duration<double, milli>(clock_type::now() - t0).count();
+
+                // One frame per take: the cells must add up to this frame's count
+                const MotionHeatmap h = tiled.takeHeatmap();
+                uint64_t sum = 0;
+                for (uint64_t c : h.changed) sum += c;
+                if (a.changed != b.changed || (fits && sum != (uint64_t)b.changed)) sumsMatch = false;
+            }
+
+            // Busiest tile of one last "second" of the clip
+            for (size_t i = 0; i < clip.size(); i++) tiled.process(clip[i]);
+            const MotionHeatmap h = tiled.takeHeatmap();
+            const size_t best = max_element(h.changed.begin(), h.changed.end()) - h.changed.begin();
+
+            printf("%-11s %9d %8.3f %8.3f %8.1f%% r%dc%d%s\n", useBackground ? "background" : "previous", decimate,
+                   plainMs / frames, tiledMs / frames, 100.0 * (tiledMs - plainMs) / max(1e-9, plainMs),
+                   (int)best / cols, (int)best % cols, sumsMatch ? "" : "  (count mismatch!)");
+        }
+    }
+
+    // Tile layout on small planes: 16-column alignment would leave narrow
+    // tiles empty, and a grid with more rows than the plane has some to spare
+    struct Layout
+    {
+        Size frame;
+        int decimate, cols, rows;
+    };
+    const Layout layouts[] = {
+        {Size(1280, 720), 8, 16, 12}, {Size(1280, 720), 4, 64, 64}, {Size(640, 480), 8, 64, 64},
+        {Size(320, 240), 2, 64, 64},  {Size(160, 120), 8, 16, 12},  {Size(1920, 1080), 1, 16, 12},
+    };
+    bool layoutsOk = true;
+    cout << "\nTile layout (every tile must cover plane pixels)\n";
+    printf("%-10s %9s %6s %8s %11s %s\n", "frame", "decimate", "grid", "plane", "empty tiles", "cells add up");
+    for (const Layout& l : layouts)
+    {
+        DetectorOptions options;
+        options.decimation = l.decimate;
+        options.heatmapCols = l.cols;
+        options.heatmapRows = l.rows;
+        MotionDetector detector(DIFF_THRESH, MOTION_RATIO, options);
+
+        Mat a(l.frame, CV_8UC3), b(l.frame, CV_8UC3);
+        randu(a, Scalar::all(0), Scalar::all(255));
+        randu(b, Scalar::all(0), Scalar::all(255));
+        detector.process(a);
+        detector.takeHeatmap();
+        const MotionResult r = detector.process(b);
+        const MotionHeatmap h = detector.takeHeatmap();
+
+        const Size plane = motion::decimatedSize(l.frame, l.decimate);
+        const bool fits = l.cols <= plane.width && l.rows <= plane.height;
+        uint64_t sum = 0;
+        int empty = 0;
+        for (size_t i = 0; i < h.changed.size(); i++)
+        {
+            sum += h.changed[i];
+            if (h.active[i] == 0) empty++;
+        }
+        const bool sumOk = !fits || sum == (uint64_t)r.changed;
+        if (empty > 0 || !sumOk) layoutsOk = false;
+        printf("%4dx%-5d %9d %3dx%-2d %4dx%-3d %11d %s\n", l.frame.width, l.frame.height, l.decimate, l.cols, l.rows,
+               plane.width, plane.height, empty, fits ? (sumOk ? "yes" : "NO") : "(repeats)");
+    }
+    return layoutsOk ? 0 : 1;
+}
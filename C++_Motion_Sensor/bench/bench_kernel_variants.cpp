@@ -0,0 +1,283 @@
+// Benchmark and equivalence check: every row-kernel build this CPU runs
+// (scalar, sse41, avx2, avx512 / scalar, neon).
+//
+// First each build is checked against the scalar one on random rows of random
+// widths and offsets (so every vector width and every tail is hit): luma,
+// counts, background models, per-cell counts, lighting sums, decimated rows
+// and block matches must all be identical. Then each kernel is timed per build
+// on a frame's worth of rows (block matching: one in ten 16x16 cells, +/- 8
+// pixels), in ms per frame.
+//
+// Exits with 1 if any build disagrees with scalar.
+//
+// Usage: bench_kernel_variants [frames=50] [width=1920] [height=1080]
+
+#include "motion_kernel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+static const int DIFF_THRESH = 25;
+
+namespace
+{
+// Everything one build produces for one random case
+struct Outputs
+{
+    vector<uint8_t>  luma, cur, grayCur, decimated;
+    vector<uint16_t> bg, cells, bgCells;
+    int diffCount = 0, grayCount = 0, bgCount = 0, gainCount = 0, gainBgCount = 0;
+    uint64_t sums[4] = {0, 0, 0, 0};
+    motion::BlockMatch match;
+
+    bool operator==(const Outputs& o) const
+    {
+        return luma == o.luma && cur == o.cur && grayCur == o.grayCur && decimated == o.decimated && bg == o.bg &&
+               cells == o.cells && bgCells == o.bgCells && diffCount == o.diffCount && grayCount == o.grayCount &&
+               bgCount == o.bgCount && gainCount == o.gainCount && gainBgCount == o.gainBgCount &&
+               equal(begin(sums), end(sums), begin(o.sums)) && match.dx == o.match.dx && match.dy == o.match.dy &&
+               match.sad == o.match.sad && match.zeroSad == o.match.zeroSad;
+    }
+};
+
+struct Case
+{
+    int width, x0, x1, thresh, alpha, gain, cellShift, factor;
+    vector<uint8_t> bgr, prev, gray;
+    vector<uint16_t> bg;
+    vector<vector<uint8_t>> rows; // factor BGR rows for decimation
+
+    // Block matching: a block of blockSize, and the reference area around it
+    int blockSize, range, curStep, refStep;
+    vector<uint8_t> block, area;
+};
+
+Case randomCase(mt19937& rng)
+{
+    Case c;
+    c.width = 1 + (int)(rng() % 700);
+    c.x0 = (int)(rng() % c.width);
+    c.x1 = c.x0 + (int)(rng() % (c.width - c.x0 + 1));
+    c.thresh = (int)(rng() % 64);
+    c.alpha = 1 + (int)(rng() % 16384);
+    c.gain = (int)(rng() % 4096);
+    c.cellShift = (rng() % 2) ? 4 : 3;
+    c.factor = 2 << (rng() % 3);
+
+    // Half the cases near the baseline, so counts aren't all or nothing
+    const bool near = rng() % 2;
+    auto byte = [&]() { return (uint8_t)rng(); };
+    c.bgr.resize((size_t)c.width * 3);
+    c.prev.resize(c.width);
+    c.gray.resize(c.width);
+    c.bg.resize(c.width);
+    for (auto& v : c.bgr) v = byte();
+    for (int x = 0; x < c.width; x++)
+    {
+        c.gray[x] = byte();
+        c.prev[x] = near ? (uint8_t)max(0, min(255, (int)c.gray[x] + (int)(rng() % 61) - 30)) : byte();
+        c.bg[x] = (uint16_t)(rng() % ((255 << motion::kBackgroundShift) + 1));
+    }
+    const int outWidth = max(1, c.width / c.factor);
+    c.rows.assign(c.factor, vector<uint8_t>((size_t)outWidth * c.factor * 3));
+    for (auto& r : c.rows)
+        for (auto& v : r) v = byte();
+
+    // The block is a piece of the area at a random shift, plus some noise
+    c.blockSize = (rng() % 2) ? 16 : 8;
+    c.range = 1 + (int)(rng() % 8);
+    const int side = c.blockSize + 2 * c.range;
+    c.refStep = side + (int)(rng() % 9);
+    c.curStep = c.blockSize + (int)(rng() % 9);
+    c.area.resize((size_t)c.refStep * side);
+    for (auto& v : c.area) v = byte();
+    const int sx = (int)(rng() % (2 * c.range + 1)), sy = (int)(rng() % (2 * c.range + 1));
+    c.block.resize((size_t)c.curStep * c.blockSize);
+    for (int y = 0; y < c.blockSize; y++)
+        for (int x = 0; x < c.blockSize; x++)
+        {
+            const int v = c.area[(size_t)(sy + y) * c.refStep + sx + x] + (near ? (int)(rng() % 21) - 10 : 0);
+            c.block[(size_t)y * c.curStep + x] = (uint8_t)max(0, min(255, v));
+        }
+    return c;
+}
+
+Outputs run(const Case& c)
+{
+    Outputs o;
+    const int w = c.width;
+    o.luma.assign(w, 0);
+    motion::bgrToLumaRow(c.bgr.data(), o.luma.data(), w);
+
+    o.cur.assign(w, 0);
+    o.diffCount = motion::lumaDiffCountRow(c.bgr.data(), c.prev.data(), o.cur.data(), w, c.thresh);
+    o.grayCur.assign(w, 0);
+    o.grayCount = motion::grayDiffCountRow(c.gray.data(), c.prev.data(), o.grayCur.data(), w, c.thresh);
+
+    o.cells.assign(((size_t)w >> c.cellShift) + 1, 0);
+    motion::cellDiffCountRow(c.gray.data(), c.prev.data(), c.x0, c.x1, c.thresh, c.cellShift, o.cells.data());
+    o.bgCells.assign(o.cells.size(), 0);
+    motion::cellBackgroundCountRow(c.gray.data(), c.bg.data(), c.x0, c.x1, c.thresh, c.cellShift,
+                                   o.bgCells.data());
+
+    motion::lumaSumsRow(c.gray.data(), c.prev.data(), c.x0, c.x1, o.sums[0], o.sums[1]);
+    motion::backgroundSumsRow(c.gray.data(), c.bg.data(), c.x0, c.x1, o.sums[2], o.sums[3]);
+    o.gainCount = motion::gainDiffCountRow(c.gray.data(), c.prev.data(), c.x0, c.x1, c.thresh, c.gain);
+    o.gainBgCount = motion::gainBackgroundCountRow(c.gray.data(), c.bg.data(), c.x0, c.x1, c.thresh, c.gain);
+
+    o.bg = c.bg;
+    o.bgCount = motion::backgroundDiffUpdateRow(c.gray.data(), o.bg.data(), w, c.thresh, c.alpha);
+
+    const int outWidth = max(1, w / c.factor);
+    const uint8_t* rows[8];
+    for (int r = 0; r < c.factor; r++) rows[r] = c.rows[r].data();
+    motion::DecimationScratch scratch;
+    o.decimated.assign(outWidth, 0);
+    motion::decimateLumaRow(rows, true, c.factor, outWidth, o.decimated.data(), scratch);
+
+    const uint8_t* center = c.area.data() + (size_t)c.range * c.refStep + c.range;
+    o.match = motion::blockMatch(c.block.data(), c.curStep, center, c.refStep, c.blockSize, -c.range, c.range,
+                                 -c.range, c.range);
+    return o;
+}
+
+double msPerFrame(int frames, const function<void()>& frame)
+{
+    frame(); // warm-up
+    const auto t0 = clock_type::now();
+    for (int i = 0; i < frames; i++) frame();
+    return chrono::duration<double, milli>(clock_type::now() - t0).count() / frames;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = (argc > 1) ? max(1, atoi(argv[1])) : 50;
+    const int width  = (argc > 2) ? max(64, atoi(argv[2])) : 1920;
+    const int height = (argc > 3) ? max(8, atoi(argv[3])) : 1080;
+
+    const vector<string> variants = motion::kernelVariants();
+    const string chosen = motion::kernelIsa();
+
+    // ---- Equivalence with scalar
+    int failures = 0;
+    const int cases = 3000;
+    for (const string& v : variants)
+    {
+        if (v == "scalar") continue;
+        mt19937 rng(7);
+        int bad = 0;
+        for (int i = 0; i < cases; i++)
+        {
+            const Case c = randomCase(rng);
+            motion::useKernelVariant("scalar");
+            const Outputs ref = run(c);
+            motion::useKernelVariant(v);
+            if (!(run(c) == ref)) bad++;
+        }
+        cout << v << ": " << (cases - bad) << "/" << cases << " random rows identical to scalar\n";
+        failures += bad;
+    }
+
+    // ---- Timing: one frame's rows per call
+    mt19937 rng(3);
+    vector<uint8_t> bgr((size_t)width * height * 3), prev((size_t)width * height), cur(prev.size()),
+        gray(prev.size());
+    vector<uint16_t> bg(prev.size()), bgWork;
+    for (auto& v : bgr) v = (uint8_t)rng();
+    for (size_t i = 0; i < prev.size(); i++)
+    {
+        gray[i] = (uint8_t)rng();
+        prev[i] = (uint8_t)max(0, min(255, (int)gray[i] + (int)(rng() % 61) - 30));
+        bg[i] = (uint16_t)(prev[i] << motion::kBackgroundShift);
+    }
+    vector<uint16_t> cells(((size_t)width >> 3) + 1);
+
+    struct Kernel
+    {
+        const char* name;
+        function<void()> frame;
+    };
+    volatile int sink = 0; // keeps the counts from being optimized away
+    uint64_t s0 = 0, s1 = 0;
+    motion::DecimationScratch scratch;
+    vector<uint8_t> out(width / 4 + 1);
+    const vector<Kernel> kernels = {
+        {"bgr luma+diff", [&]() {
+             for (int y = 0; y < height; y++)
+                 sink += motion::lumaDiffCountRow(&bgr[(size_t)y * width * 3], &prev[(size_t)y * width],
+                                                  &cur[(size_t)y * width], width, DIFF_THRESH);
+         }},
+        {"gray diff", [&]() {
+             for (int y = 0; y < height; y++)
+                 sink += motion::grayDiffCountRow(&gray[(size_t)y * width], &prev[(size_t)y * width],
+                                                  &cur[(size_t)y * width], width, DIFF_THRESH);
+         }},
+        {"background", [&]() {
+             bgWork = bg;
+             for (int y = 0; y < height; y++)
+                 sink += motion::backgroundDiffUpdateRow(&gray[(size_t)y * width], &bgWork[(size_t)y * width],
+                                                         width, DIFF_THRESH, 655);
+         }},
+        {"decimate 1/4", [&]() {
+             const uint8_t* rows[4];
+             for (int y = 0; y + 4 <= height; y += 4)
+             {
+                 for (int r = 0; r < 4; r++) rows[r] = &bgr[(size_t)(y + r) * width * 3];
+                 motion::decimateLumaRow(rows, true, 4, width / 4, out.data(), scratch);
+             }
+         }},
+        {"blob cells", [&]() {
+             for (int y = 0; y < height; y++)
+                 motion::cellDiffCountRow(&gray[(size_t)y * width], &prev[(size_t)y * width], 0, width,
+                                          DIFF_THRESH, 3, cells.data());
+         }},
+        {"lighting", [&]() {
+             for (int y = 0; y < height; y++)
+             {
+                 motion::lumaSumsRow(&gray[(size_t)y * width], &prev[(size_t)y * width], 0, width, s0, s1);
+                 sink += motion::gainDiffCountRow(&gray[(size_t)y * width], &prev[(size_t)y * width], 0, width,
+                                                  DIFF_THRESH, 280);
+             }
+         }},
+        {"block match", [&]() {
+             int n = 0;
+             for (int y = 16; y + 32 <= height; y += 16)
+                 for (int x = 16; x + 32 <= width; x += 16)
+                     if (n++ % 10 == 0)
+                         sink += motion::blockMatch(&gray[(size_t)y * width + x], width, &prev[(size_t)y * width + x],
+                                                    width, 16, -8, 8, -8, 8).sad;
+         }},
+    };
+
+    cout << "\nRow kernels, " << width << "x" << height << ", " << frames << " frames (ms per frame; picked at "
+         << "startup: " << chosen << ")\n";
+    printf("%-14s", "kernel");
+    for (const string& v : variants) printf(" %9s", v.c_str());
+    printf("\n");
+    for (const Kernel& k : kernels)
+    {
+        printf("%-14s", k.name);
+        for (const string& v : variants)
+        {
+            motion::useKernelVariant(v);
+            printf(" %9.3f", msPerFrame(frames, k.frame));
+        }
+        printf("\n");
+    }
+    motion::useKernelVariant(chosen);
+    sink = sink + (int)(s0 - s1);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+// Benchmark: what lighting compensation (--lighting) costs, and what it
+// rejects.
+//
+// Two clips over the same noisy scene:
+//   steady    a block moving across, constant light: ms per frame without and
+//             with compensation, and whether the per-frame motion decisions
+//             still agree
+//   lights    no movement, the light switching between 1x and 1.6x every
+//             few frames plus an auto-exposure-like ramp: frames reported as
+//             motion without and with compensation, and frames flagged as a
+//             lighting change
+// for both baselines at full and 1/4 resolution.
+//
+// Usage: bench_lighting [frames=100] [width=1920] [height=1080]
+
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const int    DIFF_THRESH  = 25;
+static const double MOTION_RATIO = 0.02;
+
+using clock_type = chrono::steady_clock;
+
+static double msSince(clock_type::time_point t0)
+{
+    return chrono::duration<double, milli>(clock_type::now() - t0).count();
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = (argc > 1) ? max(2, atoi(argv[1])) : 100;
+    const int width  = (argc > 2) ? max(64, atoi(argv[2])) : 1920;
+    const int height = (argc > 3) ? max(64, atoi(argv[3])) : 1080;
+
+    // Noisy scene with some structure, so a gain doesn't shift every pixel alike
+    Mat scene(height, width, CV_8UC3);
+    randu(scene, Scalar::all(60), Scalar::all(90));
+    for (int i = 0; i < 6; i++)
+        rectangle(scene, Rect(i * width / 6, (i % 3) * height / 3, width / 8, height / 4),
+                  Scalar::all(30 + 25 * i), FILLED);
+
+    vector<Mat> steady;
+    for (int i = 0; i < 8; i++)
+    {
+        Mat f = scene.clone();
+        rectangle(f, Rect((i * width / 10) % (width - width / 4), height / 3, width / 4, height / 3),
+                  Scalar(220, 220, 220), FILLED);
+        steady.push_back(f);
+    }
+
+    // Lights off / on every four frames, then exposure creeping up 10% a frame
+    vector<Mat> lights;
+    for (double gain : {1.0, 1.0, 1.0, 1.0, 1.6, 1.6, 1.6, 1.6, 1.0, 1.1, 1.21, 1.33, 1.46, 1.61, 1.0, 1.0})
+    {
+        Mat f;
+        scene.convertTo(f, -1, gain);
+        lights.push_back(f);
+    }
+
+    cout << "Lighting benchmark: " << width << "x" << height << " BGR, " << frames << " frames, kernel "
+         << motion::kernelIsa() << "\n";
+    printf("%-11s %9s | %8s %8s %9s %7s | %13s %13s %9s\n", "baseline", "decimate", "off ms", "on ms", "overhead",
+           "agree", "motion (off)", "motion (on)", "lighting");
+
+    for (bool useBackground : {false, true})
+    {
+        for (int decimate : {1, 4})
+        {
+            DetectorOptions options;
+            options.background = useBackground;
+            options.decimation = decimate;
+            MotionDetector plain(DIFF_THRESH, MOTION_RATIO, options);
+            options.lighting = true;
+            MotionDetector compensated(DIFF_THRESH, MOTION_RATIO, options);
+
+            double plainMs = 0.0, compMs = 0.0;
+            int agree = 0;
+            plain.process(steady[0]);
+            compensated.process(steady[0]);
+            for (int i = 1; i <= frames; i++)
+            {
+                const Mat& f = steady[i % steady.size()];
+
+                auto t0 = clock_type::now();
+                const MotionResult a = plain.process(f);
+                plainMs += msSince(t0);
+
+                t0 = clock_type::now();
+                const MotionResult b = compensated.process(f);
+                compMs += msSince(t0);
+
+                if (a.motion == b.motion) agree++;
+            }
+
+            // Fresh baselines on the lit scene
+            options.lighting = false;
+            MotionDetector litPlain(DIFF_THRESH, MOTION_RATIO, options);
+            options.lighting = true;
+            MotionDetector litComp(DIFF_THRESH, MOTION_RATIO, options);
+            int motionOff = 0, motionOn = 0, flagged = 0;
+            litPlain.process(lights[0]);
+            litComp.process(lights[0]);
+            for (int i = 1; i <= frames; i++)
+            {
+                const Mat& f = lights[i % lights.size()];
+                motionOff += litPlain.process(f).motion;
+                const MotionResult r = litComp.process(f);
+                motionOn += r.motion;
+                flagged += r.lighting;
+            }
+
+            printf("%-11s %9d | %8.3f %8.3f %8.1f%% %3d/%-3d | %13d %13d %9d\n",
+                   useBackground ? "background" : "previous", decimate, plainMs / frames, compMs / frames,
+                   100.0 * (compMs - plainMs) / max(1e-9, plainMs), agree, frames, motionOff, motionOn, flagged);
+        }
+    }
+    return 0;
+}
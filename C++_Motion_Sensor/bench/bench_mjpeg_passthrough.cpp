@@ -0,0 +1,174 @@
+// Benchmark: CPU per camera, decode + re-encode vs MJPEG passthrough.
+//
+// A synthetic MJPEG camera (frame_source.hpp, JPEG q90) delivers `frames`
+// packets up front; their encoding is the camera's work and not timed. Each
+// packet then goes through one camera's share of Program 3:
+//
+//   decode       imdecode to BGR -> MotionDetector (--decimate) ->
+//                AsyncVideoWriter, mp4v into .mp4 (the path without the switch)
+//   passthrough  luma plane decoded at 1/decimate (mjpeg.hpp) -> MotionDetector
+//                -> AsyncVideoWriter muxing the packet into .avi (--mjpeg-passthrough)
+//
+// CPU is process time (all threads, encoder included) per frame, and what
+// that is as a share of one core at the camera's frame rate. Files go to the
+// temp directory and are removed afterwards.
+//
+// Usage: bench_mjpeg_passthrough [frames=300] [width=1280] [height=720] [decimate=4] [fps=30]
+
+#include "async_video_writer.hpp"
+#include "frame_source.hpp"
+#include "mjpeg.hpp"
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+using clock_type = chrono::steady_clock;
+
+struct ModeResult
+{
+    double cpuMs = 0.0;    // process CPU for the whole run
+    double decodeMs = 0.0; // main thread, per frame
+    double detectMs = 0.0;
+    double writerMs = 0.0; // encoder thread, per frame (AsyncWriterStats)
+    uintmax_t bytes = 0;   // output file size
+    uint64_t muxed = 0;
+};
+
+static double msSince(clock_type::time_point t0)
+{
+    return chrono::duration<double, milli>(clock_type::now() - t0).count();
+}
+
+static ModeResult runMode(bool passthrough, const vector<Mat>& packets, Size size, int decimate, double fps)
+{
+    ModeResult r;
+    const fs::path path = fs::temp_directory_path() / (passthrough ? "bench_passthrough.avi" : "bench_decode.mp4");
+
+    WriterOptions wo;
+    wo.passthrough = passthrough;
+    wo.queueCapacity = 64;
+    AsyncVideoWriter writer(wo);
+    const int fourcc = passthrough ? VideoWriter::fourcc('M', 'J', 'P', 'G') : VideoWriter::fourcc('m', 'p', '4', 'v');
+    if (!writer.open(path.string(), fourcc, fps, size, true))
+    {
+        cerr << "Unable to open " << path.string() << "\n";
+        return r;
+    }
+
+    // The passthrough plane is decimated by the JPEG decoder already
+    DetectorOptions imageOptions, planeOptions;
+    imageOptions.decimation = decimate;
+    MotionDetector det(25, 0.02, passthrough ? planeOptions : imageOptions);
+
+    const clock_t cpu0 = clock();
+    Mat luma;
+    for (const Mat& packet : packets)
+    {
+        auto t0 = clock_type::now();
+        Mat image;
+        EncodedFrame bytes;
+        if (passthrough)
+        {
+            bytes = make_shared<const vector<uint8_t>>(packet.ptr<uchar>(0), packet.ptr<uchar>(0) + packet.cols);
+            decodeJpegLuma(packet, decimate, luma);
+        }
+        else
+        {
+            image = imdecode(packet, IMREAD_COLOR);
+        }
+        auto t1 = clock_type::now();
+
+        det.process(passthrough ? luma : image);
+        auto t2 = clock_type::now();
+
+        if (passthrough) writer.write(bytes, FrameStamp());
+        else             writer.write(image);
+
+        r.decodeMs += chrono::duration<double, milli>(t1 - t0).count();
+        r.detectMs += chrono::duration<double, milli>(t2 - t1).count();
+    }
+    writer.release(); // waits for the encoder
+    r.cpuMs = 1000.0 * (double)(clock() - cpu0) / CLOCKS_PER_SEC;
+
+    const AsyncWriterStats ws = writer.stats();
+    r.writerMs = ws.encodeMsAvg;
+    r.muxed = ws.muxed;
+    r.decodeMs /= (double)packets.size();
+    r.detectMs /= (double)packets.size();
+
+    error_code ec;
+    r.bytes = fs::file_size(path, ec);
+    fs::remove(path, ec);
+    return r;
+}
+
+static void report(const char* name, const ModeResult& r, size_t frames, double fps)
+{
+    const double perFrame = r.cpuMs / (double)frames;
+    printf("%-12s %10.2f %8.2f %8.2f %8.2f %10.1f%% %9.1f MB\n", name, perFrame, r.decodeMs, r.detectMs, r.writerMs,
+           perFrame * fps / 10.0, (double)r.bytes / (1024.0 * 1024.0));
+}
+
+int main(int argc, char** argv)
+{
+    const int    frames   = (argc > 1) ? max(2, atoi(argv[1])) : 300;
+    const int    width    = (argc > 2) ? max(16, atoi(argv[2])) : 1280;
+    const int    height   = (argc > 3) ? max(16, atoi(argv[3])) : 720;
+    int          decimate = (argc > 4) ? atoi(argv[4]) : 4;
+    const double fps      = (argc > 5) ? max(1.0, atof(argv[5])) : 30.0;
+    if (decimate != 1 && decimate != 2 && decimate != 4 && decimate != 8) decimate = 4;
+
+    SourceOptions options;
+    options.fast = true;
+    options.mjpegPassthrough = true;
+    unique_ptr<FrameSource> camera =
+        openFrameSource("synthetic:" + to_string(width) + "x" + to_string(height) + "@" + to_string((int)fps), options);
+
+    vector<Mat> packets;
+    Mat packet;
+    size_t bytes = 0;
+    while ((int)packets.size() < frames && camera->read(packet) && isJpegPacket(packet))
+    {
+        packets.push_back(packet.clone());
+        bytes += (size_t)packet.cols;
+    }
+    if (packets.size() < 2)
+    {
+        cerr << "Source delivered fewer than 2 JPEG packets\n";
+        return 1;
+    }
+
+    cout << "MJPEG passthrough benchmark: " << camera->describe() << ", " << packets.size() << " packets (avg "
+         << bytes / packets.size() / 1024 << " KB), detection at 1/" << decimate << "\n";
+    printf("%-12s %10s %8s %8s %8s %11s %12s\n", "mode", "cpu ms/f", "decode", "detect", "writer", "core @fps",
+           "file");
+
+    const ModeResult decode = runMode(false, packets, Size(width, height), decimate, fps);
+    const ModeResult mux = runMode(true, packets, Size(width, height), decimate, fps);
+    report("decode", decode, packets.size(), fps);
+    report("passthrough", mux, packets.size(), fps);
+
+    if (mux.muxed == 0)
+        cout << "Note: this OpenCV has no raw video writer (needs FFmpeg, 4.10+); passthrough fell back to "
+                "decode + MJPEG encode.\n";
+    else if (mux.cpuMs > 0.0)
+        printf("Passthrough: %.1fx less CPU per camera\n", decode.cpuMs / mux.cpuMs);
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Accuracy report: per-second motion decisions on recorded clips, full
+// resolution vs the decimated planes (--decimate=2/4/8).
+//
+// Each clip is split into 1-second windows (CAP_PROP_FPS frames, 30 if the
+// container doesn't say). A window is "motion" if any frame in it reaches
+// MOTION_RATIO, exactly like the per-second CSV. Decimated decisions are
+// compared with the full-resolution ones.
+//
+// Usage: bench_motion_accuracy <clip.mp4> [more clips...]
+
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const int    DIFF_THRESH  = 25;
+static const double MOTION_RATIO = 0.02;
+static const int    FACTORS[] = { 1, 2, 4, 8 };
+static const int    NUM_FACTORS = 4;
+
+struct Tally
+{
+    int seconds = 0;
+    int agree = 0;
+    int missed = 0; // full = motion, decimated = no motion
+    int extra = 0;  // full = no motion, decimated = motion
+    double ratioAbsErr = 0.0; // summed per-frame |ratio - full ratio|
+    long frames = 0;
+};
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " <clip.mp4> [more clips...]\n";
+        return 1;
+    }
+
+    Tally total[NUM_FACTORS];
+
+    for (int c = 1; c < argc; c++)
+    {
+        VideoCapture cap(argv[c]);
+        if (!cap.isOpened())
+        {
+            cerr << "Could not open " << argv[c] << ", skipping\n";
+            continue;
+        }
+
+        double fps = cap.get(CAP_PROP_FPS);
+        int window = (fps > 1.0) ? (int)lround(fps) : 30;
+
+        vector<MotionDetector> dets;
+        for (int f : FACTORS)
+        {
+            DetectorOptions opt;
+            opt.decimation = f;
+            dets.emplace_back(DIFF_THRESH, MOTION_RATIO, opt);
+        }
+
+        Tally clip[NUM_FACTORS];
+        bool windowMotion[NUM_FACTORS] = {};
+        int inWindow = 0;
+        Mat frame;
+
+        while (cap.read(frame) && !frame.empty())
+        {
+            double fullRatio = 0.0;
+            for (int k = 0; k < NUM_FACTORS; k++)
+            {
+                MotionResult r = dets[k].process(frame);
+                if (k == 0) fullRatio = r.ratio;
+                windowMotion[k] = windowMotion[k] || r.motion;
+                clip[k].ratioAbsErr += fabs(r.ratio - fullRatio);
+                clip[k].frames++;
+            }
+
+            if (++inWindow == window)
+            {
+                for (int k = 0; k < NUM_FACTORS; k++)
+                {
+                    clip[k].seconds++;
+                    if (windowMotion[k] == windowMotion[0]) clip[k].agree++;
+                    else if (windowMotion[0])               clip[k].missed++;
+                    else                                    clip[k].extra++;
+                    windowMotion[k] = false;
+                }
+                inWindow = 0;
+            }
+        }
+
+        cout << "\n" << argv[c] << " (" << window << " frames/s window)\n";
+        printf("  %9s %8s %8s %8s %8s %14s\n", "decimate", "seconds", "agree%", "missed", "extra", "mean |dRatio|");
+        for (int k = 0; k < NUM_FACTORS; k++)
+        {
+            const Tally& t = clip[k];
+            printf("  %9d %8d %7.1f%% %8d %8d %14.5f\n", FACTORS[k], t.seconds,
+                   t.seconds ? 100.0 * t.agree / t.seconds : 100.0, t.missed, t.extra,
+                   t.frames ? t.ratioAbsErr / (double)t.frames : 0.0);
+
+            total[k].seconds += t.seconds;
+            total[k].agree += t.agree;
+            total[k].missed += t.missed;
+            total[k].extra += t.extra;
+            total[k].ratioAbsErr += t.ratioAbsErr;
+            total[k].frames += t.frames;
+        }
+    }
+
+    cout << "\nAll clips\n";
+    printf("  %9s %8s %8s %8s %8s %14s\n", "decimate", "seconds", "agree%", "missed", "extra", "mean |dRatio|");
+    for (int k = 0; k < NUM_FACTORS; k++)
+    {
+        const Tally& t = total[k];
+        printf("  %9d %8d %7.1f%% %8d %8d %14.5f\n", FACTORS[k], t.seconds,
+               t.seconds ? 100.0 * t.agree / t.seconds : 100.0, t.missed, t.extra,
+               t.frames ? t.ratioAbsErr / (double)t.frames : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Benchmark: full-frame detection vs decision mode (early exit + per-second latch).
+//
+// Replays synthetic 1-second windows through MotionDetector in both modes and
+// reports detector CPU time per second of video for three scenes:
+//   idle  - static background with sensor noise only (never reaches MOTION_RATIO)
+//   high  - large object moving every frame (motion on the first frame of each second)
+//   burst - motion during a short part of every second, idle otherwise
+// The per-second decisions of both modes are compared; any difference is an error.
+//
+// Usage: bench_motion_decision [seconds=20] [fps=30] [width=1920] [height=1080]
+
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const int    DIFF_THRESH  = 25;
+static const double MOTION_RATIO = 0.02;
+
+// Frame i of a scene. `moving` decides whether the block moves on that frame.
+static Mat makeFrame(const Mat& background, int i, bool moving)
+{
+    Mat f = background.clone();
+    Mat noise(background.size(), CV_8UC3);
+    randu(noise, Scalar::all(0), Scalar::all(8)); // well under DIFF_THRESH
+    f += noise;
+
+    if (moving)
+    {
+        int bw = background.cols / 3, bh = background.rows / 3;
+        Rect block((i * 37) % (background.cols - bw), (i * 23) % (background.rows - bh), bw, bh);
+        rectangle(f, block, Scalar(255, 255, 255), FILLED);
+    }
+    return f;
+}
+
+struct RunResult
+{
+    double cpuMsPerSecond = 0.0;
+    vector<bool> decisions;
+};
+
+static RunResult run(const vector<Mat>& frames, int seconds, int fps, bool decisionMode)
+{
+    DetectorOptions opt;
+    opt.decisionMode = decisionMode;
+    MotionDetector det(DIFF_THRESH, MOTION_RATIO, opt);
+
+    RunResult r;
+    det.reset(frames[0]);
+
+    clock_t c0 = clock();
+    size_t idx = 1;
+    for (int s = 0; s < seconds; s++)
+    {
+        bool motionThisSecond = false;
+        const Mat* last = nullptr;
+        for (int f = 0; f < fps; f++, idx++)
+        {
+            last = &frames[idx % frames.size()];
+            if (det.process(*last).motion)
+                motionThisSecond = true;
+        }
+        r.decisions.push_back(motionThisSecond);
+        det.rollWindow(*last);
+    }
+    clock_t c1 = clock();
+
+    r.cpuMsPerSecond = 1000.0 * (double)(c1 - c0) / CLOCKS_PER_SEC / seconds;
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    const int seconds = (argc > 1) ? atoi(argv[1]) : 20;
+    const int fps     = (argc > 2) ? atoi(argv[2]) : 30;
+    const int w       = (argc > 3) ? atoi(argv[3]) : 1920;
+    const int h       = (argc > 4) ? atoi(argv[4]) : 1080;
+
+    Mat background(h, w, CV_8UC3);
+    randu(background, Scalar::all(0), Scalar::all(200));
+
+    cout << "Decision-mode benchmark: " << w << "x" << h << " @ " << fps << " fps, "
+         << seconds << " s per scene\n";
+    printf("%-6s %16s %16s %10s\n", "scene", "full cpu ms/s", "decision ms/s", "saved");
+
+    const string scenes[] = { "idle", "high", "burst" };
+    for (const string& scene : scenes)
+    {
+        // One second's worth of frames is enough; the run loops over them.
+        vector<Mat> frames;
+        for (int i = 0; i < fps; i++)
+        {
+            bool moving = (scene == "high") || (scene == "burst" && i >= fps / 2 && i < fps / 2 + 3);
+            frames.push_back(makeFrame(background, i, moving));
+        }
+
+        RunResult full = run(frames, seconds, fps, false);
+        RunResult dec  = run(frames, seconds, fps, true);
+
+        if (full.decisions != dec.decisions)
+        {
+            cerr << "MISMATCH: per-second decisions differ in scene " << scene << "\n";
+            return 1;
+        }
+
+        double saved = (full.cpuMsPerSecond > 0.0) ? 100.0 * (1.0 - dec.cpuMsPerSecond / full.cpuMsPerSecond) : 0.0;
+        printf("%-6s %16.1f %16.1f %9.1f%%\n", scene.c_str(), full.cpuMsPerSecond, dec.cpuMsPerSecond, saved);
+    }
+
+    cout << "Per-second decisions identical in both modes.\n";
+    return 0;
+}
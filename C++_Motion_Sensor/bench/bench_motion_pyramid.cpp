@@ -0,0 +1,74 @@
+// Benchmark: detector throughput at full resolution vs the decimated planes
+// (--decimate=2/4/8). Single-threaded, so the numbers are frames/sec per core.
+//
+// Usage: bench_motion_pyramid [iterations=200]
+
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+static vector<Mat> makeFrames(Size size, int count)
+{
+    Mat background(size, CV_8UC3);
+    randu(background, Scalar::all(0), Scalar::all(255));
+
+    vector<Mat> frames;
+    for (int i = 0; i < count; i++)
+    {
+        Mat f = background.clone();
+        int bw = size.width / 8, bh = size.height / 8;
+        Rect block((i * 29) % (size.width - bw), (i * 13) % (size.height - bh), bw, bh);
+        rectangle(f, block, Scalar(255, 255, 255), FILLED);
+        frames.push_back(f);
+    }
+    return frames;
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = (argc > 1) ? atoi(argv[1]) : 200;
+
+    const Size sizes[] = { Size(1920, 1080), Size(3840, 2160) };
+    const char* names[] = { "1080p", "4K" };
+    const int factors[] = { 1, 2, 4, 8 };
+
+    cout << "Multi-resolution detector throughput (" << iterations << " frames per row, 1 thread)\n";
+    printf("%-6s %9s %12s %12s %12s\n", "res", "decimate", "plane", "ms/frame", "fps/core");
+
+    for (int s = 0; s < 2; s++)
+    {
+        vector<Mat> frames = makeFrames(sizes[s], 8);
+
+        for (int f : factors)
+        {
+            DetectorOptions opt;
+            opt.decimation = f;
+            MotionDetector det(25, 0.02, opt);
+            det.reset(frames[0]);
+
+            auto t0 = clock_type::now();
+            int hits = 0;
+            for (int i = 0; i < iterations; i++)
+                hits += det.process(frames[(i + 1) % frames.size()]).motion ? 1 : 0;
+            auto t1 = clock_type::now();
+
+            double ms = chrono::duration<double, milli>(t1 - t0).count() / iterations;
+            Size plane = det.planeSize(sizes[s]);
+            printf("%-6s %9d %6dx%-5d %12.3f %12.1f\n", names[s], f, plane.width, plane.height, ms, 1000.0 / ms);
+            (void)hits;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+// Benchmark: block-matching motion vectors (--motion-vectors) against dense
+// optical flow (calcOpticalFlowFarneback) on the same clips.
+//
+// Each clip is a textured scene with a textured block moving at a known
+// velocity (E, NE, S, W and a slow SE, 1 to 8 pixels per frame), plus a
+// little sensor noise. For each clip:
+//   blocks     detector ms per frame without and with --motion-vectors for
+//              8x8 / 16x16 cells, full resolution and --decimate=2, and the
+//              background baseline; vectors found, and the clip's dominant
+//              direction and speed (MotionFlowStats) against the truth
+//   farneback  calcOpticalFlowFarneback ms per frame on the full-resolution
+//              luma, with its flow at every pixel that changed by more than
+//              DIFF_THRESH binned the same way
+//
+// Usage: bench_motion_vectors [frames=40] [width=1280] [height=720]
+
+#include "motion_detector.hpp"
+#include "motion_vectors.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const int    DIFF_THRESH  = 25;
+static const double MOTION_RATIO = 0.02;
+
+using clock_type = chrono::steady_clock;
+
+namespace
+{
+constexpr double kPi = 3.14159265358979323846;
+
+double msSince(clock_type::time_point t0)
+{
+    return chrono::duration<double, milli>(clock_type::now() - t0).count();
+}
+
+struct Clip
+{
+    string name;
+    Point2f velocity; // frame pixels per frame (x right, y down)
+    vector<Mat> frames;
+};
+
+Mat texture(int rows, int cols, double low, double high)
+{
+    Mat t(rows, cols, CV_8UC3);
+    randu(t, Scalar::all(low), Scalar::all(high));
+    GaussianBlur(t, t, Size(5, 5), 1.2);
+    return t;
+}
+
+Clip makeClip(const string& name, Point2f velocity, int frames, Size size, const Mat& scene, const Mat& object)
+{
+    Clip clip{name, velocity, {}};
+
+    // As many frames as the block's path fits, centred in the frame
+    const Size obj = object.size();
+    int n = frames;
+    if (velocity.x != 0.0f) n = min(n, (int)((size.width - obj.width - 2) / fabs(velocity.x)));
+    if (velocity.y != 0.0f) n = min(n, (int)((size.height - obj.height - 2) / fabs(velocity.y)));
+    n = max(2, n);
+    const Point2f start((size.width - obj.width) * 0.5f - velocity.x * (n - 1) * 0.5f,
+                        (size.height - obj.height) * 0.5f - velocity.y * (n - 1) * 0.5f);
+
+    Mat noise(size.height, size.width, CV_8UC3);
+    for (int i = 0; i < n; i++)
+    {
+        Mat f = scene.clone();
+        const int x = (int)lround(start.x + velocity.x * i);
+        const int y = (int)lround(start.y + velocity.y * i);
+        Mat at = f(Rect(x, y, obj.width, obj.height));
+        object.copyTo(at);
+        randu(noise, Scalar::all(0), Scalar::all(4));
+        f += noise;
+        clip.frames.push_back(f);
+    }
+    return clip;
+}
+
+double angleOf(Point2f v)
+{
+    const double deg = atan2(-(double)v.y, (double)v.x) * 180.0 / kPi;
+    return deg < 0.0 ? deg + 360.0 : deg;
+}
+
+double angleError(double a, double b)
+{
+    const double d = fabs(a - b);
+    return min(d, 360.0 - d);
+}
+
+void printRow(const char* method, double plainMs, double ms, const MotionFlowStats& flow, const Clip& clip)
+{
+    const Point2f v = clip.velocity;
+    const double truthSpeed = sqrt((double)v.x * v.x + (double)v.y * v.y);
+    const int d = flow.dominant();
+    const double perFrame = flow.frames ? (double)flow.vectors / flow.frames : 0.0;
+    char plain[16] = "";
+    if (plainMs > 0.0) snprintf(plain, sizeof(plain), "%.3f", plainMs);
+    printf("%-9s %-15s | %9s %9.3f %9.1f | %-3s %8.1f %9.2f %+8.1f%%\n", clip.name.c_str(), method, plain, ms,
+           perFrame, directionName(d), d < 0 ? 0.0 : angleError(flow.direction(), angleOf(v)), flow.speed(),
+           d < 0 ? -100.0 : 100.0 * (flow.speed() - truthSpeed) / truthSpeed);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = (argc > 1) ? max(4, atoi(argv[1])) : 40;
+    const int width  = (argc > 2) ? max(160, atoi(argv[2])) : 1280;
+    const int height = (argc > 3) ? max(120, atoi(argv[3])) : 720;
+    const Size size(width, height);
+
+    const Mat scene = texture(height, width, 40, 200);
+    const Mat object = texture(height / 5, width / 6, 0, 255);
+
+    const vector<Clip> clips = {
+        makeClip("E 4", Point2f(4, 0), frames, size, scene, object),
+        makeClip("NE 5", Point2f(5, -5), frames, size, scene, object),
+        makeClip("S 6", Point2f(0, 6), frames, size, scene, object),
+        makeClip("W 8", Point2f(-8, 0), frames, size, scene, object),
+        makeClip("SE 1", Point2f(1, 1), frames, size, scene, object),
+    };
+
+    struct Setup
+    {
+        const char* name;
+        int cell, decimation;
+        bool background;
+    };
+    const vector<Setup> setups = {
+        {"blocks 8", 8, 1, false},
+        {"blocks 16", 16, 1, false},
+        {"blocks 8 1/2", 8, 2, false},
+        {"blocks 16 bg", 16, 1, true},
+    };
+
+    printf("%dx%d, range +/- 8 plane pixels; speeds in frame pixels per frame\n", width, height);
+    printf("%-9s %-15s | %9s %9s %9s | %-3s %8s %9s %9s\n", "clip", "method", "plain ms", "ms", "vec/frame", "dir",
+           "deg err", "speed", "speed err");
+
+    double sink = 0.0;
+    for (const Clip& clip : clips)
+    {
+        for (const Setup& s : setups)
+        {
+            double ms[2] = {0.0, 0.0};
+            MotionFlowStats flow;
+            for (int withVectors = 0; withVectors < 2; withVectors++)
+            {
+                DetectorOptions options;
+                options.blobCell = s.cell;
+                options.decimation = s.decimation;
+                options.background = s.background;
+                options.vectors = withVectors != 0;
+                MotionDetector detector(DIFF_THRESH, MOTION_RATIO, options);
+                detector.process(clip.frames[0]);
+
+                const auto t0 = clock_type::now();
+                for (size_t i = 1; i < clip.frames.size(); i++) sink += detector.process(clip.frames[i]).ratio;
+                ms[withVectors] = msSince(t0) / (double)(clip.frames.size() - 1);
+                if (withVectors) flow = detector.takeFlow();
+            }
+            printRow(s.name, ms[0], ms[1], flow, clip);
+        }
+
+        // Dense flow on the full-resolution luma, read where pixels changed
+        MotionFlowStats flow;
+        Mat prev, gray, field;
+        vector<MotionVector> changed;
+        double ms = 0.0;
+        cvtColor(clip.frames[0], prev, COLOR_BGR2GRAY);
+        for (size_t i = 1; i < clip.frames.size(); i++)
+        {
+            cvtColor(clip.frames[i], gray, COLOR_BGR2GRAY);
+            const auto t0 = clock_type::now();
+            calcOpticalFlowFarneback(prev, gray, field, 0.5, 3, 15, 3, 5, 1.2, 0);
+            ms += msSince(t0);
+
+            changed.clear();
+            for (int y = 0; y < height; y++)
+            {
+                const uint8_t* a = prev.ptr<uint8_t>(y);
+                const uint8_t* b = gray.ptr<uint8_t>(y);
+                const Point2f* f = field.ptr<Point2f>(y);
+                for (int x = 0; x < width; x++)
+                {
+                    if (abs((int)a[x] - (int)b[x]) <= DIFF_THRESH || fabs(f[x].x) + fabs(f[x].y) < 0.5f) continue;
+                    MotionVector v;
+                    v.center = Point2f((float)x, (float)y);
+                    v.shift = f[x];
+                    changed.push_back(v);
+                }
+            }
+            flow.add(changed);
+            swap(prev, gray);
+        }
+        printRow("farneback", 0.0, ms / (double)(clip.frames.size() - 1), flow, clip);
+    }
+
+    return sink < 0.0 ? 1 : 0;
+}
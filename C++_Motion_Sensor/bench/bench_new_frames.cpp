@@ -0,0 +1,158 @@
+// Benchmark: CPU spent by the Program 3 loop when it polls the cameras vs
+// when it waits for new frames and processes each one once.
+//
+// Two simulated cameras publish frames of a moving block at their own rates
+// (default 30 and 15 fps) from their own threads. The engine loop then runs
+// for a few seconds in two modes:
+//
+//   poll : step every ~1 ms (the old 1 ms sleep / waitKey(1) pace) and treat
+//          every read as new, so repeated frames are re-recorded and re-diffed
+//   wait : sleep on the FrameSignal, skip frames already processed
+//
+// and reports frames processed, duplicates skipped and the process CPU time.
+//
+// Usage: bench_new_frames [seconds=3] [fps1=30] [fps2=15] [width=1280] [height=720]
+
+#include "frame_signal.hpp"
+#include "motion_engine.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+// Publishes a sequence number at a fixed rate, like a capture thread
+struct FakeCamera
+{
+    atomic<uint64_t> seq{1};
+    atomic<bool> running{true};
+    thread th;
+
+    FakeCamera(double fps, FrameSignal& signal)
+    {
+        th = thread([this, fps, &signal]() {
+            const auto period = chrono::duration_cast<clock_type::duration>(chrono::duration<double>(1.0 / fps));
+            auto next = clock_type::now() + period;
+            while (running)
+            {
+                this_thread::sleep_until(next);
+                next += period;
+                seq++;
+                signal.notify();
+            }
+        });
+    }
+
+    ~FakeCamera()
+    {
+        running = false;
+        th.join();
+    }
+};
+
+struct ModeResult
+{
+    uint64_t loops = 0, processed = 0, duplicates = 0;
+    double cpuMs = 0.0;
+};
+
+static ModeResult runMode(const vector<Mat>& frames, double seconds, double fps1, double fps2, bool wait)
+{
+    EngineOptions engineOptions;
+    engineOptions.threads = 1; // isolate the loop policy from pool scaling
+    MotionEngine engine(25, 0.02, engineOptions, DetectorOptions(), RecorderOptions(), WriterOptions(), EventOptions());
+
+    FakeCamera cam1(fps1, engine.newFrameSignal());
+    FakeCamera cam2(fps2, engine.newFrameSignal());
+    FakeCamera* cams[] = { &cam1, &cam2 };
+
+    for (FakeCamera* cam : cams)
+    {
+        uint64_t lastSeq = 0;
+        engine.addCamera(
+            "Cam",
+            [&frames, cam, lastSeq, wait](Mat& frame, clock_type::time_point& captureTime, bool& isNew) mutable {
+                const uint64_t s = cam->seq.load();
+                frame = frames[s % frames.size()];
+                captureTime = clock_type::now();
+                isNew = !wait || s != lastSeq; // poll mode: the old loop never asked
+                lastSeq = s;
+                return true;
+            },
+            []() { return string(); });
+    }
+
+    engine.step(false, 0);
+    engine.resetDetectors();
+
+    ModeResult r;
+    const clock_t cpu0 = clock();
+    const auto end = clock_type::now() + chrono::duration_cast<clock_type::duration>(chrono::duration<double>(seconds));
+    while (clock_type::now() < end)
+    {
+        if (wait)
+            engine.waitForFrames(chrono::milliseconds(50));
+        else
+            this_thread::sleep_for(chrono::milliseconds(1));
+
+        engine.step(true, 1);
+        r.loops++;
+    }
+    r.cpuMs = 1000.0 * (double)(clock() - cpu0) / CLOCKS_PER_SEC;
+
+    for (size_t i = 0; i < engine.size(); i++)
+    {
+        PipelineStats s = engine.camera(i).stats();
+        r.processed += s.newFrames;
+        r.duplicates += s.duplicates;
+    }
+    engine.stop();
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds = (argc > 1) ? atof(argv[1]) : 3.0;
+    const double fps1    = (argc > 2) ? atof(argv[2]) : 30.0;
+    const double fps2    = (argc > 3) ? atof(argv[3]) : 15.0;
+    const int    w       = (argc > 4) ? atoi(argv[4]) : 1280;
+    const int    h       = (argc > 5) ? atoi(argv[5]) : 720;
+
+    // A second of frames with a moving block
+    vector<Mat> frames;
+    for (int i = 0; i < 30; i++)
+    {
+        Mat f(h, w, CV_8UC3, Scalar(90, 100, 110));
+        rectangle(f, Rect((i * 41) % (w * 3 / 4), h / 3, w / 8, h / 4), Scalar(40, 40, 200), FILLED);
+        frames.push_back(f);
+    }
+
+    cout << "New-frame benchmark: " << seconds << " s, cameras at " << fps1 << " and " << fps2 << " fps, " << w
+         << "x" << h << " (captured: ~" << (int)((fps1 + fps2) * seconds) << " frames)\n";
+    printf("%-6s %8s %10s %11s %10s %12s\n", "mode", "loops", "processed", "duplicates", "CPU ms", "CPU ms/s");
+
+    const ModeResult poll = runMode(frames, seconds, fps1, fps2, false);
+    const ModeResult wait = runMode(frames, seconds, fps1, fps2, true);
+    for (const auto& row : { make_pair("poll", poll), make_pair("wait", wait) })
+    {
+        const ModeResult& r = row.second;
+        printf("%-6s %8llu %10llu %11llu %10.1f %12.1f\n", row.first, (unsigned long long)r.loops,
+               (unsigned long long)r.processed, (unsigned long long)r.duplicates, r.cpuMs, r.cpuMs / seconds);
+    }
+    if (wait.cpuMs > 0.0)
+        printf("CPU saved: %.1f%% (%.1fx less)\n", 100.0 * (1.0 - wait.cpuMs / poll.cpuMs), poll.cpuMs / wait.cpuMs);
+    return 0;
+}
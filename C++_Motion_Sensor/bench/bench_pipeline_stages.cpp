@@ -0,0 +1,101 @@
+// Benchmark: per-stage throughput of the motion pipeline on any FrameSource,
+// no webcam needed.
+//
+// Reads `frames` frames from the source as fast as it can (--fast-sources),
+// then runs each later stage over the frames it kept:
+//
+//   read        FrameSource::read (decode for files / images, render for synthetic)
+//   detect      MotionDetector at full resolution
+//   detect /4   MotionDetector on the 1/4 plane (--decimate=4)
+//   jpeg q85    pre-roll buffer encode (--preroll)
+//
+// Single-threaded, so the numbers are frames/s per core. With the default
+// synthetic source the run is reproducible on any box (e.g. CI).
+//
+// Usage: bench_pipeline_stages [source=synthetic:1280x720@30] [frames=300]
+
+#include "frame_source.hpp"
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+static void report(const char* stage, int count, double ms)
+{
+    const double perFrame = (count > 0) ? ms / count : 0.0;
+    printf("%-10s %8d %12.3f %12.1f\n", stage, count, perFrame, (perFrame > 0.0) ? 1000.0 / perFrame : 0.0);
+}
+
+// Runs fn over `count` frames (cycling through `frames`) and reports it
+static void timeStage(const char* stage, const vector<Mat>& frames, int count, const function<void(const Mat&)>& fn)
+{
+    auto t0 = clock_type::now();
+    for (int i = 0; i < count; i++) fn(frames[i % frames.size()]);
+    report(stage, count, chrono::duration<double, milli>(clock_type::now() - t0).count());
+}
+
+int main(int argc, char** argv)
+{
+    const string spec  = (argc > 1) ? argv[1] : "synthetic:1280x720@30";
+    const int    count = (argc > 2) ? max(1, atoi(argv[2])) : 300;
+
+    SourceOptions options;
+    options.fast = true;
+    unique_ptr<FrameSource> source = openFrameSource(spec, options);
+    if (!source->isOpened())
+    {
+        cerr << "Unable to open " << source->describe() << "\n";
+        return 1;
+    }
+
+    cout << "Pipeline stage benchmark: " << source->describe() << ", up to " << count << " frames, 1 thread\n";
+    printf("%-10s %8s %12s %12s\n", "stage", "frames", "ms/frame", "fps/core");
+
+    // Read stage; keep up to a second of frames (by value) for the others
+    vector<Mat> kept;
+    Mat frame;
+    int read = 0;
+    auto t0 = clock_type::now();
+    while (read < count && source->read(frame) && !frame.empty())
+    {
+        read++;
+        if (kept.size() < 30) kept.push_back(frame.clone());
+    }
+    report("read", read, chrono::duration<double, milli>(clock_type::now() - t0).count());
+    if (kept.size() < 2)
+    {
+        cerr << "Source delivered fewer than 2 frames\n";
+        return 1;
+    }
+
+    const int n = max(read, 2);
+
+    MotionDetector full(25, 0.02);
+    full.reset(kept[0]);
+    timeStage("detect", kept, n, [&](const Mat& f) { full.process(f); });
+
+    DetectorOptions quarter;
+    quarter.decimation = 4;
+    MotionDetector decimated(25, 0.02, quarter);
+    decimated.reset(kept[0]);
+    timeStage("detect /4", kept, n, [&](const Mat& f) { decimated.process(f); });
+
+    vector<uchar> jpeg;
+    const vector<int> params = { IMWRITE_JPEG_QUALITY, 85 };
+    timeStage("jpeg q85", kept, n, [&](const Mat& f) { imencode(".jpg", f, jpeg, params); });
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Benchmark: RAM per second of pre-roll history, raw frames vs JPEG packets.
+//
+// Builds a second of synthetic camera frames (smooth gradients, sensor noise
+// and a moving object, so JPEG sees roughly what a real scene gives it), then
+// for raw BGR and each JPEG quality reports bytes per frame, MB per second of
+// buffered history, the seconds that fit in the default --preroll-mb cap and
+// the compression cost per frame.
+//
+// Usage: bench_preroll_memory [fps=30] [width=1920] [height=1080] [capMB=64]
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+// Camera-like frame: lit gradient background, mild noise, one moving block.
+static Mat makeFrame(int w, int h, int i)
+{
+    Mat f(h, w, CV_8UC3);
+    for (int y = 0; y < h; y++)
+    {
+        uchar* row = f.ptr<uchar>(y);
+        for (int x = 0; x < w; x++)
+        {
+            row[3 * x + 0] = (uchar)(60 + 120 * x / w);
+            row[3 * x + 1] = (uchar)(80 + 100 * y / h);
+            row[3 * x + 2] = (uchar)(90 + 60 * (x + y) / (w + h));
+        }
+    }
+
+    Mat noise(h, w, CV_8UC3);
+    randn(noise, Scalar::all(0), Scalar::all(3));
+    f += noise;
+
+    rectangle(f, Rect((i * 23) % (w * 3 / 4), h / 3, w / 8, h / 4), Scalar(40, 40, 200), FILLED);
+    return f;
+}
+
+int main(int argc, char** argv)
+{
+    const int fps    = (argc > 1) ? atoi(argv[1]) : 30;
+    const int w      = (argc > 2) ? atoi(argv[2]) : 1920;
+    const int h      = (argc > 3) ? atoi(argv[3]) : 1080;
+    const int capMB  = (argc > 4) ? atoi(argv[4]) : 64;
+
+    vector<Mat> frames;
+    for (int i = 0; i < fps; i++) frames.push_back(makeFrame(w, h, i));
+
+    const double capBytes = (double)capMB * 1024.0 * 1024.0;
+    const double rawBytes = (double)w * h * 3;
+
+    cout << "Pre-roll memory: " << w << "x" << h << " @ " << fps << " fps, cap " << capMB << " MB\n";
+    printf("%-10s %12s %12s %12s %12s\n", "format", "KB/frame", "MB/s", "sec in cap", "encode ms");
+
+    printf("%-10s %12.1f %12.1f %12.2f %12s\n", "raw BGR", rawBytes / 1024.0,
+           rawBytes * fps / (1024.0 * 1024.0), capBytes / (rawBytes * fps), "-");
+
+    const int qualities[] = { 95, 85, 75, 60, 40 };
+    vector<uchar> buf;
+    for (int q : qualities)
+    {
+        const vector<int> params = { IMWRITE_JPEG_QUALITY, q };
+        double bytes = 0, ms = 0;
+        for (const Mat& f : frames)
+        {
+            auto t0 = clock_type::now();
+            imencode(".jpg", f, buf, params);
+            auto t1 = clock_type::now();
+            bytes += (double)buf.size();
+            ms += chrono::duration<double, milli>(t1 - t0).count();
+        }
+        const double perFrame = bytes / frames.size();
+
+        char name[16];
+        snprintf(name, sizeof(name), "jpeg q%d", q);
+        printf("%-10s %12.1f %12.1f %12.2f %12.2f\n", name, perFrame / 1024.0,
+               perFrame * fps / (1024.0 * 1024.0), capBytes / (perFrame * fps), ms / frames.size());
+    }
+    return 0;
+}
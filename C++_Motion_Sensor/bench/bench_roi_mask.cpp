@@ -0,0 +1,128 @@
+// Benchmark: detection cost with region masks (--roi) covering 0 / 25 / 50 /
+// 75% of the frame.
+//
+// Three ways to ignore the excluded area, per frame:
+//   after     the original chain on the whole frame, with the mask applied
+//             after thresholding (cvtColor, absdiff, threshold, bitwise_and,
+//             countNonZero)
+//   full      MotionDetector with no mask (the fused kernel on every pixel;
+//             what the mask costs to beat)
+//   spans     MotionDetector with the mask compiled into row spans; excluded
+//             pixels are skipped
+// The excluded area is a slanted polygon, so rows get spans of different
+// lengths. Also checks that the span count equals the masked chain's count.
+//
+// Usage: bench_roi_mask [frames=100] [width=1920] [height=1080] [decimate=1]
+
+#include "motion_detector.hpp"
+#include "roi_mask.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+static const int    DIFF_THRESH  = 25;
+static const double MOTION_RATIO = 0.02;
+
+using clock_type = chrono::steady_clock;
+
+static double msSince(clock_type::time_point t0)
+{
+    return chrono::duration<double, milli>(clock_type::now() - t0).count();
+}
+
+// Exclude a quadrilateral over the left `fraction` of the frame, slanted by 10%
+static vector<RoiPolygon> excludeLeft(double fraction)
+{
+    if (fraction <= 0.0) return {};
+    RoiPolygon p;
+    p.exclude = true;
+    const float top = (float)min(1.0, fraction + 0.05), bottom = (float)max(0.0, fraction - 0.05);
+    p.points = {Point2f(0.f, 0.f), Point2f(top, 0.f), Point2f(bottom, 1.f), Point2f(0.f, 1.f)};
+    return {p};
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = (argc > 1) ? max(2, atoi(argv[1])) : 100;
+    const int width  = (argc > 2) ? max(64, atoi(argv[2])) : 1920;
+    const int height = (argc > 3) ? max(64, atoi(argv[3])) : 1080;
+    int decimate     = (argc > 4) ? atoi(argv[4]) : 1;
+    if (decimate != 1 && decimate != 2 && decimate != 4 && decimate != 8) decimate = 1;
+
+    // A few noisy frames with a moving block, cycled
+    vector<Mat> clip;
+    for (int i = 0; i < 8; i++)
+    {
+        Mat f(height, width, CV_8UC3);
+        randu(f, Scalar::all(60), Scalar::all(90));
+        rectangle(f, Rect((i * width / 10) % (width - width / 4), height / 3, width / 4, height / 3),
+                  Scalar(220, 220, 220), FILLED);
+        clip.push_back(f);
+    }
+
+    cout << "ROI mask benchmark: " << width << "x" << height << " BGR, " << frames << " frames, detection at 1/"
+         << decimate << ", kernel " << motion::kernelIsa() << " (ms per frame)\n";
+    printf("%-9s %8s %8s %8s %8s %10s\n", "excluded", "active", "after", "full", "spans", "speedup");
+
+    DetectorOptions options;
+    options.decimation = decimate;
+    for (double fraction : {0.0, 0.25, 0.5, 0.75})
+    {
+        const vector<RoiPolygon> regions = excludeLeft(fraction);
+
+        MotionDetector full(DIFF_THRESH, MOTION_RATIO, options);
+        MotionDetector spans(DIFF_THRESH, MOTION_RATIO, options);
+        spans.setRegions(regions);
+
+        // Mask-after-threshold chain, at full resolution only
+        Mat maskImage;
+        RoiMask(regions, Size(width, height)).toImage(maskImage);
+        Mat gray, prevGray, diff;
+        cvtColor(clip[0], prevGray, COLOR_BGR2GRAY);
+
+        double afterMs = 0.0, fullMs = 0.0, spanMs = 0.0;
+        bool countsMatch = true;
+        full.process(clip[0]);
+        spans.process(clip[0]);
+        for (int i = 1; i <= frames; i++)
+        {
+            const Mat& f = clip[i % clip.size()];
+
+            auto t0 = clock_type::now();
+            cvtColor(f, gray, COLOR_BGR2GRAY);
+            absdiff(gray, prevGray, diff);
+            threshold(diff, diff, DIFF_THRESH, 255, THRESH_BINARY);
+            bitwise_and(diff, maskImage, diff);
+            const int afterCount = countNonZero(diff);
+            swap(gray, prevGray);
+            afterMs += msSince(t0);
+
+            t0 = clock_type::now();
+            full.process(f);
+            fullMs += msSince(t0);
+
+            t0 = clock_type::now();
+            const MotionResult r = spans.process(f);
+            spanMs += msSince(t0);
+
+            if (decimate == 1 && r.changed != afterCount) countsMatch = false;
+        }
+
+        const Size plane = spans.planeSize(Size(width, height));
+        const int active = spans.regionMask().empty() ? plane.area() : spans.regionMask().activePixels();
+        printf("%8.0f%% %7.0f%% %8.3f %8.3f %8.3f %9.2fx%s\n", fraction * 100.0, 100.0 * active / plane.area(),
+               afterMs / frames, fullMs / frames, spanMs / frames, fullMs / max(1e-9, spanMs),
+               countsMatch ? "" : "  (count mismatch!)");
+    }
+    return 0;
+}
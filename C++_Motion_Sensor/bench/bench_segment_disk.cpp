@@ -0,0 +1,213 @@
+// Benchmark: disk bytes per hour, continuous recording vs --segments.
+//
+// Plays a synthetic scene (static background with sensor noise, plus a moving
+// object during "events") through the same pieces the programs use: a
+// MotionDetector decides motion, and the frames go either to one continuous
+// Recorder or to an EventRecorder in segment mode (one clip per event, closed
+// after the hold-off). Three scenes: idle (no events), sparse (a 3 s event per
+// minute) and busy (a 4 s event every 10 s). Bytes written are scaled to an
+// hour; frames encoded show how much encoder work the idle time saves.
+//
+// Frames carry synthetic capture times, so the run is faster than real time.
+// The output files are written to the working directory and deleted afterwards.
+//
+// Usage: bench_segment_disk [seconds=60] [fps=15] [width=1280] [height=720] [holdoff=5]
+
+#include "event_recorder.hpp"
+#include "motion_detector.hpp"
+#include "recorder.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+using clock_type = chrono::steady_clock;
+
+struct Scene
+{
+    const char* name;
+    double periodSec; // one event every periodSec (0 = never)
+    double eventSec;
+};
+
+struct DiskResult
+{
+    uintmax_t bytes = 0;
+    uint64_t  framesEncoded = 0;
+    uint64_t  clips = 0;
+};
+
+// Static background plus a few noise variants (a real sensor is never still).
+static vector<Mat> makeBackgrounds(int w, int h)
+{
+    Mat base(h, w, CV_8UC3);
+    for (int y = 0; y < h; y++)
+    {
+        uchar* row = base.ptr<uchar>(y);
+        for (int x = 0; x < w; x++)
+        {
+            row[3 * x + 0] = (uchar)(60 + 120 * x / w);
+            row[3 * x + 1] = (uchar)(80 + 100 * y / h);
+            row[3 * x + 2] = (uchar)(90 + 60 * (x + y) / (w + h));
+        }
+    }
+
+    vector<Mat> out;
+    for (int i = 0; i < 8; i++)
+    {
+        Mat noise(h, w, CV_8UC3), f;
+        randu(noise, Scalar::all(0), Scalar::all(6));
+        add(base, noise, f);
+        out.push_back(f);
+    }
+    return out;
+}
+
+// Events sit mid-period so the first and last one aren't cut by the run.
+static bool inEvent(const Scene& s, double t)
+{
+    return s.periodSec > 0.0 && fmod(t + s.periodSec / 2.0, s.periodSec) < s.eventSec;
+}
+
+// Frame i of the scene; a fresh buffer only when something is drawn on it.
+static Mat frameAt(const Scene& s, const vector<Mat>& backgrounds, int i, int fps)
+{
+    const Mat& bg = backgrounds[i % backgrounds.size()];
+    if (!inEvent(s, (double)i / fps)) return bg;
+
+    Mat f = bg.clone();
+    const int w = f.cols, h = f.rows;
+    rectangle(f, Rect((i * 13) % (w * 3 / 4), h / 3, w / 6, h / 3), Scalar(40, 40, 200), FILLED);
+    return f;
+}
+
+static uintmax_t fileBytes(const fs::path& p)
+{
+    error_code ec;
+    uintmax_t n = fs::file_size(p, ec);
+    fs::remove(p, ec);
+    return ec ? 0 : n;
+}
+
+static DiskResult runContinuous(const Scene& s, const vector<Mat>& backgrounds, int frames, int fps, int codec)
+{
+    RecorderOptions ro;
+    ro.fixedFps = fps;
+    ro.writeIndex = false;
+
+    const fs::path out = "bench_segment_continuous.mp4";
+    Recorder recorder(ro);
+    recorder.start(out.string(), codec, backgrounds[0].size(), true);
+
+    const auto base = clock_type::now();
+    for (int i = 0; i < frames; i++)
+        recorder.addFrame(frameAt(s, backgrounds, i, fps), base + chrono::microseconds(1000000LL * i / fps));
+    recorder.stop();
+
+    DiskResult r;
+    r.framesEncoded = recorder.stats().writer.written;
+    r.bytes = fileBytes(out);
+    r.clips = 1;
+    return r;
+}
+
+static DiskResult runSegments(const Scene& s, const vector<Mat>& backgrounds, int frames, int fps, int codec,
+                              double holdoff)
+{
+    EventOptions eo;
+    eo.segments = true;
+    eo.postRollSec = holdoff;
+
+    RecorderOptions ro;
+    ro.fixedFps = fps;
+    ro.writeIndex = false;
+
+    vector<fs::path> clips;
+    EventRecorder events(eo, ro, WriterOptions(), codec, [&]() {
+        clips.push_back("bench_segment_" + to_string(clips.size() + 1) + ".mp4");
+        return clips.back().string();
+    });
+
+    MotionDetector detector(25, 0.02);
+    const auto base = clock_type::now();
+    uint64_t motionFrames = 0;
+
+    for (int i = 0; i < frames; i++)
+    {
+        const Mat f = frameAt(s, backgrounds, i, fps);
+        const auto t = base + chrono::microseconds(1000000LL * i / fps);
+
+        events.addFrame(f, t);
+        if (!detector.hasBaseline())
+            detector.reset(f);
+        else if (detector.process(f).motion)
+            events.trigger(t);
+
+        // Stay in step with the worker so no frame is dropped for speed.
+        for (;;)
+        {
+            EventRecorderStats st = events.stats();
+            if (st.frames + st.rawDropped >= (uint64_t)i + 1) break;
+            this_thread::sleep_for(chrono::microseconds(100));
+        }
+        if (events.stats().clipOpen) motionFrames++;
+    }
+    events.stop();
+
+    DiskResult r;
+    r.clips = events.stats().clips;
+    r.framesEncoded = motionFrames; // frames that went into a clip (approximately)
+    for (const fs::path& p : clips) r.bytes += fileBytes(p);
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    const int    seconds = (argc > 1) ? atoi(argv[1]) : 60;
+    const int    fps     = (argc > 2) ? atoi(argv[2]) : 15;
+    const int    w       = (argc > 3) ? atoi(argv[3]) : 1280;
+    const int    h       = (argc > 4) ? atoi(argv[4]) : 720;
+    const double holdoff = (argc > 5) ? atof(argv[5]) : 5.0;
+
+    const int frames = seconds * fps;
+    const int codec = VideoWriter::fourcc('m', 'p', '4', 'v');
+    const vector<Mat> backgrounds = makeBackgrounds(w, h);
+
+    const Scene scenes[] = {
+        { "idle",   0.0,  0.0 },
+        { "sparse", 60.0, 3.0 },
+        { "busy",   10.0, 4.0 },
+    };
+
+    cout << "Disk per hour: " << seconds << " s simulated, " << w << "x" << h << " @ " << fps
+         << " fps, mp4v, hold-off " << holdoff << " s\n";
+    printf("%-8s %-12s %10s %10s %8s %8s\n", "scene", "mode", "MB/hour", "frames", "clips", "saved");
+
+    const double toHour = 3600.0 / seconds / (1024.0 * 1024.0);
+    for (const Scene& s : scenes)
+    {
+        DiskResult cont = runContinuous(s, backgrounds, frames, fps, codec);
+        DiskResult seg = runSegments(s, backgrounds, frames, fps, codec, holdoff);
+
+        const double saved = (cont.bytes > 0) ? 100.0 * (1.0 - (double)seg.bytes / (double)cont.bytes) : 0.0;
+        printf("%-8s %-12s %10.1f %10llu %8llu %8s\n", s.name, "continuous", cont.bytes * toHour,
+               (unsigned long long)cont.framesEncoded, (unsigned long long)cont.clips, "-");
+        printf("%-8s %-12s %10.1f %10llu %8llu %7.1f%%\n", s.name, "segments", seg.bytes * toHour,
+               (unsigned long long)seg.framesEncoded, (unsigned long long)seg.clips, saved);
+    }
+    return 0;
+}
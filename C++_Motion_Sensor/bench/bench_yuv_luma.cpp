@@ -0,0 +1,122 @@
+// Benchmark: per-frame conversion cost of the BGR path vs detecting on the
+// camera's Y plane (--capture-format=yuyv|nv12).
+//
+// A synthetic YUV camera (frame_source.hpp) delivers raw YUYV / NV12 frames.
+// For each layout, every frame goes through:
+//
+//   bgr path   YUV -> BGR (what VideoCapture does with RGB conversion on),
+//              then detection, which converts BGR back to luma in its pass
+//   y plane    the Y plane (NV12: a header, YUYV: one gather), then detection
+//              on it; BGR is made only for frames a consumer needs in color
+//
+// Reported per frame: conversion ms, detection ms, and the total with no
+// color consumer and with every frame recorded (lazy BGR on the encoder
+// thread, counted here). Also the mean changed-pixel ratio of each path: the
+// Y plane is the camera's video-range luma, so diffs come out a bit smaller
+// than on the BGR-converted gray.
+//
+// Usage: bench_yuv_luma [frames=300] [width=1280] [height=720] [decimate=1]
+
+#include "frame_format.hpp"
+#include "frame_source.hpp"
+#include "motion_detector.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+using clock_type = chrono::steady_clock;
+
+static double msBetween(clock_type::time_point t0, clock_type::time_point t1)
+{
+    return chrono::duration<double, milli>(t1 - t0).count();
+}
+
+static void runFormat(PixelFormat format, int count, int width, int height, int decimate)
+{
+    SourceOptions options;
+    options.fast = true;
+    options.captureFormat = format;
+    unique_ptr<FrameSource> camera =
+        openFrameSource("synthetic:" + to_string(width) + "x" + to_string(height), options);
+
+    // About a second of frames, cycled
+    vector<Mat> frames;
+    Mat f;
+    while (frames.size() < 30 && camera->read(f) && !f.empty()) frames.push_back(f.clone());
+    if (frames.size() < 2 || camera->pixelFormat() != format)
+    {
+        cerr << "Source delivered no " << pixelFormatName(format) << " frames\n";
+        return;
+    }
+
+    DetectorOptions detOptions;
+    detOptions.decimation = decimate;
+
+    // BGR path
+    MotionDetector bgrDet(25, 0.02, detOptions);
+    Mat bgr;
+    double bgrConvert = 0.0, bgrDetect = 0.0, bgrRatio = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        auto t0 = clock_type::now();
+        toBgr(frames[i % frames.size()], format, bgr);
+        auto t1 = clock_type::now();
+        bgrRatio += bgrDet.process(bgr).ratio;
+        auto t2 = clock_type::now();
+        bgrConvert += msBetween(t0, t1);
+        bgrDetect += msBetween(t1, t2);
+    }
+
+    // Y-plane path, plus the BGR a recording would still need
+    MotionDetector yDet(25, 0.02, detOptions);
+    Mat scratch, lazy;
+    double yConvert = 0.0, yDetect = 0.0, yLazy = 0.0, yRatio = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        const Mat& frame = frames[i % frames.size()];
+        auto t0 = clock_type::now();
+        const Mat plane = lumaPlane(frame, format, scratch);
+        auto t1 = clock_type::now();
+        yRatio += yDet.process(plane).ratio;
+        auto t2 = clock_type::now();
+        toBgr(frame, format, lazy);
+        auto t3 = clock_type::now();
+        yConvert += msBetween(t0, t1);
+        yDetect += msBetween(t1, t2);
+        yLazy += msBetween(t2, t3);
+    }
+
+    const double n = (double)count;
+    printf("%-5s %-8s %9.3f %9.3f %12.3f %12.3f %10.4f\n", pixelFormatName(format), "bgr path", bgrConvert / n,
+           bgrDetect / n, (bgrConvert + bgrDetect) / n, (bgrConvert + bgrDetect) / n, bgrRatio / n);
+    printf("%-5s %-8s %9.3f %9.3f %12.3f %12.3f %10.4f\n", pixelFormatName(format), "y plane", yConvert / n,
+           yDetect / n, (yConvert + yDetect) / n, (yConvert + yDetect + yLazy) / n, yRatio / n);
+}
+
+int main(int argc, char** argv)
+{
+    const int count  = (argc > 1) ? max(2, atoi(argv[1])) : 300;
+    const int width  = (argc > 2) ? max(16, atoi(argv[2])) & ~1 : 1280;
+    const int height = (argc > 3) ? max(16, atoi(argv[3])) & ~1 : 720;
+    int decimate     = (argc > 4) ? atoi(argv[4]) : 1;
+    if (decimate != 1 && decimate != 2 && decimate != 4 && decimate != 8) decimate = 1;
+
+    cout << "YUV luma benchmark: synthetic " << width << "x" << height << ", " << count
+         << " frames per path, detection at 1/" << decimate << ", 1 thread (ms per frame)\n";
+    printf("%-5s %-8s %9s %9s %12s %12s %10s\n", "fmt", "path", "convert", "detect", "no color", "recording",
+           "ratio");
+    runFormat(PixelFormat::YUYV, count, width, height, decimate);
+    runFormat(PixelFormat::NV12, count, width, height, decimate);
+    return 0;
+}
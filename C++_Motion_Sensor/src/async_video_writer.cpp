@@ -0,0 +1,234 @@
+#include "async_video_writer.hpp"
+
+#include "mjpeg.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+using Clock = chrono::steady_clock;
+
+uint64_t microsSince(Clock::time_point t0, Clock::time_point t1)
+{
+    return (uint64_t)chrono::duration_cast<chrono::microseconds>(t1 - t0).count();
+}
+
+void storeMax(atomic<uint64_t>& target, uint64_t v)
+{
+    uint64_t cur = target.load(memory_order_relaxed);
+    while (v > cur && !target.compare_exchange_weak(cur, v, memory_order_relaxed)) {}
+}
+
+// Writer that takes already-encoded packets. Only FFmpeg in OpenCV 4.10+
+// has it; elsewhere passthrough falls back to decode + encode.
+bool openRawWriter(VideoWriter& writer, const string& path, int fourcc, double fps, Size frameSize, bool isColor)
+{
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 10)
+    return writer.open(path, CAP_FFMPEG, fourcc, fps, frameSize,
+                       { VIDEOWRITER_PROP_RAW_VIDEO, 1, VIDEOWRITER_PROP_IS_COLOR, isColor ? 1 : 0 });
+#else
+    (void)writer; (void)path; (void)fourcc; (void)fps; (void)frameSize; (void)isColor;
+    return false;
+#endif
+}
+} // namespace
+
+AsyncVideoWriter::AsyncVideoWriter(const WriterOptions& options)
+    : options(options)
+{
+}
+
+AsyncVideoWriter::~AsyncVideoWriter()
+{
+    release();
+}
+
+bool AsyncVideoWriter::open(const string& path, int fourcc, double fps, Size frameSize, bool isColor,
+                            const string& indexPath)
+{
+    release();
+
+    rawMux = options.passthrough && openRawWriter(writer, path, fourcc, fps, frameSize, isColor);
+    if (!rawMux && !writer.open(path, fourcc, fps, frameSize, isColor))
+        return false;
+
+    outputFps = fps;
+    outputColor = isColor;
+    if (!indexPath.empty())
+    {
+        index.open(indexPath, ios::out);
+        if (index.is_open())
+            index << "Frame,VideoMs,CaptureMs,LogSecond,Duplicate\n";
+    }
+
+    queue.reset(new BoundedQueue<QueuedFrame>((size_t)max(1, options.queueCapacity), options.overflow));
+    written = 0;
+    muxed = 0;
+    encodeUsTotal = 0;
+    encodeUsMax = 0;
+    latencyUsMax = 0;
+
+    opened = true;
+    th = thread(&AsyncVideoWriter::loop, this);
+    return true;
+}
+
+bool AsyncVideoWriter::write(const Mat& frame)
+{
+    FrameStamp stamp;
+    stamp.captureTime = Clock::now();
+    return write(frame, stamp);
+}
+
+bool AsyncVideoWriter::write(const Mat& frame, const FrameStamp& stamp)
+{
+    if (!opened || frame.empty()) return false;
+
+    QueuedFrame q;
+    q.frame = frame; // header only, shares the pixel buffer
+    q.stamp = stamp;
+    q.queuedAt = Clock::now();
+    return queue->push(std::move(q));
+}
+
+bool AsyncVideoWriter::write(const EncodedFrame& packet, const FrameStamp& stamp)
+{
+    if (!opened || !packet || packet->empty()) return false;
+
+    QueuedFrame q;
+    q.packet = packet;
+    q.stamp = stamp;
+    q.queuedAt = Clock::now();
+    return queue->push(std::move(q));
+}
+
+void AsyncVideoWriter::release()
+{
+    if (!opened) return;
+
+    queue->close(); // encoder drains what's left, then exits
+    if (th.joinable()) th.join();
+
+    writer.release();
+    if (index.is_open()) index.close();
+    opened = false;
+}
+
+void AsyncVideoWriter::loop()
+{
+    QueuedFrame q;
+    Clock::time_point firstCapture{};
+    uint64_t frameNo = 0;
+    vector<uchar> jpeg;
+    Mat bgr;
+
+    while (queue->pop(q))
+    {
+        auto t0 = Clock::now();
+        if (!q.frame.empty() && q.stamp.format != PixelFormat::BGR)
+            q.frame = toBgr(q.frame, q.stamp.format, bgr);
+
+        bool wrote = false;
+        if (rawMux)
+        {
+            // The raw writer takes one packet per write(), as a 1-row byte Mat
+            if (q.packet)
+            {
+                writer.write(Mat(1, (int)q.packet->size(), CV_8UC1, (void*)q.packet->data()));
+                muxed.fetch_add(1, memory_order_relaxed);
+                wrote = true;
+            }
+            else if (isJpegPacket(q.frame))
+            {
+                writer.write(q.frame);
+                muxed.fetch_add(1, memory_order_relaxed);
+                wrote = true;
+            }
+            else if (!q.frame.empty() && imencode(".jpg", q.frame, jpeg, { IMWRITE_JPEG_QUALITY, 90 }))
+            {
+                writer.write(Mat(1, (int)jpeg.size(), CV_8UC1, jpeg.data()));
+                wrote = true;
+            }
+        }
+        else
+        {
+            if (q.frame.empty() && q.packet)
+                q.frame = imdecode(*q.packet, outputColor ? IMREAD_COLOR : IMREAD_GRAYSCALE);
+            else if (isJpegPacket(q.frame))
+                q.frame = imdecode(q.frame, outputColor ? IMREAD_COLOR : IMREAD_GRAYSCALE);
+            if (!q.frame.empty())
+            {
+                writer.write(q.frame);
+                wrote = true;
+            }
+        }
+        auto t1 = Clock::now();
+
+        uint64_t encodeUs = microsSince(t0, t1);
+        encodeUsTotal.fetch_add(encodeUs, memory_order_relaxed);
+        storeMax(encodeUsMax, encodeUs);
+        storeMax(latencyUsMax, microsSince(q.queuedAt, t1));
+
+        // A corrupt packet (common on USB MJPEG) or a failed JPEG encode puts
+        // nothing in the file: it must not take a frame slot in the index
+        if (!wrote)
+        {
+            failed.fetch_add(1, memory_order_relaxed);
+            q.frame.release();
+            q.packet.reset();
+            continue;
+        }
+        written.fetch_add(1, memory_order_release);
+
+        // Index rows describe what actually went into the file (drops included).
+        if (index.is_open())
+        {
+            if (frameNo == 0) firstCapture = q.stamp.captureTime;
+            double videoMs = (outputFps > 0.0) ? 1000.0 * (double)frameNo / outputFps : 0.0;
+            double captureMs = chrono::duration<double, milli>(q.stamp.captureTime - firstCapture).count();
+            char row[128];
+            snprintf(row, sizeof(row), "%llu,%.3f,%.3f,%d,%d\n", (unsigned long long)frameNo, videoMs, captureMs,
+                     q.stamp.logSecond, q.stamp.duplicate ? 1 : 0);
+            index << row;
+        }
+        frameNo++;
+
+        q.frame.release(); // hand the buffer back as soon as it's encoded
+        q.packet.reset();
+    }
+}
+
+AsyncWriterStats AsyncVideoWriter::stats() const
+{
+    AsyncWriterStats s;
+    if (queue) s.queue = queue->stats();
+
+    s.written = written.load(memory_order_acquire);
+    s.muxed = muxed.load(memory_order_relaxed);
+    s.failed = failed.load(memory_order_relaxed);
+    const uint64_t handled = s.written + s.failed;
+    s.encodeMsAvg = (handled > 0) ? encodeUsTotal.load(memory_order_relaxed) / 1000.0 / (double)handled : 0.0;
+    s.encodeMsMax = encodeUsMax.load(memory_order_relaxed) / 1000.0;
+    s.latencyMsMax = latencyUsMax.load(memory_order_relaxed) / 1000.0;
+    return s;
+}
+
+string formatWriterStats(const AsyncWriterStats& s)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "written %llu, dropped %llu, blocked %llu, max depth %zu, encode avg %.1f ms / max %.1f ms, latency max %.1f ms",
+             (unsigned long long)s.written, (unsigned long long)s.queue.dropped,
+             (unsigned long long)s.queue.blocked, s.queue.maxDepth,
+             s.encodeMsAvg, s.encodeMsMax, s.latencyMsMax);
+    string line = buf;
+    if (s.muxed > 0) line += ", " + to_string(s.muxed) + " packets muxed without re-encoding";
+    if (s.failed > 0) line += ", " + to_string(s.failed) + " frames lost to decode / encode errors";
+    return line;
+}
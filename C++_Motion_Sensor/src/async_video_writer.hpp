@@ -0,0 +1,152 @@
+#pragma once
+
+// VideoWriter that encodes on its own thread. One per camera.
+
+#include "bounded_queue.hpp"
+#include "frame_format.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Recording switches (see run_options.hpp for the command-line side).
+struct WriterOptions
+{
+    // Frames allowed to wait for the encoder. Each queued frame keeps its
+    // pixel buffer alive, so memory is roughly capacity x frame size.
+    int queueCapacity = 8;
+
+    // What happens when the encoder falls behind and the queue is full.
+    OverflowPolicy overflow = OverflowPolicy::Block;
+
+    // MJPEG passthrough: open the file with an MJPG fourcc and mux JPEG
+    // packets into it as they are (cv::VIDEOWRITER_PROP_RAW_VIDEO, FFmpeg
+    // backend, OpenCV 4.10+). Image frames are JPEG-encoded first. Where raw
+    // writing isn't available, packets are decoded and re-encoded as before.
+    bool passthrough = false;
+};
+
+// A compressed frame (JPEG or anything cv::imdecode() reads), shared between
+// the pre-roll buffer and the encoder queue without copying.
+using EncodedFrame = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Where a queued frame came from; written to the optional frame index.
+struct FrameStamp
+{
+    std::chrono::steady_clock::time_point captureTime{}; // default: when write() was called
+    int  logSecond = 0;     // motion-log second the frame belongs to (0 = sensor not running)
+    bool duplicate = false; // repeats the previous source frame to hold the output rate
+
+    // Layout of the queued frame; raw YUV is converted to BGR on the encoder
+    // thread, so only frames that get written pay for the conversion.
+    PixelFormat format = PixelFormat::BGR;
+};
+
+// Counters exported by AsyncVideoWriter (snapshot, safe to read any time).
+struct AsyncWriterStats
+{
+    BoundedQueueStats queue;   // depth, max depth, pushed, dropped, blocked
+    uint64_t written = 0;      // frames handed to cv::VideoWriter
+    uint64_t muxed = 0;        // of those, packets written as they are (passthrough)
+    uint64_t failed = 0;       // frames dropped because a packet didn't decode or a JPEG didn't encode
+    double   encodeMsAvg = 0;  // time spent in VideoWriter::write() (plus imdecode / YUV -> BGR)
+    double   encodeMsMax = 0;
+    double   latencyMsMax = 0; // write() call -> frame encoded, worst case
+};
+
+// ============================================================
+// AsyncVideoWriter
+// ============================================================
+//
+// Why this exists:
+// - VideoWriter::write() (mp4v encode + disk) used to run on the main loop,
+//   so a slow encode or a slow disk delayed display, keys and detection
+// - write() here only queues a reference-counted cv::Mat header (no copy);
+//   a dedicated thread does the encoding
+// - The queue is bounded; the overflow policy decides between stalling the
+//   main loop (Block) and dropping frames (DropOldest / DropNewest)
+// - Compressed frames (pre-roll packets) can be queued too; decoding them is
+//   the encoder thread's job. With WriterOptions::passthrough they aren't
+//   decoded at all but muxed into the file
+//
+// Because frames are shared, not copied, the caller must not decode into a
+// buffer that is still queued. Call detachIfShared() (frame_ring.hpp) on the
+// capture Mat before each VideoCapture::read().
+//
+class AsyncVideoWriter
+{
+public:
+    explicit AsyncVideoWriter(const WriterOptions& options = WriterOptions());
+
+    AsyncVideoWriter(const AsyncVideoWriter&) = delete;
+    AsyncVideoWriter& operator=(const AsyncVideoWriter&) = delete;
+
+    ~AsyncVideoWriter();
+
+    // Same arguments as cv::VideoWriter::open(). Starts the encoder thread.
+    // With options.passthrough, fourcc should be MJPG (and the file an .avi).
+    // With an indexPath, the encoder also writes one CSV row per encoded frame:
+    // Frame,VideoMs,CaptureMs,LogSecond,Duplicate (CaptureMs relative to the
+    // first encoded frame), so video time can be mapped back to capture time.
+    bool open(const std::string& path, int fourcc, double fps, cv::Size frameSize, bool isColor,
+              const std::string& indexPath = std::string());
+
+    bool isOpened() const { return opened; }
+
+    // Packets go into the file without re-encoding (passthrough took effect).
+    bool muxing() const { return rawMux; }
+
+    // Queue a frame for encoding. Returns false if it was dropped.
+    bool write(const cv::Mat& frame);
+    bool write(const cv::Mat& frame, const FrameStamp& stamp);
+
+    // Queue a compressed frame; it's decoded on the encoder thread.
+    bool write(const EncodedFrame& packet, const FrameStamp& stamp);
+
+    // Encode everything still queued, stop the thread and close the file.
+    void release();
+
+    AsyncWriterStats stats() const;
+
+private:
+    struct QueuedFrame
+    {
+        cv::Mat frame;
+        EncodedFrame packet; // used when frame is empty
+        FrameStamp stamp;
+        std::chrono::steady_clock::time_point queuedAt{};
+    };
+
+    void loop();
+
+    WriterOptions options;
+    cv::VideoWriter writer;
+    std::unique_ptr<BoundedQueue<QueuedFrame>> queue; // one per open()
+    std::thread th;
+    bool opened = false;
+    bool rawMux = false;
+
+    // Encoder-thread only
+    std::ofstream index;
+    double outputFps = 0.0;
+    bool outputColor = true;
+
+    // Encoder-side counters
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> muxed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> encodeUsTotal{0};
+    std::atomic<uint64_t> encodeUsMax{0};
+    std::atomic<uint64_t> latencyUsMax{0};
+};
+
+// One-line summary for logs, e.g. "written 3600, dropped 0, max depth 3, encode avg 4.1 ms".
+std::string formatWriterStats(const AsyncWriterStats& s);
@@ -0,0 +1,164 @@
+#include "background_model.hpp"
+
+#include "motion_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+// Checkpoint header, followed by the state rows (native-endian uint16)
+struct StateHeader
+{
+    char     magic[4];  // "MSBG"
+    uint32_t version;   // 1
+    int32_t  width;
+    int32_t  height;
+    uint32_t fracBits;  // motion::kBackgroundShift
+    uint32_t alphaQ15;  // learning rate it was built with (informational)
+};
+
+const char kMagic[4] = {'M', 'S', 'B', 'G'};
+} // namespace
+
+BackgroundModel::BackgroundModel(double learningRate)
+{
+    const double rate = min(0.5, max(0.001, learningRate));
+    alphaQ15 = (int)lround(rate * 32768.0);
+}
+
+void BackgroundModel::reset(const Mat& luma)
+{
+    CV_Assert(luma.type() == CV_8UC1);
+    state.create(luma.rows, luma.cols, CV_16UC1);
+    for (int y = 0; y < luma.rows; y++)
+    {
+        const uint8_t* in = luma.ptr<uint8_t>(y);
+        uint16_t* out = state.ptr<uint16_t>(y);
+        for (int x = 0; x < luma.cols; x++) out[x] = (uint16_t)(in[x] << motion::kBackgroundShift);
+    }
+}
+
+int BackgroundModel::diffUpdateRows(const Mat& luma, int diffThresh, int rowBegin, int rowEnd)
+{
+    CV_Assert(luma.type() == CV_8UC1 && luma.size() == state.size());
+    CV_Assert(diffThresh >= 0 && diffThresh <= 255);
+
+    // Continuous planes are processed as one long row per band.
+    int cols = luma.cols;
+    if (luma.isContinuous() && state.isContinuous())
+    {
+        cols *= (rowEnd - rowBegin);
+        rowEnd = rowBegin + 1;
+    }
+
+    int changed = 0;
+    for (int y = rowBegin; y < rowEnd; y++)
+        changed += motion::backgroundDiffUpdateRow(luma.ptr<uint8_t>(y), state.ptr<uint16_t>(y), cols, diffThresh,
+                                                   alphaQ15);
+    return changed;
+}
+
+int BackgroundModel::diffUpdateSpan(const Mat& luma, int diffThresh, int y, int x0, int x1)
+{
+    return motion::backgroundDiffUpdateRow(luma.ptr<uint8_t>(y) + x0, state.ptr<uint16_t>(y) + x0, x1 - x0,
+                                           diffThresh, alphaQ15);
+}
+
+void BackgroundModel::countCells(const Mat& luma, int diffThresh, int y, int x0, int x1, int cellShift,
+                                 uint16_t* cells) const
+{
+    motion::cellBackgroundCountRow(luma.ptr<uint8_t>(y), state.ptr<uint16_t>(y), x0, x1, diffThresh, cellShift,
+                                   cells);
+}
+
+void BackgroundModel::sums(const Mat& luma, int y, int x0, int x1, uint64_t& lumaSum, uint64_t& backgroundSum) const
+{
+    motion::backgroundSumsRow(luma.ptr<uint8_t>(y), state.ptr<uint16_t>(y), x0, x1, lumaSum, backgroundSum);
+}
+
+int BackgroundModel::gainDiffCount(const Mat& luma, int diffThresh, int y, int x0, int x1, int gainQ8) const
+{
+    return motion::gainBackgroundCountRow(luma.ptr<uint8_t>(y), state.ptr<uint16_t>(y), x0, x1, diffThresh, gainQ8);
+}
+
+void BackgroundModel::toLuma(Mat& dst) const
+{
+    dst.create(state.rows, state.cols, CV_8UC1);
+    const int rnd = 1 << (motion::kBackgroundShift - 1);
+    for (int y = 0; y < state.rows; y++)
+    {
+        const uint16_t* in = state.ptr<uint16_t>(y);
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        for (int x = 0; x < state.cols; x++) out[x] = (uint8_t)((in[x] + rnd) >> motion::kBackgroundShift);
+    }
+}
+
+bool BackgroundModel::save(const string& path) const
+{
+    if (state.empty()) return false;
+
+    StateHeader h{};
+    memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = 1;
+    h.width = state.cols;
+    h.height = state.rows;
+    h.fracBits = motion::kBackgroundShift;
+    h.alphaQ15 = (uint32_t)alphaQ15;
+
+    // A crash mid-write must not leave a truncated checkpoint behind
+    const string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out) return false;
+        out.write((const char*)&h, sizeof(h));
+        for (int y = 0; y < state.rows; y++)
+            out.write((const char*)state.ptr<uint16_t>(y), (streamsize)state.cols * sizeof(uint16_t));
+        if (!out) return false;
+    }
+
+    error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+bool BackgroundModel::load(const string& path)
+{
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    StateHeader h{};
+    if (!in.read((char*)&h, sizeof(h))) return false;
+    if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != 1 ||
+        h.fracBits != (uint32_t)motion::kBackgroundShift || h.width <= 0 || h.height <= 0 ||
+        h.width > 16384 || h.height > 16384)
+        return false;
+
+    Mat loaded(h.height, h.width, CV_16UC1);
+    for (int y = 0; y < loaded.rows; y++)
+        if (!in.read((char*)loaded.ptr<uint16_t>(y), (streamsize)loaded.cols * sizeof(uint16_t))) return false;
+
+    // Values outside luma << 7 would break the 16-bit lanes of the kernel
+    const uint16_t top = (uint16_t)(255 << motion::kBackgroundShift);
+    for (int y = 0; y < loaded.rows; y++)
+    {
+        const uint16_t* row = loaded.ptr<uint16_t>(y);
+        if (any_of(row, row + loaded.cols, [&](uint16_t v) { return v > top; })) return false;
+    }
+
+    state = loaded;
+    return true;
+}
+
+string backgroundStatePath(const string& dir, const string& camera)
+{
+    return (fs::path(dir) / (camera + "_background.bin")).string();
+}
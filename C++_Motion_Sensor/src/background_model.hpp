@@ -0,0 +1,77 @@
+#pragma once
+
+// Fixed-point running-average background, the baseline of --background mode.
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+
+// ============================================================
+// BackgroundModel
+// ============================================================
+//
+// Why this exists:
+// - Differencing against the previous frame only sees what changed in the
+//   last frame period: a slow intruder moves a few pixels per frame and
+//   barely registers, while single-frame sensor noise does
+// - Comparing against an exponential average of past frames keeps a slow
+//   mover standing out until it has been still for a while, and averages the
+//   noise out of the baseline
+//
+// Each pixel is luma << 7 in 16 bits (1/128 of a gray level), updated as
+//     bg += round((luma - bg) * alpha)
+// with alpha in Q15, in the same pass that counts the changed pixels
+// (motion_kernel.hpp). Learning rates under ~1/1000 stall short of the scene
+// by a few gray levels, so they are clamped there.
+//
+// The state can be checkpointed to a file and restored on the next run, so a
+// restart doesn't spend the first seconds relearning the scene.
+//
+class BackgroundModel
+{
+public:
+    // `learningRate`: fraction of each frame blended in (0.001 .. 0.5).
+    explicit BackgroundModel(double learningRate = 0.02);
+
+    bool empty() const { return state.empty(); }
+    cv::Size size() const { return state.size(); }
+    double learningRate() const { return (double)alphaQ15 / 32768.0; }
+
+    // Every pixel starts at this luma plane (CV_8UC1).
+    void reset(const cv::Mat& luma);
+
+    // Rows [rowBegin, rowEnd) of a luma plane the model's size: count pixels
+    // more than diffThresh away from the background, then learn them.
+    int diffUpdateRows(const cv::Mat& luma, int diffThresh, int rowBegin, int rowEnd);
+
+    // Same for columns [x0, x1) of row y (ROI spans); not checked per call.
+    int diffUpdateSpan(const cv::Mat& luma, int diffThresh, int y, int x0, int x1);
+
+    // Changed pixels of columns [x0, x1) of row y per cell (blob extraction,
+    // motion_kernel.hpp cellBackgroundCountRow), before the row is learned.
+    void countCells(const cv::Mat& luma, int diffThresh, int y, int x0, int x1, int cellShift,
+                    uint16_t* cells) const;
+
+    // Lighting compensation (motion_kernel.hpp): luma totals of columns
+    // [x0, x1) of row y and of the background under them, and the pixels more
+    // than diffThresh away from the background scaled by gainQ8 / 256.
+    void sums(const cv::Mat& luma, int y, int x0, int x1, uint64_t& lumaSum, uint64_t& backgroundSum) const;
+    int gainDiffCount(const cv::Mat& luma, int diffThresh, int y, int x0, int x1, int gainQ8) const;
+
+    // The background as 8-bit luma.
+    void toLuma(cv::Mat& dst) const;
+
+    // Checkpoint: written to a temporary file first and renamed over `path`.
+    bool save(const std::string& path) const;
+
+    // False (model unchanged) if the file is missing or not a checkpoint.
+    bool load(const std::string& path);
+
+private:
+    cv::Mat state; // CV_16UC1, luma << 7
+    int alphaQ15;
+};
+
+// <dir>/<camera>_background.bin, where --background-state keeps a camera's model.
+std::string backgroundStatePath(const std::string& dir, const std::string& camera);
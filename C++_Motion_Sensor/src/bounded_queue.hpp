@@ -0,0 +1,133 @@
+#pragma once
+
+// Bounded multi-producer / multi-consumer queue with a configurable overflow
+// policy. Used to hand frames from the main loop to encoder threads.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// What push() does when the queue is full.
+enum class OverflowPolicy
+{
+    Block,      // wait for the consumer (nothing is lost, producer may stall)
+    DropOldest, // evict the oldest queued item to make room
+    DropNewest  // reject the item being pushed
+};
+
+struct BoundedQueueStats
+{
+    uint64_t pushed   = 0; // items accepted into the queue
+    uint64_t dropped  = 0; // items evicted (DropOldest) or rejected (DropNewest)
+    uint64_t blocked  = 0; // pushes that had to wait for space (Block)
+    size_t   depth    = 0; // items queued right now
+    size_t   maxDepth = 0; // high-water mark
+};
+
+// ============================================================
+// BoundedQueue
+// ============================================================
+//
+// Why this exists:
+// - The main loop must never wait on a slow consumer unless told to
+// - A fixed capacity bounds memory when the consumer falls behind
+// - close() wakes everyone up so the consumer can drain and exit
+//
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(size_t capacity, OverflowPolicy policy)
+        : capacity(std::max<size_t>(1, capacity)), policy(policy)
+    {
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns false if the item was not queued (DropNewest overflow, or closed).
+    bool push(T item)
+    {
+        T evicted; // destroyed outside the lock
+        {
+            std::unique_lock<std::mutex> lock(m);
+            if (closed) return false;
+
+            if (items.size() >= capacity)
+            {
+                switch (policy)
+                {
+                case OverflowPolicy::Block:
+                    counters.blocked++;
+                    notFull.wait(lock, [&] { return closed || items.size() < capacity; });
+                    if (closed) return false;
+                    break;
+                case OverflowPolicy::DropOldest:
+                    evicted = std::move(items.front());
+                    items.pop_front();
+                    counters.dropped++;
+                    break;
+                case OverflowPolicy::DropNewest:
+                    counters.dropped++;
+                    return false;
+                }
+            }
+
+            items.push_back(std::move(item));
+            counters.pushed++;
+            counters.maxDepth = std::max(counters.maxDepth, items.size());
+        }
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Waits for an item. Returns false once the queue is closed and drained.
+    bool pop(T& out)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            notEmpty.wait(lock, [&] { return closed || !items.empty(); });
+            if (items.empty()) return false;
+
+            out = std::move(items.front());
+            items.pop_front();
+        }
+        notFull.notify_one();
+        return true;
+    }
+
+    // No more pushes; pop() keeps returning queued items, then false.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    BoundedQueueStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m);
+        BoundedQueueStats s = counters;
+        s.depth = items.size();
+        return s;
+    }
+
+private:
+    const size_t capacity;
+    const OverflowPolicy policy;
+
+    mutable std::mutex m;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    bool closed = false;
+
+    BoundedQueueStats counters;
+};
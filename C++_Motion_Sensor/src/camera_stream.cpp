@@ -0,0 +1,140 @@
+#include "camera_stream.hpp"
+
+#include <chrono>
+
+using namespace cv;
+using namespace std;
+
+CameraStream::CameraStream(int index, int ringSlots)
+    : CameraStream(openFrameSource(to_string(index)), ringSlots)
+{
+}
+
+CameraStream::CameraStream(unique_ptr<FrameSource> frameSource, int ringSlots, CaptureBarrier* sync)
+    : source(std::move(frameSource)), barrier(sync), ring(ringSlots), running(false), ok(false)
+{
+    if (!source || !source->isOpened())
+    {
+        ok = false;
+        return;
+    }
+
+    // Warm start: grab one frame so consumers have something immediately.
+    if (source->read(ring.writeBuffer()) && !ring.writeBuffer().empty())
+    {
+        ring.publish(chrono::steady_clock::now());
+        format = source->pixelFormat();
+        ok = true;
+    }
+    else
+    {
+        ok = false;
+        source.reset();
+        return;
+    }
+
+    running = true;
+    if (barrier) barrier->join();
+    th = thread(&CameraStream::loop, this);
+}
+
+CameraStream::~CameraStream()
+{
+    stop();
+}
+
+const FrameSlot* CameraStream::borrow()
+{
+    if (!ok) return nullptr;
+
+    const FrameSlot* slot = ring.acquireLatest();
+    if (!slot || slot->frame.empty()) return nullptr;
+
+    return slot;
+}
+
+bool CameraStream::read(Mat& out, bool* outIsNew, chrono::steady_clock::time_point* outCaptureTime)
+{
+    const FrameSlot* slot = borrow();
+    if (!slot) return false;
+
+    out = slot->frame; // header only, shares the slot buffer
+
+    if (outIsNew)
+    {
+        *outIsNew = (slot->seq != lastReadSeq);
+    }
+    lastReadSeq = slot->seq;
+
+    if (outCaptureTime)
+    {
+        *outCaptureTime = slot->captureTime;
+    }
+
+    return true;
+}
+
+void CameraStream::stop()
+{
+    if (!running) return;
+
+    running = false;
+    if (th.joinable()) th.join();
+
+    source.reset();
+}
+
+double CameraStream::get(int propId) const
+{
+    if (!source || !source->isOpened()) return 0.0;
+    return source->get(propId);
+}
+
+void CameraStream::loop()
+{
+    // Capture loop: keep reading frames in background.
+    // If read fails repeatedly, we mark the stream as not OK.
+    int consecutiveFails = 0;
+
+    while (running)
+    {
+        // Synced mode: wait until every camera is ready, so the grabs below
+        // happen back to back across cameras.
+        if (barrier && !barrier->arriveAndWait(running)) break;
+
+        // Latch the frame and stamp it now; decoding comes after.
+        const bool grabbed = source->grab();
+        const auto captureTime = chrono::steady_clock::now();
+
+        // Decode directly into the slot the ring says nobody is looking at.
+        // A slot whose buffer is still queued for encoding gets a new buffer.
+        Mat& dst = ring.writeBuffer();
+        detachIfShared(dst);
+        bool ret = grabbed && source->retrieve(dst);
+
+        if (!ret || dst.empty())
+        {
+            consecutiveFails++;
+            // If the camera disappears (or a file / sequence ends), stop
+            // treating it as available.
+            if (consecutiveFails >= 30 || source->exhausted())
+            {
+                ok = false;
+                if (FrameSignal* signal = frameSignal.load(memory_order_acquire)) signal->notify();
+                break;
+            }
+            // Tiny sleep prevents spinning at 100% CPU on failure
+            this_thread::sleep_for(chrono::milliseconds(5));
+            continue;
+        }
+
+        consecutiveFails = 0;
+        ring.publish(captureTime); // latest frame wins
+
+        // Wake a consumer waiting for new frames instead of polling
+        if (FrameSignal* signal = frameSignal.load(memory_order_acquire)) signal->notify();
+    }
+
+    // Don't hold the other synced cameras up
+    if (barrier) barrier->leave();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+// Threaded camera capture used by Program 3 (main_2Cams_Threaded.cpp).
+
+#include "frame_ring.hpp"
+#include "frame_signal.hpp"
+#include "frame_source.hpp"
+#include "frame_sync.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+// ============================================================
+// Threaded camera capture class
+// ============================================================
+//
+// Why this exists:
+// - VideoCapture::read() can block unpredictably (USB hiccups, driver latency)
+// - In non-threaded designs, a slow camera can stall the entire loop
+// - Here, each camera captures frames in its own thread
+// - The main loop always reads "the latest frame" without waiting
+//
+// Frames are handed over through a FrameRing: the capture thread decodes
+// straight into a preallocated slot, and read() borrows that slot in place.
+// No mutex, no per-frame copy.
+//
+// The frames come from a FrameSource, so a file, an image sequence or a
+// synthetic scene can stand in for the camera (see frame_source.hpp).
+// Each frame is grab()bed, timestamped, then retrieve()d: the capture time is
+// when the frame was latched, not when its decode finished.
+//
+class CameraStream
+{
+public:
+    explicit CameraStream(int index, int ringSlots = 3);
+
+    // `sync` (optional) latches this stream's grab() together with the other
+    // streams on the same barrier (see frame_sync.hpp).
+    explicit CameraStream(std::unique_ptr<FrameSource> source, int ringSlots = 3, CaptureBarrier* sync = nullptr);
+
+    // Non-copyable (thread + ring)
+    CameraStream(const CameraStream&) = delete;
+    CameraStream& operator=(const CameraStream&) = delete;
+
+    ~CameraStream();
+
+    bool isOk() const { return ok; }
+
+    // Borrow the latest frame. `out` becomes a header on the ring slot (no copy)
+    // and stays valid until the next read() / borrow() on this stream.
+    // Optionally reports whether it's a new frame and when it was captured.
+    // Returns false if stream is not OK.
+    bool read(cv::Mat& out, bool* outIsNew = nullptr,
+              std::chrono::steady_clock::time_point* outCaptureTime = nullptr);
+
+    // Same as read(), but exposes sequence number and capture timestamp.
+    // Returns nullptr if the stream is not OK.
+    const FrameSlot* borrow();
+
+    void stop();
+
+    // Optional: access to capture props if needed later
+    double get(int propId) const;
+
+    // Layout of the frames read() returns (see frame_format.hpp).
+    PixelFormat pixelFormat() const { return format; }
+
+    const FrameRingStats& ringStats() const { return ring.stats(); }
+
+    // Notify `signal` after every published frame, and once if the stream
+    // dies (see frame_signal.hpp). nullptr = no notifications.
+    void setSignal(FrameSignal* signal) { frameSignal.store(signal, std::memory_order_release); }
+
+private:
+    void loop();
+
+    std::unique_ptr<FrameSource> source;
+    CaptureBarrier* barrier = nullptr;
+    FrameRing ring;
+    PixelFormat format = PixelFormat::BGR; // settled by the warm-start read
+
+    std::thread th;
+    std::atomic<bool> running;
+    std::atomic<bool> ok;
+    std::atomic<FrameSignal*> frameSignal{nullptr};
+
+    uint64_t lastReadSeq = 0; // consumer-only
+};
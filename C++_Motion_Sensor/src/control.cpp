@@ -0,0 +1,272 @@
+#include "control.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+// Set from signal handlers, consumed by pollKey().
+volatile sig_atomic_t stopSignals = 0;
+#ifndef _WIN32
+volatile sig_atomic_t recordSignals = 0;
+volatile sig_atomic_t motionSignals = 0;
+#endif
+
+void onStop(int sig)
+{
+    // The first signal asks for a clean stop; a second one kills as usual.
+    if (stopSignals > 0) signal(sig, SIG_DFL);
+    stopSignals = stopSignals + 1;
+}
+
+#ifndef _WIN32
+void onRecord(int) { recordSignals = recordSignals + 1; }
+void onMotion(int) { motionSignals = motionSignals + 1; }
+
+bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+#endif
+
+// "record" / "r" -> 'r', ... ; -1 if unknown
+int keyFor(string cmd)
+{
+    transform(cmd.begin(), cmd.end(), cmd.begin(), [](unsigned char c) { return (char)tolower(c); });
+    if (cmd == "r" || cmd == "record") return 'r';
+    if (cmd == "m" || cmd == "motion") return 'm';
+    if (cmd == "q" || cmd == "stop" || cmd == "quit") return 27;
+    return -1;
+}
+} // namespace
+
+ControlChannel::ControlChannel(const ControlOptions& options)
+    : options(options)
+{
+    signal(SIGINT, onStop);
+    signal(SIGTERM, onStop);
+#ifndef _WIN32
+    signal(SIGUSR1, onRecord);
+    signal(SIGUSR2, onMotion);
+
+    if (!options.fifoPath.empty())
+    {
+        struct stat st;
+        if (stat(options.fifoPath.c_str(), &st) != 0)
+            createdFifo = (mkfifo(options.fifoPath.c_str(), 0600) == 0);
+
+        // Non-blocking read end: open succeeds without a writer, and reads
+        // just come back empty until someone writes.
+        fifoFd = open(options.fifoPath.c_str(), O_RDONLY | O_NONBLOCK);
+        if (fifoFd < 0)
+        {
+            cerr << "Could not open control FIFO " << options.fifoPath << ": " << strerror(errno) << "\n";
+            opened = false;
+        }
+    }
+
+    if (!options.socketPath.empty())
+    {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (options.socketPath.size() >= sizeof(addr.sun_path))
+        {
+            cerr << "Control socket path too long: " << options.socketPath << "\n";
+            opened = false;
+        }
+        else
+        {
+            strncpy(addr.sun_path, options.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+            unlink(options.socketPath.c_str()); // stale socket from a previous run
+
+            listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+                listen(listenFd, 4) != 0 || !setNonBlocking(listenFd))
+            {
+                cerr << "Could not listen on control socket " << options.socketPath << ": " << strerror(errno) << "\n";
+                if (listenFd >= 0) close(listenFd);
+                listenFd = -1;
+                opened = false;
+            }
+        }
+    }
+#else
+    if (!options.fifoPath.empty() || !options.socketPath.empty())
+    {
+        cerr << "Control FIFO / socket are not supported on this platform\n";
+        opened = false;
+    }
+#endif
+}
+
+ControlChannel::~ControlChannel()
+{
+#ifndef _WIN32
+    for (Client& c : clients) close(c.fd);
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        unlink(options.socketPath.c_str());
+    }
+    if (fifoFd >= 0) close(fifoFd);
+    if (createdFifo) unlink(options.fifoPath.c_str());
+#endif
+}
+
+int ControlChannel::pollKey()
+{
+    if (stopSignals > 0)
+    {
+        stopSignals = 0;
+        pending.push_back(27);
+    }
+#ifndef _WIN32
+    if (recordSignals > 0)
+    {
+        recordSignals = 0;
+        pending.push_back('r');
+    }
+    if (motionSignals > 0)
+    {
+        motionSignals = 0;
+        pending.push_back('m');
+    }
+
+    if (fifoFd >= 0) readFifo();
+    if (listenFd >= 0) readSocket();
+#endif
+
+    if (pending.empty()) return -1;
+    int key = pending.front();
+    pending.pop_front();
+    return key;
+}
+
+void ControlChannel::readFifo()
+{
+#ifndef _WIN32
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fifoFd, buf, sizeof(buf))) > 0)
+        fifoBuffer.append(buf, (size_t)n);
+    parse(fifoBuffer, nullptr);
+#endif
+}
+
+void ControlChannel::readSocket()
+{
+#ifndef _WIN32
+    int fd;
+    while ((fd = accept(listenFd, nullptr, nullptr)) >= 0)
+    {
+        if (setNonBlocking(fd))
+            clients.push_back({ fd, string() });
+        else
+            close(fd);
+    }
+
+    for (size_t i = 0; i < clients.size();)
+    {
+        char buf[256];
+        ssize_t n;
+        bool closed = false;
+        while ((n = read(clients[i].fd, buf, sizeof(buf))) > 0)
+            clients[i].buffer.append(buf, (size_t)n);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            closed = true;
+
+        // A last command without a newline still counts when the client hangs up.
+        if (closed) clients[i].buffer += '\n';
+        parse(clients[i].buffer, &clients[i]);
+
+        if (closed)
+        {
+            close(clients[i].fd);
+            clients.erase(clients.begin() + (ptrdiff_t)i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+#endif
+}
+
+void ControlChannel::broadcast(const string& line)
+{
+#ifndef _WIN32
+    const string msg = line + "\n";
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL; // a client gone away is noticed by the next read, not by SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    for (Client& c : clients)
+        if (c.events) (void)send(c.fd, msg.data(), msg.size(), flags);
+#else
+    (void)line;
+#endif
+}
+
+void ControlChannel::parse(string& buffer, Client* client)
+{
+    size_t eol;
+    while ((eol = buffer.find('\n')) != string::npos)
+    {
+        string line = buffer.substr(0, eol);
+        buffer.erase(0, eol + 1);
+
+        // Trim spaces and a Windows line ending
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty()) continue;
+
+        string lower = line;
+        transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)tolower(c); });
+        if (lower == "events")
+        {
+            if (client)
+                client->events = true;
+            else
+                cerr << "\"events\" only works on the control socket\n";
+            continue;
+        }
+
+        int key = keyFor(line);
+        if (key >= 0)
+            pending.push_back(key);
+        else
+            cerr << "Ignoring unknown control command: " << line << "\n";
+    }
+}
+
+string describeControls(const ControlOptions& options)
+{
+    string out;
+#ifndef _WIN32
+    out += "  SIGUSR1 = r, SIGUSR2 = m, SIGINT / SIGTERM = stop\n";
+#else
+    out += "  Ctrl+C = stop\n";
+#endif
+    if (!options.fifoPath.empty())
+        out += "  echo record|motion|stop > " + options.fifoPath + "\n";
+    if (!options.socketPath.empty())
+        out += "  record|motion|stop lines on Unix socket " + options.socketPath
+               + " (\"events\" streams motion events back)\n";
+    return out;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// Remote control for headless runs: signals, a control FIFO or a Unix socket.
+
+#include <deque>
+#include <string>
+#include <vector>
+
+// Control switches (see run_options.hpp for the command-line side).
+struct ControlOptions
+{
+    // Named pipe to read commands from (created if missing). Empty = none.
+    std::string fifoPath;
+
+    // Local (AF_UNIX) stream socket to accept commands on. Empty = none.
+    std::string socketPath;
+};
+
+// ============================================================
+// ControlChannel
+// ============================================================
+//
+// Why this exists:
+// - The programs were driven only by keys in the preview window ('r', 'm',
+//   ESC), which doesn't exist on a headless box
+// - The same commands now also come from outside, and map onto those keys
+//   so the main loops keep one code path:
+//
+//     SIGUSR1            -> 'r' (start recording)
+//     SIGUSR2            -> 'm' (start the motion sensor)
+//     SIGINT / SIGTERM   -> ESC (stop, with the usual cleanup; a second
+//                           signal kills the process)
+//
+// - The FIFO and the socket take one command per line: "record" / "r",
+//   "motion" / "m", "stop" / "quit" / "q". For example:
+//
+//     echo record > /run/motion.ctl
+//     echo motion | socat - UNIX-CONNECT:/run/motion.sock
+//
+// - A socket client that sends "events" also gets every motion start / end
+//   (--motion-events) as a line, for as long as it stays connected:
+//
+//     { echo events; sleep infinity; } | socat - UNIX-CONNECT:/run/motion.sock
+//
+// Everything is non-blocking; pollKey() is called once per loop iteration.
+// FIFO and socket need POSIX; on other platforms only the signals work.
+//
+class ControlChannel
+{
+public:
+    explicit ControlChannel(const ControlOptions& options = ControlOptions());
+
+    ControlChannel(const ControlChannel&) = delete;
+    ControlChannel& operator=(const ControlChannel&) = delete;
+
+    ~ControlChannel();
+
+    // False if a FIFO or socket was asked for and couldn't be opened.
+    bool ok() const { return opened; }
+
+    // Next pending command as the key it stands for ('r', 'm' or 27 for
+    // stop), or -1 if none.
+    int pollKey();
+
+    // Send `line` (newline added) to every socket client that asked for
+    // "events". A client that can't take it right away misses it.
+    void broadcast(const std::string& line);
+
+private:
+    struct Client
+    {
+        int fd;
+        std::string buffer;
+        bool events = false; // subscribed to motion events
+    };
+
+    void readFifo();
+    void readSocket();
+    void parse(std::string& buffer, Client* client);
+
+    ControlOptions options;
+    bool opened = true;
+
+    int fifoFd = -1;
+    bool createdFifo = false;
+    std::string fifoBuffer;
+
+    int listenFd = -1;
+    std::vector<Client> clients;
+
+    std::deque<int> pending;
+};
+
+// Help lines for the remote controls in use, for the "Controls:" banner.
+std::string describeControls(const ControlOptions& options);
@@ -0,0 +1,106 @@
+#include "display.hpp"
+
+#ifndef MOTION_HEADLESS
+#include <opencv2/highgui.hpp>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+using Clock = chrono::steady_clock;
+
+double msSince(Clock::time_point t0)
+{
+    return chrono::duration<double, milli>(Clock::now() - t0).count();
+}
+} // namespace
+
+Display::Display(const DisplayOptions& options)
+    : options(options)
+{
+#ifdef MOTION_HEADLESS
+    this->options.headless = true;
+#endif
+    if (options.previewFps > 0.0)
+        period = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / options.previewFps));
+    refreshing = !this->options.headless;
+}
+
+void Display::show(const string& name, const Mat& frame)
+{
+    if (!refreshing || frame.empty()) return;
+
+    const auto t0 = Clock::now();
+#ifndef MOTION_HEADLESS
+    imshow(name, frame);
+#else
+    (void)name;
+#endif
+    msLoop += msSince(t0);
+}
+
+int Display::pollKey()
+{
+    int key = -1;
+    const auto t0 = Clock::now();
+
+    if (refreshing)
+    {
+#ifndef MOTION_HEADLESS
+        key = waitKey(1);
+#endif
+        lastRefresh = t0;
+        refreshes++;
+    }
+
+    msLoop += msSince(t0);
+    msTotal += msLoop;
+    msMax = max(msMax, msLoop);
+    msLoop = 0.0;
+    loops++;
+
+    // Decide now whether the next loop draws, so all its windows agree.
+    refreshing = !options.headless && (Clock::now() - lastRefresh >= period);
+    return key;
+}
+
+void Display::close(const string& name)
+{
+    if (options.headless) return;
+#ifndef MOTION_HEADLESS
+    try { destroyWindow(name); } catch (...) {}
+#else
+    (void)name;
+#endif
+}
+
+void Display::closeAll()
+{
+    if (options.headless) return;
+#ifndef MOTION_HEADLESS
+    destroyAllWindows();
+#endif
+}
+
+DisplayStats Display::stats() const
+{
+    DisplayStats s;
+    s.loops = loops;
+    s.refreshes = refreshes;
+    s.msAvg = (loops > 0) ? msTotal / (double)loops : 0.0;
+    s.msMax = msMax;
+    return s;
+}
+
+string formatDisplayStats(const DisplayStats& s)
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%llu of %llu loops refreshed, %.3f ms/loop in display (max %.2f ms)",
+             (unsigned long long)s.refreshes, (unsigned long long)s.loops, s.msAvg, s.msMax);
+    return buf;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Live preview windows and keyboard input, decimated or switched off.
+
+#include <opencv2/core.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Display switches (see run_options.hpp for the command-line side).
+struct DisplayOptions
+{
+    // No windows and no highgui calls at all. Always on in MOTION_HEADLESS
+    // builds, which don't link highgui.
+    bool headless = false;
+
+    // Preview refresh rate. 0 = every frame (the original behavior).
+    double previewFps = 0.0;
+};
+
+struct DisplayStats
+{
+    uint64_t loops = 0;     // pollKey() calls
+    uint64_t refreshes = 0; // loops that drew and pumped the GUI
+    double   msAvg = 0.0;   // time spent in show() + pollKey() per loop
+    double   msMax = 0.0;
+};
+
+// ============================================================
+// Display
+// ============================================================
+//
+// Why this exists:
+// - Every loop iteration used to imshow() each window and waitKey(1): a GUI
+//   event-loop round trip and a render per frame, on the same thread that
+//   does capture, detection and logging
+// - On a headless box (Docker, no X server) highgui either fails or burns
+//   CPU for a window nobody sees
+// - Windows are now refreshed at most previewFps times per second, and keys
+//   are read on those refreshes; headless, nothing is drawn or polled
+//
+// Call show() for each window, then pollKey() once per loop iteration.
+//
+class Display
+{
+public:
+    explicit Display(const DisplayOptions& options = DisplayOptions());
+
+    bool headless() const { return options.headless; }
+
+    // Draw `frame` in window `name` if this loop is a refresh.
+    void show(const std::string& name, const cv::Mat& frame);
+
+    // True if this loop is a refresh, so a frame that costs something to
+    // produce (a decoded preview) is only made when it will be shown.
+    bool drawing() const { return refreshing; }
+
+    // End of the loop's display work: on a refresh, pump GUI events and
+    // return the key pressed (-1 if none, or between refreshes / headless).
+    int pollKey();
+
+    void close(const std::string& name);
+    void closeAll();
+
+    DisplayStats stats() const;
+
+private:
+    DisplayOptions options;
+    std::chrono::steady_clock::duration period{};
+    std::chrono::steady_clock::time_point lastRefresh{};
+    bool refreshing = true; // this loop draws
+
+    uint64_t loops = 0;
+    uint64_t refreshes = 0;
+    double msLoop = 0.0; // display time in the current loop
+    double msTotal = 0.0;
+    double msMax = 0.0;
+};
+
+// One-line summary for logs.
+std::string formatDisplayStats(const DisplayStats& s);
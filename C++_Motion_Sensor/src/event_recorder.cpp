@@ -0,0 +1,335 @@
+#include "event_recorder.hpp"
+
+#include "mjpeg.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+using Clock = chrono::steady_clock;
+
+// Frames the compressor may fall behind by before the oldest is dropped.
+constexpr size_t kRawQueueFrames = 4;
+
+// Highest frame rate the clip queue is sized for (see the constructor).
+constexpr double kMaxPrerollFps = 120.0;
+} // namespace
+
+EventRecorder::EventRecorder(const EventOptions& options, const RecorderOptions& recorderOptions,
+                             const WriterOptions& writerOptions, int fourcc,
+                             function<string()> nextClipPath)
+    : options(options),
+      recorderOptions(recorderOptions),
+      clipWriterOptions(writerOptions),
+      fourcc(fourcc),
+      nextClipPath(std::move(nextClipPath)),
+      raw(kRawQueueFrames, OverflowPolicy::DropOldest),
+      estimator(recorderOptions.warmupSec)
+{
+    if (!enabled()) return;
+
+    // A flush queues the whole pre-roll at once. Packets are small and already
+    // bounded by memoryCapMB, so the clip queue gets room for a full pre-roll
+    // on top of the usual capacity; flushing never blocks on the encoder.
+    clipWriterOptions.queueCapacity += (int)ceil(options.preRollSec * kMaxPrerollFps);
+    clipWriterOptions.overflow = OverflowPolicy::Block;
+
+    running = true;
+    th = thread(&EventRecorder::loop, this);
+}
+
+EventRecorder::~EventRecorder()
+{
+    stop();
+}
+
+void EventRecorder::addFrame(const Mat& frame, Clock::time_point captureTime, int logSecond, PixelFormat format)
+{
+    if (!running || frame.empty()) return;
+
+    RawFrame r;
+    r.frame = frame; // header only; the compressor reads it
+    r.format = format;
+    r.captureTime = captureTime;
+    r.logSecond = logSecond;
+    raw.push(std::move(r));
+}
+
+void EventRecorder::addPacket(const EncodedFrame& packet, Clock::time_point captureTime, int logSecond)
+{
+    if (!running || !packet || packet->empty()) return;
+
+    RawFrame r;
+    r.packet = packet;
+    r.captureTime = captureTime;
+    r.logSecond = logSecond;
+    raw.push(std::move(r));
+}
+
+void EventRecorder::trigger(Clock::time_point captureTime)
+{
+    if (!running) return;
+
+    lock_guard<mutex> lock(m);
+    lastTrigger = max(lastTrigger, captureTime);
+    if (!armed && !counters.clipOpen)
+    {
+        armed = true;
+        triggerTime = captureTime;
+    }
+}
+
+void EventRecorder::stop()
+{
+    if (!running) return;
+
+    raw.close(); // worker drains what's queued, then exits
+    if (th.joinable()) th.join();
+    running = false;
+
+    closeClip();
+    for (auto& f : closing) f.wait();
+    closing.clear();
+}
+
+void EventRecorder::loop()
+{
+    const vector<int> params = { IMWRITE_JPEG_QUALITY, max(1, min(100, options.jpegQuality)) };
+    const auto postRoll = chrono::duration_cast<Clock::duration>(chrono::duration<double>(options.postRollSec));
+
+    RawFrame r;
+    vector<uint8_t> buf;
+    Mat bgr;
+    while (raw.pop(r))
+    {
+        estimator.addSample(r.captureTime);
+
+        bool openNow = false;
+        Clock::time_point triggeredAt;
+        {
+            lock_guard<mutex> lock(m);
+            counters.frames++;
+            counters.rawDropped = raw.stats().dropped;
+            openNow = !clip && armed && r.captureTime >= triggerTime;
+            triggeredAt = triggerTime;
+        }
+
+        Packet p;
+        p.captureTime = r.captureTime;
+        p.logSecond = r.logSecond;
+        p.format = r.format;
+
+        if (clip || openNow)
+        {
+            // Live frame: straight to the clip, no JPEG round trip.
+            Size frameSize = imageSize(r.frame, r.format);
+            bool isColor = (r.frame.channels() == 3 || r.format != PixelFormat::BGR);
+            if (r.packet)
+            {
+                int components = 3;
+                jpegInfo(r.packet->data(), r.packet->size(), frameSize, components);
+                isColor = (components != 1);
+            }
+            p.frame = std::move(r.frame);
+            p.data = std::move(r.packet);
+
+            if (!clip)
+            {
+                openClip(p, frameSize, isColor, triggeredAt);
+            }
+            else
+            {
+                feedClip(p);
+
+                // Decided under the lock so a trigger arriving now either
+                // extends this clip or arms the next one.
+                bool expired = false;
+                {
+                    lock_guard<mutex> lock(m);
+                    expired = (p.captureTime > lastTrigger + postRoll);
+                    if (expired) counters.clipOpen = false;
+                }
+                if (expired) closeClip();
+            }
+        }
+        else if (options.preRollSec > 0.0 && r.packet)
+        {
+            // Compressed by the camera already
+            p.data = std::move(r.packet);
+            bufferPacket(p);
+        }
+        else if (options.preRollSec > 0.0)
+        {
+            auto t0 = Clock::now();
+            imencode(".jpg", toBgr(r.frame, r.format, bgr), buf, params);
+            auto t1 = Clock::now();
+            r.frame.release(); // the camera buffer is free again
+
+            p.data = make_shared<const vector<uint8_t>>(buf);
+            {
+                lock_guard<mutex> lock(m);
+                counters.compressed++;
+                jpegUsTotal += (uint64_t)chrono::duration_cast<chrono::microseconds>(t1 - t0).count();
+            }
+            bufferPacket(p);
+        }
+        else
+        {
+            // Between segments nothing is encoded. The newest frame is kept
+            // (by reference): the trigger for it may still be on its way.
+            lastIdle.frame = std::move(r.frame);
+            lastIdle.data = std::move(r.packet);
+            lastIdle.format = r.format;
+            lastIdle.captureTime = p.captureTime;
+            lastIdle.logSecond = p.logSecond;
+        }
+
+        // Forget clips that finished draining.
+        closing.erase(remove_if(closing.begin(), closing.end(),
+                                [](future<void>& f) { return f.wait_for(chrono::seconds(0)) == future_status::ready; }),
+                      closing.end());
+    }
+}
+
+void EventRecorder::bufferPacket(const Packet& p)
+{
+    preroll.push_back(p);
+    prerollBytes += p.data->size();
+
+    const auto window = chrono::duration_cast<Clock::duration>(chrono::duration<double>(options.preRollSec));
+    const size_t cap = (size_t)max(1, options.memoryCapMB) * 1024 * 1024;
+
+    uint64_t trimmed = 0;
+    while (preroll.size() > 1)
+    {
+        const bool tooOld = (preroll.back().captureTime - preroll.front().captureTime) > window;
+        const bool tooBig = prerollBytes > cap;
+        if (!tooOld && !tooBig) break;
+
+        if (!tooOld) trimmed++;
+        prerollBytes -= preroll.front().data->size();
+        preroll.pop_front();
+    }
+
+    lock_guard<mutex> lock(m);
+    counters.trimmedForMemory += trimmed;
+    counters.prerollPackets = preroll.size();
+    counters.prerollBytes = prerollBytes;
+    counters.prerollSec = chrono::duration<double>(preroll.back().captureTime - preroll.front().captureTime).count();
+}
+
+void EventRecorder::openClip(const Packet& p, Size frameSize, bool isColor, Clock::time_point triggeredAt)
+{
+    // Without pre-roll, the frame that triggered may already have gone by.
+    if ((lastIdle.data || !lastIdle.frame.empty()) && lastIdle.captureTime >= triggeredAt)
+        preroll.push_back(lastIdle);
+    lastIdle = Packet();
+
+    const string path = nextClipPath();
+
+    clip.reset(new Recorder(recorderOptions, clipWriterOptions));
+    clip->seedRate(estimator);
+
+    Mark mark;
+    if (clip->start(path, fourcc, frameSize, isColor))
+    {
+        clipName = fs::path(path).filename().string();
+        mark.start = true;
+        mark.name = clipName;
+        mark.time = preroll.empty() ? p.captureTime : preroll.front().captureTime;
+
+        for (const Packet& h : preroll)
+            feedClip(h);
+        feedClip(p);
+    }
+    else
+    {
+        clip.reset(); // couldn't open; the trigger is dropped
+    }
+
+    preroll.clear();
+    prerollBytes = 0;
+
+    lock_guard<mutex> lock(m);
+    armed = false;
+    counters.clipOpen = (clip != nullptr);
+    if (clip)
+    {
+        counters.clips++;
+        marks.push_back(mark);
+    }
+    counters.prerollPackets = 0;
+    counters.prerollBytes = 0;
+    counters.prerollSec = 0.0;
+}
+
+void EventRecorder::feedClip(const Packet& p)
+{
+    if (p.data)
+        clip->addPacket(p.data, p.captureTime, p.logSecond);
+    else
+        clip->addFrame(p.frame, p.captureTime, p.logSecond, p.format);
+    clipLast = p.captureTime;
+}
+
+void EventRecorder::closeClip()
+{
+    if (!clip) return;
+
+    // Draining the encoder can take a while after a long flush; do it off this
+    // thread so the next pre-roll keeps filling.
+    closing.push_back(async(launch::async, [](unique_ptr<Recorder> r) { r->stop(); }, std::move(clip)));
+
+    Mark mark;
+    mark.name = clipName;
+    mark.time = clipLast;
+
+    lock_guard<mutex> lock(m);
+    counters.clipOpen = false;
+    marks.push_back(mark);
+}
+
+EventRecorder::SegmentMarks EventRecorder::takeSegmentMarks(Clock::time_point origin)
+{
+    SegmentMarks out;
+
+    lock_guard<mutex> lock(m);
+    for (const Mark& k : marks)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "@%.3f", chrono::duration<double>(k.time - origin).count());
+
+        string& list = k.start ? out.starts : out.ends;
+        if (!list.empty()) list += ';';
+        list += k.name + buf;
+    }
+    marks.clear();
+    return out;
+}
+
+EventRecorderStats EventRecorder::stats() const
+{
+    lock_guard<mutex> lock(m);
+    EventRecorderStats s = counters;
+    s.jpegMsAvg = (s.compressed > 0) ? (double)jpegUsTotal / 1000.0 / (double)s.compressed : 0.0;
+    return s;
+}
+
+string formatEventStats(const EventRecorderStats& s)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "%llu clips, pre-roll %.1f s in %.1f MB (%zu packets), jpeg avg %.1f ms, %llu frames dropped, %llu trimmed for memory",
+             (unsigned long long)s.clips, s.prerollSec, (double)s.prerollBytes / (1024.0 * 1024.0), s.prerollPackets,
+             s.jpegMsAvg, (unsigned long long)s.rawDropped, (unsigned long long)s.trimmedForMemory);
+    return buf;
+}
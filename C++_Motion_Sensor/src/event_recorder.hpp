@@ -0,0 +1,187 @@
+#pragma once
+
+// Motion-triggered clips (segments), optionally starting with the seconds
+// *before* the trigger.
+
+#include "async_video_writer.hpp"
+#include "bounded_queue.hpp"
+#include "recorder.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Event-clip switches (see run_options.hpp for the command-line side).
+struct EventOptions
+{
+    // Record only event segments: 'r' arms segments instead of starting one
+    // continuous video.
+    bool segments = false;
+
+    // Seconds of history kept before a trigger (0 = none). Event clips are on
+    // when this is set or `segments` is.
+    double preRollSec = 0.0;
+
+    // Hold-off: seconds a clip keeps running after the last motion.
+    double postRollSec = 5.0;
+
+    // Upper bound on pre-roll memory; the oldest packets go first.
+    int memoryCapMB = 64;
+
+    // JPEG quality of the buffered packets (1..100).
+    int jpegQuality = 85;
+};
+
+struct EventRecorderStats
+{
+    uint64_t frames = 0;           // frames the worker took off the queue
+    size_t   prerollPackets = 0;   // packets buffered right now
+    size_t   prerollBytes = 0;
+    double   prerollSec = 0.0;     // capture time covered by the buffer
+    uint64_t compressed = 0;       // frames JPEG-encoded
+    uint64_t rawDropped = 0;       // frames the compressor had no time for
+    uint64_t trimmedForMemory = 0; // packets evicted early by the memory cap
+    double   jpegMsAvg = 0.0;
+    uint64_t clips = 0;            // clips opened so far
+    bool     clipOpen = false;
+};
+
+// ============================================================
+// EventRecorder
+// ============================================================
+//
+// Why this exists:
+// - Recording used to start only on 'r', so the moments before an event
+//   were never on disk, and one video covered the whole session
+// - trigger() opens a new clip; it runs until postRollSec after the last
+//   trigger, then closes. Between clips nothing is encoded
+// - With preRollSec, frames outside a clip are JPEG-compressed on a worker
+//   thread into a pre-roll ring bounded by time and memory (memoryCapMB);
+//   10 s of 1080p is tens of MB instead of gigabytes of raw BGR. A new clip
+//   starts with that ring
+// - Packets are decoded on the clip's encoder thread, so neither the main
+//   loop nor the worker waits for a flush; live frames go to the clip as is
+// - Frames that are JPEG packets already (MJPEG passthrough) skip the
+//   compressor: they go into the pre-roll, and the clip, as they are
+//
+// The main loop only queues frame headers (no copy); if the worker falls
+// behind, the oldest queued frame is dropped and counted.
+//
+class EventRecorder
+{
+public:
+    // nextClipPath is called (on the worker thread) for each new clip.
+    EventRecorder(const EventOptions& options, const RecorderOptions& recorderOptions,
+                  const WriterOptions& writerOptions, int fourcc,
+                  std::function<std::string()> nextClipPath);
+
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+
+    ~EventRecorder();
+
+    bool enabled() const { return options.segments || options.preRollSec > 0.0; }
+
+    // Call for every frame (no-op when disabled). Raw YUV frames (`format`)
+    // are converted to BGR on the worker or encoder thread, when needed.
+    void addFrame(const cv::Mat& frame, std::chrono::steady_clock::time_point captureTime, int logSecond = 0,
+                  PixelFormat format = PixelFormat::BGR);
+
+    // Same for a frame that is a JPEG packet already (MJPEG passthrough).
+    void addPacket(const EncodedFrame& packet, std::chrono::steady_clock::time_point captureTime, int logSecond = 0);
+
+    // Motion in the frame captured at captureTime: open a clip, or keep the
+    // open one running for another postRollSec.
+    void trigger(std::chrono::steady_clock::time_point captureTime);
+
+    // Close any open clip and stop the worker.
+    void stop();
+
+    // Clips opened / closed since the last call, for the motion-log CSV:
+    // "Event3.mp4@12.345" with the capture time of the clip's first / last
+    // frame in seconds since `origin`, several joined by ';'.
+    struct SegmentMarks
+    {
+        std::string starts;
+        std::string ends;
+    };
+    SegmentMarks takeSegmentMarks(std::chrono::steady_clock::time_point origin);
+
+    EventRecorderStats stats() const;
+
+private:
+    struct RawFrame
+    {
+        cv::Mat frame;
+        EncodedFrame packet; // when frame is empty
+        PixelFormat format = PixelFormat::BGR;
+        std::chrono::steady_clock::time_point captureTime{};
+        int logSecond = 0;
+    };
+
+    // A buffered (JPEG) or live frame.
+    struct Packet
+    {
+        EncodedFrame data;
+        cv::Mat frame; // when data is empty
+        PixelFormat format = PixelFormat::BGR;
+        std::chrono::steady_clock::time_point captureTime{};
+        int logSecond = 0;
+    };
+
+    struct Mark
+    {
+        bool start = false;
+        std::string name;
+        std::chrono::steady_clock::time_point time{};
+    };
+
+    void loop();
+    void bufferPacket(const Packet& p);
+    void openClip(const Packet& p, cv::Size frameSize, bool isColor,
+                  std::chrono::steady_clock::time_point triggeredAt);
+    void feedClip(const Packet& p);
+    void closeClip();
+
+    EventOptions options;
+    RecorderOptions recorderOptions;
+    WriterOptions clipWriterOptions;
+    int fourcc;
+    std::function<std::string()> nextClipPath;
+
+    BoundedQueue<RawFrame> raw;
+    std::thread th;
+    bool running = false;
+
+    // Worker-thread only
+    std::deque<Packet> preroll;
+    size_t prerollBytes = 0;
+    Packet lastIdle; // newest frame outside a clip when there's no pre-roll
+    FrameRateEstimator estimator;
+    std::unique_ptr<Recorder> clip;
+    std::string clipName;
+    std::chrono::steady_clock::time_point clipLast{}; // newest frame in the clip
+    std::vector<std::future<void>> closing; // clips still draining their encoder
+
+    // Shared with the main thread
+    mutable std::mutex m;
+    bool armed = false;                                   // trigger waiting for a clip to open
+    std::chrono::steady_clock::time_point triggerTime{};  // first trigger not yet in a clip
+    std::chrono::steady_clock::time_point lastTrigger{};
+    EventRecorderStats counters;
+    uint64_t jpegUsTotal = 0;
+    std::vector<Mark> marks;
+};
+
+// One-line summary for logs.
+std::string formatEventStats(const EventRecorderStats& s);
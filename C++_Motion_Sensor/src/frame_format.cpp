@@ -0,0 +1,139 @@
+#include "frame_format.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+using namespace cv;
+using namespace std;
+
+const char* pixelFormatName(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::YUYV: return "yuyv";
+    case PixelFormat::NV12: return "nv12";
+    default:                return "bgr";
+    }
+}
+
+bool parsePixelFormat(const string& name, PixelFormat& format)
+{
+    if (name == "bgr")       format = PixelFormat::BGR;
+    else if (name == "yuyv") format = PixelFormat::YUYV;
+    else if (name == "nv12") format = PixelFormat::NV12;
+    else return false;
+    return true;
+}
+
+int pixelFormatFourcc(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::YUYV: return VideoWriter::fourcc('Y', 'U', 'Y', 'V');
+    case PixelFormat::NV12: return VideoWriter::fourcc('N', 'V', '1', '2');
+    default:                return 0;
+    }
+}
+
+Size imageSize(const Mat& frame, PixelFormat format)
+{
+    if (format == PixelFormat::NV12) return Size(frame.cols, frame.rows * 2 / 3);
+    return frame.size();
+}
+
+bool shapeRawFrame(Mat& frame, Size size, PixelFormat format)
+{
+    if (frame.empty() || !frame.isContinuous() || frame.depth() != CV_8U) return false;
+
+    const size_t bytes = frame.total() * frame.elemSize();
+    const size_t pixels = (size_t)size.area();
+    if (format == PixelFormat::YUYV && bytes == pixels * 2)
+    {
+        frame = frame.reshape(2, size.height);
+        return true;
+    }
+    if (format == PixelFormat::NV12 && bytes == pixels * 3 / 2)
+    {
+        frame = frame.reshape(1, size.height * 3 / 2);
+        return true;
+    }
+    return false;
+}
+
+Mat lumaPlane(const Mat& frame, PixelFormat format, Mat& scratch)
+{
+    switch (format)
+    {
+    case PixelFormat::NV12:
+        return frame.rowRange(0, frame.rows * 2 / 3);
+    case PixelFormat::YUYV:
+        cvtColor(frame, scratch, COLOR_YUV2GRAY_YUYV); // every other byte, no arithmetic
+        return scratch;
+    default:
+        return frame;
+    }
+}
+
+const Mat& toBgr(const Mat& frame, PixelFormat format, Mat& scratch)
+{
+    switch (format)
+    {
+    case PixelFormat::YUYV:
+        cvtColor(frame, scratch, COLOR_YUV2BGR_YUYV);
+        return scratch;
+    case PixelFormat::NV12:
+        cvtColor(frame, scratch, COLOR_YUV2BGR_NV12);
+        return scratch;
+    default:
+        return frame;
+    }
+}
+
+void fromBgr(const Mat& bgr, PixelFormat format, Mat& dst)
+{
+    if (format == PixelFormat::BGR)
+    {
+        bgr.copyTo(dst);
+        return;
+    }
+
+    // Planar 4:2:0 first (BT.601 video range, the inverse of the conversions
+    // above), then repacked
+    Mat i420;
+    cvtColor(bgr, i420, COLOR_BGR2YUV_I420);
+    const int w = bgr.cols, h = bgr.rows;
+    const uchar* u = i420.ptr<uchar>(h);
+    const uchar* v = u + (w / 2) * (h / 2);
+
+    if (format == PixelFormat::NV12)
+    {
+        dst.create(h * 3 / 2, w, CV_8UC1);
+        Mat yPlane = dst.rowRange(0, h);
+        i420.rowRange(0, h).copyTo(yPlane);
+        for (int y = 0; y < h / 2; y++)
+        {
+            uchar* uv = dst.ptr<uchar>(h + y);
+            for (int x = 0; x < w / 2; x++)
+            {
+                uv[2 * x] = u[y * (w / 2) + x];
+                uv[2 * x + 1] = v[y * (w / 2) + x];
+            }
+        }
+        return;
+    }
+
+    // YUYV: both rows of a 4:2:0 pair share their chroma
+    dst.create(h, w, CV_8UC2);
+    for (int y = 0; y < h; y++)
+    {
+        const uchar* luma = i420.ptr<uchar>(y);
+        uchar* out = dst.ptr<uchar>(y);
+        for (int x = 0; x < w / 2; x++)
+        {
+            out[4 * x + 0] = luma[2 * x];
+            out[4 * x + 1] = u[(y / 2) * (w / 2) + x];
+            out[4 * x + 2] = luma[2 * x + 1];
+            out[4 * x + 3] = v[(y / 2) * (w / 2) + x];
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Pixel layouts a frame can arrive in: BGR (what VideoCapture converts to by
+// default) or the camera's raw YUV, whose Y plane is the luma detection needs.
+
+#include <opencv2/core.hpp>
+
+#include <cstddef>
+#include <string>
+
+// Frame layouts, as stored in a cv::Mat:
+//   BGR   h x w CV_8UC3
+//   YUYV  h x w CV_8UC2, Y0 U Y1 V (packed 4:2:2, what most UVC webcams send)
+//   NV12  (h * 3/2) x w CV_8UC1, the Y plane then interleaved UV at half size
+enum class PixelFormat
+{
+    BGR,
+    YUYV,
+    NV12
+};
+
+// "bgr", "yuyv", "nv12".
+const char* pixelFormatName(PixelFormat format);
+bool parsePixelFormat(const std::string& name, PixelFormat& format);
+
+// Capture FOURCC that asks a camera for this layout (0 for BGR).
+int pixelFormatFourcc(PixelFormat format);
+
+// Image size of a frame stored in this layout.
+cv::Size imageSize(const cv::Mat& frame, PixelFormat format);
+
+// A backend's raw buffer (any shape, continuous) as the layout above, without
+// copying. False if its size doesn't match a w x h frame in that layout.
+bool shapeRawFrame(cv::Mat& frame, cv::Size size, PixelFormat format);
+
+// What the detector looks at: for NV12 a header on the Y rows (no copy), for
+// YUYV the Y bytes gathered into `scratch` (one pass, no arithmetic). BGR
+// frames come back as they are; the detector converts them in its fused pass.
+cv::Mat lumaPlane(const cv::Mat& frame, PixelFormat format, cv::Mat& scratch);
+
+// BGR image for encoders and preview windows (BT.601, as the camera driver
+// would have converted it). BGR frames are returned without a copy.
+const cv::Mat& toBgr(const cv::Mat& frame, PixelFormat format, cv::Mat& scratch);
+
+// BGR -> raw layout, for sources standing in for a YUV camera. Width and
+// height must be even.
+void fromBgr(const cv::Mat& bgr, PixelFormat format, cv::Mat& dst);
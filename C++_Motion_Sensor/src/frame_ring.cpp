@@ -0,0 +1,89 @@
+#include "frame_ring.hpp"
+
+#include <algorithm>
+
+FrameRing::FrameRing(int slotCount)
+    : slots((size_t)std::clamp(slotCount, 3, 16)),
+      state(pack(kNone, kNone)),
+      lastPublishedSeq(0)
+{
+}
+
+// ------------------------------------------------------------
+// Producer
+// ------------------------------------------------------------
+void FrameRing::publish(std::chrono::steady_clock::time_point captureTime)
+{
+    FrameSlot& slot = slots[writeIdx];
+    slot.seq = nextSeq++;
+    slot.captureTime = captureTime;
+
+    // Swap in the new published index. The release half makes the slot
+    // contents visible to the consumer before it can borrow the slot.
+    uint32_t s = state.load(std::memory_order_relaxed);
+    while (!state.compare_exchange_weak(s, pack(writeIdx, borrowedOf(s)),
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_relaxed))
+    {
+    }
+    lastPublishedSeq.store(slot.seq, std::memory_order_release);
+
+    // From here on the consumer can only move its borrow onto the slot we just
+    // published, so any slot that is neither that one nor the borrow we saw in
+    // the CAS is ours to overwrite.
+    const uint32_t published = writeIdx;
+    const uint32_t borrowed = borrowedOf(s);
+    const uint32_t n = (uint32_t)slots.size();
+
+    uint32_t next = writeIdx;
+    do
+    {
+        next = (next + 1) % n;
+    } while (next == published || next == borrowed);
+
+    writeIdx = next;
+}
+
+// ------------------------------------------------------------
+// Consumer
+// ------------------------------------------------------------
+const FrameSlot* FrameRing::acquireLatest()
+{
+    uint32_t s = state.load(std::memory_order_acquire);
+    uint32_t idx = kNone;
+
+    do
+    {
+        idx = publishedOf(s);
+        if (idx == kNone) return nullptr;
+    } while (!state.compare_exchange_weak(s, pack(idx, idx),
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire));
+
+    const FrameSlot& slot = slots[idx];
+
+    if (slot.seq == lastSeenSeq)
+    {
+        consumerStats.repeated++;
+    }
+    else
+    {
+        if (lastSeenSeq != 0 && slot.seq > lastSeenSeq + 1)
+            consumerStats.skipped += slot.seq - lastSeenSeq - 1;
+
+        consumerStats.consumed++;
+        lastSeenSeq = slot.seq;
+    }
+
+    return &slot;
+}
+
+void FrameRing::release()
+{
+    uint32_t s = state.load(std::memory_order_relaxed);
+    while (!state.compare_exchange_weak(s, pack(publishedOf(s), kNone),
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_relaxed))
+    {
+    }
+}
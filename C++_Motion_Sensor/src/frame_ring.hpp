@@ -0,0 +1,113 @@
+#pragma once
+
+// Lock-free single-producer / single-consumer frame ring.
+// Used by CameraStream to hand frames from the capture thread to the main loop
+// without a mutex and without copying the frame.
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// One preallocated frame slot
+// ============================================================
+struct FrameSlot
+{
+    cv::Mat  frame;                                       // pixel buffer, reused across frames
+    uint64_t seq = 0;                                     // 1, 2, 3, ... per published frame
+    std::chrono::steady_clock::time_point captureTime{};  // when the producer finished filling it
+};
+
+// If anything else still holds a reference to m's pixel buffer (e.g. a frame
+// queued for an AsyncVideoWriter), drop m's reference so the next decode into
+// m allocates a fresh buffer instead of overwriting the shared one. Returns
+// true if m was detached. No-op for buffers nobody else holds.
+inline bool detachIfShared(cv::Mat& m)
+{
+    if (m.u && m.u->refcount > 1)
+    {
+        m.release();
+        return true;
+    }
+    return false;
+}
+
+// Consumer-side bookkeeping (only touched by the consumer thread).
+struct FrameRingStats
+{
+    uint64_t consumed = 0;  // distinct frames the consumer borrowed
+    uint64_t skipped  = 0;  // frames overwritten before the consumer ever saw them
+    uint64_t repeated = 0;  // borrows that returned a frame already seen
+};
+
+// ============================================================
+// FrameRing
+// ============================================================
+//
+// Why this exists:
+// - The old CameraStream::read() took a mutex and copyTo()'d the whole frame
+// - Here the capture thread fills one of N preallocated slots in place and
+//   publishes it; the consumer borrows the newest published slot in place
+// - A single atomic word records "which slot is published" and "which slot is
+//   borrowed", so the producer never writes into a slot the consumer holds
+// - Latest frame wins: a slow consumer skips frames, it never builds a backlog
+//
+// Needs at least 3 slots (one being written, one published, one borrowed).
+//
+class FrameRing
+{
+public:
+    explicit FrameRing(int slotCount = 3);
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    int slotCount() const { return (int)slots.size(); }
+
+    // ---- Producer side (capture thread only)
+
+    // Slot buffer the producer should fill next (e.g. cap.read(ring.writeBuffer())).
+    cv::Mat& writeBuffer() { return slots[writeIdx].frame; }
+
+    // Publish the filled slot and move on to a slot nobody is looking at.
+    void publish(std::chrono::steady_clock::time_point captureTime);
+
+    // Sequence number of the newest published frame (0 = nothing yet).
+    uint64_t publishedSeq() const { return lastPublishedSeq.load(std::memory_order_acquire); }
+
+    // ---- Consumer side (one consumer thread only)
+
+    // Borrow the newest published slot. Any previously borrowed slot is released.
+    // The returned slot stays untouched by the producer until the next
+    // acquireLatest() / release(). Returns nullptr if nothing is published yet.
+    const FrameSlot* acquireLatest();
+
+    // Hand the borrowed slot back to the producer.
+    void release();
+
+    const FrameRingStats& stats() const { return consumerStats; }
+
+private:
+    static constexpr uint32_t kNone = 0xFF;
+
+    static uint32_t publishedOf(uint32_t s) { return s & 0xFF; }
+    static uint32_t borrowedOf(uint32_t s)  { return (s >> 8) & 0xFF; }
+    static uint32_t pack(uint32_t published, uint32_t borrowed) { return published | (borrowed << 8); }
+
+    std::vector<FrameSlot> slots;
+
+    // Low byte: published slot index, next byte: borrowed slot index (kNone = none).
+    std::atomic<uint32_t> state;
+    std::atomic<uint64_t> lastPublishedSeq;
+
+    // Producer-only
+    uint32_t writeIdx = 0;
+    uint64_t nextSeq = 1;
+
+    // Consumer-only
+    uint64_t lastSeenSeq = 0;
+    FrameRingStats consumerStats;
+};
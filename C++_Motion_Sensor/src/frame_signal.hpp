@@ -0,0 +1,49 @@
+#pragma once
+
+// "A new frame was captured" notification shared by several capture threads.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// ============================================================
+// FrameSignal
+// ============================================================
+//
+// Why this exists:
+// - The Program 3 loop used to poll every camera, find nothing new most of
+//   the time, and either spin or sleep a fixed 1 ms
+// - Capture threads now notify() after publishing a frame, and the loop
+//   sleeps in wait() until one did (or a timeout passes, so keys and the
+//   per-second CSV row still get serviced when every camera stalls)
+// - A generation counter instead of a flag: a frame published between two
+//   waits is never missed, and several cameras can share one signal
+//
+class FrameSignal
+{
+public:
+    // Producer side: one call per published frame (or when a stream dies).
+    void notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            generation++;
+        }
+        cv.notify_all();
+    }
+
+    // Block until the generation differs from `seen` or `timeout` passes.
+    // Returns the current generation; pass it back in as `seen` next time.
+    uint64_t wait(uint64_t seen, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait_for(lock, timeout, [&] { return generation != seen; });
+        return generation;
+    }
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    uint64_t generation = 0;
+};
@@ -0,0 +1,514 @@
+#include "frame_source.hpp"
+
+#include "mjpeg.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+using Clock = chrono::steady_clock;
+
+// Longest numbered image sequence read (about 9 hours at 30 fps)
+constexpr int kMaxSequenceFrames = 1000000;
+
+bool isNumber(const string& s)
+{
+    return !s.empty() && all_of(s.begin(), s.end(), [](unsigned char c) { return isdigit(c) != 0; });
+}
+
+// "clip@15" -> "clip", 15. Leaves `rest` alone without a numeric "@FPS" tail.
+void splitFps(string& rest, double& fps)
+{
+    const size_t at = rest.rfind('@');
+    if (at == string::npos) return;
+    try
+    {
+        size_t used = 0;
+        const double v = stod(rest.substr(at + 1), &used);
+        if (used != rest.size() - at - 1 || v <= 0.0) return;
+        fps = v;
+        rest.erase(at);
+    }
+    catch (...)
+    {
+    }
+}
+
+// An images: pattern must take exactly one int: a single %d / %i / %u with
+// optional flags and width ("%05d"); "%%" stands for a literal '%'.
+bool isFramePattern(const string& pattern)
+{
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        if (pattern[i] != '%') continue;
+        if (++i < pattern.size() && pattern[i] == '%') continue;
+        while (i < pattern.size() && strchr("-+ #0", pattern[i])) i++;
+        while (i < pattern.size() && isdigit((unsigned char)pattern[i])) i++;
+        if (i >= pattern.size() || !strchr("diu", pattern[i])) return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+bool hasJpegExtension(const string& path)
+{
+    string ext = fs::path(path).extension().string();
+    transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return ext == ".jpg" || ext == ".jpeg";
+}
+
+// ------------------------------------------------------------
+// Live camera (VideoCapture by index)
+// ------------------------------------------------------------
+class CameraSource : public FrameSource
+{
+public:
+    CameraSource(int index, bool passthrough, PixelFormat raw) : index(index), cap(index)
+    {
+        if (!cap.isOpened()) return;
+
+        // Ask for MJPG or raw YUV and hand out the driver's buffers as they
+        // are. Not every camera (or backend) can; those keep delivering BGR.
+        if (passthrough)
+        {
+            const int mjpg = VideoWriter::fourcc('M', 'J', 'P', 'G');
+            cap.set(CAP_PROP_FOURCC, mjpg);
+            packets = (int)cap.get(CAP_PROP_FOURCC) == mjpg && cap.set(CAP_PROP_CONVERT_RGB, 0);
+            if (!packets) cap.set(CAP_PROP_CONVERT_RGB, 1);
+        }
+        else if (raw != PixelFormat::BGR)
+        {
+            cap.set(CAP_PROP_FOURCC, pixelFormatFourcc(raw));
+            if ((int)cap.get(CAP_PROP_FOURCC) == pixelFormatFourcc(raw) && cap.set(CAP_PROP_CONVERT_RGB, 0))
+            {
+                format = raw;
+                size = Size((int)cap.get(CAP_PROP_FRAME_WIDTH), (int)cap.get(CAP_PROP_FRAME_HEIGHT));
+            }
+            else
+            {
+                cap.set(CAP_PROP_CONVERT_RGB, 1);
+            }
+        }
+    }
+
+    bool isOpened() const override { return cap.isOpened(); }
+    bool read(Mat& frame) override { return grab() && retrieve(frame); }
+    bool grab() override { return cap.grab(); }
+
+    bool retrieve(Mat& frame) override
+    {
+        if (format == PixelFormat::BGR) return cap.retrieve(frame);
+
+        // Hand the backend its buffer back in the shape it delivered (one row
+        // of bytes), so it's reused instead of reallocated
+        if (!frame.empty() && frame.isContinuous()) frame = frame.reshape(1, 1);
+        if (!cap.retrieve(frame)) return false;
+        if (shapeRawFrame(frame, size, format)) return true;
+
+        // Not the layout we asked for (the backend converted anyway, or a
+        // stride we don't know): go back to plain BGR for good
+        format = PixelFormat::BGR;
+        cap.set(CAP_PROP_CONVERT_RGB, 1);
+        return frame.type() == CV_8UC3;
+    }
+
+    double fps() const override { return cap.get(CAP_PROP_FPS); }
+    PixelFormat pixelFormat() const override { return format; }
+    double get(int propId) const override { return cap.get(propId); }
+
+    string describe() const override
+    {
+        string d = "camera " + to_string(index);
+        if (packets) d += " (mjpeg)";
+        if (format != PixelFormat::BGR) d += string(" (") + pixelFormatName(format) + ")";
+        return d;
+    }
+
+private:
+    int index;
+    VideoCapture cap;
+    bool packets = false;
+    PixelFormat format = PixelFormat::BGR;
+    Size size;
+};
+
+// ------------------------------------------------------------
+// Video file (or anything else VideoCapture opens by name)
+// ------------------------------------------------------------
+class VideoFileSource : public FrameSource
+{
+public:
+    VideoFileSource(const string& path, bool passthrough) : path(path), cap(path)
+    {
+        // Only MJPEG streams give packets the rest of the pipeline understands
+        if (passthrough && cap.isOpened() && (int)cap.get(CAP_PROP_FOURCC) == VideoWriter::fourcc('M', 'J', 'P', 'G'))
+            packets = cap.set(CAP_PROP_FORMAT, -1);
+    }
+
+    bool isOpened() const override { return cap.isOpened(); }
+
+    bool read(Mat& frame) override
+    {
+        return grab() && retrieve(frame);
+    }
+
+    bool grab() override
+    {
+        if (ended) return false;
+        if (cap.grab()) return true;
+        ended = true; // VideoCapture doesn't tell end-of-file from errors; files don't recover
+        return false;
+    }
+
+    bool retrieve(Mat& frame) override
+    {
+        return cap.retrieve(frame) && !frame.empty();
+    }
+
+    bool exhausted() const override { return ended; }
+    double fps() const override { return cap.get(CAP_PROP_FPS); }
+    double get(int propId) const override { return cap.get(propId); }
+    string describe() const override { return "file " + path + (packets ? " (mjpeg)" : ""); }
+
+private:
+    string path;
+    VideoCapture cap;
+    bool ended = false;
+    bool packets = false;
+};
+
+// ------------------------------------------------------------
+// Image sequence: a directory of images, or a printf pattern
+// ------------------------------------------------------------
+class ImageSequenceSource : public FrameSource
+{
+public:
+    ImageSequenceSource(const string& where, double fps, bool passthrough)
+        : where(where), rate(fps), packets(passthrough)
+    {
+        if (where.find('%') != string::npos && !fs::is_directory(where))
+        {
+            if (!isFramePattern(where))
+            {
+                cerr << "images:" << where << " must have exactly one %d conversion (e.g. %05d, %% for a '%')\n";
+                return;
+            }
+
+            // Numbered files; sequences start at 0 or 1
+            char name[4096];
+            for (int first = 0; first <= 1 && paths.empty(); first++)
+            {
+                for (int i = first; i < kMaxSequenceFrames; i++)
+                {
+                    snprintf(name, sizeof(name), where.c_str(), i);
+                    if (!fs::exists(name)) break;
+                    paths.push_back(name);
+                }
+            }
+        }
+        else if (fs::is_directory(where))
+        {
+            for (const auto& entry : fs::directory_iterator(where))
+            {
+                if (!entry.is_regular_file()) continue;
+                string ext = entry.path().extension().string();
+                transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+                if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")
+                    paths.push_back(entry.path().string());
+            }
+            sort(paths.begin(), paths.end());
+        }
+    }
+
+    bool isOpened() const override { return !paths.empty(); }
+
+    bool read(Mat& frame) override
+    {
+        if (next >= paths.size()) return false;
+        const string& path = paths[next++];
+        if (packets && hasJpegExtension(path))
+            return readBytes(path, frame);
+        frame = imread(path, IMREAD_COLOR);
+        return !frame.empty();
+    }
+
+    bool exhausted() const override { return next >= paths.size(); }
+    double fps() const override { return rate; }
+
+    string describe() const override
+    {
+        return "images " + where + " (" + to_string(paths.size()) + " frames" + (packets ? ", mjpeg" : "") + ")";
+    }
+
+private:
+    // The file as one JPEG packet
+    static bool readBytes(const string& path, Mat& frame)
+    {
+        ifstream in(path, ios::binary | ios::ate);
+        const streamoff size = in.tellg();
+        if (!in || size <= 0) return false;
+
+        frame.create(1, (int)size, CV_8UC1);
+        in.seekg(0);
+        return (bool)in.read((char*)frame.ptr<uchar>(0), size) && isJpegPacket(frame);
+    }
+
+    string where;
+    double rate;
+    bool packets;
+    vector<string> paths;
+    size_t next = 0;
+};
+
+// ------------------------------------------------------------
+// Synthetic scene: a static gradient with a block that moves for 2 s out of
+// every 5 s. Frame n is always the same image, so runs are reproducible.
+// ------------------------------------------------------------
+class SyntheticSource : public FrameSource
+{
+public:
+    SyntheticSource(int width, int height, double fps) : rate(fps), background(height, width, CV_8UC3)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            uchar* row = background.ptr<uchar>(y);
+            for (int x = 0; x < width; x++)
+            {
+                row[3 * x + 0] = (uchar)(64 + 128 * x / width);
+                row[3 * x + 1] = (uchar)(64 + 128 * y / height);
+                row[3 * x + 2] = 110;
+            }
+        }
+    }
+
+    bool isOpened() const override { return !background.empty(); }
+
+    bool read(Mat& frame) override
+    {
+        const int w = background.cols, h = background.rows;
+        const long long cycle = (long long)(5.0 * rate + 0.5);
+        const long long moving = (long long)(2.0 * rate + 0.5);
+
+        // Block position only advances during the moving part of each cycle
+        const long long inCycle = n % cycle;
+        const long long steps = (n / cycle) * moving + min(inCycle, moving);
+        const int range = max(1, w - w / 8);
+        const int x = (int)((steps * max(1, w / 90)) % range);
+
+        background.copyTo(frame);
+        rectangle(frame, Rect(x, h / 3, w / 8, h / 4), Scalar(40, 40, 200), FILLED);
+        n++;
+        return true;
+    }
+
+    double fps() const override { return rate; }
+
+    string describe() const override
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "synthetic %dx%d@%g", background.cols, background.rows, rate);
+        return buf;
+    }
+
+private:
+    double rate;
+    Mat background;
+    long long n = 0;
+};
+
+// ------------------------------------------------------------
+// JPEG-encode another source's frames, the way an MJPEG camera's encoder
+// would, so passthrough runs without a camera
+// ------------------------------------------------------------
+class JpegEncodingSource : public FrameSource
+{
+public:
+    explicit JpegEncodingSource(unique_ptr<FrameSource> inner) : inner(std::move(inner)) {}
+
+    bool isOpened() const override { return inner->isOpened(); }
+
+    bool read(Mat& frame) override
+    {
+        if (!inner->read(image)) return false;
+        if (!imencode(".jpg", image, bytes, { IMWRITE_JPEG_QUALITY, 90 })) return false;
+
+        frame.create(1, (int)bytes.size(), CV_8UC1);
+        copy(bytes.begin(), bytes.end(), frame.ptr<uchar>(0));
+        return true;
+    }
+
+    bool exhausted() const override { return inner->exhausted(); }
+    double fps() const override { return inner->fps(); }
+    double get(int propId) const override { return inner->get(propId); }
+    string describe() const override { return inner->describe() + " (mjpeg)"; }
+
+private:
+    unique_ptr<FrameSource> inner;
+    Mat image;
+    vector<uchar> bytes;
+};
+
+// ------------------------------------------------------------
+// Convert another source's BGR frames to a raw YUV layout, the way a YUV
+// camera would deliver them, so the luma path runs without a camera
+// ------------------------------------------------------------
+class YuvEncodingSource : public FrameSource
+{
+public:
+    YuvEncodingSource(unique_ptr<FrameSource> inner, PixelFormat format) : inner(std::move(inner)), format(format) {}
+
+    bool isOpened() const override { return inner->isOpened(); }
+
+    bool read(Mat& frame) override
+    {
+        if (!inner->read(image) || image.type() != CV_8UC3) return false;
+
+        // 4:2:x chroma needs even sizes
+        const Mat even = image(Rect(0, 0, image.cols & ~1, image.rows & ~1));
+        fromBgr(even, format, frame);
+        return !frame.empty();
+    }
+
+    bool exhausted() const override { return inner->exhausted(); }
+    double fps() const override { return inner->fps(); }
+    PixelFormat pixelFormat() const override { return format; }
+    double get(int propId) const override { return inner->get(propId); }
+    string describe() const override { return inner->describe() + " (" + pixelFormatName(format) + ")"; }
+
+private:
+    unique_ptr<FrameSource> inner;
+    PixelFormat format;
+    Mat image;
+};
+
+// ------------------------------------------------------------
+// Real-time pacing around a non-camera source
+// ------------------------------------------------------------
+class PacedSource : public FrameSource
+{
+public:
+    explicit PacedSource(unique_ptr<FrameSource> inner)
+        : inner(std::move(inner)),
+          period(chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / this->inner->fps())))
+    {
+    }
+
+    bool isOpened() const override { return inner->isOpened(); }
+
+    bool read(Mat& frame) override
+    {
+        pace();
+        return inner->read(frame);
+    }
+
+    bool grab() override
+    {
+        pace();
+        return inner->grab();
+    }
+
+    bool retrieve(Mat& frame) override { return inner->retrieve(frame); }
+
+    bool exhausted() const override { return inner->exhausted(); }
+    double fps() const override { return inner->fps(); }
+    PixelFormat pixelFormat() const override { return inner->pixelFormat(); }
+    double get(int propId) const override { return inner->get(propId); }
+    string describe() const override { return inner->describe() + " (paced)"; }
+
+private:
+    // Wait for this frame's slot in real time
+    void pace()
+    {
+        const auto now = Clock::now();
+        if (started && now < due)
+            this_thread::sleep_until(due);
+
+        // Running late (slow decode): start over from now instead of bursting
+        if (!started || now > due + period) due = now;
+        started = true;
+        due += period;
+    }
+
+    unique_ptr<FrameSource> inner;
+    Clock::duration period;
+    Clock::time_point due{};
+    bool started = false;
+};
+} // namespace
+
+bool FrameSource::grab()
+{
+    hasGrabbed = read(grabbed) && !grabbed.empty();
+    return hasGrabbed;
+}
+
+bool FrameSource::retrieve(Mat& frame)
+{
+    if (!hasGrabbed) return false;
+    hasGrabbed = false;
+    swap(frame, grabbed); // hands over the buffer; frame's old one is reused by the next grab()
+    return true;
+}
+
+unique_ptr<FrameSource> openFrameSource(const string& spec, const SourceOptions& options)
+{
+    if (isNumber(spec))
+        return make_unique<CameraSource>(stoi(spec), options.mjpegPassthrough, options.captureFormat);
+
+    unique_ptr<FrameSource> source;
+    if (spec.compare(0, 7, "images:") == 0)
+    {
+        string where = spec.substr(7);
+        double fps = 30.0;
+        splitFps(where, fps);
+        source = make_unique<ImageSequenceSource>(where, fps, options.mjpegPassthrough);
+        if (!options.mjpegPassthrough && options.captureFormat != PixelFormat::BGR)
+            source = make_unique<YuvEncodingSource>(std::move(source), options.captureFormat);
+    }
+    else if (spec.compare(0, 9, "synthetic") == 0 && (spec.size() == 9 || spec[9] == ':' || spec[9] == '@'))
+    {
+        string rest = spec.substr(9);
+        if (!rest.empty() && rest[0] == ':') rest.erase(0, 1);
+        double fps = 30.0;
+        splitFps(rest, fps);
+
+        int w = 640, h = 480;
+        if (!rest.empty() && (sscanf(rest.c_str(), "%dx%d", &w, &h) != 2 || w < 16 || h < 16))
+        {
+            w = 640;
+            h = 480;
+        }
+        source = make_unique<SyntheticSource>(w, h, fps);
+        if (options.mjpegPassthrough)
+            source = make_unique<JpegEncodingSource>(std::move(source));
+        else if (options.captureFormat != PixelFormat::BGR)
+            source = make_unique<YuvEncodingSource>(std::move(source), options.captureFormat);
+    }
+    else
+    {
+        // "file:PATH", or a bare path / URL
+        source = make_unique<VideoFileSource>(spec.compare(0, 5, "file:") == 0 ? spec.substr(5) : spec,
+                                              options.mjpegPassthrough);
+    }
+
+    if (!options.fast && source->isOpened() && source->fps() > 0.0)
+        return make_unique<PacedSource>(std::move(source));
+    return source;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// Where frames come from: a camera, a video file, an image sequence or a
+// procedural synthetic scene.
+
+#include "frame_format.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Source switches (see run_options.hpp for the command-line side).
+struct SourceOptions
+{
+    // One spec per camera slot, in CSV column order (see openFrameSource()).
+    // Program 1 uses the first, Program 2 the first two, Program 3 all.
+    std::vector<std::string> specs = { "0", "1" };
+
+    // Read files, image sequences and synthetic scenes as fast as possible
+    // instead of at their frame rate. Cameras always run at their own rate.
+    bool fast = false;
+
+    // Keep MJPEG frames compressed: cameras are switched to MJPG with RGB
+    // conversion off, MJPEG files are read as raw packets, .jpg sequences as
+    // file bytes and synthetic scenes are JPEG-encoded as a camera would. Each
+    // frame is then a JPEG packet (see mjpeg.hpp); sources that can't deliver
+    // packets (a camera without MJPG, an H.264 file) decode as usual.
+    bool mjpegPassthrough = false;
+
+    // Raw YUV capture: cameras are asked for YUYV or NV12 with RGB conversion
+    // off, so the Y plane can go to detection as it is and BGR is only made
+    // for the consumers that need color. Image sequences and synthetic scenes
+    // are converted to the layout, to stand in for such a camera. A camera
+    // that can't deliver it stays on BGR (check FrameSource::pixelFormat()).
+    PixelFormat captureFormat = PixelFormat::BGR;
+};
+
+// ============================================================
+// FrameSource
+// ============================================================
+//
+// Why this exists:
+// - Every program hardwired VideoCapture(0) / CameraStream(1), so none of
+//   the motion code could run (or be benchmarked) without webcams attached
+// - The programs and CameraStream now read from a FrameSource; which backend
+//   is behind it is picked by a spec string:
+//
+//     0, 1, ...                  live camera by index
+//     file:PATH                  video file (replay of a recorded incident)
+//     images:DIR                 every .jpg / .png / .bmp in DIR, by name
+//     images:PATTERN             printf pattern with one %d, e.g. images:clip/%05d.png
+//     synthetic[:WxH][@FPS]      moving block over a static scene
+//
+//   images: and synthetic: take "@FPS" (default 30); files use the rate
+//   stored in the container.
+// - Non-camera sources are paced to their frame rate by default, so they
+//   behave like a camera; with SourceOptions::fast they return frames as
+//   fast as they can be produced (throughput runs on CI boxes)
+//
+// read() blocks until the next frame (like VideoCapture::read()). A source
+// is used by one thread at a time. With SourceOptions::mjpegPassthrough a
+// frame may be a JPEG packet instead of a BGR image (isJpegPacket()).
+//
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool isOpened() const = 0;
+
+    // Next frame into `frame` (reusing its buffer when possible). False on a
+    // read error or at the end of a file / sequence.
+    virtual bool read(cv::Mat& frame) = 0;
+
+    // read() split in two, like VideoCapture: grab() latches the next frame
+    // (cheap for cameras and files), retrieve() decodes it. Grabbing several
+    // cameras back to back and decoding afterwards keeps their frames close
+    // in time. Backends without a split read the whole frame in grab().
+    virtual bool grab();
+    virtual bool retrieve(cv::Mat& frame);
+
+    // True once read() failed because the source ran out, not because of a
+    // transient error: there is no point retrying.
+    virtual bool exhausted() const { return false; }
+
+    // Nominal frame rate, 0 = unknown (cameras that don't report it).
+    virtual double fps() const = 0;
+
+    // Layout of the frames read() returns. Settled by the first read.
+    virtual PixelFormat pixelFormat() const { return PixelFormat::BGR; }
+
+    // Capture property (cv::CAP_PROP_*); 0 when the backend has none.
+    virtual double get(int /*propId*/) const { return 0.0; }
+
+    // Short human-readable name, e.g. "camera 0" or "file incident.mp4".
+    virtual std::string describe() const = 0;
+
+private:
+    cv::Mat grabbed; // default grab() / retrieve() hand-off
+    bool hasGrabbed = false;
+};
+
+// Opens the source named by `spec` (see FrameSource). Never returns null;
+// check isOpened().
+std::unique_ptr<FrameSource> openFrameSource(const std::string& spec, const SourceOptions& options = SourceOptions());
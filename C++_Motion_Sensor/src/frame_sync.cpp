@@ -0,0 +1,187 @@
+#include "frame_sync.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+
+// ------------------------------------------------------------
+// CaptureBarrier
+// ------------------------------------------------------------
+void CaptureBarrier::join()
+{
+    lock_guard<mutex> lock(m);
+    members++;
+}
+
+void CaptureBarrier::leave()
+{
+    {
+        lock_guard<mutex> lock(m);
+        if (members > 0) members--;
+
+        // The ones already waiting may be everybody now
+        if (arrived > 0 && arrived >= members)
+        {
+            arrived = 0;
+            round++;
+        }
+    }
+    cv.notify_all();
+}
+
+bool CaptureBarrier::arriveAndWait(const atomic<bool>& running)
+{
+    unique_lock<mutex> lock(m);
+    const uint64_t myRound = round;
+    if (++arrived >= members)
+    {
+        arrived = 0;
+        round++;
+        lock.unlock();
+        cv.notify_all();
+        return true;
+    }
+
+    while (round == myRound)
+    {
+        cv.wait_for(lock, chrono::milliseconds(50));
+        if (round == myRound && !running)
+        {
+            arrived--;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// SkewTracker
+// ------------------------------------------------------------
+const vector<double> SkewTracker::bucketsMs = { 1, 2, 5, 10, 20, 50, 100 };
+
+SkewTracker::SkewTracker(double toleranceMs) : toleranceMs(toleranceMs)
+{
+    totals.histogram.assign(bucketsMs.size() + 1, 0);
+}
+
+void SkewTracker::resize(size_t cameras)
+{
+    pending.resize(cameras);
+    active.resize(cameras, true);
+}
+
+void SkewTracker::deactivate(size_t k)
+{
+    if (k >= active.size() || !active[k]) return;
+    active[k] = false;
+    pending[k].clear();
+    match(); // the others may have been waiting on this one
+}
+
+void SkewTracker::add(size_t k, chrono::steady_clock::time_point captureTime)
+{
+    if (k >= active.size() || !active[k]) return;
+
+    // Bounded: a camera far ahead of the others only keeps its newest frames
+    auto& q = pending[k];
+    q.push_back(captureTime);
+    if (q.size() > 8)
+    {
+        q.pop_front();
+        totals.unmatched++;
+    }
+    match();
+}
+
+void SkewTracker::match()
+{
+    size_t activeCount = 0;
+    for (bool a : active) activeCount += a ? 1 : 0;
+    if (activeCount < 2)
+    {
+        for (auto& q : pending) q.clear();
+        return;
+    }
+
+    for (;;)
+    {
+        size_t oldest = 0;
+        chrono::steady_clock::time_point lo = chrono::steady_clock::time_point::max();
+        chrono::steady_clock::time_point hi = chrono::steady_clock::time_point::min();
+        for (size_t k = 0; k < pending.size(); k++)
+        {
+            if (!active[k]) continue;
+            if (pending[k].empty()) return; // wait for this camera
+            const auto t = pending[k].front();
+            if (t < lo)
+            {
+                lo = t;
+                oldest = k;
+            }
+            hi = max(hi, t);
+        }
+
+        const double ms = chrono::duration<double, milli>(hi - lo).count();
+        if (ms > toleranceMs)
+        {
+            // The oldest frame has no partner this close; its camera's next
+            // frame may.
+            pending[oldest].pop_front();
+            totals.unmatched++;
+            continue;
+        }
+
+        totals.sets++;
+        msTotal += ms;
+        totals.msMax = max(totals.msMax, ms);
+        const size_t bucket = (size_t)(lower_bound(bucketsMs.begin(), bucketsMs.end(), ms) - bucketsMs.begin());
+        totals.histogram[bucket]++;
+
+        for (size_t k = 0; k < pending.size(); k++)
+            if (active[k]) pending[k].pop_front();
+    }
+}
+
+SkewStats SkewTracker::stats() const
+{
+    SkewStats s = totals;
+    s.msAvg = (s.sets > 0) ? msTotal / (double)s.sets : 0.0;
+    return s;
+}
+
+string formatSkewStats(const SkewStats& s, double toleranceMs)
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%llu frame sets within %.1f ms (skew avg %.2f ms, max %.2f ms), %llu unmatched frames",
+             (unsigned long long)s.sets, toleranceMs, s.msAvg, s.msMax, (unsigned long long)s.unmatched);
+
+    string line = buf;
+    line += " |";
+    for (size_t b = 0; b < s.histogram.size(); b++)
+    {
+        char cell[48];
+        if (b < SkewTracker::bucketsMs.size())
+            snprintf(cell, sizeof(cell), " <=%gms:%llu", SkewTracker::bucketsMs[b], (unsigned long long)s.histogram[b]);
+        else
+            snprintf(cell, sizeof(cell), " more:%llu", (unsigned long long)s.histogram[b]);
+        line += cell;
+    }
+    return line;
+}
+
+bool writeSkewHistogram(const string& csvPath, const SkewStats& s)
+{
+    ofstream out(csvPath);
+    if (!out.is_open()) return false;
+
+    out << "SkewMsUpTo,Sets\n";
+    for (size_t b = 0; b < s.histogram.size(); b++)
+    {
+        if (b < SkewTracker::bucketsMs.size()) out << SkewTracker::bucketsMs[b];
+        else                                  out << "inf";
+        out << "," << s.histogram[b] << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// Multi-camera alignment: latch cameras together (CaptureBarrier) and pair
+// their frames by capture time, with a skew histogram (SkewTracker).
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================================================
+// CaptureBarrier
+// ============================================================
+//
+// Why this exists:
+// - Each CameraStream reads its camera in its own loop, so the "same
+//   moment" on two cameras can be tens of ms apart
+// - With --sync-capture every capture thread waits here before grab(): all
+//   cameras are latched back to back, then each decodes (retrieve()) on its
+//   own thread, in parallel, so syncing adds no decode latency
+// - The set runs at the pace of the slowest camera, which is the point
+//
+// Streams join() when their thread starts and leave() when it ends (stop,
+// camera gone), so a dead camera never holds the others up.
+//
+class CaptureBarrier
+{
+public:
+    void join();
+    void leave();
+
+    // Block until every joined stream arrived for this round, or `running`
+    // went false (checked every 50 ms). Returns false in the latter case.
+    bool arriveAndWait(const std::atomic<bool>& running);
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    size_t members = 0;
+    size_t arrived = 0;
+    uint64_t round = 0;
+};
+
+struct SkewStats
+{
+    uint64_t sets = 0;      // frame sets paired within the tolerance
+    uint64_t unmatched = 0; // frames dropped because no partner was close enough
+    double   msAvg = 0.0;   // skew (newest - oldest capture time) of the paired sets
+    double   msMax = 0.0;
+
+    // Paired sets per skew bucket, upper bounds in SkewTracker::bucketsMs
+    std::vector<uint64_t> histogram;
+};
+
+// ============================================================
+// SkewTracker
+// ============================================================
+//
+// Pairs each camera's new frames by capture timestamp: one frame per active
+// camera, all within `toleranceMs` of each other, make a set. A frame that
+// is older than its partners by more than the tolerance had no partner
+// (dropped by latest-frame-wins, or the cameras drift) and is counted as
+// unmatched. Only used from the engine thread.
+//
+class SkewTracker
+{
+public:
+    // Histogram bucket upper bounds in ms; the last bucket is everything above.
+    static const std::vector<double> bucketsMs;
+
+    explicit SkewTracker(double toleranceMs = 10.0);
+
+    // Number of cameras; all start active.
+    void resize(size_t cameras);
+
+    // Camera k stopped: stop waiting for its frames.
+    void deactivate(size_t k);
+
+    // A new frame from camera k. Pairs as soon as every active camera has one.
+    void add(size_t k, std::chrono::steady_clock::time_point captureTime);
+
+    SkewStats stats() const;
+
+private:
+    void match();
+
+    double toleranceMs;
+    std::vector<std::deque<std::chrono::steady_clock::time_point>> pending;
+    std::vector<bool> active;
+
+    SkewStats totals;
+    double msTotal = 0.0;
+};
+
+// One-line summary for logs.
+std::string formatSkewStats(const SkewStats& s, double toleranceMs);
+
+// "SkewMsUpTo,Sets" rows for the histogram export.
+bool writeSkewHistogram(const std::string& csvPath, const SkewStats& s);
@@ -1,6 +1,5 @@
 #include <opencv2/core.hpp>
 #include <opencv2/videoio.hpp>
-#include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
 #include <iostream>
@@ -9,6 +8,17 @@
 #include <chrono>
 #include <filesystem>
 #include <regex>
+#include <memory>
+
+#include "frame_ring.hpp"
+#include "control.hpp"
+#include "display.hpp"
+#include "event_recorder.hpp"
+#include "frame_source.hpp"
+#include "motion_detector.hpp"
+#include "motion_events.hpp"
+#include "recorder.hpp"
+#include "run_options.hpp"
 
 using namespace cv;
 using namespace std;
@@ -43,8 +53,35 @@ static int getNextIndex(const fs::path& dir, const string& baseName, const strin
     return maxIdx + 1;
 }
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    // Command-line switches (all default to the original behavior)
+    RunOptions opts = parseRunOptions(argc, argv);
+    if (opts.showHelp)
+    {
+        printRunOptionsHelp(argv[0]);
+        return 0;
+    }
+    if (opts.sources.mjpegPassthrough)
+    {
+        // JPEG packets need the engine's packet path (Program 3)
+        cout << "--mjpeg-passthrough is only supported by the threaded program; decoding frames as usual.\n";
+        opts.sources.mjpegPassthrough = false;
+        opts.writer.passthrough = false;
+    }
+    if (opts.sources.captureFormat != PixelFormat::BGR)
+    {
+        // Raw YUV frames need the engine's Y-plane path (Program 3)
+        cout << "--capture-format is only supported by the threaded program; capturing BGR.\n";
+        opts.sources.captureFormat = PixelFormat::BGR;
+    }
+
+    // Live windows (none with --headless) and remote control (signals, FIFO, socket)
+    Display display(opts.display);
+    ControlChannel control(opts.control);
+    if (!control.ok())
+        return -1;
+
     // Ensure output folders exist (relative to the working directory / exe run directory)
     fs::path videoDir = fs::path("./Output Videos");
     fs::path dataDir  = fs::path("./Output Data");
@@ -53,17 +90,18 @@ int main(int, char**)
 
     Mat src;
 
-    // Use default camera as video source
-    VideoCapture cap(0);
+    // Use default camera as video source (or the first --cameras entry:
+    // a file, an image sequence or a synthetic scene, see frame_source.hpp)
+    unique_ptr<FrameSource> cap = openFrameSource(opts.sources.specs.front(), opts.sources);
 
     // Check if camera opened successfully
-    if (!cap.isOpened()) {
-        cerr << "ERROR! Unable to open camera\n";
+    if (!cap->isOpened()) {
+        cerr << "ERROR! Unable to open " << cap->describe() << "\n";
         return -1;
     }
 
     // Grab one frame to determine size/type
-    cap >> src;
+    cap->read(src);
     if (src.empty()) {
         cerr << "ERROR! blank frame grabbed\n";
         return -1;
@@ -75,8 +113,17 @@ int main(int, char**)
     bool recordingOn = false;
     bool motionOn = false;
 
-    VideoWriter writer;
+    Recorder recorder(opts.recorder, opts.writer); // camera-rate video, encoded on its own thread
+
+    // Motion-triggered clips that include the seconds before the trigger (only with --preroll)
+    EventRecorder events(opts.events, opts.recorder, opts.writer, VideoWriter::fourcc('m', 'p', '4', 'v'),
+                         [&]() { return (videoDir / ("Event" + to_string(getNextIndex(videoDir, "Event", ".mp4")) + ".mp4")).string(); });
     ofstream csv;
+    ofstream heatCsv; // <log>_heatmap.csv, with --heatmap
+    ofstream blobCsv; // <log>_blobs.csv, with --blobs
+    ofstream eventCsv; // <log>_events.csv, with --motion-events
+    ofstream statsCsv; // <log>_stats.csv, with --ratio-stats
+    ofstream flowCsv;  // <log>_flow.csv, with --motion-vectors
 
     // Timing
     using clock_t = std::chrono::steady_clock;
@@ -85,10 +132,7 @@ int main(int, char**)
 
     int secondsLogged = 0;                 // 1..45
     bool motionDetectedThisSecond = false; // OR of motion detections within current second
-
-    // Motion detection baseline
-    Mat prevGray; // previous frame gray (used to measure change)
-    Mat gray, diff, threshImg;
+    bool lightingThisSecond = false;       // a frame this second was only a lighting change (--lighting)
 
     // --- Tunables for "SIGNIFICANT movement"
     // May need to tweak these depending on camera noise/lighting. Is it possible to get these to tune automatically?
@@ -96,41 +140,98 @@ int main(int, char**)
     const double MOTION_RATIO = 0.02; // fraction of pixels changed to count as "motion" (2%)
     // ---
 
+    // Row-band threads for detection (--detect-threads)
+    unique_ptr<WorkerPool> bandPool;
+    if (opts.detector.threads != 1) bandPool = make_unique<WorkerPool>(opts.detector.threads);
+
+    // Motion detection baseline (previous frame luma lives inside the detector)
+    MotionDetector detector(DIFF_THRESH, MOTION_RATIO, opts.detector);
+    detector.setPool(bandPool.get());
+
+    // Detection regions (--roi): excluded pixels are never looked at
+    RoiConfig roi;
+    string roiError;
+    if (!opts.detector.roiFile.empty() && !loadRoiConfig(opts.detector.roiFile, roi, roiError))
+    {
+        cerr << "ERROR! --roi: " << roiError << "\n";
+        return -1;
+    }
+    detector.setRegions(regionsFor(roi, "Cam1"));
+
+    // Motion start / end events (--motion-events): published the frame they are
+    // decided on, drained right away into <log>_events.csv, the console and
+    // control socket clients that asked for "events"
+    MotionHysteresis hysteresis(0, MOTION_RATIO, opts.motionEvents);
+    MotionEventBus motionEvents;
+    MotionEventQueue& eventLog = motionEvents.subscribe();
+    MotionEventStats eventStats;
+    auto drainMotionEvents = [&]()
+    {
+        MotionEvent e;
+        while (eventLog.pop(e))
+        {
+            const clock_t::time_point now = clock_t::now();
+            eventStats.add(e, now);
+            const string row = formatMotionEventRow(e, "Cam1", motionStartTime, now);
+            eventCsv << row << "\n" << flush;
+            control.broadcast(row);
+            cout << "[Motion] " << row << "\n";
+        }
+    };
+
+    // Background model saved by the last run (--background --background-state)
+    const bool checkpoints = opts.detector.background && !opts.detector.backgroundStateDir.empty();
+    const string statePath = backgroundStatePath(opts.detector.backgroundStateDir, "Cam1");
+    if (checkpoints && detector.loadBackground(statePath))
+        cout << "[Background] Cam1 model restored from " << statePath << "\n";
+
     cout << "Controls:\n"
          << "  r = start recording\n"
          << "  m = start motion sensor (only while recording; runs up to 45s then exits)\n"
          << "  ESC = exit early\n";
+    cout << describeControls(opts.control);
+    if (display.headless())
+        cout << "Headless: no windows, keys above come from the controls listed.\n";
 
     for (;;)
     {
-        if (!cap.read(src)) {
+        // The previous frame may still be queued for the encoder: decode into a new buffer then.
+        detachIfShared(src);
+        if (!cap->read(src)) {
             cerr << "ERROR! blank frame grabbed\n";
             break;
         }
+        clock_t::time_point captureTime = clock_t::now();
 
-        // Always show live feed
-        imshow("Live", src);
+        // Live feed, at the preview rate (skipped with --headless)
+        display.show("Live", src);
 
-        // Handle key input
-        int key = waitKey(1);
+        // Keys from the window, or the same commands from a signal / FIFO / socket
+        int key = display.pollKey();
+        if (key < 0) key = control.pollKey();
 
         // ESC terminates anytime
         if (key == 27) {
-            cout << "ESC pressed. Exiting early.\n";
+            cout << "Stop requested. Exiting early.\n";
             break;
         }
 
         // Start recording on 'r'
+        if (!recordingOn && (key == 'r' || key == 'R') && opts.events.segments)
+        {
+            // Segment mode: clips open on motion (see event_recorder.hpp)
+            recordingOn = true;
+            cout << "Segment recording armed: one Event#.mp4 per motion event in " << videoDir.string() << "\n";
+        }
         if (!recordingOn && (key == 'r' || key == 'R'))
         {
             int nextVid = getNextIndex(videoDir, "Video", ".mp4");
             fs::path videoPath = videoDir / ("Video" + to_string(nextVid) + ".mp4");
 
             int codec = VideoWriter::fourcc('m', 'p', '4', 'v');
-            double fps = 60.0;
 
-            writer.open(videoPath.string(), codec, fps, src.size(), isColor);
-            if (!writer.isOpened()) {
+            // Written at the camera's measured frame rate (see recorder.hpp)
+            if (!recorder.start(videoPath.string(), codec, src.size(), isColor)) {
                 cerr << "Could not open the output video file for write\n";
                 return -1;
             }
@@ -151,8 +252,46 @@ int main(int, char**)
                 return -1;
             }
 
-            // header row 
-            csv << "Second,Status\n";
+            // header row (segment columns only when event clips are on)
+            csv << "Second,Status" << (opts.detector.lighting ? ",Lighting" : "")
+                << (events.enabled() ? ",SegmentStart,SegmentEnd" : "") << "\n";
+
+            // Per-tile motion, one row per second next to the log
+            if (opts.detector.heatmapCols > 0)
+            {
+                heatCsv = openSideCsv(dataPath, "_heatmap", string("Second,Camera,Frames,") +
+                                      heatmapColumns(opts.detector.heatmapCols, opts.detector.heatmapRows));
+                if (!heatCsv.is_open()) return -1;
+            }
+
+            // Motion regions of every detected frame
+            if (opts.detector.blobs)
+            {
+                blobCsv = openSideCsv(dataPath, "_blobs",
+                                      "Second,Camera,Time,X,Y,Width,Height,Area,CentroidX,CentroidY");
+                if (!blobCsv.is_open()) return -1;
+            }
+
+            // Ratio statistics, one row per second next to the log
+            if (opts.detector.ratioStats)
+            {
+                statsCsv = openSideCsv(dataPath, "_stats", string("Second,Camera,") + windowStatsColumns());
+                if (!statsCsv.is_open()) return -1;
+            }
+
+            // Dominant direction and speed of motion, one row per second
+            if (opts.detector.vectors)
+            {
+                flowCsv = openSideCsv(dataPath, "_flow", string("Second,Camera,") + flowColumns());
+                if (!flowCsv.is_open()) return -1;
+            }
+
+            // Motion start / end, one row per event as it happens
+            if (opts.motionEvents.enabled)
+            {
+                eventCsv = openSideCsv(dataPath, "_events", motionEventColumns());
+                if (!eventCsv.is_open()) return -1;
+            }
 
             motionOn = true;
             motionStartTime = clock_t::now();
@@ -160,43 +299,54 @@ int main(int, char**)
 
             secondsLogged = 0;
             motionDetectedThisSecond = false;
+            lightingThisSecond = false;
 
             // Initialize baseline
-            cvtColor(src, prevGray, COLOR_BGR2GRAY);
+            detector.reset(src);
+            hysteresis.reset();
 
             cout << "Motion sensor started. Logging to: " << dataPath.string() << "\n";
             cout << "Will auto-terminate after 2 minutes (120 seconds).\n";
         }
 
-        // If recording, write every frame
-        if (recordingOn) {
-            writer.write(src);
+        // Every frame feeds the recorder so it keeps measuring the camera rate.
+        // While recording, frames are queued for the encoder thread at that
+        // rate (no copy), tagged with the CSV second they're counted in.
+        const int logSecond = motionOn ? secondsLogged + 1 : 0;
+        recorder.addFrame(src, captureTime, logSecond);
+        events.addFrame(src, captureTime, logSecond); // pre-roll (no-op without --preroll)
+        if (recordingOn && !recorder.ok()) {
+            cerr << "Could not open the output video file for write\n";
+            return -1;
         }
 
         // Motion detection + CSV logging only while motion sensor is active
         if (motionOn)
         {
-            // Convert to grayscale
-            cvtColor(src, gray, COLOR_BGR2GRAY);
-
-            // Compute absolute difference vs previous frame
-            absdiff(gray, prevGray, diff);
-
-            // Threshold to keep only "meaningful" pixel changes
-            threshold(diff, threshImg, DIFF_THRESH, 255, THRESH_BINARY);
+            // Grayscale, difference vs previous frame, threshold and count changed
+            // pixels in one fused pass. The detector then swaps the current luma in
+            // as the next baseline (no clone, no allocation).
+            MotionResult res = detector.process(src);
 
-            // How many pixels changed?
-            int changed = countNonZero(threshImg);
-            int totalPixels = threshImg.rows * threshImg.cols;
-
-            double ratio = (totalPixels > 0) ? (double)changed / (double)totalPixels : 0.0;
+            if (blobCsv.is_open())
+            {
+                const double t = std::chrono::duration<double>(captureTime - motionStartTime).count();
+                for (const MotionBlob& b : detector.blobs())
+                    blobCsv << secondsLogged + 1 << ",Cam1," << formatBlobRow(b, t) << "\n";
+            }
 
-            if (ratio >= MOTION_RATIO) {
+            if (res.motion) {
                 motionDetectedThisSecond = true;
+                events.trigger(captureTime);
             }
+            if (res.lighting) lightingThisSecond = true;
 
-            // Update prev frame baseline for next loop
-            prevGray = gray.clone();
+            MotionEvent motionEvent;
+            if (opts.motionEvents.enabled && hysteresis.update(res, captureTime, motionEvent))
+            {
+                motionEvents.publish(motionEvent);
+                drainMotionEvents();
+            }
 
             // Every 1 second: write one CSV row
             auto now = clock_t::now();
@@ -207,18 +357,39 @@ int main(int, char**)
                 secondsLogged += 1;
 
                 csv << secondsLogged << ","
-                    << (motionDetectedThisSecond ? "Motion Detected" : "No motion")
-                    << "\n";
+                    << (motionDetectedThisSecond ? "Motion Detected" : "No motion");
+                if (opts.detector.lighting)
+                    csv << "," << (lightingThisSecond ? "Lighting change" : "Steady");
+                if (events.enabled())
+                {
+                    // Clips opened / closed since the last row
+                    EventRecorder::SegmentMarks marks = events.takeSegmentMarks(motionStartTime);
+                    csv << "," << marks.starts << "," << marks.ends;
+                }
+                csv << "\n";
+
+                if (heatCsv.is_open())
+                {
+                    const MotionHeatmap heat = detector.takeHeatmap();
+                    heatCsv << secondsLogged << ",Cam1," << heat.frames << "," << formatHeatmapCells(heat) << "\n";
+                }
+                if (statsCsv.is_open())
+                    statsCsv << secondsLogged << ",Cam1," << formatWindowStats(detector.takeWindowStats()) << "\n";
+                if (flowCsv.is_open())
+                    flowCsv << secondsLogged << ",Cam1," << formatFlowStats(detector.takeFlow()) << "\n";
                 
                 //Printing what's going in the CSV in real time, to be consistent with the python Light Level Program
                 cout << "[Sensor] t =" << secondsLogged
                      << "s -->"
                      << (motionDetectedThisSecond ? "Motion Detected": "No motion")
+                     << (lightingThisSecond ? " (lighting change)" : "")
                      << endl;
 
                 // Reset for next second window
                 motionDetectedThisSecond = false;
+                lightingThisSecond = false;
                 lastSecondTick = now;
+                detector.rollWindow(src);
             }
 
             // Auto-terminate after 120 seconds (based on seconds logged)
@@ -229,11 +400,54 @@ int main(int, char**)
         }
     }
 
+    // An event still running at exit ends at its last moving frame
+    MotionEvent lastEvent;
+    if (hysteresis.finish(clock_t::now(), lastEvent))
+        motionEvents.publish(lastEvent);
+    drainMotionEvents();
+    if (opts.motionEvents.enabled && motionOn)
+    {
+        eventStats.dropped = eventLog.dropped();
+        cout << "[Motion] " << formatMotionEventStats(eventStats) << "\n";
+    }
+
     // Explicit Cleanup, essentially due diligence as writer does close as well
+    if (events.enabled())
+    {
+        events.stop(); // closes an open event clip
+        cout << "[Events] " << formatEventStats(events.stats()) << "\n";
+
+        // A clip still open at exit ends in a final (partial-second) row
+        EventRecorder::SegmentMarks marks = events.takeSegmentMarks(motionStartTime);
+        if (csv.is_open() && !(marks.starts.empty() && marks.ends.empty()))
+        {
+            csv << secondsLogged + 1 << "," << (motionDetectedThisSecond ? "Motion Detected" : "No motion");
+            if (opts.detector.lighting)
+                csv << "," << (lightingThisSecond ? "Lighting change" : "Steady");
+            csv << "," << marks.starts << "," << marks.ends << "\n";
+        }
+    }
     if (csv.is_open()) csv.close();
-    if (writer.isOpened()) writer.release();
-    cap.release();
-    destroyAllWindows();
+    if (heatCsv.is_open()) heatCsv.close();
+    if (blobCsv.is_open()) blobCsv.close();
+    if (eventCsv.is_open()) eventCsv.close();
+    if (statsCsv.is_open()) statsCsv.close();
+    if (flowCsv.is_open()) flowCsv.close();
+    if (checkpoints)
+    {
+        error_code ec;
+        fs::create_directories(opts.detector.backgroundStateDir, ec);
+        if (detector.saveBackground(statePath))
+            cout << "[Background] Cam1 model saved to " << statePath << "\n";
+    }
+    if (recorder.isRecording())
+    {
+        recorder.stop(); // finishes encoding whatever is still queued
+        cout << "[Recorder] " << formatRecorderStats(recorder.stats()) << "\n";
+    }
+    cap.reset();
+    display.closeAll();
+    cout << "[Display] " << formatDisplayStats(display.stats()) << "\n";
 
     return 0;
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 //Redeveloping motion sensor to use 2 webcams and accordingly adjusting output
 #include <opencv2/core.hpp>
 #include <opencv2/videoio.hpp>
-#include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
 #include <iostream>
@@ -10,6 +9,18 @@
 #include <chrono>
 #include <filesystem>
 #include <regex>
+#include <memory>
+#include <vector>
+
+#include "frame_ring.hpp"
+#include "control.hpp"
+#include "display.hpp"
+#include "event_recorder.hpp"
+#include "frame_source.hpp"
+#include "motion_detector.hpp"
+#include "motion_events.hpp"
+#include "recorder.hpp"
+#include "run_options.hpp"
 
 using namespace cv;
 using namespace std;
@@ -63,8 +74,35 @@ static int getNextIndex(const fs::path& dir, const string& baseName, const strin
     return maxIdx + 1;
 }
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    // Command-line switches (all default to the original behavior)
+    RunOptions opts = parseRunOptions(argc, argv);
+    if (opts.showHelp)
+    {
+        printRunOptionsHelp(argv[0]);
+        return 0;
+    }
+    if (opts.sources.mjpegPassthrough)
+    {
+        // JPEG packets need the engine's packet path (Program 3)
+        cout << "--mjpeg-passthrough is only supported by the threaded program; decoding frames as usual.\n";
+        opts.sources.mjpegPassthrough = false;
+        opts.writer.passthrough = false;
+    }
+    if (opts.sources.captureFormat != PixelFormat::BGR)
+    {
+        // Raw YUV frames need the engine's Y-plane path (Program 3)
+        cout << "--capture-format is only supported by the threaded program; capturing BGR.\n";
+        opts.sources.captureFormat = PixelFormat::BGR;
+    }
+
+    // Live windows (none with --headless) and remote control (signals, FIFO, socket)
+    Display display(opts.display);
+    ControlChannel control(opts.control);
+    if (!control.ok())
+        return -1;
+
     // ---------------------------------------------------------------------
     // Output folders (Program 2 keeps your current behavior: relative to CWD)
     // Program 4+ can anchor these to the exe path like we discussed later.
@@ -77,11 +115,14 @@ int main(int, char**)
     // ---------------------------------------------------------------------
     // Camera setup
     // ---------------------------------------------------------------------
-    VideoCapture cap1(0);             // REQUIRED
-    VideoCapture cap2(1);             // OPTIONAL
-    bool cam2Available = cap2.isOpened();
-
-    if (!cap1.isOpened())
+    // Cameras 0 and 1 unless --cameras names other sources (see frame_source.hpp)
+    const vector<string>& specs = opts.sources.specs;
+    unique_ptr<FrameSource> cap1 = openFrameSource(specs[0], opts.sources);                  // REQUIRED
+    unique_ptr<FrameSource> cap2 = specs.size() > 1 ? openFrameSource(specs[1], opts.sources) // OPTIONAL
+                                                    : nullptr;
+    bool cam2Available = cap2 && cap2->isOpened();
+
+    if (!cap1->isOpened())
     {
         cerr << "ERROR! Unable to open camera 0 (required)\n";
         return -1;
@@ -95,7 +136,7 @@ int main(int, char**)
     Mat src1, src2;
 
     // Grab one frame from Cam1 to establish size/type
-    cap1 >> src1;
+    cap1->read(src1);
     if (src1.empty())
     {
         cerr << "ERROR! blank frame grabbed from camera 0\n";
@@ -105,7 +146,7 @@ int main(int, char**)
     // If Cam2 exists, grab one frame to confirm it's actually producing frames
     if (cam2Available)
     {
-        cap2 >> src2;
+        cap2->read(src2);
         if (src2.empty())
         {
             cout << "Camera 1 opened but returned an empty frame. Disabling Cam2.\n";
@@ -121,10 +162,24 @@ int main(int, char**)
     // ---------------------------------------------------------------------
     bool recordingOn = false;
     bool motionOn = false;
-
-    VideoWriter writer1;
-    VideoWriter writer2; // only used if cam2Available at recording start
+    bool logCam2 = false; // the motion log has Cam2 columns (Cam2 was up when 'm' was pressed)
+
+    // Each camera gets its own recorder: own measured frame rate, own encoder thread
+    Recorder recorder1(opts.recorder, opts.writer);
+    Recorder recorder2(opts.recorder, opts.writer); // only used if cam2Available at recording start
+
+    // Motion-triggered clips per camera, starting with the pre-roll (only with --preroll)
+    const int eventCodec = VideoWriter::fourcc('m', 'p', '4', 'v');
+    EventRecorder events1(opts.events, opts.recorder, opts.writer, eventCodec,
+                          [&]() { return (videoDir / ("Cam1_Event" + to_string(getNextIndex(videoDir, "Cam1_Event", ".mp4")) + ".mp4")).string(); });
+    EventRecorder events2(opts.events, opts.recorder, opts.writer, eventCodec,
+                          [&]() { return (videoDir / ("Cam2_Event" + to_string(getNextIndex(videoDir, "Cam2_Event", ".mp4")) + ".mp4")).string(); });
     ofstream csv;
+    ofstream heatCsv; // <log>_heatmap.csv, with --heatmap
+    ofstream blobCsv; // <log>_blobs.csv, with --blobs
+    ofstream eventCsv; // <log>_events.csv, with --motion-events
+    ofstream statsCsv; // <log>_stats.csv, with --ratio-stats
+    ofstream flowCsv;  // <log>_flow.csv, with --motion-vectors
 
     // ---------------------------------------------------------------------
     // Timing (single authoritative clock for per-second logging)
@@ -136,23 +191,121 @@ int main(int, char**)
     int secondsLogged = 0;                 // 1..120
     bool motionDetectedCam1ThisSecond = false;
     bool motionDetectedCam2ThisSecond = false;
+    bool lightingCam1ThisSecond = false; // --lighting: a frame was only a brightness change
+    bool lightingCam2ThisSecond = false;
 
     // ---------------------------------------------------------------------
     // Motion detection baseline (per camera)
     // ---------------------------------------------------------------------
-    Mat prevGray1, prevGray2;
-    Mat gray1, gray2, diff1, diff2, thresh1, thresh2;
-
     // --- Tunables for "SIGNIFICANT movement"
     // These are intentionally explicit and easy to tweak.
     const int    DIFF_THRESH  = 25;    // pixel intensity change threshold (0..255)
     const double MOTION_RATIO = 0.02;  // fraction of pixels changed (2%) counts as motion
     // ---
 
+    // Row-band threads for detection (--detect-threads); the cameras are
+    // detected one after the other, so they share the pool
+    unique_ptr<WorkerPool> bandPool;
+    if (opts.detector.threads != 1) bandPool = make_unique<WorkerPool>(opts.detector.threads);
+
+    // Each detector keeps its own previous-frame luma (swapped, never cloned)
+    MotionDetector detector1(DIFF_THRESH, MOTION_RATIO, opts.detector);
+    MotionDetector detector2(DIFF_THRESH, MOTION_RATIO, opts.detector);
+    detector1.setPool(bandPool.get());
+    detector2.setPool(bandPool.get());
+
+    // Detection regions (--roi): excluded pixels are never looked at
+    RoiConfig roi;
+    string roiError;
+    if (!opts.detector.roiFile.empty() && !loadRoiConfig(opts.detector.roiFile, roi, roiError))
+    {
+        cerr << "ERROR! --roi: " << roiError << "\n";
+        return -1;
+    }
+    detector1.setRegions(regionsFor(roi, "Cam1"));
+    detector2.setRegions(regionsFor(roi, "Cam2"));
+
+    // Motion start / end events per camera (--motion-events): published the
+    // frame they are decided on, drained right away into <log>_events.csv,
+    // the console and control socket clients that asked for "events"
+    MotionHysteresis hysteresis1(0, MOTION_RATIO, opts.motionEvents);
+    MotionHysteresis hysteresis2(1, MOTION_RATIO, opts.motionEvents);
+    MotionEventBus motionEvents;
+    MotionEventQueue& eventLog = motionEvents.subscribe();
+    MotionEventStats eventStats;
+    auto drainMotionEvents = [&]()
+    {
+        MotionEvent e;
+        while (eventLog.pop(e))
+        {
+            const clock_t::time_point now = clock_t::now();
+            eventStats.add(e, now);
+            const string row = formatMotionEventRow(e, e.camera == 0 ? "Cam1" : "Cam2", motionStartTime, now);
+            eventCsv << row << "\n" << flush;
+            control.broadcast(row);
+            cout << "[Motion] " << row << "\n";
+        }
+    };
+    auto feedMotionEvents = [&](MotionHysteresis& hysteresis, const MotionResult& res, clock_t::time_point captureTime)
+    {
+        MotionEvent e;
+        if (opts.motionEvents.enabled && hysteresis.update(res, captureTime, e))
+            motionEvents.publish(e);
+    };
+
+    // Background models saved by the last run (--background --background-state)
+    const bool checkpoints = opts.detector.background && !opts.detector.backgroundStateDir.empty();
+    const string statePath1 = backgroundStatePath(opts.detector.backgroundStateDir, "Cam1");
+    const string statePath2 = backgroundStatePath(opts.detector.backgroundStateDir, "Cam2");
+    if (checkpoints)
+    {
+        if (detector1.loadBackground(statePath1)) cout << "[Background] Cam1 model restored from " << statePath1 << "\n";
+        if (detector2.loadBackground(statePath2)) cout << "[Background] Cam2 model restored from " << statePath2 << "\n";
+    }
+
+    // Segment columns of a motion-log row: clips opened / closed since the last row
+    auto segmentColumns = [&](bool withCam2) {
+        if (!events1.enabled()) return string();
+        EventRecorder::SegmentMarks m1 = events1.takeSegmentMarks(motionStartTime);
+        string cols = "," + m1.starts + "," + m1.ends;
+        if (withCam2)
+        {
+            EventRecorder::SegmentMarks m2 = events2.takeSegmentMarks(motionStartTime);
+            cols += "," + m2.starts + "," + m2.ends;
+        }
+        return cols;
+    };
+
+    // Lighting columns of a motion-log row (--lighting); empty for a Cam2 that went offline
+    auto lightingColumns = [&](bool withCam2) {
+        if (!opts.detector.lighting) return string();
+        string cols = lightingCam1ThisSecond ? ",Lighting change" : ",Steady";
+        if (withCam2) cols += !cam2Available ? "," : (lightingCam2ThisSecond ? ",Lighting change" : ",Steady");
+        return cols;
+    };
+
+    // Motion columns of a motion-log row; Cam2 stays in the row as "Offline" once it stopped
+    auto statusColumns = [&](bool cam1Motion, bool cam2Motion) {
+        string cols = cam1Motion ? "Motion" : "No motion";
+        if (logCam2) cols += !cam2Available ? ",Offline" : (cam2Motion ? ",Motion" : ",No motion");
+        return cols;
+    };
+
+    // Blob-log rows of the frame a detector just processed (--blobs)
+    auto logBlobs = [&](const char* camera, const MotionDetector& detector, clock_t::time_point captureTime) {
+        if (!blobCsv.is_open()) return;
+        const double t = std::chrono::duration<double>(captureTime - motionStartTime).count();
+        for (const MotionBlob& b : detector.blobs())
+            blobCsv << secondsLogged + 1 << "," << camera << "," << formatBlobRow(b, t) << "\n";
+    };
+
     cout << "Controls:\n"
          << "  r = start recording (records Cam0 always, Cam1 if present)\n"
          << "  m = start motion sensor (only while recording; runs up to 120s then exits)\n"
          << "  ESC = exit early\n";
+    cout << describeControls(opts.control);
+    if (display.headless())
+        cout << "Headless: no windows, keys above come from the controls listed.\n";
 
     // ---------------------------------------------------------------------
     // Main loop (NON-threaded): we read frames directly in this loop
@@ -160,45 +313,60 @@ int main(int, char**)
     for (;;)
     {
         // ---- Read camera 0 (required)
-        if (!cap1.read(src1) || src1.empty())
+        // Frames still queued for the encoder keep their buffer; decode into a new one.
+        detachIfShared(src1);
+        if (!cap1->read(src1) || src1.empty())
         {
             cerr << "ERROR! blank frame grabbed from camera 0\n";
             break;
         }
+        clock_t::time_point captureTime1 = clock_t::now(), captureTime2{};
 
         // ---- Read camera 1 (optional)
         if (cam2Available)
         {
-            if (!cap2.read(src2) || src2.empty())
+            detachIfShared(src2);
+            if (cap2->read(src2) && !src2.empty())
+            {
+                captureTime2 = clock_t::now();
+            }
+            else
             {
                 // If Cam2 stops producing frames, we gracefully disable it
                 cout << "Camera 1 stopped producing frames. Disabling Cam2.\n";
                 cam2Available = false;
 
-                // If we were recording Cam2, we release its writer cleanly
-                if (writer2.isOpened())
-                    writer2.release();
+                // If we were recording Cam2, we close its clip cleanly
+                if (recorder2.isRecording())
+                    recorder2.stop();
             }
         }
 
-        // ---- Always show live feed(s)
-        imshow("Cam1 Live (Camera 0)", src1);
+        // ---- Live feed(s), at the preview rate (skipped with --headless)
+        display.show("Cam1 Live (Camera 0)", src1);
         if (cam2Available)
-            imshow("Cam2 Live (Camera 1)", src2);
+            display.show("Cam2 Live (Camera 1)", src2);
 
-        // ---- Key input
-        int key = waitKey(1);
+        // ---- Key input (window keys, or the same commands from signal / FIFO / socket)
+        int key = display.pollKey();
+        if (key < 0) key = control.pollKey();
 
         if (key == 27) // ESC
         {
-            cout << "ESC pressed. Exiting early.\n";
+            cout << "Stop requested. Exiting early.\n";
             break;
         }
 
         // -----------------------------------------------------------------
         // Start recording ('r')
-        // We open writer(s) here, and then write every frame while recordingOn.
+        // We start the recorder(s) here; they get every frame while recordingOn.
         // -----------------------------------------------------------------
+        if (!recordingOn && (key == 'r' || key == 'R') && opts.events.segments)
+        {
+            // Segment mode: clips open on motion (see event_recorder.hpp)
+            recordingOn = true;
+            cout << "Segment recording armed: one Cam#_Event#.mp4 per motion event in " << videoDir.string() << "\n";
+        }
         if (!recordingOn && (key == 'r' || key == 'R'))
         {
             // Independent sequential indexes for each camera’s video
@@ -215,13 +383,9 @@ int main(int, char**)
 
             int codec = VideoWriter::fourcc('m', 'p', '4', 'v');
 
-            // In Program 2, we keep fps fixed like your baseline.
-            // In Program 3 (threaded), we can measure/derive fps more accurately.
-            double fps = 60.0;
-
+            // Each video is written at its camera's measured rate (see recorder.hpp).
             // Open writer for Cam1
-            writer1.open(videoPath1.string(), codec, fps, src1.size(), isColor1);
-            if (!writer1.isOpened())
+            if (!recorder1.start(videoPath1.string(), codec, src1.size(), isColor1))
             {
                 cerr << "Could not open Cam1 output video for write\n";
                 return -1;
@@ -230,8 +394,7 @@ int main(int, char**)
             // Open writer for Cam2 if available
             if (cam2Available)
             {
-                writer2.open(videoPath2.string(), codec, fps, src2.size(), isColor2);
-                if (!writer2.isOpened())
+                if (!recorder2.start(videoPath2.string(), codec, src2.size(), isColor2))
                 {
                     cout << "Warning: Could not open Cam2 output video. Continuing with Cam1 only.\n";
                     cam2Available = false; // treat as disabled for recording/sensing
@@ -261,11 +424,59 @@ int main(int, char**)
                 return -1;
             }
 
-            // Header adapts to camera availability
-            if (cam2Available)
-                csv << "Second,Cam1,Cam2\n";
+            // Header adapts to camera availability; Cam2's columns then stay for the whole log
+            logCam2 = cam2Available;
+            if (logCam2)
+                csv << "Second,Cam1,Cam2";
             else
-                csv << "Second,Cam1\n";
+                csv << "Second,Cam1";
+            if (opts.detector.lighting)
+                csv << (logCam2 ? ",Cam1Lighting,Cam2Lighting" : ",Cam1Lighting");
+            if (events1.enabled())
+            {
+                // Event clips opened / closed during each second
+                csv << ",Cam1SegmentStart,Cam1SegmentEnd";
+                if (logCam2)
+                    csv << ",Cam2SegmentStart,Cam2SegmentEnd";
+            }
+            csv << "\n";
+
+            // Per-tile motion, one row per camera per second next to the log
+            if (opts.detector.heatmapCols > 0)
+            {
+                heatCsv = openSideCsv(dataPath, "_heatmap", string("Second,Camera,Frames,") +
+                                      heatmapColumns(opts.detector.heatmapCols, opts.detector.heatmapRows));
+                if (!heatCsv.is_open()) return -1;
+            }
+
+            // Motion regions of every detected frame
+            if (opts.detector.blobs)
+            {
+                blobCsv = openSideCsv(dataPath, "_blobs",
+                                      "Second,Camera,Time,X,Y,Width,Height,Area,CentroidX,CentroidY");
+                if (!blobCsv.is_open()) return -1;
+            }
+
+            // Ratio statistics, one row per camera per second next to the log
+            if (opts.detector.ratioStats)
+            {
+                statsCsv = openSideCsv(dataPath, "_stats", string("Second,Camera,") + windowStatsColumns());
+                if (!statsCsv.is_open()) return -1;
+            }
+
+            // Dominant direction and speed of motion, one row per camera per second
+            if (opts.detector.vectors)
+            {
+                flowCsv = openSideCsv(dataPath, "_flow", string("Second,Camera,") + flowColumns());
+                if (!flowCsv.is_open()) return -1;
+            }
+
+            // Motion start / end, one row per event as it happens
+            if (opts.motionEvents.enabled)
+            {
+                eventCsv = openSideCsv(dataPath, "_events", motionEventColumns());
+                if (!eventCsv.is_open()) return -1;
+            }
 
             motionOn = true;
             motionStartTime = clock_t::now();
@@ -274,24 +485,44 @@ int main(int, char**)
             secondsLogged = 0;
             motionDetectedCam1ThisSecond = false;
             motionDetectedCam2ThisSecond = false;
+            lightingCam1ThisSecond = false;
+            lightingCam2ThisSecond = false;
 
             // Initialize baselines from the current frames
-            cvtColor(src1, prevGray1, COLOR_BGR2GRAY);
+            detector1.reset(src1);
             if (cam2Available)
-                cvtColor(src2, prevGray2, COLOR_BGR2GRAY);
+                detector2.reset(src2);
+            hysteresis1.reset();
+            hysteresis2.reset();
 
             cout << "Motion sensor started. Logging to: " << dataPath.string() << "\n";
             cout << "Will auto-terminate after 2 minutes (120 seconds).\n";
         }
 
         // -----------------------------------------------------------------
-        // If recording, write every frame for any available writers
+        // If recording, queue every frame for the encoder threads (no copy)
         // -----------------------------------------------------------------
-        if (recordingOn)
+        // Every frame feeds its recorder so the camera rate keeps being
+        // measured; while recording, frames are tagged with the CSV second
+        // they're counted in.
+        const int logSecond = motionOn ? secondsLogged + 1 : 0;
+        recorder1.addFrame(src1, captureTime1, logSecond);
+        events1.addFrame(src1, captureTime1, logSecond); // pre-roll (no-op without --preroll)
+        if (cam2Available)
         {
-            writer1.write(src1);
-            if (cam2Available && writer2.isOpened())
-                writer2.write(src2);
+            recorder2.addFrame(src2, captureTime2, logSecond);
+            events2.addFrame(src2, captureTime2, logSecond);
+        }
+
+        if (recordingOn && !recorder1.ok())
+        {
+            cerr << "Could not open Cam1 output video for write\n";
+            return -1;
+        }
+        if (recordingOn && cam2Available && !recorder2.ok())
+        {
+            cout << "Warning: Could not open Cam2 output video. Continuing with Cam1 only.\n";
+            cam2Available = false;
         }
 
         // -----------------------------------------------------------------
@@ -300,35 +531,33 @@ int main(int, char**)
         if (motionOn)
         {
             // ---- Cam1 motion detection
-            cvtColor(src1, gray1, COLOR_BGR2GRAY);
-            absdiff(gray1, prevGray1, diff1);
-            threshold(diff1, thresh1, DIFF_THRESH, 255, THRESH_BINARY);
-
-            int changed1 = countNonZero(thresh1);
-            int total1 = thresh1.rows * thresh1.cols;
-            double ratio1 = (total1 > 0) ? (double)changed1 / (double)total1 : 0.0;
-
-            if (ratio1 >= MOTION_RATIO)
+            // (fused luma + diff + threshold + count, one pass)
+            const MotionResult res1 = detector1.process(src1);
+            if (res1.motion)
+            {
                 motionDetectedCam1ThisSecond = true;
-
-            prevGray1 = gray1.clone();
+                events1.trigger(captureTime1);
+            }
+            if (res1.lighting)
+                lightingCam1ThisSecond = true;
+            logBlobs("Cam1", detector1, captureTime1);
+            feedMotionEvents(hysteresis1, res1, captureTime1);
 
             // ---- Cam2 motion detection (only if available)
             if (cam2Available)
             {
-                cvtColor(src2, gray2, COLOR_BGR2GRAY);
-                absdiff(gray2, prevGray2, diff2);
-                threshold(diff2, thresh2, DIFF_THRESH, 255, THRESH_BINARY);
-
-                int changed2 = countNonZero(thresh2);
-                int total2 = thresh2.rows * thresh2.cols;
-                double ratio2 = (total2 > 0) ? (double)changed2 / (double)total2 : 0.0;
-
-                if (ratio2 >= MOTION_RATIO)
+                const MotionResult res2 = detector2.process(src2);
+                if (res2.motion)
+                {
                     motionDetectedCam2ThisSecond = true;
-
-                prevGray2 = gray2.clone();
+                    events2.trigger(captureTime2);
+                }
+                if (res2.lighting)
+                    lightingCam2ThisSecond = true;
+                logBlobs("Cam2", detector2, captureTime2);
+                feedMotionEvents(hysteresis2, res2, captureTime2);
             }
+            drainMotionEvents();
 
             // ---- Every ~1 second, write one CSV row
             auto now = clock_t::now();
@@ -339,26 +568,46 @@ int main(int, char**)
             {
                 secondsLogged += 1;
 
-                const string cam1Status = (motionDetectedCam1ThisSecond ? "Motion" : "No motion");
-                if (cam2Available)
+                // CSV row matches what we'd like to see in terminal output
+                const string status = statusColumns(motionDetectedCam1ThisSecond, motionDetectedCam2ThisSecond);
+                csv << secondsLogged << "," << status << lightingColumns(logCam2) << segmentColumns(logCam2) << "\n";
+                cout << secondsLogged << "," << status << "\n";
+
+                if (heatCsv.is_open())
                 {
-                    const string cam2Status = (motionDetectedCam2ThisSecond ? "Motion" : "No motion");
+                    const MotionHeatmap heat1 = detector1.takeHeatmap();
+                    heatCsv << secondsLogged << ",Cam1," << heat1.frames << "," << formatHeatmapCells(heat1) << "\n";
+                    if (cam2Available)
+                    {
+                        const MotionHeatmap heat2 = detector2.takeHeatmap();
+                        heatCsv << secondsLogged << ",Cam2," << heat2.frames << "," << formatHeatmapCells(heat2) << "\n";
+                    }
+                }
 
-                    // CSV row matches what we'd like to see in terminal output
-                    csv << secondsLogged << "," << cam1Status << "," << cam2Status << "\n";
-                    cout << secondsLogged << "," << cam1Status << "," << cam2Status << "\n";
+                if (statsCsv.is_open())
+                {
+                    statsCsv << secondsLogged << ",Cam1," << formatWindowStats(detector1.takeWindowStats()) << "\n";
+                    if (cam2Available)
+                        statsCsv << secondsLogged << ",Cam2," << formatWindowStats(detector2.takeWindowStats()) << "\n";
                 }
-                else
+
+                if (flowCsv.is_open())
                 {
-                    csv << secondsLogged << "," << cam1Status << "\n";
-                    cout << secondsLogged << "," << cam1Status << "\n";
+                    flowCsv << secondsLogged << ",Cam1," << formatFlowStats(detector1.takeFlow()) << "\n";
+                    if (cam2Available)
+                        flowCsv << secondsLogged << ",Cam2," << formatFlowStats(detector2.takeFlow()) << "\n";
                 }
 
                 // Reset 1-second window accumulation flags
                 motionDetectedCam1ThisSecond = false;
                 motionDetectedCam2ThisSecond = false;
+                lightingCam1ThisSecond = false;
+                lightingCam2ThisSecond = false;
 
                 lastSecondTick = now;
+                detector1.rollWindow(src1);
+                if (cam2Available)
+                    detector2.rollWindow(src2);
             }
 
             // Auto-terminate after 120 seconds (based on seconds logged)
@@ -373,12 +622,60 @@ int main(int, char**)
     // ---------------------------------------------------------------------
     // Cleanup (explicit, consistent with your current style)
     // ---------------------------------------------------------------------
+    // Events still running at exit end at their last moving frame
+    MotionEvent lastEvent;
+    if (hysteresis1.finish(clock_t::now(), lastEvent)) motionEvents.publish(lastEvent);
+    if (hysteresis2.finish(clock_t::now(), lastEvent)) motionEvents.publish(lastEvent);
+    drainMotionEvents();
+    if (opts.motionEvents.enabled && motionOn)
+    {
+        eventStats.dropped = eventLog.dropped();
+        cout << "[Motion] " << formatMotionEventStats(eventStats) << "\n";
+    }
+
+    if (events1.enabled())
+    {
+        // Closes any open event clip
+        events1.stop();
+        events2.stop();
+        cout << "[Events] Cam1: " << formatEventStats(events1.stats()) << "\n";
+        if (events2.stats().frames > 0)
+            cout << "[Events] Cam2: " << formatEventStats(events2.stats()) << "\n";
+
+        // A clip still open at exit ends in a final (partial-second) row
+        const string cols = segmentColumns(logCam2);
+        if (csv.is_open() && cols.find_first_not_of(',') != string::npos)
+        {
+            csv << secondsLogged + 1 << "," << statusColumns(motionDetectedCam1ThisSecond, motionDetectedCam2ThisSecond)
+                << lightingColumns(logCam2) << cols << "\n";
+        }
+    }
     if (csv.is_open()) csv.close();
-    if (writer1.isOpened()) writer1.release();
-    if (writer2.isOpened()) writer2.release();
-    cap1.release();
-    if (cam2Available) cap2.release();
-    destroyAllWindows();
+    if (heatCsv.is_open()) heatCsv.close();
+    if (blobCsv.is_open()) blobCsv.close();
+    if (eventCsv.is_open()) eventCsv.close();
+    if (statsCsv.is_open()) statsCsv.close();
+    if (flowCsv.is_open()) flowCsv.close();
+    if (checkpoints)
+    {
+        error_code ec;
+        fs::create_directories(opts.detector.backgroundStateDir, ec);
+        if (detector1.saveBackground(statePath1)) cout << "[Background] Cam1 model saved to " << statePath1 << "\n";
+        if (detector2.saveBackground(statePath2)) cout << "[Background] Cam2 model saved to " << statePath2 << "\n";
+    }
+    // Stopping a recorder finishes encoding whatever is still queued
+    if (recorder1.isRecording() || recorder2.isRecording())
+    {
+        recorder1.stop();
+        recorder2.stop();
+        cout << "[Recorder] Cam1: " << formatRecorderStats(recorder1.stats()) << "\n";
+        if (recorder2.stats().sourceFrames > 0)
+            cout << "[Recorder] Cam2: " << formatRecorderStats(recorder2.stats()) << "\n";
+    }
+    cap1.reset();
+    cap2.reset();
+    display.closeAll();
+    cout << "[Display] " << formatDisplayStats(display.stats()) << "\n";
 
     return 0;
 }
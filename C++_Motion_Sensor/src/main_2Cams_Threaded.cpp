@@ -1,10 +1,18 @@
-// Program 3 (Dual-Camera, THREADED) — C++ Motion Sensor
+// Program 3 (Multi-Camera, THREADED) — C++ Motion Sensor
 // Same behavior as Program 2, but camera I/O is moved into background threads.
 // This removes blocking reads from the main loop and improves timing stability.
+// Frames come back from CameraStream as borrowed ring slots (see frame_ring.hpp),
+// so pulling the latest frame costs no lock and no copy.
+// Cameras come from --cameras (default 0,1; files and synthetic scenes work
+// too, see frame_source.hpp) and run as pipelines of a MotionEngine, so the
+// per-camera work is spread over a worker pool.
+// With --mjpeg-passthrough, camera JPEGs are muxed into .avi files as they
+// arrive and only their luma plane is decoded, for detection. With
+// --capture-format=yuyv|nv12, cameras deliver raw YUV: detection runs on the
+// Y plane and only recording and preview convert to BGR.
 
 #include <opencv2/core.hpp>
 #include <opencv2/videoio.hpp>
-#include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
 #include <iostream>
@@ -14,9 +22,18 @@
 #include <filesystem>
 #include <regex>
 
-#include <thread>
-#include <mutex>
-#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "camera_stream.hpp"
+#include "control.hpp"
+#include "display.hpp"
+#include "event_recorder.hpp"
+#include "frame_source.hpp"
+#include "frame_sync.hpp"
+#include "motion_engine.hpp"
+#include "recorder.hpp"
+#include "run_options.hpp"
 
 using namespace cv;
 using namespace std;
@@ -49,150 +66,25 @@ static int getNextIndex(const fs::path& dir, const string& baseName, const strin
 }
 
 // ============================================================
-// Threaded camera capture class
+// Program 3 main
 // ============================================================
-//
-// Why this exists:
-// - VideoCapture::read() can block unpredictably (USB hiccups, driver latency)
-// - In non-threaded designs, a slow camera can stall the entire loop
-// - Here, each camera captures frames in its own thread
-// - The main loop always reads "the latest frame" without waiting
-//
-class CameraStream
-{
-public:
-    explicit CameraStream(int index)
-        : camIndex(index), running(false), ok(false), newFrame(false)
-    {
-        cap.open(index);
-        if (!cap.isOpened())
-        {
-            ok = false;
-            return;
-        }
-
-        // Warm start: grab one frame so consumers have something immediately.
-        Mat tmp;
-        if (cap.read(tmp) && !tmp.empty())
-        {
-            lock_guard<mutex> lk(mtx);
-            frame = tmp;
-            ok = true;
-            newFrame = true;
-        }
-        else
-        {
-            ok = false;
-            cap.release();
-            return;
-        }
-
-        running = true;
-        th = thread(&CameraStream::loop, this);
-    }
-
-    // Non-copyable (threads + mutex)
-    CameraStream(const CameraStream&) = delete;
-    CameraStream& operator=(const CameraStream&) = delete;
-
-    ~CameraStream()
-    {
-        stop();
-    }
-
-    bool isOk() const { return ok; }
-
-    // Grab a snapshot of the latest frame.
-    // Returns false if stream is not OK.
-    bool read(Mat& out, bool* outIsNew = nullptr)
-    {
-        if (!ok) return false;
-
-        lock_guard<mutex> lk(mtx);
-        if (frame.empty()) return false;
-
-        frame.copyTo(out);
 
-        if (outIsNew)
-        {
-            *outIsNew = newFrame;
-        }
-        newFrame = false;
-
-        return true;
-    }
-
-    void stop()
-    {
-        if (!running) return;
-
-        running = false;
-        if (th.joinable()) th.join();
-
-        if (cap.isOpened()) cap.release();
-    }
-
-    // Optional: access to capture props if needed later
-    double get(int propId) const
+int main(int argc, char** argv)
+{
+    // Command-line switches (all default to the original behavior)
+    RunOptions opts = parseRunOptions(argc, argv);
+    if (opts.showHelp)
     {
-        if (!cap.isOpened()) return 0.0;
-        return cap.get(propId);
+        printRunOptionsHelp(argv[0]);
+        return 0;
     }
 
-private:
-    void loop()
-    {
-        // Capture loop: keep reading frames in background.
-        // If read fails repeatedly, we mark the stream as not OK.
-        int consecutiveFails = 0;
-
-        while (running)
-        {
-            Mat tmp;
-            bool ret = cap.read(tmp);
-
-            if (!ret || tmp.empty())
-            {
-                consecutiveFails++;
-                // If the camera disappears, stop treating it as available.
-                if (consecutiveFails >= 30)
-                {
-                    ok = false;
-                    break;
-                }
-                // Tiny sleep prevents spinning at 100% CPU on failure
-                this_thread::sleep_for(chrono::milliseconds(5));
-                continue;
-            }
-
-            consecutiveFails = 0;
-
-            {
-                lock_guard<mutex> lk(mtx);
-                frame = tmp;      // latest frame wins
-                newFrame = true;  // mark that consumer hasn't seen this one yet
-            }
-        }
-    }
-
-    int camIndex;
-    mutable mutex mtx;
-    VideoCapture cap;
-    Mat frame;
-
-    thread th;
-    atomic<bool> running;
-    atomic<bool> ok;
-
-    bool newFrame; // protected by mtx
-};
-
-// ============================================================
-// Program 3 main
-// ============================================================
+    // Live windows (none with --headless) and remote control (signals, FIFO, socket)
+    Display display(opts.display);
+    ControlChannel control(opts.control);
+    if (!control.ok())
+        return -1;
 
-int main(int argc, char** argv)
-{
     // ---------------------------------------------------------
     // Output folders (still relative to CWD in Program 3)
     // Next upgrade will anchor these relative to the executable.
@@ -202,184 +94,299 @@ int main(int argc, char** argv)
     fs::create_directories(videoDir);
     fs::create_directories(dataDir);
 
+    // Passthrough writes the cameras' own JPEGs, which go in an AVI container
+    const bool passthrough = opts.writer.passthrough;
+    const string videoExt = passthrough ? ".avi" : ".mp4";
+
     // ---------------------------------------------------------
-    // Start threaded camera streams
+    // Start threaded camera streams (the first one is REQUIRED)
     // ---------------------------------------------------------
-    CameraStream cam1(0); // REQUIRED
-    if (!cam1.isOk())
-    {
-        cerr << "ERROR! Unable to open camera 0 (required)\n";
-        return -1;
-    }
-
-    unique_ptr<CameraStream> cam2;
-    bool cam2Available = false;
+    CaptureBarrier barrier; // --sync-capture: grab() all cameras together (outlives the streams)
+    vector<unique_ptr<CameraStream>> streams;
+    vector<string> labelOf; // "Camera 0", or the source spec for files / synthetic scenes
 
+    for (size_t i = 0; i < opts.sources.specs.size(); i++)
     {
-        auto tmp = make_unique<CameraStream>(1);
-        if (tmp->isOk())
+        const string& spec = opts.sources.specs[i];
+        const bool isCamera = spec.find_first_not_of("0123456789") == string::npos;
+        const string label = isCamera ? "Camera " + spec : spec;
+        auto cam = make_unique<CameraStream>(openFrameSource(spec, opts.sources), 3,
+                                             opts.engine.syncCapture ? &barrier : nullptr);
+
+        // Grab an initial frame to make sure the camera really delivers
+        Mat first;
+        const bool ok = cam->isOk() && cam->read(first) && !first.empty();
+        if (!ok && i == 0)
         {
-            cam2 = std::move(tmp);
-            cam2Available = true;
+            cerr << "ERROR! Unable to open " << label << " (required)\n";
+            return -1;
         }
-        else
+        if (!ok)
         {
-            cout << "Camera 1 not detected. Running in single-camera mode.\n";
+            cout << label << " not detected. Skipping it.\n";
+            continue;
         }
+
+        if (cam->pixelFormat() != opts.sources.captureFormat && !opts.sources.mjpegPassthrough)
+            cout << label << " can't deliver " << pixelFormatName(opts.sources.captureFormat)
+                 << "; using BGR.\n";
+
+        streams.push_back(std::move(cam));
+        labelOf.push_back(label);
     }
 
     // ---------------------------------------------------------
-    // Grab an initial frame from Cam1 to establish size/type
+    // Motion detection settings (same for every camera)
     // ---------------------------------------------------------
-    Mat src1, src2;
-    if (!cam1.read(src1) || src1.empty())
+    const int    DIFF_THRESH  = 25;
+    const double MOTION_RATIO = 0.02;
+
+    // One pipeline per camera: own detector, own recorder (measured frame rate,
+    // encoder thread) and own motion-triggered clips (only with --preroll / --segments)
+    MotionEngine engine(DIFF_THRESH, MOTION_RATIO, opts.engine, opts.detector, opts.recorder, opts.writer, opts.events);
+
+    // Detection regions (--roi): excluded pixels are never looked at
+    RoiConfig roi;
+    string roiError;
+    if (!opts.detector.roiFile.empty() && !loadRoiConfig(opts.detector.roiFile, roi, roiError))
     {
-        cerr << "ERROR! Could not read initial frame from Cam1\n";
+        cerr << "ERROR! --roi: " << roiError << "\n";
         return -1;
     }
 
-    bool isColor1 = (src1.type() == CV_8UC3);
-
-    bool isColor2 = false;
-    if (cam2Available)
+    vector<string> windowOf;
+    for (size_t k = 0; k < streams.size(); k++)
     {
-        if (!cam2->read(src2) || src2.empty())
-        {
-            cout << "Cam2 opened but no initial frame. Disabling Cam2.\n";
-            cam2Available = false;
-            cam2.reset();
-        }
-        else
-        {
-            isColor2 = (src2.type() == CV_8UC3);
-        }
+        CameraStream* cam = streams[k].get();
+        const string name = "Cam" + to_string(k + 1);
+
+        CameraPipeline& pipeline = engine.addCamera(
+            name,
+            [cam](Mat& frame, chrono::steady_clock::time_point& captureTime, bool& isNew) {
+                return cam->read(frame, &isNew, &captureTime);
+            },
+            [videoDir, name, videoExt]() {
+                const string base = name + "_Event";
+                return (videoDir / (base + to_string(getNextIndex(videoDir, base, videoExt)) + videoExt)).string();
+            },
+            cam->pixelFormat());
+        pipeline.setRegions(regionsFor(roi, name));
+        windowOf.push_back(name + " Live (" + labelOf[k] + ")");
+
+        // Wake the loop when this camera has a new frame
+        cam->setSignal(&engine.newFrameSignal());
     }
 
+    // Background models saved by the last run (--background --background-state)
+    const string& stateDir = opts.detector.backgroundStateDir;
+    const bool checkpoints = opts.detector.background && !stateDir.empty();
+    if (checkpoints)
+        cout << "[Background] " << engine.loadBackgrounds(stateDir) << " of " << engine.size()
+             << " camera models restored from " << stateDir << "\n";
+
+    // A camera that stops (or can't record) is closed and logged as "Offline"
+    vector<bool> announcedOffline(engine.size(), false);
+    auto disableCamera = [&](size_t k, const string& why) {
+        cout << why << "\n";
+        engine.camera(k).shutDown();
+        streams[k]->stop();
+        display.close(windowOf[k]);
+        announcedOffline[k] = true;
+    };
+
+    cout << "Engine: " << engine.size() << " camera(s) on " << engine.threads() << " thread(s)"
+         << (engine.bandThreads() > 1 ? ", " + to_string(engine.bandThreads()) + " band threads per camera" : "")
+         << (opts.engine.syncCapture && engine.size() > 1 ? ", synchronized capture" : "")
+         << (passthrough ? ", MJPEG passthrough" : "") << "\n";
+
     // ---------------------------------------------------------
     // Recording / motion sensor state
     // ---------------------------------------------------------
     bool recordingOn = false;
     bool motionOn = false;
 
-    VideoWriter writer1;
-    VideoWriter writer2; // only if Cam2 remains available
     ofstream csv;
+    ofstream heatCsv; // <log>_heatmap.csv, with --heatmap
+    ofstream blobCsv; // <log>_blobs.csv, with --blobs
+    ofstream eventCsv; // <log>_events.csv, with --motion-events
+    ofstream statsCsv; // <log>_stats.csv, with --ratio-stats
+    ofstream flowCsv;  // <log>_flow.csv, with --motion-vectors
+    vector<TimedBlob> blobs;
+    fs::path dataPath;
 
     // ---------------------------------------------------------
     // Timing (single authoritative clock)
     // ---------------------------------------------------------
     using clock_t = std::chrono::steady_clock;
+    clock_t::time_point motionStartTime{}; // origin of the segment times in the CSV
     clock_t::time_point lastSecondTick{};
 
     int secondsLogged = 0; // 1..120
-    bool motionDetectedCam1ThisSecond = false;
-    bool motionDetectedCam2ThisSecond = false;
 
-    // ---------------------------------------------------------
-    // Motion detection baseline (per camera)
-    // ---------------------------------------------------------
-    Mat prevGray1, prevGray2;
-    Mat gray1, gray2, diff1, diff2, thresh1, thresh2;
+    const bool eventsOn = engine.camera(0).events().enabled();
+
+    // Motion start / end events (--motion-events): published by the engine
+    // worker that decided them, drained here after every step into
+    // <log>_events.csv, the console and control socket clients that asked for
+    // "events"
+    MotionEventBus motionEvents;
+    MotionEventQueue& eventLog = motionEvents.subscribe();
+    MotionEventStats eventStats;
+    if (opts.motionEvents.enabled) engine.publishMotionEvents(&motionEvents, opts.motionEvents);
+    auto drainMotionEvents = [&]()
+    {
+        MotionEvent e;
+        while (eventLog.pop(e))
+        {
+            const clock_t::time_point now = clock_t::now();
+            eventStats.add(e, now);
+            const string row = formatMotionEventRow(e, engine.camera((size_t)e.camera).name(), motionStartTime, now);
+            eventCsv << row << "\n" << flush;
+            control.broadcast(row);
+            cout << "[Motion] " << row << "\n";
+        }
+    };
 
-    const int    DIFF_THRESH  = 25;
-    const double MOTION_RATIO = 0.02;
+    // Motion columns of a log row; "Offline" once a camera has stopped
+    auto statusColumns = [&]() {
+        string cols;
+        for (size_t k = 0; k < engine.size(); k++)
+        {
+            CameraPipeline& p = engine.camera(k);
+            const bool motion = p.takeMotion();
+            cols += ",";
+            cols += !p.alive() ? "Offline" : (motion ? "Motion Detected" : "No motion");
+        }
+        return cols;
+    };
+
+    // Lighting columns of a motion-log row (--lighting): a frame that was only a brightness change
+    auto lightingColumns = [&]() {
+        if (!opts.detector.lighting) return string();
+        string cols;
+        for (size_t k = 0; k < engine.size(); k++)
+            cols += engine.camera(k).takeLighting() ? ",Lighting change" : ",Steady";
+        return cols;
+    };
+
+    // Segment columns of a motion-log row: clips opened / closed since the last row
+    auto segmentColumns = [&]() {
+        if (!eventsOn) return string();
+        string cols;
+        for (size_t k = 0; k < engine.size(); k++)
+        {
+            EventRecorder::SegmentMarks m = engine.camera(k).events().takeSegmentMarks(motionStartTime);
+            cols += "," + m.starts + "," + m.ends;
+        }
+        return cols;
+    };
 
     cout << "Controls:\n"
-         << "  r = start recording (records Cam0 always, Cam1 if present)\n"
+         << "  r = start recording (records every camera that opened)\n"
          << "  m = start motion sensor (only while recording; runs up to 120s then exits)\n"
          << "  ESC = exit early\n";
+    cout << describeControls(opts.control);
+    if (display.headless())
+        cout << "Headless: no windows, keys above come from the controls listed.\n";
 
     // ---------------------------------------------------------
     // Main loop
     // ---------------------------------------------------------
     for (;;)
     {
-        // ---- Pull latest Cam1 frame (non-blocking snapshot)
-        if (!cam1.read(src1) || src1.empty())
+        // Sleep until a camera publishes a new frame. The timeout keeps keys,
+        // control commands and the per-second CSV row going if all stall.
+        engine.waitForFrames(chrono::milliseconds(50));
+
+        // -----------------------------------------------------
+        // One engine step: every live camera pulls its latest frame
+        // (non-blocking snapshot) and, if it is new, queues it for its
+        // encoder thread and, with the sensor on, runs motion detection -
+        // in parallel. Frames already processed are skipped.
+        // -----------------------------------------------------
+        // Frames are tagged with the CSV second they're counted in.
+        const int logSecond = motionOn ? secondsLogged + 1 : 0;
+        engine.step(motionOn, logSecond);
+        drainMotionEvents();
+
+        if (!engine.camera(0).alive())
         {
             cerr << "ERROR! Cam1 stream stopped.\n";
             break;
         }
-
-        // ---- Pull latest Cam2 frame if available
-        if (cam2Available)
+        for (size_t k = 1; k < engine.size(); k++)
         {
-            Mat tmp2;
-            if (!cam2->read(tmp2) || tmp2.empty())
-            {
-                // Cam2 died mid-run: disable it gracefully (and keep going with Cam1)
-                cout << "Camera 1 stopped producing frames. Disabling Cam2.\n";
-                cam2Available = false;
-                cam2.reset();
-
-                if (writer2.isOpened())
-                    writer2.release();
+            // Died mid-run: disable it gracefully (and keep going with the rest)
+            if (!engine.camera(k).alive() && !announcedOffline[k])
+                disableCamera(k, labelOf[k] + " stopped producing frames. Disabling "
+                                     + engine.camera(k).name() + ".");
+        }
 
-                // Also close Cam2 window if it exists
-                try { destroyWindow("Cam2 Live (Camera 1)"); } catch (...) {}
-            }
-            else
-            {
-                src2 = tmp2;
-            }
+        if (recordingOn && !engine.camera(0).recorder().ok())
+        {
+            cerr << "Could not open Cam1 output video for write\n";
+            return -1;
+        }
+        for (size_t k = 1; k < engine.size(); k++)
+        {
+            if (recordingOn && engine.camera(k).alive() && !engine.camera(k).recorder().ok())
+                disableCamera(k, "Warning: Could not open " + engine.camera(k).name()
+                                     + " output video. Continuing without it.");
         }
 
-        // ---- Show live feed(s)
-        imshow("Cam1 Live (Camera 0)", src1);
-        if (cam2Available)
-            imshow("Cam2 Live (Camera 1)", src2);
+        // ---- Show live feed(s), at the preview rate (skipped with --headless)
+        for (size_t k = 0; k < engine.size(); k++)
+        {
+            if (engine.camera(k).alive() && display.drawing())
+                display.show(windowOf[k], engine.camera(k).preview());
+        }
 
-        int key = waitKey(1);
+        // Window keys, or the same commands from signal / FIFO / socket
+        int key = display.pollKey();
+        if (key < 0) key = control.pollKey();
         if (key == 27)
         {
-            cout << "ESC pressed. Exiting early.\n";
+            cout << "Stop requested. Exiting early.\n";
             break;
         }
 
         // -----------------------------------------------------
         // Start recording
         // -----------------------------------------------------
+        if (!recordingOn && (key == 'r' || key == 'R') && opts.events.segments)
+        {
+            // Segment mode: clips open on motion (see event_recorder.hpp)
+            recordingOn = true;
+            cout << "Segment recording armed: one Cam#_Event#" << videoExt << " per motion event in " << videoDir.string() << "\n";
+        }
         if (!recordingOn && (key == 'r' || key == 'R'))
         {
-            int nextVid1 = getNextIndex(videoDir, "Cam1_OutputVideo", ".mp4");
-            fs::path videoPath1 = videoDir / ("Cam1_OutputVideo" + to_string(nextVid1) + ".mp4");
+            int codec = passthrough ? VideoWriter::fourcc('M', 'J', 'P', 'G') : VideoWriter::fourcc('m', 'p', '4', 'v');
 
-            fs::path videoPath2;
-            if (cam2Available)
+            cout << "Recording started:\n";
+            for (size_t k = 0; k < engine.size(); k++)
             {
-                int nextVid2 = getNextIndex(videoDir, "Cam2_OutputVideo", ".mp4");
-                videoPath2 = videoDir / ("Cam2_OutputVideo" + to_string(nextVid2) + ".mp4");
-            }
-
-            int codec = VideoWriter::fourcc('m', 'p', '4', 'v');
+                CameraPipeline& p = engine.camera(k);
+                if (!p.alive()) continue;
 
-            // Threaded capture doesn’t automatically guarantee 60 fps, but it reduces stalls.
-            // For now we keep your simple fixed FPS. Later we can compute/write actual FPS.
-            double fps = 60.0;
-
-            writer1.open(videoPath1.string(), codec, fps, src1.size(), isColor1);
-            if (!writer1.isOpened())
-            {
-                cerr << "Could not open Cam1 output video for write\n";
-                return -1;
-            }
+                const string base = p.name() + "_OutputVideo";
+                fs::path videoPath = videoDir / (base + to_string(getNextIndex(videoDir, base, videoExt)) + videoExt);
 
-            if (cam2Available)
-            {
-                writer2.open(videoPath2.string(), codec, fps, src2.size(), isColor2);
-                if (!writer2.isOpened())
+                // Each video is written at its camera's measured rate, resampled on
+                // the ring's capture timestamps (see recorder.hpp).
+                if (!p.recorder().start(videoPath.string(), codec, p.frameSize(), p.isColor()))
                 {
-                    cout << "Warning: Could not open Cam2 output video. Continuing with Cam1 only.\n";
-                    cam2Available = false;
-                    cam2.reset();
+                    if (k == 0)
+                    {
+                        cerr << "Could not open Cam1 output video for write\n";
+                        return -1;
+                    }
+                    disableCamera(k, "Warning: Could not open " + p.name() + " output video. Continuing without it.");
+                    continue;
                 }
+                cout << "  " << p.name() << " -> " << videoPath.string() << "\n";
             }
-
             recordingOn = true;
-            cout << "Recording started:\n"
-                 << "  Cam1 -> " << videoPath1.string() << "\n";
-            if (cam2Available)
-                cout << "  Cam2 -> " << videoPath2.string() << "\n";
         }
 
         // -----------------------------------------------------
@@ -388,7 +395,7 @@ int main(int argc, char** argv)
         if (!motionOn && recordingOn && (key == 'm' || key == 'M'))
         {
             int nextData = getNextIndex(dataDir, "MotionLog", ".csv");
-            fs::path dataPath = dataDir / ("MotionLog" + to_string(nextData) + ".csv");
+            dataPath = dataDir / ("MotionLog" + to_string(nextData) + ".csv");
 
             csv.open(dataPath.string(), ios::out);
             if (!csv.is_open())
@@ -397,73 +404,75 @@ int main(int argc, char** argv)
                 return -1;
             }
 
-            if (cam2Available) csv << "Second,Cam1,Cam2\n";
-            else              csv << "Second,Cam1\n";
+            csv << "Second";
+            for (size_t k = 0; k < engine.size(); k++)
+                csv << "," << engine.camera(k).name();
+            if (opts.detector.lighting)
+            {
+                for (size_t k = 0; k < engine.size(); k++)
+                    csv << "," << engine.camera(k).name() << "Lighting";
+            }
+            if (eventsOn)
+            {
+                for (size_t k = 0; k < engine.size(); k++)
+                    csv << "," << engine.camera(k).name() << "SegmentStart," << engine.camera(k).name() << "SegmentEnd";
+            }
+            csv << "\n";
+
+            // Per-tile motion, one row per camera per second next to the log
+            if (opts.detector.heatmapCols > 0)
+            {
+                heatCsv = openSideCsv(dataPath, "_heatmap", string("Second,Camera,Frames,") +
+                                      heatmapColumns(opts.detector.heatmapCols, opts.detector.heatmapRows));
+                if (!heatCsv.is_open()) return -1;
+            }
+
+            // Motion regions of every detected frame
+            if (opts.detector.blobs)
+            {
+                blobCsv = openSideCsv(dataPath, "_blobs",
+                                      "Second,Camera,Time,X,Y,Width,Height,Area,CentroidX,CentroidY");
+                if (!blobCsv.is_open()) return -1;
+            }
+
+            // Ratio statistics, one row per camera per second next to the log
+            if (opts.detector.ratioStats)
+            {
+                statsCsv = openSideCsv(dataPath, "_stats", string("Second,Camera,") + windowStatsColumns());
+                if (!statsCsv.is_open()) return -1;
+            }
+
+            // Dominant direction and speed of motion, one row per camera per second
+            if (opts.detector.vectors)
+            {
+                flowCsv = openSideCsv(dataPath, "_flow", string("Second,Camera,") + flowColumns());
+                if (!flowCsv.is_open()) return -1;
+            }
+
+            // Motion start / end, one row per event as it happens
+            if (opts.motionEvents.enabled)
+            {
+                eventCsv = openSideCsv(dataPath, "_events", motionEventColumns());
+                if (!eventCsv.is_open()) return -1;
+            }
 
             motionOn = true;
-            lastSecondTick = clock_t::now();
+            motionStartTime = clock_t::now();
+            lastSecondTick = motionStartTime;
             secondsLogged = 0;
 
-            motionDetectedCam1ThisSecond = false;
-            motionDetectedCam2ThisSecond = false;
-
-            // Initialize baselines from current frames
-            cvtColor(src1, prevGray1, COLOR_BGR2GRAY);
-            if (cam2Available)
-                cvtColor(src2, prevGray2, COLOR_BGR2GRAY);
+            // Initialize baselines from current frames (and clear the motion flags)
+            engine.resetDetectors();
 
             cout << "Motion sensor started. Logging to: " << dataPath.string() << "\n";
             cout << "Will auto-terminate after 2 minutes (120 seconds).\n";
         }
 
         // -----------------------------------------------------
-        // Write frames to video(s)
-        // -----------------------------------------------------
-        if (recordingOn)
-        {
-            writer1.write(src1);
-            if (cam2Available && writer2.isOpened())
-                writer2.write(src2);
-        }
-
-        // -----------------------------------------------------
-        // Motion detection + CSV logging
+        // CSV logging (detection already ran in the engine step)
         // -----------------------------------------------------
         if (motionOn)
         {
-            // Cam1 motion detection
-            cvtColor(src1, gray1, COLOR_BGR2GRAY);
-            absdiff(gray1, prevGray1, diff1);
-            threshold(diff1, thresh1, DIFF_THRESH, 255, THRESH_BINARY);
-
-            int changed1 = countNonZero(thresh1);
-            int total1 = thresh1.rows * thresh1.cols;
-            double ratio1 = (total1 > 0) ? (double)changed1 / (double)total1 : 0.0;
-
-            if (ratio1 >= MOTION_RATIO)
-                motionDetectedCam1ThisSecond = true;
-
-            // NOTE: clone() is safe and simple. Later optimization:
-            // reuse buffers or swap Mats to reduce allocations.
-            prevGray1 = gray1.clone();
-
-            // Cam2 motion detection (optional)
-            if (cam2Available)
-            {
-                cvtColor(src2, gray2, COLOR_BGR2GRAY);
-                absdiff(gray2, prevGray2, diff2);
-                threshold(diff2, thresh2, DIFF_THRESH, 255, THRESH_BINARY);
-
-                int changed2 = countNonZero(thresh2);
-                int total2 = thresh2.rows * thresh2.cols;
-                double ratio2 = (total2 > 0) ? (double)changed2 / (double)total2 : 0.0;
-
-                if (ratio2 >= MOTION_RATIO)
-                    motionDetectedCam2ThisSecond = true;
-
-                prevGray2 = gray2.clone();
-            }
-
             // Per-second logging (same model as your Python program)
             auto now = clock_t::now();
             auto elapsedSinceTickMs =
@@ -473,23 +482,59 @@ int main(int argc, char** argv)
             {
                 secondsLogged += 1;
 
-                const string cam1Status = motionDetectedCam1ThisSecond ? "Motion Detected" : "No motion";
+                const string status = statusColumns();
+                csv  << secondsLogged << status << lightingColumns() << segmentColumns() << "\n";
+                cout << secondsLogged << status << "\n";
 
-                if (cam2Available)
+                if (heatCsv.is_open())
                 {
-                    const string cam2Status = motionDetectedCam2ThisSecond ? "Motion Detected" : "No motion";
-                    csv  << secondsLogged << "," << cam1Status << "," << cam2Status << "\n";
-                    cout << secondsLogged << "," << cam1Status << "," << cam2Status << "\n";
+                    for (size_t k = 0; k < engine.size(); k++)
+                    {
+                        CameraPipeline& p = engine.camera(k);
+                        if (!p.alive()) continue;
+                        const MotionHeatmap heat = p.takeHeatmap();
+                        heatCsv << secondsLogged << "," << p.name() << "," << heat.frames << ","
+                                << formatHeatmapCells(heat) << "\n";
+                    }
                 }
-                else
+
+                if (statsCsv.is_open())
                 {
-                    csv  << secondsLogged << "," << cam1Status << "\n";
-                    cout << secondsLogged << "," << cam1Status << "\n";
+                    for (size_t k = 0; k < engine.size(); k++)
+                    {
+                        CameraPipeline& p = engine.camera(k);
+                        if (!p.alive()) continue;
+                        statsCsv << secondsLogged << "," << p.name() << "," << formatWindowStats(p.takeWindowStats())
+                                 << "\n";
+                    }
+                }
+
+                if (flowCsv.is_open())
+                {
+                    for (size_t k = 0; k < engine.size(); k++)
+                    {
+                        CameraPipeline& p = engine.camera(k);
+                        if (!p.alive()) continue;
+                        flowCsv << secondsLogged << "," << p.name() << "," << formatFlowStats(p.takeFlow()) << "\n";
+                    }
+                }
+
+                if (blobCsv.is_open())
+                {
+                    for (size_t k = 0; k < engine.size(); k++)
+                    {
+                        CameraPipeline& p = engine.camera(k);
+                        p.takeBlobs(blobs);
+                        for (const TimedBlob& b : blobs)
+                        {
+                            const double t = chrono::duration<double>(b.captureTime - motionStartTime).count();
+                            blobCsv << secondsLogged << "," << p.name() << "," << formatBlobRow(b.blob, t) << "\n";
+                        }
+                    }
                 }
 
-                motionDetectedCam1ThisSecond = false;
-                motionDetectedCam2ThisSecond = false;
                 lastSecondTick = now;
+                engine.rollWindows();
             }
 
             if (secondsLogged >= 120)
@@ -503,14 +548,78 @@ int main(int argc, char** argv)
     // ---------------------------------------------------------
     // Cleanup
     // ---------------------------------------------------------
+    // Events still running at exit end at their last moving frame
+    engine.finishMotionEvents();
+    drainMotionEvents();
+    if (opts.motionEvents.enabled && motionOn)
+    {
+        eventStats.dropped = eventLog.dropped();
+        cout << "[Motion] " << formatMotionEventStats(eventStats) << "\n";
+    }
+
+    if (eventsOn)
+    {
+        // Closes any open event clip
+        for (size_t k = 0; k < engine.size(); k++)
+        {
+            EventRecorder& ev = engine.camera(k).events();
+            ev.stop();
+            if (k == 0 || ev.stats().frames > 0)
+                cout << "[Events] " << engine.camera(k).name() << ": " << formatEventStats(ev.stats()) << "\n";
+        }
+
+        // A clip still open at exit ends in a final (partial-second) row
+        const string cols = segmentColumns();
+        if (csv.is_open() && cols.find_first_not_of(',') != string::npos)
+            csv << secondsLogged + 1 << statusColumns() << lightingColumns() << cols << "\n";
+    }
     if (csv.is_open()) csv.close();
-    if (writer1.isOpened()) writer1.release();
-    if (writer2.isOpened()) writer2.release();
+    if (heatCsv.is_open()) heatCsv.close();
+    if (blobCsv.is_open()) blobCsv.close();
+    if (eventCsv.is_open()) eventCsv.close();
+    if (statsCsv.is_open()) statsCsv.close();
+    if (flowCsv.is_open()) flowCsv.close();
+
+    // Stopping a recorder finishes encoding whatever is still queued
+    bool anyRecording = false;
+    for (size_t k = 0; k < engine.size(); k++)
+        anyRecording = anyRecording || engine.camera(k).recorder().isRecording();
+    engine.stop();
+    if (checkpoints)
+    {
+        error_code ec;
+        fs::create_directories(stateDir, ec);
+        cout << "[Background] " << engine.saveBackgrounds(stateDir) << " camera models saved to " << stateDir << "\n";
+    }
+    if (anyRecording)
+    {
+        for (size_t k = 0; k < engine.size(); k++)
+        {
+            const RecorderStats rs = engine.camera(k).recorder().stats();
+            if (k == 0 || rs.sourceFrames > 0)
+                cout << "[Recorder] " << engine.camera(k).name() << ": " << formatRecorderStats(rs) << "\n";
+        }
+    }
+    for (size_t k = 0; k < engine.size(); k++)
+        cout << "[Engine] " << engine.camera(k).name() << ": " << formatPipelineStats(engine.camera(k).stats()) << "\n";
+
+    // Cross-camera skew of the frame sets, next to the motion log as <log>_skew.csv
+    if (engine.size() > 1)
+    {
+        const SkewStats skew = engine.skewStats();
+        cout << "[Sync] " << formatSkewStats(skew, engine.syncToleranceMs()) << "\n";
+        if (!dataPath.empty())
+        {
+            const fs::path skewPath = sideLogPath(dataPath, "_skew");
+            if (!writeSkewHistogram(skewPath.string(), skew))
+                cerr << "Could not write " << skewPath.string() << "\n";
+        }
+    }
 
     // Stop streams explicitly (also done in destructors, but explicit feels cleaner)
-    cam1.stop();
-    if (cam2Available && cam2) cam2->stop();
+    for (auto& cam : streams) cam->stop();
 
-    destroyAllWindows();
+    display.closeAll();
+    cout << "[Display] " << formatDisplayStats(display.stats()) << "\n";
     return 0;
 }
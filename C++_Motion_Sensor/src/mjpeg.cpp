@@ -0,0 +1,74 @@
+#include "mjpeg.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+int reducedFlag(int scale, bool color)
+{
+    switch (scale)
+    {
+    case 2:  return color ? IMREAD_REDUCED_COLOR_2 : IMREAD_REDUCED_GRAYSCALE_2;
+    case 4:  return color ? IMREAD_REDUCED_COLOR_4 : IMREAD_REDUCED_GRAYSCALE_4;
+    case 8:  return color ? IMREAD_REDUCED_COLOR_8 : IMREAD_REDUCED_GRAYSCALE_8;
+    default: return color ? IMREAD_COLOR : IMREAD_GRAYSCALE;
+    }
+}
+
+bool decode(const Mat& packet, int flags, Mat& dst)
+{
+    if (!isJpegPacket(packet)) return false;
+    imdecode(packet, flags, &dst);
+    return !dst.empty();
+}
+} // namespace
+
+bool isJpegPacket(const Mat& frame)
+{
+    if (frame.rows != 1 || frame.type() != CV_8UC1 || frame.cols < 4) return false;
+    const uchar* p = frame.ptr<uchar>(0);
+    return p[0] == 0xFF && p[1] == 0xD8;
+}
+
+bool jpegInfo(const uint8_t* data, size_t size, Size& frameSize, int& components)
+{
+    // Walk the marker segments up to the first SOFn (baseline, progressive, ...)
+    size_t pos = 2;
+    while (pos + 4 <= size)
+    {
+        if (data[pos] != 0xFF) return false;
+        const uint8_t marker = data[pos + 1];
+        if (marker == 0xFF)
+        {
+            pos++; // fill byte
+            continue;
+        }
+
+        const size_t length = ((size_t)data[pos + 2] << 8) | data[pos + 3];
+        const bool isSof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (isSof)
+        {
+            if (pos + 10 > size) return false;
+            frameSize.height = (data[pos + 5] << 8) | data[pos + 6];
+            frameSize.width = (data[pos + 7] << 8) | data[pos + 8];
+            components = data[pos + 9];
+            return frameSize.width > 0 && frameSize.height > 0;
+        }
+        if (marker == 0xDA) return false; // scan data before any frame header
+        pos += 2 + length;
+    }
+    return false;
+}
+
+bool decodeJpegLuma(const Mat& packet, int scale, Mat& dst)
+{
+    return decode(packet, reducedFlag(scale, false), dst);
+}
+
+bool decodeJpegColor(const Mat& packet, int scale, Mat& dst)
+{
+    return decode(packet, reducedFlag(scale, true), dst);
+}
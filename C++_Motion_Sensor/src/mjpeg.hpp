@@ -0,0 +1,26 @@
+#pragma once
+
+// MJPEG passthrough helpers: frames that stay JPEG packets from the camera
+// to the video file, decoded only as far as detection and preview need.
+
+#include <opencv2/core.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// True if `frame` is one compressed JPEG packet (a 1-row CV_8UC1 Mat that
+// starts with the SOI marker), as delivered by a camera or file opened with
+// SourceOptions::mjpegPassthrough.
+bool isJpegPacket(const cv::Mat& frame);
+
+// Image size and component count (1 = gray, 3 = color) from the packet's
+// frame header, without decoding. False if no SOF marker was found.
+bool jpegInfo(const uint8_t* data, size_t size, cv::Size& frameSize, int& components);
+
+// Luma plane at 1/scale width and height (scale 1, 2, 4 or 8). Uses the JPEG
+// decoder's DCT-domain scaling and skips the chroma planes, so a 1/4 plane
+// costs a fraction of a full BGR decode. Reuses `dst` when it fits.
+bool decodeJpegLuma(const cv::Mat& packet, int scale, cv::Mat& dst);
+
+// BGR image at 1/scale size, for preview windows.
+bool decodeJpegColor(const cv::Mat& packet, int scale, cv::Mat& dst);
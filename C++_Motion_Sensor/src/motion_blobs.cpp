@@ -0,0 +1,150 @@
+#include "motion_blobs.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace cv;
+using namespace std;
+
+BlobExtractor::BlobExtractor(int maxBlobs) : maxBlobs(max(1, maxBlobs))
+{
+}
+
+void BlobExtractor::configure(int cols, int rows, int cellSize, int scale, Size frameSize)
+{
+    gridCols = max(0, cols);
+    gridRows = max(0, rows);
+    this->cellSize = cellSize;
+    this->scale = scale;
+    this->frameSize = frameSize;
+
+    // At most one run per two cells of a row
+    const size_t maxRuns = (size_t)gridRows * (size_t)((gridCols + 1) / 2);
+    runs.reserve(maxRuns);
+    stats.reserve(maxRuns);
+    roots.reserve(maxRuns);
+}
+
+int BlobExtractor::find(int i)
+{
+    while (runs[i].parent != i)
+    {
+        runs[i].parent = runs[runs[i].parent].parent; // path halving
+        i = runs[i].parent;
+    }
+    return i;
+}
+
+void BlobExtractor::unite(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    // The earlier run stays the root
+    if (a < b) runs[b].parent = a;
+    else       runs[a].parent = b;
+}
+
+void BlobExtractor::extract(const uint16_t* cells, int minCellCount, int minCells, vector<MotionBlob>& out)
+{
+    out.clear();
+    out.reserve((size_t)maxBlobs);
+    runs.clear();
+    stats.clear();
+    roots.clear();
+    minCellCount = max(1, minCellCount);
+
+    int prevBegin = 0, prevEnd = 0; // runs of the previous cell row
+    for (int r = 0; r < gridRows; r++)
+    {
+        const uint16_t* row = cells + (size_t)r * gridCols;
+        const int rowBegin = (int)runs.size();
+
+        for (int c = 0; c < gridCols;)
+        {
+            if (row[c] < minCellCount)
+            {
+                c++;
+                continue;
+            }
+            const int idx = (int)runs.size();
+            Stats s;
+            s.x0 = c;
+            s.y0 = s.y1 = r;
+            for (; c < gridCols && row[c] >= minCellCount; c++)
+            {
+                s.area += row[c];
+                s.sumX += (uint64_t)row[c] * (uint64_t)(2 * c + 1);
+                s.sumY += (uint64_t)row[c] * (uint64_t)(2 * r + 1);
+            }
+            s.x1 = c - 1;
+            s.cells = c - s.x0;
+            runs.push_back({s.x0, c, idx});
+            stats.push_back(s);
+        }
+
+        // Join with the runs above that touch, diagonals included: both lists
+        // are sorted, so one forward scan
+        int j = prevBegin;
+        for (int i = rowBegin; i < (int)runs.size(); i++)
+        {
+            while (j < prevEnd && runs[j].end < runs[i].begin) j++;
+            for (int k = j; k < prevEnd && runs[k].begin <= runs[i].end; k++) unite(i, k);
+        }
+        prevBegin = rowBegin;
+        prevEnd = (int)runs.size();
+    }
+
+    // Fold every run's stats into its root
+    for (int i = 0; i < (int)runs.size(); i++)
+    {
+        const int root = find(i);
+        if (root == i)
+        {
+            roots.push_back(i);
+            continue;
+        }
+        Stats& dst = stats[root];
+        const Stats& s = stats[i];
+        dst.area += s.area;
+        dst.sumX += s.sumX;
+        dst.sumY += s.sumY;
+        dst.cells += s.cells;
+        dst.x0 = min(dst.x0, s.x0);
+        dst.x1 = max(dst.x1, s.x1);
+        dst.y0 = min(dst.y0, s.y0);
+        dst.y1 = max(dst.y1, s.y1);
+    }
+
+    // Largest first, at most maxBlobs
+    auto small = [&](int i) { return stats[i].cells < minCells; };
+    roots.erase(remove_if(roots.begin(), roots.end(), small), roots.end());
+    auto larger = [&](int a, int b) { return stats[a].area > stats[b].area; };
+    if ((int)roots.size() > maxBlobs)
+    {
+        nth_element(roots.begin(), roots.begin() + maxBlobs, roots.end(), larger);
+        roots.resize((size_t)maxBlobs);
+    }
+    sort(roots.begin(), roots.end(), larger);
+
+    const int px = cellSize * scale;
+    const Rect frame(0, 0, frameSize.width, frameSize.height);
+    for (int i : roots)
+    {
+        const Stats& s = stats[i];
+        MotionBlob b;
+        b.box = Rect(s.x0 * px, s.y0 * px, (s.x1 + 1 - s.x0) * px, (s.y1 + 1 - s.y0) * px) & frame;
+        b.area = (int)s.area;
+        b.centroid = Point2f((float)((double)s.sumX * px / (2.0 * (double)s.area)),
+                             (float)((double)s.sumY * px / (2.0 * (double)s.area)));
+        out.push_back(b);
+    }
+}
+
+string formatBlobRow(const MotionBlob& b, double seconds)
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%.3f,%d,%d,%d,%d,%d,%.1f,%.1f", seconds, b.box.x, b.box.y, b.box.width,
+             b.box.height, b.area, b.centroid.x, b.centroid.y);
+    return buf;
+}
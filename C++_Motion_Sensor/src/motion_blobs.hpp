@@ -0,0 +1,87 @@
+#pragma once
+
+// Motion blobs: connected regions of changed cells, with boxes and centroids.
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One connected region of motion, in frame pixels.
+struct MotionBlob
+{
+    cv::Rect    box;      // covering cells, clipped to the frame
+    int         area = 0; // changed pixels inside it (plane pixels)
+    cv::Point2f centroid; // mean of the changed pixels, weighted per cell
+};
+
+// ============================================================
+// BlobExtractor
+// ============================================================
+//
+// Why this exists:
+// - Downstream tracking needs where the motion is, not just whether there was
+//   any; findContours / connectedComponentsWithStats on a full-resolution mask
+//   is several ms per frame per camera
+// - The detector already counts changed pixels per small cell (8x8 or 16x16
+//   plane pixels) while the rows are in cache; a cell is "on" once enough of
+//   it changed
+// - On cells are run-length encoded per cell row and the runs joined with a
+//   union-find (8-connected), so the work is proportional to the runs, not the
+//   pixels
+//
+// All buffers are sized by configure() for the largest possible run count;
+// extract() never allocates.
+//
+class BlobExtractor
+{
+public:
+    // Keep at most maxBlobs per frame (the largest by area).
+    explicit BlobExtractor(int maxBlobs = 32);
+
+    // Grid of cols x rows cells of `cellSize` plane pixels; `scale` maps plane
+    // pixels to frame pixels (the decimation) and frameSize clips the boxes.
+    void configure(int cols, int rows, int cellSize, int scale, cv::Size frameSize);
+
+    int cols() const { return gridCols; }
+    int rows() const { return gridRows; }
+
+    // Blobs of a grid of changed-pixel counts (row-major, cols x rows). A cell
+    // is on at minCellCount or more; blobs with fewer than minCells cells are
+    // dropped. `out` keeps its capacity (maxBlobs).
+    void extract(const uint16_t* cells, int minCellCount, int minCells, std::vector<MotionBlob>& out);
+
+private:
+    struct Run
+    {
+        int begin, end; // cell columns [begin, end)
+        int parent;     // union-find
+    };
+
+    struct Stats
+    {
+        uint64_t area = 0;
+        uint64_t sumX = 0, sumY = 0; // area-weighted cell centers (in half cells)
+        int cells = 0;
+        int x0 = 0, y0 = 0, x1 = 0, y1 = 0; // cell bounds, inclusive
+    };
+
+    int find(int i);
+    void unite(int a, int b);
+
+    int maxBlobs;
+    int gridCols = 0;
+    int gridRows = 0;
+    int cellSize = 8;
+    int scale = 1;
+    cv::Size frameSize;
+
+    std::vector<Run> runs;
+    std::vector<Stats> stats;
+    std::vector<int> roots; // indices of the root runs
+};
+
+// Columns of a blob log row: "Time,X,Y,Width,Height,Area,CentroidX,CentroidY",
+// with the frame's capture time in seconds (e.g. since 'm' was pressed).
+std::string formatBlobRow(const MotionBlob& b, double seconds);
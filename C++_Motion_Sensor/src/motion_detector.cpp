@@ -0,0 +1,651 @@
+#include "motion_detector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+using namespace cv;
+
+namespace
+{
+// Plane rows per band when a second look follows the conversion or the diff
+// (the background model pass, blob cells): few enough that the band's luma
+// is still in L1/L2 when it is read again.
+constexpr int kBandRows = 8;
+
+// Blobs: a cell is on once 1/kBlobCellFill of its pixels changed, and a blob
+// needs kBlobMinCells cells.
+constexpr int kBlobCellFill = 4;
+constexpr int kBlobMinCells = 2;
+
+// Lighting: a band is counted again once its gain (Q8) is this far from 1.0,
+// and the gain is capped where the SIMD scaling stays exact (16x).
+constexpr int kLightingMinGain = 8;
+constexpr int kLightingMaxGain = 4095;
+
+// Row bands: each band gets at least kMinBandPixels plane pixels (below that
+// the fork/join costs more than the band saves), and band edges fall on
+// multiples of kBandAlign rows (blob cells, lighting bands).
+constexpr int kMinBandPixels = 128 * 1024;
+constexpr int kBandAlign = 16;
+
+// Smallest changed-pixel count c with (double)c / total >= ratio, i.e. the
+// exact threshold the original `ratio >= MOTION_RATIO` test applies.
+int pixelsNeeded(double ratio, int total)
+{
+    if (total <= 0) return 1;
+    int c = (int)std::ceil(ratio * (double)total);
+    c = std::max(0, std::min(c, total + 1));
+    while (c > 0 && (double)(c - 1) / (double)total >= ratio) c--;
+    while (c <= total && (double)c / (double)total < ratio) c++;
+    return c;
+}
+} // namespace
+
+MotionDetector::MotionDetector(int diffThresh, double motionRatio, const DetectorOptions& options)
+    : diffThresh(diffThresh), motionRatio(motionRatio), options(options),
+      vectorEstimator(options.vectorRange), background(options.learningRate)
+{
+    if (this->options.decimation != 2 && this->options.decimation != 4 && this->options.decimation != 8)
+        this->options.decimation = 1;
+    if (this->options.heatmapCols <= 0 || this->options.heatmapRows <= 0)
+        this->options.heatmapCols = this->options.heatmapRows = 0;
+    if (this->options.blobCell != 16)
+        this->options.blobCell = 8;
+    cellShift = (this->options.blobCell == 16) ? 4 : 3;
+    if (this->options.decisionMode)
+        this->options.vectors = false;
+    bandState.resize(1);
+}
+
+Size MotionDetector::planeSize(Size frameSize) const
+{
+    if (options.decimation == 1) return frameSize;
+    return motion::decimatedSize(frameSize, options.decimation);
+}
+
+template <typename Visit>
+void MotionDetector::forEachSegment(int y, int width, Visit visit) const
+{
+    const RoiMask::Span whole{0, width};
+    const RoiMask::Span* begin = mask.empty() ? &whole : mask.rowBegin(y);
+    const RoiMask::Span* end = mask.empty() ? &whole + 1 : mask.rowEnd(y);
+    for (const RoiMask::Span* s = begin; s != end; ++s)
+    {
+        if (!heatmapOn())
+        {
+            visit(s->begin, s->end, 0);
+            continue;
+        }
+        // First tile whose right edge lies past the span's start
+        int t = (int)(std::upper_bound(tileX.begin() + 1, tileX.end() - 1, s->begin) - tileX.begin()) - 1;
+        for (int x = s->begin; x < s->end; t++)
+        {
+            const int e = std::min(s->end, tileX[t + 1]);
+            if (e > x) visit(x, e, t);
+            x = std::max(x, e);
+        }
+    }
+}
+
+template <typename Count>
+int MotionDetector::countSegments(int r0, int r1, int width, Band& band, Count count)
+{
+    int changed = 0;
+    for (int y = r0; y < r1; y++)
+    {
+        uint64_t* cells = heatmapOn() ? band.heatCells + (size_t)(y * heat.rows / heatPlane.height) * heat.cols
+                                      : nullptr;
+        forEachSegment(y, width, [&](int x0, int x1, int t) {
+            const int c = count(y, x0, x1);
+            changed += c;
+            if (cells) cells[t] += (uint64_t)c;
+        });
+    }
+    return changed;
+}
+
+void MotionDetector::convertRows(const Mat& frame, Mat& dst, int r0, int r1, Band& band)
+{
+    if (!mask.empty())
+    {
+        for (int y = r0; y < r1; y++)
+            for (const RoiMask::Span* s = mask.rowBegin(y); s != mask.rowEnd(y); ++s)
+                motion::toLumaSpan(frame, dst, options.decimation, y, s->begin, s->end, band.scratch);
+        return;
+    }
+
+    if (options.decimation == 1)
+        motion::toLumaRows(frame, dst, r0, r1);
+    else
+        motion::toLumaDecimatedRows(frame, dst, options.decimation, r0, r1, band.scratch);
+}
+
+int MotionDetector::diffBands(const Mat& frame, Size plane, int& raw)
+{
+    const int n = bandCount(plane);
+    lastBands = n;
+    if ((int)bandState.size() < n) bandState.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        Band& band = bandState[i];
+        band.rawChanged = 0;
+        if (!heatmapOn()) continue;
+        if (i == 0)
+        {
+            band.heatCells = heat.changed.data();
+            continue;
+        }
+        band.heat.assign(heat.changed.size(), 0);
+        band.heatCells = band.heat.data();
+    }
+
+    if (n == 1)
+    {
+        const int changed = diffRows(frame, 0, plane.height, bandState[0]);
+        raw = bandState[0].rawChanged;
+        return changed;
+    }
+
+    const int rows = (plane.height + n - 1) / n;
+    const int step = (rows + kBandAlign - 1) / kBandAlign * kBandAlign;
+    bandPool->parallelFor((size_t)n, [&](size_t i) {
+        Band& band = bandState[i];
+        const int r0 = std::min(plane.height, (int)i * step);
+        const int r1 = std::min(plane.height, r0 + step);
+        band.changed = (r0 < r1) ? diffRows(frame, r0, r1, band) : 0;
+    });
+
+    int changed = 0;
+    raw = 0;
+    for (int i = 0; i < n; i++)
+    {
+        const Band& band = bandState[i];
+        changed += band.changed;
+        raw += band.rawChanged;
+        if (i > 0 && heatmapOn())
+            for (size_t c = 0; c < band.heat.size(); c++) heat.changed[c] += band.heat[c];
+    }
+    return changed;
+}
+
+int MotionDetector::bandCount(Size plane) const
+{
+    if (!bandPool || bandPool->size() < 2) return 1;
+    const int bySize = std::min(plane.area() / kMinBandPixels, plane.height / kBandAlign);
+    return std::max(1, std::min(bandPool->size(), bySize));
+}
+
+int MotionDetector::diffRows(const Mat& frame, int r0, int r1, Band& band)
+{
+    if (options.background)
+        return backgroundRows(frame, r0, r1, band);
+    if (!cellsOn() && !options.lighting)
+        return diffPlaneRows(frame, r0, r1, band);
+
+    int changed = 0;
+    for (int r = r0; r < r1; r += kBandRows)
+    {
+        const int end = std::min(r1, r + kBandRows);
+        const int raw = diffPlaneRows(frame, r, end, band);
+        if (cellsOn()) countCells(curLuma, r, end);
+        changed += options.lighting ? keepCompensated(raw, compensatedRows(curLuma, r, end), band) : raw;
+    }
+    return changed;
+}
+
+int MotionDetector::diffPlaneRows(const Mat& frame, int r0, int r1, Band& band)
+{
+    if (!mask.empty() || heatmapOn())
+    {
+        return countSegments(r0, r1, curLuma.cols, band, [&](int y, int x0, int x1) {
+            return motion::lumaDiffCountSpan(frame, prevLuma, curLuma, options.decimation, diffThresh, y, x0, x1,
+                                             band.scratch);
+        });
+    }
+
+    if (options.decimation == 1)
+        return motion::lumaDiffCountRows(frame, prevLuma, curLuma, diffThresh, r0, r1);
+
+    return motion::lumaDecimatedDiffCountRows(frame, prevLuma, curLuma, options.decimation,
+                                              diffThresh, r0, r1, band.scratch);
+}
+
+int MotionDetector::backgroundRows(const Mat& frame, int r0, int r1, Band& band)
+{
+    // Full-resolution gray input (a Y plane, a decoded luma plane) already is the plane
+    const bool direct = options.decimation == 1 && frame.type() == CV_8UC1;
+    const bool whole = mask.empty() && !heatmapOn();
+    if (direct && whole && !cellsOn() && !options.lighting)
+        return background.diffUpdateRows(frame, diffThresh, r0, r1);
+
+    int changed = 0;
+    for (int r = r0; r < r1; r += kBandRows)
+    {
+        const int end = std::min(r1, r + kBandRows);
+        const Mat& luma = direct ? frame : curLuma;
+        if (!direct) convertRows(frame, curLuma, r, end, band);
+        if (cellsOn()) countCells(luma, r, end);
+        const int compensated = options.lighting ? compensatedRows(luma, r, end) : -1;
+
+        const int raw = whole ? background.diffUpdateRows(luma, diffThresh, r, end)
+                              : countSegments(r, end, luma.cols, band, [&](int y, int x0, int x1) {
+                                    return background.diffUpdateSpan(luma, diffThresh, y, x0, x1);
+                                });
+        changed += options.lighting ? keepCompensated(raw, compensated, band) : raw;
+    }
+    return changed;
+}
+
+void MotionDetector::learnRows(const Mat& frame, int r0, int r1, Band& band)
+{
+    const bool direct = options.decimation == 1 && frame.type() == CV_8UC1;
+    const Mat& luma = direct ? frame : curLuma;
+    for (int r = r0; r < r1; r += kBandRows)
+    {
+        const int end = std::min(r1, r + kBandRows);
+        if (!direct) convertRows(frame, curLuma, r, end, band);
+        if (mask.empty())
+        {
+            background.diffUpdateRows(luma, diffThresh, r, end);
+            continue;
+        }
+        for (int y = r; y < end; y++)
+            for (const RoiMask::Span* s = mask.rowBegin(y); s != mask.rowEnd(y); ++s)
+                background.diffUpdateSpan(luma, diffThresh, y, s->begin, s->end);
+    }
+}
+
+int MotionDetector::compensatedRows(const Mat& luma, int r0, int r1) const
+{
+    // The band's gain: its luma total over its baseline's
+    uint64_t curSum = 0, refSum = 0;
+    for (int y = r0; y < r1; y++)
+    {
+        forEachSegment(y, luma.cols, [&](int x0, int x1, int) {
+            if (options.background)
+                background.sums(luma, y, x0, x1, curSum, refSum);
+            else
+                motion::lumaSumsRow(luma.ptr<uint8_t>(y), prevLuma.ptr<uint8_t>(y), x0, x1, curSum, refSum);
+        });
+    }
+    if (refSum == 0) return -1;
+    const int gain = (int)std::min<uint64_t>(kLightingMaxGain, (curSum * 256 + refSum / 2) / refSum);
+    if (std::abs(gain - 256) < kLightingMinGain) return -1;
+
+    int changed = 0;
+    for (int y = r0; y < r1; y++)
+    {
+        forEachSegment(y, luma.cols, [&](int x0, int x1, int) {
+            if (options.background)
+                changed += background.gainDiffCount(luma, diffThresh, y, x0, x1, gain);
+            else
+                changed += motion::gainDiffCountRow(luma.ptr<uint8_t>(y), prevLuma.ptr<uint8_t>(y), x0, x1,
+                                                    diffThresh, gain);
+        });
+    }
+    return changed;
+}
+
+int MotionDetector::keepCompensated(int raw, int compensated, Band& band)
+{
+    band.rawChanged += raw;
+    return (compensated < 0) ? raw : std::min(raw, compensated);
+}
+
+void MotionDetector::countCells(const Mat& luma, int r0, int r1)
+{
+    const int cols = blobExtractor.cols();
+    for (int y = r0; y < r1; y++)
+    {
+        uint16_t* row = cells.data() + (size_t)(y >> cellShift) * cols;
+        const uint8_t* cur = luma.ptr<uint8_t>(y);
+        forEachSegment(y, luma.cols, [&](int x0, int x1, int) {
+            if (options.background)
+                background.countCells(luma, diffThresh, y, x0, x1, cellShift, row);
+            else
+                motion::cellDiffCountRow(cur, prevLuma.ptr<uint8_t>(y), x0, x1, diffThresh, cellShift, row);
+        });
+    }
+}
+
+void MotionDetector::setRegions(std::vector<RoiPolygon> polygons)
+{
+    regions = std::move(polygons);
+    mask = RoiMask();   // compiled for the plane size on the next frame
+    heatPlane = Size(); // tile areas change with the mask
+}
+
+void MotionDetector::fitPlane(Size plane)
+{
+    if (!regions.empty() && (mask.empty() || mask.size() != plane))
+        mask = RoiMask(regions, plane);
+    if (heatmapOn() && heatPlane != plane)
+        fitHeatmap(plane);
+    if (cellsOn() && blobPlane != plane)
+        fitBlobs(plane);
+}
+
+void MotionDetector::fitBlobs(Size plane)
+{
+    blobPlane = plane;
+    const int cell = 1 << cellShift;
+    const int cols = (plane.width + cell - 1) >> cellShift;
+    const int rows = (plane.height + cell - 1) >> cellShift;
+    cells.assign((size_t)cols * rows, 0);
+
+    const int d = options.decimation;
+    blobExtractor.configure(cols, rows, cell, d, Size(plane.width * d, plane.height * d));
+    vectorEstimator.configure(cols, rows, cell, d, plane);
+    vectorRef.release();
+}
+
+void MotionDetector::finishCells(const Mat& frame, bool lighting)
+{
+    const int cell = 1 << cellShift;
+    if (options.vectors)
+    {
+        // The plane this frame was detected on, and the previous one
+        const bool direct = options.background && options.decimation == 1 && frame.type() == CV_8UC1;
+        const Mat& luma = direct ? frame : curLuma;
+        const Mat& ref = options.background ? vectorRef : prevLuma;
+        frameVectors.clear();
+        if (!lighting) vectorEstimator.estimate(cells.data(), cell * cell / kBlobCellFill, luma, ref, frameVectors);
+        flow.add(frameVectors);
+
+        // curLuma is rebuilt every frame in background mode, so its buffer
+        // can simply change places with the copy
+        if (options.background)
+        {
+            if (direct) frame.copyTo(vectorRef);
+            else        cv::swap(vectorRef, curLuma);
+        }
+    }
+    if (options.blobs)
+    {
+        blobExtractor.extract(cells.data(), cell * cell / kBlobCellFill, kBlobMinCells, frameBlobs);
+        if (lighting) frameBlobs.clear();
+    }
+    std::fill(cells.begin(), cells.end(), (uint16_t)0);
+}
+
+void MotionDetector::fitHeatmap(Size plane)
+{
+    const int cols = options.heatmapCols, rows = options.heatmapRows;
+    heatPlane = plane;
+
+    // Inner edges on 16-column boundaries when tiles are that wide, so the
+    // row kernels run whole vectors in every tile instead of a scalar tail
+    // per tile; narrower tiles (small or decimated planes) keep exact edges
+    const bool aligned = plane.width / cols >= 16;
+    tileX.assign((size_t)cols + 1, plane.width);
+    tileX[0] = 0;
+    for (int t = 1; t < cols; t++)
+    {
+        const int x = t * plane.width / cols;
+        tileX[t] = std::max(tileX[t - 1], std::min(plane.width, aligned ? (x + 8) & ~15 : x));
+    }
+
+    // A grid finer than the plane leaves tiles without pixels of their own;
+    // they report the tile covering their position (the one the next pixel
+    // column or row lands in)
+    tileSource.resize((size_t)cols * rows);
+    for (int r = 0; r < rows; r++)
+    {
+        const int y = std::min(plane.height - 1, (r * plane.height + rows - 1) / rows);
+        const int sr = y * rows / plane.height;
+        for (int t = 0; t < cols; t++)
+        {
+            const int x = std::min(plane.width - 1, tileX[t]);
+            int st = t;
+            while (st > 0 && tileX[st] > x) st--;
+            while (st + 1 < cols && tileX[st + 1] <= x) st++;
+            tileSource[(size_t)r * cols + t] = sr * cols + st;
+        }
+    }
+
+    heat.cols = cols;
+    heat.rows = rows;
+    heat.frames = 0;
+    heat.changed.assign((size_t)cols * rows, 0);
+    heat.active.assign((size_t)cols * rows, 0);
+    for (int y = 0; y < plane.height; y++)
+    {
+        uint32_t* cells = heat.active.data() + (size_t)(y * rows / plane.height) * cols;
+        forEachSegment(y, plane.width, [&](int x0, int x1, int t) { cells[t] += (uint32_t)(x1 - x0); });
+    }
+}
+
+MotionHeatmap MotionDetector::takeHeatmap()
+{
+    MotionHeatmap out = heat;
+    for (size_t i = 0; i < tileSource.size(); i++)
+    {
+        const size_t src = (size_t)tileSource[i];
+        if (src == i) continue;
+        out.changed[i] = heat.changed[src];
+        out.active[i] = heat.active[src];
+    }
+    heat.frames = 0;
+    std::fill(heat.changed.begin(), heat.changed.end(), (uint64_t)0);
+    return out;
+}
+
+MotionWindowStats MotionDetector::takeWindowStats()
+{
+    MotionWindowStats out = windowStats;
+    windowStats.clear();
+    return out;
+}
+
+MotionFlowStats MotionDetector::takeFlow()
+{
+    MotionFlowStats out = flow;
+    flow.clear();
+    return out;
+}
+
+int MotionDetector::activePixels(Size plane) const
+{
+    return mask.empty() ? plane.area() : mask.activePixels();
+}
+
+void MotionDetector::reset(const Mat& frame)
+{
+    Size plane = planeSize(frame.size());
+    fitPlane(plane);
+    if (options.background)
+    {
+        // A restored checkpoint is the better baseline than a single frame
+        if (!(restored && background.size() == plane))
+        {
+            curLuma.create(plane.height, plane.width, CV_8UC1);
+            convertRows(frame, curLuma, 0, plane.height, bandState[0]);
+            background.reset(curLuma);
+        }
+        restored = false;
+    }
+    else
+    {
+        prevLuma.create(plane.height, plane.width, CV_8UC1);
+        convertRows(frame, prevLuma, 0, plane.height, bandState[0]);
+    }
+
+    latched = false;
+    baselineStale = false;
+    frameBlobs.clear();
+    frameVectors.clear();
+    vectorRef.release();
+}
+
+MotionResult MotionDetector::process(const Mat& frame)
+{
+    MotionResult res;
+
+    const Size plane = planeSize(frame.size());
+    if (!hasBaseline() || baselineSize() != plane)
+    {
+        reset(frame);
+        return res;
+    }
+    restored = false;
+    fitPlane(plane);
+
+    if (options.decisionMode)
+        return processDecision(frame);
+
+    curLuma.create(plane.height, plane.width, CV_8UC1);
+    int raw = 0;
+    res.changed = diffBands(frame, plane, raw);
+    res.total = activePixels(plane);
+    res.ratio = (res.total > 0) ? (double)res.changed / (double)res.total : 0.0;
+    res.motion = (res.ratio >= motionRatio);
+    res.rawChanged = options.lighting ? raw : res.changed;
+    res.lighting = !res.motion && res.total > 0 && (double)res.rawChanged / (double)res.total >= motionRatio;
+    if (heatmapOn()) heat.frames++;
+    if (options.ratioStats) windowStats.add(res.ratio, res.motion);
+    if (cellsOn()) finishCells(frame, res.lighting);
+
+    // Current luma becomes the baseline; the old baseline buffer is reused next
+    // tick. (The background model has learned this frame in the same pass.)
+    if (!options.background) cv::swap(prevLuma, curLuma);
+
+    return res;
+}
+
+// ------------------------------------------------------------
+// Decision mode
+// ------------------------------------------------------------
+MotionResult MotionDetector::processDecision(const Mat& frame)
+{
+    MotionResult res;
+    const Size plane = planeSize(frame.size());
+    res.total = activePixels(plane);
+
+    // Already latched this second: the CSV answer cannot change, so do nothing.
+    // The baseline is rebuilt once in rollWindow(); a background model just
+    // skips learning these frames.
+    if (latched)
+    {
+        res.motion = true;
+        res.latched = true;
+        res.partial = true;
+        baselineStale = !options.background;
+        frameBlobs.clear();
+        return res;
+    }
+
+    curLuma.create(plane.height, plane.width, CV_8UC1);
+
+    const int needed = pixelsNeeded(motionRatio, res.total);
+    const int tile = std::max(1, options.tileRows);
+    Band& band = bandState[0];
+    band.rawChanged = 0;
+    band.heatCells = heat.changed.data();
+    lastBands = 1;
+
+    int row = 0;
+    while (row < plane.height)
+    {
+        int end = std::min(plane.height, row + tile);
+        res.changed += diffRows(frame, row, end, band);
+        row = end;
+
+        // Reached: this frame is motion, and so is the whole second.
+        if (res.changed >= needed)
+            break;
+
+        // Unreachable: even if every remaining pixel changed we'd stay below.
+        int remaining = mask.empty() ? (plane.height - row) * plane.width
+                                     : res.total - mask.activeRowsBefore(row);
+        if (res.changed + remaining < needed)
+            break;
+    }
+
+    res.partial = (row < plane.height);
+    if (heatmapOn()) heat.frames++;
+    res.ratio = (res.total > 0) ? (double)res.changed / (double)res.total : 0.0;
+    res.motion = (res.changed >= needed);
+    res.rawChanged = options.lighting ? band.rawChanged : res.changed;
+    res.lighting = !res.motion && res.rawChanged >= needed;
+    if (options.ratioStats) windowStats.add(res.ratio, res.motion);
+
+    if (res.motion)
+    {
+        // Nothing else this second needs pixels; leave the baseline stale.
+        latched = true;
+        baselineStale = !options.background;
+    }
+    else if (options.background)
+    {
+        // Negative early exit: the background still learns the remaining rows,
+        // but they stay out of the count, the heatmap and the blob cells
+        if (row < plane.height) learnRows(frame, row, plane.height, band);
+    }
+    else
+    {
+        if (row < plane.height)
+            convertRows(frame, curLuma, row, plane.height, band);
+        cv::swap(prevLuma, curLuma);
+    }
+
+    // Blobs of the rows looked at
+    if (options.blobs) finishCells(frame, res.lighting);
+    return res;
+}
+
+void MotionDetector::rollWindow(const Mat& frame)
+{
+    if (!options.decisionMode) return;
+
+    if (baselineStale && !frame.empty())
+        reset(frame);
+
+    latched = false;
+    baselineStale = false;
+}
+
+// ------------------------------------------------------------
+// Background checkpoints
+// ------------------------------------------------------------
+bool MotionDetector::saveBackground(const std::string& path) const
+{
+    return options.background && background.save(path);
+}
+
+bool MotionDetector::loadBackground(const std::string& path)
+{
+    if (!options.background || !background.load(path)) return false;
+    restored = true;
+    return true;
+}
+
+// ------------------------------------------------------------
+// Heatmap formatting
+// ------------------------------------------------------------
+std::string formatHeatmapCells(const MotionHeatmap& h)
+{
+    std::string out;
+    out.reserve(h.changed.size() * 4);
+    for (size_t i = 0; i < h.changed.size(); i++)
+    {
+        const double pixels = (double)h.active[i] * (double)h.frames;
+        const long permille = (pixels > 0.0) ? std::lround(1000.0 * (double)h.changed[i] / pixels) : 0;
+        if (i > 0) out += ',';
+        out += std::to_string(permille);
+    }
+    return out;
+}
+
+std::string heatmapColumns(int cols, int rows)
+{
+    std::string out;
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c < cols; c++)
+        {
+            if (r > 0 || c > 0) out += ',';
+            out += "r" + std::to_string(r) + "c" + std::to_string(c);
+        }
+    return out;
+}
@@ -0,0 +1,356 @@
+#pragma once
+
+// Per-camera frame-differencing motion detector shared by Programs 1-3.
+
+#include "background_model.hpp"
+#include "motion_blobs.hpp"
+#include "motion_kernel.hpp"
+#include "motion_stats.hpp"
+#include "motion_vectors.hpp"
+#include "roi_mask.hpp"
+#include "worker_pool.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Detector switches (see run_options.hpp for the command-line side).
+struct DetectorOptions
+{
+    // Decision mode: the per-second CSV only needs "did ratio >= MOTION_RATIO
+    // happen at least once". Work through the frame in tiles and stop once the
+    // answer for this frame is known, and skip detection entirely once the
+    // current second is already latched as motion.
+    bool decisionMode = false;
+
+    // Tile height (rows) between early-exit checks in decision mode.
+    int tileRows = 16;
+
+    // Multi-resolution mode: detect on a box-filtered luma plane at 1/N width
+    // and height (1 = full resolution, or 2, 4, 8). MOTION_RATIO applies to the
+    // decimated plane.
+    int decimation = 1;
+
+    // Background mode: compare each frame against a running average of past
+    // frames (background_model.hpp) instead of the previous frame, so slow
+    // movers keep standing out and sensor noise is averaged out of the baseline.
+    bool background = false;
+
+    // Fraction of each new frame blended into the background (0.001 .. 0.5).
+    double learningRate = 0.02;
+
+    // Background mode: directory the programs load each camera's model from at
+    // start and save it to at exit (empty = no checkpoints).
+    std::string backgroundStateDir;
+
+    // Region file (roi_mask.hpp): the programs load it at start and give each
+    // camera its polygons with setRegions() (empty = whole frame).
+    std::string roiFile;
+
+    // Heatmap: also count changed pixels per tile of a heatmapCols x
+    // heatmapRows grid over the plane, in the same pass (0 = off). Read with
+    // takeHeatmap().
+    int heatmapCols = 0;
+    int heatmapRows = 0;
+
+    // Blobs: also count changed pixels per blobCell x blobCell cell of the
+    // plane (8 or 16) and group the busy cells into blobs (motion_blobs.hpp),
+    // read with blobs() after each frame.
+    bool blobs = false;
+    int blobCell = 8;
+
+    // Lighting compensation: measure each band of rows' luma gain against the
+    // baseline in the same pass and, where it moved, count the band again
+    // against the baseline scaled by that gain. A frame that only reaches
+    // MOTION_RATIO before compensation is a lighting change, not motion.
+    bool lighting = false;
+
+    // Ratio statistics: fold every detected frame's changed ratio into a
+    // MotionWindowStats (count, motion frames, mean, max, p95), read per
+    // second with takeWindowStats().
+    bool ratioStats = false;
+
+    // Motion vectors: match every cell that is on (blobCell x blobCell, as
+    // for blobs) against the previous plane within +/- vectorRange plane
+    // pixels (motion_vectors.hpp), read with vectors() after each frame and
+    // per second with takeFlow(). Not in decision mode, which stops passes
+    // short and leaves the previous plane stale.
+    bool vectors = false;
+    int vectorRange = 8;
+
+    // Row-band threads: the programs give each detector a WorkerPool of this
+    // many threads (setPool) and every frame's rows are split into bands that
+    // run on it (1 = serial, 0 = one per hardware thread; MotionEngine caps
+    // it at the cores divided among its cameras).
+    int threads = 1;
+};
+
+// Result of one detection tick.
+struct MotionResult
+{
+    int    changed = 0;    // pixels whose luma moved by more than DIFF_THRESH
+    int    total = 0;      // pixels considered (the active pixels with a region mask)
+    double ratio = 0.0;    // changed / total
+    bool   motion = false; // ratio >= MOTION_RATIO
+
+    // Decision mode only: `changed` is a lower bound because the pass stopped
+    // early (or, when `latched`, no pixels were looked at this tick).
+    bool   partial = false;
+    bool   latched = false;
+
+    // Lighting compensation only: `changed` is the compensated count and
+    // `rawChanged` the plain one (equal without compensation). `lighting`:
+    // the plain count reached MOTION_RATIO, the compensated one did not.
+    int    rawChanged = 0;
+    bool   lighting = false;
+};
+
+// Changed pixels per tile, summed over the frames detected since the last
+// takeHeatmap(). Tile (c, r) is cell r * cols + c; `active` holds its pixels
+// per frame (inside the region mask), so its changed fraction is
+// changed / (active * frames). Tile edges are fractions of the plane width
+// and height, rounded to 16 columns.
+struct MotionHeatmap
+{
+    int cols = 0;
+    int rows = 0;
+    int frames = 0;                // frames whose pixels were counted
+    std::vector<uint64_t> changed; // cols * rows, row-major
+    std::vector<uint32_t> active;
+
+    bool empty() const { return changed.empty(); }
+};
+
+// ============================================================
+// MotionDetector
+// ============================================================
+//
+// Same decision as the original cvtColor/absdiff/threshold/countNonZero chain,
+// but done in one fused pass (motion_kernel.hpp), and the previous-frame luma
+// is swapped with the current one instead of being clone()'d every tick.
+// After the first frame no allocations happen as long as the size is stable.
+//
+// With regions set (roi_mask.hpp) only the active spans of each row are
+// converted, diffed and counted, and MOTION_RATIO is measured against the
+// active pixel count.
+//
+// With options.background the baseline is a BackgroundModel instead of the
+// previous frame; the frame's luma is built in short row bands and fed to the
+// model while it is still in cache.
+//
+// With a heatmap grid each row is handed to the kernels one tile at a time and
+// the per-tile counts land in the grid; the global count is their sum, so the
+// grid costs a few extra kernel calls per row and no extra pass. In decision
+// mode the grid only holds what the shortened passes looked at (a lower bound;
+// latched frames add nothing).
+//
+// With blobs on, each band of rows is compared once more per cell right after
+// the fused pass, while the band is in cache, and the cells that are at least
+// a quarter changed are grouped into blobs.
+//
+// With motion vectors on, the cells are counted the same way, and after the
+// bands every cell that is on is block-matched against the previous plane
+// (in background mode a copy of it is kept for this). Near a region edge the
+// search may read plane pixels outside the regions, which hold older frames.
+//
+// With lighting compensation each band's luma total is compared with its
+// baseline's right after the fused pass. Lights, clouds and auto exposure
+// scale a whole band's luma; when the ratio moved by more than ~3% the band is
+// counted again against the baseline times that gain, and the smaller count
+// stands. A band's own gain also follows uneven light (a lamp on one side, a
+// bright sky above), at the cost of damping an object that fills most of a
+// band. The heatmap and the blob cells count plain changes; a lighting frame
+// reports no blobs.
+//
+// With a pool set, a frame's rows are split into bands that run on the pool
+// and their counts are added up at the end. The band count follows the frame
+// size and the pool size (each band gets at least 128K pixels), band edges
+// fall on 16-row boundaries so blob cells and lighting bands never straddle
+// two of them, and every band keeps its scratch and partial counts to itself;
+// the result is the same as the serial pass. Decision mode stays serial: its
+// tiles are too short to share, and it stops early anyway.
+//
+class MotionDetector
+{
+public:
+    MotionDetector(int diffThresh, double motionRatio, const DetectorOptions& options = DetectorOptions());
+
+    // Start a new baseline from this frame (BGR or gray). A background loaded
+    // with loadBackground() and not used yet is kept if its size fits.
+    void reset(const cv::Mat& frame);
+
+    bool hasBaseline() const { return options.background ? !background.empty() : !prevLuma.empty(); }
+
+    // Compare frame against the baseline, then make it the new baseline.
+    // Without a baseline (or after a size change) this just resets.
+    MotionResult process(const cv::Mat& frame);
+
+    // Call when the per-second window closes, with the last frame of that
+    // window. Clears the decision-mode latch and, if the baseline was left
+    // stale while latched, rebuilds it from `frame` so the next tick compares
+    // against exactly the frame it would have in full mode.
+    void rollWindow(const cv::Mat& frame);
+
+    // Size of the plane detection runs on (frame size / decimation).
+    cv::Size planeSize(cv::Size frameSize) const;
+
+    // 1, 2, 4 or 8 (options.decimation after validation).
+    int decimation() const { return options.decimation; }
+
+    // Detection regions (include / exclude polygons; empty = whole frame).
+    // Compiled into row spans for the plane size on the next frame.
+    void setRegions(std::vector<RoiPolygon> polygons);
+    const RoiMask& regionMask() const { return mask; }
+
+    // Background mode checkpoints (see BackgroundModel). loadBackground()
+    // takes effect on the next frame of the model's size.
+    bool saveBackground(const std::string& path) const;
+    bool loadBackground(const std::string& path);
+    const BackgroundModel& backgroundModel() const { return background; }
+
+    // Row-band pool (not owned, outlives the detector; null = serial). A pool
+    // runs one job at a time, so detectors sharing one must take turns.
+    void setPool(WorkerPool* pool) { bandPool = pool; }
+
+    // Bands the last frame was split into (1 = serial).
+    int bands() const { return lastBands; }
+
+    // Heatmap accumulated since the last call (empty when options.heatmapCols
+    // is 0 or no frame was detected yet); starts the next one. When the grid
+    // is finer than the plane, tiles without plane pixels of their own repeat
+    // the tile covering them, so the cells add up to more than the frames.
+    MotionHeatmap takeHeatmap();
+
+    // Ratio statistics of the frames detected since the last call (empty when
+    // options.ratioStats is off); starts the next window. In decision mode
+    // latched frames are left out and a shortened pass adds its lower bound.
+    MotionWindowStats takeWindowStats();
+
+    // Blobs of the last processed frame, largest first (empty when
+    // options.blobs is off, and on a reset, latched or lighting frame),
+    // whether or not the frame reached MOTION_RATIO. Boxes and centroids are
+    // in frame pixels.
+    const std::vector<MotionBlob>& blobs() const { return frameBlobs; }
+
+    // Motion vectors of the last processed frame (empty when options.vectors
+    // is off, on a reset or lighting frame, and for the first frame of a
+    // background baseline). Positions and shifts are in frame pixels.
+    const std::vector<MotionVector>& vectors() const { return frameVectors; }
+
+    // Vectors of the frames detected since the last call, by direction
+    // (empty when options.vectors is off); starts the next window.
+    MotionFlowStats takeFlow();
+
+private:
+    // Scratch and partial counts of one row band. Bands only touch their own
+    // entry; the alignment keeps neighbouring entries off each other's cache
+    // lines.
+    struct alignas(64) Band
+    {
+        motion::DecimationScratch scratch;
+        std::vector<uint64_t> heat;      // partial heatmap cells (bands after the first)
+        uint64_t* heatCells = nullptr;   // where this band's tile counts go
+        int changed = 0;
+        int rawChanged = 0;              // lighting: the plain count
+    };
+
+    MotionResult processDecision(const cv::Mat& frame);
+
+    // Whole plane: rows split into bands on the pool (or one serial band).
+    // Returns the count; `raw` gets the plain count.
+    int  diffBands(const cv::Mat& frame, cv::Size plane, int& raw);
+    int  bandCount(cv::Size plane) const;
+
+    // Plane rows [r0, r1): frame -> dst, or frame -> curLuma diffed against prevLuma.
+    void convertRows(const cv::Mat& frame, cv::Mat& dst, int r0, int r1, Band& band);
+    int  diffRows(const cv::Mat& frame, int r0, int r1, Band& band);
+    int  diffPlaneRows(const cv::Mat& frame, int r0, int r1, Band& band);
+    int  backgroundRows(const cv::Mat& frame, int r0, int r1, Band& band);
+    // Background learns rows [r0, r1) without counting them anywhere (decision mode's skipped rows).
+    void learnRows(const cv::Mat& frame, int r0, int r1, Band& band);
+    void fitPlane(cv::Size plane);
+    void fitHeatmap(cv::Size plane);
+    void fitBlobs(cv::Size plane);
+    void finishCells(const cv::Mat& frame, bool lighting);
+    int  activePixels(cv::Size plane) const;
+    bool heatmapOn() const { return options.heatmapCols > 0; }
+    bool cellsOn() const { return options.blobs || options.vectors; }
+
+    // Blob / vector cells of rows [r0, r1) of `luma` (the frame's plane) against the
+    // baseline, before the background learns them.
+    void countCells(const cv::Mat& luma, int r0, int r1);
+
+    // Lighting: changed pixels of rows [r0, r1) of `luma` against the
+    // baseline scaled by their gain, or -1 when the gain hardly moved (the
+    // plain count stands). Call before the background learns the rows.
+    int compensatedRows(const cv::Mat& luma, int r0, int r1) const;
+
+    // Count a band keeps with lighting compensation; adds `raw` to its rawChanged.
+    int keepCompensated(int raw, int compensated, Band& band);
+
+    // Active pieces of plane row y (mask spans, or the whole row), cut at the
+    // heatmap's tile edges: visit(x0, x1, tileColumn).
+    template <typename Visit>
+    void forEachSegment(int y, int width, Visit visit) const;
+
+    // Sum of count(y, x0, x1) over the segments of rows [r0, r1), also added
+    // to the band's heatmap cells.
+    template <typename Count>
+    int countSegments(int r0, int r1, int width, Band& band, Count count);
+    cv::Size baselineSize() const { return options.background ? background.size() : prevLuma.size(); }
+
+    int    diffThresh;
+    double motionRatio;
+    DetectorOptions options;
+
+    cv::Mat prevLuma; // baseline
+    cv::Mat curLuma;  // scratch, swapped with prevLuma after every tick
+
+    // Row bands ([0] also runs the serial paths)
+    std::vector<Band> bandState;
+    WorkerPool* bandPool = nullptr;
+    int lastBands = 1;
+
+    // Region mask
+    std::vector<RoiPolygon> regions;
+    RoiMask mask; // empty without regions
+
+    // Heatmap state
+    MotionHeatmap heat;
+    std::vector<int> tileX;      // cols + 1 tile edges
+    std::vector<int> tileSource; // cols * rows: tile each one reports (itself unless it has no pixels)
+    cv::Size heatPlane;          // plane the grid was laid out for
+
+    // Ratio statistics of the current window
+    MotionWindowStats windowStats;
+
+    // Blob state
+    BlobExtractor blobExtractor;
+    std::vector<uint16_t> cells; // changed pixels per blob cell, this frame
+    std::vector<MotionBlob> frameBlobs;
+    int cellShift = 3;
+    cv::Size blobPlane;
+
+    // Motion vector state
+    MotionVectorEstimator vectorEstimator;
+    std::vector<MotionVector> frameVectors;
+    MotionFlowStats flow;
+    cv::Mat vectorRef; // background mode: the previous frame's plane
+
+    // Background mode state
+    BackgroundModel background;
+    bool restored = false; // loaded from a checkpoint, not used yet
+
+    // Decision mode state
+    bool latched = false;       // motion already seen in the current window
+    bool baselineStale = false; // prevLuma no longer matches the previous frame
+};
+
+// Heatmap cells as comma-separated per-mille changed fractions, row-major
+// ("0,0,12,..."); tiles without active pixels read 0.
+std::string formatHeatmapCells(const MotionHeatmap& h);
+
+// Matching CSV column names: "r0c0,r0c1,...".
+std::string heatmapColumns(int cols, int rows);
@@ -0,0 +1,442 @@
+#include "motion_engine.hpp"
+
+#include "mjpeg.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+using Clock = chrono::steady_clock;
+
+// A packet's luma plane comes out of the JPEG decoder at 1/decimation
+// already; its detector must not decimate again.
+DetectorOptions predecimated(DetectorOptions options)
+{
+    options.decimation = 1;
+    return options;
+}
+} // namespace
+
+// ------------------------------------------------------------
+// CameraPipeline
+// ------------------------------------------------------------
+CameraPipeline::CameraPipeline(string name, FrameReader reader, int diffThresh, double motionRatio,
+                               const DetectorOptions& detectorOptions, const RecorderOptions& recorderOptions,
+                               const WriterOptions& writerOptions, const EventOptions& eventOptions, int eventFourcc,
+                               function<string()> nextEventPath, PixelFormat format)
+    : cameraName(std::move(name)),
+      reader(std::move(reader)),
+      format(format),
+      det(diffThresh, motionRatio, detectorOptions),
+      lumaDet(diffThresh, motionRatio, predecimated(detectorOptions)),
+      rec(recorderOptions, writerOptions),
+      ev(eventOptions, recorderOptions, writerOptions, eventFourcc, std::move(nextEventPath))
+{
+}
+
+void CameraPipeline::setBandThreads(int threads)
+{
+    // Per camera, since cameras step concurrently on the engine's pool
+    if (threads == bandThreads()) return;
+    det.setPool(nullptr);
+    lumaDet.setPool(nullptr);
+    bandPool.reset();
+    if (threads < 2) return;
+    bandPool = make_unique<WorkerPool>(threads);
+    det.setPool(bandPool.get());
+    lumaDet.setPool(bandPool.get());
+}
+
+void CameraPipeline::setRegions(const vector<RoiPolygon>& polygons)
+{
+    det.setRegions(polygons);
+    lumaDet.setRegions(polygons);
+}
+
+MotionHeatmap CameraPipeline::takeHeatmap()
+{
+    // A camera delivers packets or images, not both: keep whichever detector ran
+    MotionHeatmap images = det.takeHeatmap();
+    MotionHeatmap packets = lumaDet.takeHeatmap();
+    return (packets.frames > images.frames) ? packets : images;
+}
+
+MotionWindowStats CameraPipeline::takeWindowStats()
+{
+    MotionWindowStats stats = det.takeWindowStats();
+    stats.merge(lumaDet.takeWindowStats());
+    return stats;
+}
+
+MotionFlowStats CameraPipeline::takeFlow()
+{
+    // A packet's luma plane is already 1/decimation of the frame
+    MotionFlowStats flow = det.takeFlow();
+    flow.merge(lumaDet.takeFlow(), det.decimation());
+    return flow;
+}
+
+void CameraPipeline::takeBlobs(vector<TimedBlob>& out)
+{
+    out.clear();
+    std::swap(out, blobLog);
+}
+
+bool CameraPipeline::takeMotion()
+{
+    bool m = motionThisSecond;
+    motionThisSecond = false;
+    return m;
+}
+
+bool CameraPipeline::takeLighting()
+{
+    bool l = lightingThisSecond;
+    lightingThisSecond = false;
+    return l;
+}
+
+void CameraPipeline::step(bool sensing, int logSecond)
+{
+    const auto t0 = Clock::now();
+    steps++;
+
+    Mat f;
+    Clock::time_point t{};
+    bool isNew = false;
+    if (!reader(f, t, isNew) || f.empty())
+    {
+        shutDown();
+        return;
+    }
+
+    latest = f;
+    latestTime = t;
+    latestIsNew = isNew;
+    latestIsPacket = isJpegPacket(f);
+
+    // Seen it already: re-encoding it would stretch the video and diffing it
+    // against itself can't find motion.
+    if (!isNew)
+    {
+        duplicates++;
+        return;
+    }
+    newFrames++;
+
+    // Every frame feeds the recorder so the camera rate keeps being measured;
+    // while recording, frames are tagged with the CSV second they're counted in.
+    if (latestIsPacket)
+    {
+        // One copy of the compressed bytes, shared by the recorder and the
+        // event pre-roll; neither decodes it
+        const EncodedFrame packet = make_shared<const vector<uint8_t>>(latest.ptr<uchar>(0), latest.ptr<uchar>(0) + latest.cols);
+        rec.addPacket(packet, t, logSecond);
+        ev.addPacket(packet, t, logSecond);
+    }
+    else
+    {
+        // Raw YUV goes as is; whoever needs BGR converts it
+        rec.addFrame(latest, t, logSecond, format);
+        ev.addFrame(latest, t, logSecond, format); // pre-roll / segments (no-op when off)
+    }
+
+    if (sensing)
+    {
+        const auto p0 = Clock::now();
+        const Mat plane = detectionInput();
+        planeMsTotal += chrono::duration<double, milli>(Clock::now() - p0).count();
+        detected++;
+
+        const MotionResult res = detector().process(plane);
+        if (res.motion)
+        {
+            motionThisSecond = true;
+            motionFrames++;
+            ev.trigger(t);
+        }
+        if (res.lighting)
+        {
+            lightingThisSecond = true;
+            lightingFrames++;
+        }
+
+        MotionEvent e;
+        if (eventBus && hysteresis->update(res, t, e)) eventBus->publish(e);
+
+        // A packet's luma plane is already 1/decimation of the frame
+        const int scale = latestIsPacket ? det.decimation() : 1;
+        for (const MotionBlob& b : detector().blobs())
+        {
+            TimedBlob tb{t, b};
+            tb.blob.box = Rect(b.box.x * scale, b.box.y * scale, b.box.width * scale, b.box.height * scale);
+            tb.blob.centroid = b.centroid * (float)scale;
+            blobLog.push_back(tb);
+        }
+    }
+
+    const double ms = chrono::duration<double, milli>(Clock::now() - t0).count();
+    msTotal += ms;
+    msMax = max(msMax, ms);
+}
+
+Mat CameraPipeline::detectionInput()
+{
+    // BGR goes in as is; NV12's Y plane is a header on the frame
+    if (!latestIsPacket && format != PixelFormat::YUYV)
+        return lumaPlane(latest, format, luma);
+
+    if (lumaTime != latestTime || luma.empty())
+    {
+        if (latestIsPacket && !decodeJpegLuma(latest, det.decimation(), luma)) luma.release();
+        if (!latestIsPacket) lumaPlane(latest, format, luma);
+        lumaTime = latestTime;
+    }
+    return luma;
+}
+
+const Mat& CameraPipeline::preview()
+{
+    if (!latestIsPacket && format == PixelFormat::BGR) return latest;
+
+    if (previewTime != latestTime || previewImage.empty())
+    {
+        if (latestIsPacket && !decodeJpegColor(latest, 2, previewImage)) previewImage.release();
+        if (!latestIsPacket) toBgr(latest, format, previewImage);
+        previewTime = latestTime;
+    }
+    return previewImage;
+}
+
+Size CameraPipeline::frameSize() const
+{
+    if (!latestIsPacket) return imageSize(latest, format);
+
+    Size size;
+    int components = 0;
+    jpegInfo(latest.ptr<uchar>(0), (size_t)latest.cols, size, components);
+    return size;
+}
+
+bool CameraPipeline::isColor() const
+{
+    if (!latestIsPacket) return latest.type() == CV_8UC3 || format != PixelFormat::BGR;
+
+    Size size;
+    int components = 3;
+    jpegInfo(latest.ptr<uchar>(0), (size_t)latest.cols, size, components);
+    return components != 1;
+}
+
+void CameraPipeline::shutDown()
+{
+    isAlive = false;
+    latestIsNew = false;
+    latestIsPacket = false;
+    latest.release();
+    luma.release();
+    previewImage.release();
+    rec.stop();
+    ev.stop();
+
+    MotionEvent e;
+    if (eventBus && hysteresis->finish(Clock::now(), e)) eventBus->publish(e);
+}
+
+PipelineStats CameraPipeline::stats() const
+{
+    PipelineStats s;
+    s.steps = steps;
+    s.newFrames = newFrames;
+    s.duplicates = duplicates;
+    s.motionFrames = motionFrames;
+    s.lightingFrames = lightingFrames;
+    s.stepMsAvg = (newFrames > 0) ? msTotal / (double)newFrames : 0.0;
+    s.stepMsMax = msMax;
+    s.savedMs = (double)duplicates * s.stepMsAvg;
+    s.planeMsAvg = (detected > 0) ? planeMsTotal / (double)detected : 0.0;
+    return s;
+}
+
+// ------------------------------------------------------------
+// MotionEngine
+// ------------------------------------------------------------
+MotionEngine::MotionEngine(int diffThresh, double motionRatio, const EngineOptions& engineOptions,
+                           const DetectorOptions& detectorOptions, const RecorderOptions& recorderOptions,
+                           const WriterOptions& writerOptions, const EventOptions& eventOptions)
+    : diffThresh(diffThresh),
+      motionRatio(motionRatio),
+      detectorOptions(detectorOptions),
+      recorderOptions(recorderOptions),
+      writerOptions(writerOptions),
+      eventOptions(eventOptions),
+      pool(engineOptions.threads),
+      toleranceMs(engineOptions.syncToleranceMs),
+      skew(engineOptions.syncToleranceMs)
+{
+}
+
+CameraPipeline& MotionEngine::addCamera(const string& name, FrameReader reader, function<string()> nextEventPath,
+                                        PixelFormat format)
+{
+    const int eventFourcc = writerOptions.passthrough ? VideoWriter::fourcc('M', 'J', 'P', 'G')
+                                                      : VideoWriter::fourcc('m', 'p', '4', 'v');
+    pipelines.emplace_back(new CameraPipeline(name, std::move(reader), diffThresh, motionRatio, detectorOptions,
+                                              recorderOptions, writerOptions, eventOptions, eventFourcc,
+                                              std::move(nextEventPath), format));
+    skew.resize(pipelines.size());
+    fitBandPools();
+    if (eventBus)
+    {
+        pipelines.back()->hysteresis = make_unique<MotionHysteresis>((int)pipelines.size() - 1, motionRatio,
+                                                                     motionEventOptions);
+        pipelines.back()->eventBus = eventBus;
+    }
+    return *pipelines.back();
+}
+
+int MotionEngine::bandThreads() const
+{
+    if (detectorOptions.threads == 1 || pipelines.empty()) return 1;
+
+    // Cameras step concurrently, so the cores are split between their pools
+    const int cores = (int)max(1u, thread::hardware_concurrency());
+    const int share = max(1, cores / (int)pipelines.size());
+    return detectorOptions.threads == 0 ? share : min(detectorOptions.threads, share);
+}
+
+void MotionEngine::fitBandPools()
+{
+    const int threads = bandThreads();
+    for (auto& p : pipelines) p->setBandThreads(threads);
+}
+
+size_t MotionEngine::aliveCount() const
+{
+    return (size_t)count_if(pipelines.begin(), pipelines.end(),
+                            [](const unique_ptr<CameraPipeline>& p) { return p->alive(); });
+}
+
+bool MotionEngine::waitForFrames(chrono::milliseconds timeout)
+{
+    const uint64_t before = seenGeneration;
+    seenGeneration = frameSignal.wait(before, timeout);
+    return seenGeneration != before;
+}
+
+size_t MotionEngine::step(bool sensing, int logSecond)
+{
+    pool.parallelFor(pipelines.size(), [&](size_t i) {
+        if (pipelines[i]->isAlive) pipelines[i]->step(sensing, logSecond);
+    });
+
+    // Pair the new frames across cameras by capture time
+    size_t fresh = 0;
+    for (size_t i = 0; i < pipelines.size(); i++)
+    {
+        const CameraPipeline& p = *pipelines[i];
+        if (!p.isAlive)
+        {
+            skew.deactivate(i);
+        }
+        else if (p.latestIsNew)
+        {
+            skew.add(i, p.latestTime);
+            fresh++;
+        }
+    }
+    return fresh;
+}
+
+void MotionEngine::resetDetectors()
+{
+    pool.parallelFor(pipelines.size(), [&](size_t i) {
+        CameraPipeline& p = *pipelines[i];
+        if (p.isAlive && !p.latest.empty())
+        {
+            p.detector().reset(p.detectionInput());
+            p.motionThisSecond = false;
+            p.lightingThisSecond = false;
+            if (p.hysteresis) p.hysteresis->reset();
+        }
+    });
+}
+
+void MotionEngine::rollWindows()
+{
+    pool.parallelFor(pipelines.size(), [&](size_t i) {
+        CameraPipeline& p = *pipelines[i];
+        if (p.isAlive && !p.latest.empty()) p.detector().rollWindow(p.detectionInput());
+    });
+}
+
+size_t MotionEngine::loadBackgrounds(const string& dir)
+{
+    size_t loaded = 0;
+    for (auto& p : pipelines)
+    {
+        const string path = backgroundStatePath(dir, p->name());
+        // Packets and images are detected on planes of the same size
+        const bool ok = p->det.loadBackground(path);
+        p->lumaDet.loadBackground(path);
+        if (ok) loaded++;
+    }
+    return loaded;
+}
+
+size_t MotionEngine::saveBackgrounds(const string& dir)
+{
+    size_t saved = 0;
+    for (auto& p : pipelines)
+        if (p->detector().saveBackground(backgroundStatePath(dir, p->name()))) saved++;
+    return saved;
+}
+
+void MotionEngine::publishMotionEvents(MotionEventBus* bus, const MotionEventOptions& options)
+{
+    eventBus = bus;
+    motionEventOptions = options;
+    for (size_t i = 0; i < pipelines.size(); i++)
+    {
+        CameraPipeline& p = *pipelines[i];
+        p.hysteresis = bus ? make_unique<MotionHysteresis>((int)i, motionRatio, options) : nullptr;
+        p.eventBus = bus;
+    }
+}
+
+void MotionEngine::finishMotionEvents()
+{
+    const auto now = Clock::now();
+    for (auto& p : pipelines)
+    {
+        MotionEvent e;
+        if (p->eventBus && p->hysteresis->finish(now, e)) p->eventBus->publish(e);
+    }
+}
+
+void MotionEngine::stop()
+{
+    for (auto& p : pipelines)
+    {
+        p->ev.stop();
+        p->rec.stop();
+    }
+}
+
+string formatPipelineStats(const PipelineStats& s)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "%llu new frames in %llu steps, %llu motion frames, %.2f ms/frame (max %.2f ms, detection plane %.2f ms), "
+             "%llu duplicates skipped (~%.0f ms CPU saved)",
+             (unsigned long long)s.newFrames, (unsigned long long)s.steps, (unsigned long long)s.motionFrames,
+             s.stepMsAvg, s.stepMsMax, s.planeMsAvg, (unsigned long long)s.duplicates, s.savedMs);
+    string out = buf;
+    if (s.lightingFrames > 0) out += ", " + to_string(s.lightingFrames) + " lighting changes rejected";
+    return out;
+}
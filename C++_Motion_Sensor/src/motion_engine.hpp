@@ -0,0 +1,303 @@
+#pragma once
+
+// N-camera motion sensing: one pipeline per camera, run on a shared pool.
+
+#include "async_video_writer.hpp"
+#include "event_recorder.hpp"
+#include "frame_signal.hpp"
+#include "frame_sync.hpp"
+#include "motion_detector.hpp"
+#include "motion_events.hpp"
+#include "recorder.hpp"
+#include "worker_pool.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Engine switches (see run_options.hpp for the command-line side).
+struct EngineOptions
+{
+    // Worker threads for the per-camera work, counting the main thread.
+    // 0 = one per hardware thread.
+    int threads = 0;
+
+    // Latch all cameras together before each grab() (see CaptureBarrier).
+    bool syncCapture = false;
+
+    // Frames of different cameras at most this far apart form a set (see
+    // SkewTracker); used with or without syncCapture.
+    double syncToleranceMs = 10.0;
+};
+
+// Latest frame of one camera. Sets `isNew` to false when it is the same frame
+// as last time. Returns false once the camera is gone.
+using FrameReader = std::function<bool(cv::Mat& frame, std::chrono::steady_clock::time_point& captureTime, bool& isNew)>;
+
+struct PipelineStats
+{
+    uint64_t steps = 0;        // engine steps this camera took part in
+    uint64_t newFrames = 0;    // steps that brought a new frame (processed once)
+    uint64_t duplicates = 0;   // steps that saw a frame already processed (skipped)
+    uint64_t motionFrames = 0; // frames detected as motion
+    uint64_t lightingFrames = 0; // frames rejected as a lighting change (--lighting)
+    double   stepMsAvg = 0.0;  // per new frame: read + recorder hand-off + detection
+    double   stepMsMax = 0.0;
+    double   planeMsAvg = 0.0; // per detected frame: getting the plane detection runs on (luma decode,
+                               // Y extraction; ~0 for BGR, whose conversion is fused into detection)
+    double   savedMs = 0.0;    // duplicates x stepMsAvg: CPU not spent re-processing
+};
+
+// A blob of one detected frame, stamped with the frame's capture time.
+struct TimedBlob
+{
+    std::chrono::steady_clock::time_point captureTime;
+    MotionBlob blob; // frame pixels
+};
+
+// ============================================================
+// CameraPipeline
+// ============================================================
+//
+// Everything one camera needs: reader -> recorder / event clips -> detector,
+// plus its per-second motion flag. A pipeline is only touched by one engine
+// job at a time, so nothing in here is locked.
+//
+// Each captured frame is processed once: a step that reads the frame it
+// already has (the loop ran faster than this camera) skips the recorder, the
+// event clips and the detector, and only counts a duplicate.
+//
+// A frame that is a JPEG packet (MJPEG passthrough) is never fully decoded:
+// the packet goes to the recorder and the event clips as it is, detection
+// decodes only its luma plane at the detector's decimation (DCT-domain
+// scaling, see mjpeg.hpp), and preview() decodes a half-size image on demand.
+//
+// Raw YUV frames (PixelFormat) are detected on their Y plane; BGR is only
+// made by the consumers that need color: the encoder and event threads, and
+// preview() on loops that draw.
+//
+// With motion events on (MotionEngine::publishMotionEvents), each detected
+// frame also goes through the camera's MotionHysteresis, and a start / end is
+// published from the worker thread that decided it.
+//
+class CameraPipeline
+{
+public:
+    CameraPipeline(std::string name, FrameReader reader, int diffThresh, double motionRatio,
+                   const DetectorOptions& detectorOptions, const RecorderOptions& recorderOptions,
+                   const WriterOptions& writerOptions, const EventOptions& eventOptions, int eventFourcc,
+                   std::function<std::string()> nextEventPath, PixelFormat format = PixelFormat::BGR);
+
+    const std::string& name() const { return cameraName; }
+
+    // False once the reader failed (the camera stays in the CSV as "Offline").
+    bool alive() const { return isAlive; }
+
+    // Latest frame (possibly a JPEG packet or raw YUV) and when it was captured.
+    const cv::Mat& frame() const { return latest; }
+    PixelFormat pixelFormat() const { return format; }
+    std::chrono::steady_clock::time_point captureTime() const { return latestTime; }
+
+    // Image size and color of the latest frame, packets included.
+    cv::Size frameSize() const;
+    bool isColor() const;
+
+    // Latest frame as an image for a preview window; a packet is decoded at
+    // half size and raw YUV converted, once per frame.
+    const cv::Mat& preview();
+
+    // Motion seen since the last takeMotion().
+    bool takeMotion();
+
+    // A lighting change seen since the last takeLighting() (--lighting).
+    bool takeLighting();
+
+    Recorder& recorder() { return rec; }
+    EventRecorder& events() { return ev; }
+    MotionDetector& detector() { return latestIsPacket ? lumaDet : det; }
+
+    // Detection regions for this camera (MotionDetector::setRegions).
+    void setRegions(const std::vector<RoiPolygon>& polygons);
+
+    // Per-tile motion since the last call (MotionDetector::takeHeatmap).
+    MotionHeatmap takeHeatmap();
+
+    // Ratio statistics since the last call (MotionDetector::takeWindowStats).
+    MotionWindowStats takeWindowStats();
+
+    // Motion vectors by direction since the last call (MotionDetector::takeFlow),
+    // in frame pixels.
+    MotionFlowStats takeFlow();
+
+    // Blobs of the frames detected since the last call (options.blobs), in
+    // capture order. `out` is swapped with the internal buffer, so passing
+    // the same vector each time reuses both allocations.
+    void takeBlobs(std::vector<TimedBlob>& out);
+
+    // Stop reading: close the recording and event clip, mark offline.
+    void shutDown();
+
+    PipelineStats stats() const;
+
+private:
+    friend class MotionEngine;
+    void step(bool sensing, int logSecond);
+
+    // Row-band threads of det / lumaDet (1 = serial); set by the engine.
+    void setBandThreads(int threads);
+    int bandThreads() const { return bandPool ? bandPool->size() : 1; }
+
+    // What the detector compares: the latest frame, or its luma plane for a
+    // packet (decoded once per frame) or raw YUV.
+    cv::Mat detectionInput();
+
+    std::string cameraName;
+    FrameReader reader;
+    PixelFormat format;
+    bool isAlive = true;
+
+    cv::Mat latest;
+    std::chrono::steady_clock::time_point latestTime{};
+    bool latestIsNew = false;
+    bool latestIsPacket = false;
+    bool motionThisSecond = false;
+    bool lightingThisSecond = false;
+
+    // Decoded views of the latest packet, and the frame they were decoded from
+    cv::Mat luma;
+    std::chrono::steady_clock::time_point lumaTime{};
+    cv::Mat previewImage;
+    std::chrono::steady_clock::time_point previewTime{};
+
+    std::unique_ptr<WorkerPool> bandPool; // row bands of det / lumaDet (--detect-threads)
+    MotionDetector det;     // image frames
+    MotionDetector lumaDet; // packet luma planes, decoded at det's decimation already
+    std::vector<TimedBlob> blobLog;
+    Recorder rec;
+    EventRecorder ev;
+    std::unique_ptr<MotionHysteresis> hysteresis; // set with eventBus
+    MotionEventBus* eventBus = nullptr;
+
+    uint64_t steps = 0;
+    uint64_t newFrames = 0;
+    uint64_t duplicates = 0;
+    uint64_t motionFrames = 0;
+    uint64_t lightingFrames = 0;
+    double msTotal = 0.0;
+    double msMax = 0.0;
+    double planeMsTotal = 0.0;
+    uint64_t detected = 0;
+};
+
+// ============================================================
+// MotionEngine
+// ============================================================
+//
+// Why this exists:
+// - Program 3 hardcoded two cameras (cam1/cam2, src1/src2, recorder1/2,
+//   detector1/2) and duplicated every block for the second one
+// - The engine keeps a vector of CameraPipelines, so 4-8 cameras are the
+//   same code as one
+// - Each step runs one job per live camera on a fixed WorkerPool sized to the
+//   core count; cameras are independent, so throughput scales with cores
+//   until memory bandwidth runs out
+//
+// Capture threads (CameraStream) and encoder threads (AsyncVideoWriter) stay
+// per camera: they spend their time blocked in the driver / codec, not on a
+// core. The pool runs the CPU work in between.
+//
+class MotionEngine
+{
+public:
+    MotionEngine(int diffThresh, double motionRatio, const EngineOptions& engineOptions,
+                 const DetectorOptions& detectorOptions, const RecorderOptions& recorderOptions,
+                 const WriterOptions& writerOptions, const EventOptions& eventOptions);
+
+    // Add a camera. nextEventPath names its event clips (see EventRecorder);
+    // `format` is the layout its reader delivers (CameraStream::pixelFormat()).
+    CameraPipeline& addCamera(const std::string& name, FrameReader reader,
+                              std::function<std::string()> nextEventPath, PixelFormat format = PixelFormat::BGR);
+
+    size_t size() const { return pipelines.size(); }
+    CameraPipeline& camera(size_t i) { return *pipelines[i]; }
+
+    // Number of cameras still alive.
+    size_t aliveCount() const;
+
+    // Capture threads notify this after every frame (CameraStream::setSignal).
+    FrameSignal& newFrameSignal() { return frameSignal; }
+
+    // Sleep until some camera notified a new frame since the last call, or
+    // `timeout` passes. Returns false on timeout.
+    bool waitForFrames(std::chrono::milliseconds timeout);
+
+    // One pass over every live camera, in parallel: read the latest frame,
+    // hand it to the recorder and event clips (tagged with `logSecond`), and
+    // run detection if `sensing`. Returns how many cameras had a new frame.
+    size_t step(bool sensing, int logSecond);
+
+    // Rebuild every detector's baseline from its latest frame ('m' pressed).
+    void resetDetectors();
+
+    // Per-second window boundary (see MotionDetector::rollWindow).
+    void rollWindows();
+
+    // Publish each camera's motion start / end (MotionHysteresis) to `bus`,
+    // from the worker thread that detected it; MotionEvent::camera is the
+    // camera's index. Covers cameras added later too. Null turns it off.
+    void publishMotionEvents(MotionEventBus* bus, const MotionEventOptions& options);
+
+    // End the events still running (sensor stopping), stamped with their last
+    // moving frame. A camera going offline ends its own.
+    void finishMotionEvents();
+
+    // Background mode checkpoints, one file per camera in `dir`
+    // (backgroundStatePath). Return how many cameras were loaded / saved.
+    size_t loadBackgrounds(const std::string& dir);
+    size_t saveBackgrounds(const std::string& dir);
+
+    // Close every recording and event clip.
+    void stop();
+
+    int threads() const { return pool.size(); }
+
+    // Row-band threads each camera's detector gets (--detect-threads): N, or
+    // one per core for 0, capped at the cores divided among the cameras so
+    // the band pools together never outnumber the cores. 1 = serial.
+    int bandThreads() const;
+
+    // Cross-camera alignment of the frames processed so far.
+    SkewStats skewStats() const { return skew.stats(); }
+    double syncToleranceMs() const { return toleranceMs; }
+
+private:
+    // Resize every camera's band pool to bandThreads() (cameras are added one at a time).
+    void fitBandPools();
+
+    int diffThresh;
+    double motionRatio;
+    DetectorOptions detectorOptions;
+    RecorderOptions recorderOptions;
+    WriterOptions writerOptions;
+    EventOptions eventOptions;
+
+    MotionEventBus* eventBus = nullptr;
+    MotionEventOptions motionEventOptions;
+
+    WorkerPool pool;
+    std::vector<std::unique_ptr<CameraPipeline>> pipelines;
+
+    FrameSignal frameSignal;
+    uint64_t seenGeneration = 0;
+
+    double toleranceMs;
+    SkewTracker skew;
+};
+
+// One-line summary for logs.
+std::string formatPipelineStats(const PipelineStats& s);
@@ -0,0 +1,227 @@
+#include "motion_events.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+namespace
+{
+double secondsBetween(Clock::time_point from, Clock::time_point to)
+{
+    return chrono::duration<double>(to - from).count();
+}
+} // namespace
+
+const char* motionEventName(MotionEventType type)
+{
+    return type == MotionEventType::Start ? "MOTION_START" : "MOTION_END";
+}
+
+// ------------------------------------------------------------
+// MotionHysteresis
+// ------------------------------------------------------------
+
+MotionHysteresis::MotionHysteresis(int camera, double motionRatio, const MotionEventOptions& options)
+    : camera(camera), motionRatio(motionRatio), options(options)
+{
+    this->options.startFrames = max(1, options.startFrames);
+    this->options.endSec = max(0.0, options.endSec);
+    keepRatio = motionRatio * min(1.0, max(0.0, options.keepFraction));
+}
+
+bool MotionHysteresis::update(const MotionResult& res, Clock::time_point captureTime, MotionEvent& out)
+{
+    if (!isActive)
+    {
+        if (!res.motion)
+        {
+            run = 0;
+            return false;
+        }
+        if (run++ == 0) runStart = captureTime;
+        if (run < options.startFrames) return false;
+
+        isActive = true;
+        run = 0;
+        lastMoving = captureTime;
+        out = MotionEvent();
+        out.type = MotionEventType::Start;
+        out.camera = camera;
+        out.time = runStart;
+        out.decidedAt = captureTime;
+        out.ratio = res.ratio;
+        return true;
+    }
+
+    // A frame rejected as a lighting change doesn't keep the event going
+    if (res.motion || (!res.lighting && res.ratio >= keepRatio))
+    {
+        lastMoving = captureTime;
+        return false;
+    }
+    if (secondsBetween(lastMoving, captureTime) < options.endSec) return false;
+
+    isActive = false;
+    out = MotionEvent();
+    out.type = MotionEventType::End;
+    out.camera = camera;
+    out.time = lastMoving;
+    out.decidedAt = captureTime;
+    out.ratio = res.ratio;
+    return true;
+}
+
+bool MotionHysteresis::finish(Clock::time_point now, MotionEvent& out)
+{
+    run = 0;
+    if (!isActive) return false;
+
+    isActive = false;
+    out = MotionEvent();
+    out.type = MotionEventType::End;
+    out.camera = camera;
+    out.time = lastMoving;
+    out.decidedAt = now;
+    return true;
+}
+
+void MotionHysteresis::reset()
+{
+    isActive = false;
+    run = 0;
+}
+
+// ------------------------------------------------------------
+// MotionEventQueue
+// ------------------------------------------------------------
+//
+// Cell i holds seq == position when free for the push at that position, and
+// position + 1 once filled; the pop frees it for the push one lap later.
+
+MotionEventQueue::MotionEventQueue(size_t capacity)
+{
+    size_t n = 2;
+    while (n < capacity) n <<= 1;
+    mask = n - 1;
+    cells.reset(new Cell[n]);
+    for (size_t i = 0; i < n; i++) cells[i].seq.store(i, memory_order_relaxed);
+}
+
+bool MotionEventQueue::push(const MotionEvent& event)
+{
+    uint64_t pos = head.load(memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+        cell = &cells[pos & mask];
+        const int64_t lag = (int64_t)(cell->seq.load(memory_order_acquire) - pos);
+        if (lag == 0)
+        {
+            if (head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+        }
+        else if (lag < 0)
+        {
+            // The cell still holds an event from one lap ago: full
+            droppedCount.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = head.load(memory_order_relaxed);
+        }
+    }
+    cell->event = event;
+    cell->seq.store(pos + 1, memory_order_release);
+    return true;
+}
+
+bool MotionEventQueue::pop(MotionEvent& event)
+{
+    uint64_t pos = tail.load(memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+        cell = &cells[pos & mask];
+        const int64_t lag = (int64_t)(cell->seq.load(memory_order_acquire) - (pos + 1));
+        if (lag == 0)
+        {
+            if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+        }
+        else if (lag < 0)
+        {
+            return false; // empty
+        }
+        else
+        {
+            pos = tail.load(memory_order_relaxed);
+        }
+    }
+    event = cell->event;
+    cell->seq.store(pos + mask + 1, memory_order_release);
+    return true;
+}
+
+// ------------------------------------------------------------
+// MotionEventBus
+// ------------------------------------------------------------
+
+MotionEventBus::MotionEventBus(size_t capacity)
+    : capacity(capacity)
+{
+}
+
+MotionEventQueue& MotionEventBus::subscribe()
+{
+    queues.push_back(make_unique<MotionEventQueue>(capacity));
+    return *queues.back();
+}
+
+void MotionEventBus::publish(MotionEvent event)
+{
+    event.publishedAt = Clock::now();
+    for (auto& q : queues) q->push(event);
+    publishedCount.fetch_add(1, memory_order_relaxed);
+}
+
+// ------------------------------------------------------------
+// Logging
+// ------------------------------------------------------------
+
+void MotionEventStats::add(const MotionEvent& event, Clock::time_point drainedAt)
+{
+    (event.type == MotionEventType::Start ? starts : ends)++;
+    const double ms = max(0.0, secondsBetween(event.decidedAt, drainedAt) * 1000.0);
+    const uint64_t n = starts + ends;
+    latencyMsAvg += (ms - latencyMsAvg) / (double)n;
+    latencyMsMax = max(latencyMsMax, ms);
+}
+
+const char* motionEventColumns()
+{
+    return "Second,Camera,Event,Time,DecidedAt,LatencyMs";
+}
+
+string formatMotionEventRow(const MotionEvent& event, const string& camera, Clock::time_point origin,
+                            Clock::time_point drainedAt)
+{
+    const double t = secondsBetween(origin, event.time);
+    const int second = max(1, (int)floor(t) + 1);
+    char buf[192];
+    snprintf(buf, sizeof(buf), "%d,%s,%s,%.3f,%.3f,%.2f", second, camera.c_str(), motionEventName(event.type), t,
+             secondsBetween(origin, event.decidedAt), max(0.0, secondsBetween(event.decidedAt, drainedAt) * 1000.0));
+    return buf;
+}
+
+string formatMotionEventStats(const MotionEventStats& s)
+{
+    char buf[192];
+    snprintf(buf, sizeof(buf),
+             "%llu starts, %llu ends, trigger-to-event latency avg %.2f ms / max %.2f ms, %llu dropped",
+             (unsigned long long)s.starts, (unsigned long long)s.ends, s.latencyMsAvg, s.latencyMsMax,
+             (unsigned long long)s.dropped);
+    return buf;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+// Sub-second motion start / end events: a debounced per-camera state machine
+// and the lock-free queues its events are drained from.
+
+#include "motion_detector.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Motion event switches (see run_options.hpp for the command-line side).
+struct MotionEventOptions
+{
+    // Log MOTION_START / MOTION_END events to <log>_events.csv.
+    bool enabled = false;
+
+    // Debounce: consecutive motion frames before an event starts. A one-frame
+    // flash is two motion frames against the previous frame (on and off), so
+    // 3 is the least that ignores it.
+    int startFrames = 3;
+
+    // Hold-off: capture-time seconds without a moving frame before it ends.
+    double endSec = 1.0;
+
+    // Hysteresis: while an event runs, a frame still counts as moving at this
+    // fraction of MOTION_RATIO (0..1; 1 = same threshold as the start).
+    double keepFraction = 0.5;
+};
+
+enum class MotionEventType : uint8_t
+{
+    Start,
+    End
+};
+
+// "MOTION_START" / "MOTION_END".
+const char* motionEventName(MotionEventType type);
+
+struct MotionEvent
+{
+    MotionEventType type = MotionEventType::Start;
+    int camera = 0; // index of the camera (0 = Cam1)
+
+    // Start: capture time of the first frame of the run that started it.
+    // End: capture time of the last frame that still counted as moving.
+    std::chrono::steady_clock::time_point time{};
+
+    // Capture time of the frame that decided it (the startFrames-th motion
+    // frame, or the first frame past the hold-off), and when it was published.
+    std::chrono::steady_clock::time_point decidedAt{};
+    std::chrono::steady_clock::time_point publishedAt{};
+
+    double ratio = 0.0; // changed fraction of the deciding frame
+};
+
+// ============================================================
+// MotionHysteresis
+// ============================================================
+//
+// Why this exists:
+// - The CSV says whether a second had motion; it can't say when within the
+//   second motion began or ended, or that a one-frame flicker was all there was
+// - Fed every detected frame, this turns the per-frame answer into events:
+//   startFrames motion frames in a row start one, stamped with the capture
+//   time of the first of them; endSec of capture time without a moving frame
+//   ends it, stamped with the last moving frame
+// - Two thresholds: MOTION_RATIO to start, keepFraction of it to keep going,
+//   so a person slowing down doesn't split into several events
+//
+// One instance per camera, fed from one thread at a time. Needs full passes:
+// decision mode's latched frames and shortened ratios would pass as motion
+// and end events early, so the programs turn events off with it.
+//
+class MotionHysteresis
+{
+public:
+    MotionHysteresis(int camera, double motionRatio, const MotionEventOptions& options = MotionEventOptions());
+
+    // Feed one detected frame. Returns true and fills `out` when this frame
+    // starts or ends an event.
+    bool update(const MotionResult& res, std::chrono::steady_clock::time_point captureTime, MotionEvent& out);
+
+    // End a running event now (sensor stopped), stamped with its last moving
+    // frame. Returns false if none was running.
+    bool finish(std::chrono::steady_clock::time_point now, MotionEvent& out);
+
+    // Forget any run and any running event without an event (new baseline).
+    void reset();
+
+    bool active() const { return isActive; }
+
+private:
+    int camera;
+    double motionRatio;
+    double keepRatio;
+    MotionEventOptions options;
+
+    bool isActive = false;
+    int run = 0; // consecutive motion frames while idle
+    std::chrono::steady_clock::time_point runStart{};
+    std::chrono::steady_clock::time_point lastMoving{};
+};
+
+// ============================================================
+// MotionEventQueue
+// ============================================================
+//
+// Why this exists:
+// - Events are decided on whatever thread ran detection (engine workers in
+//   the threaded program) and consumed elsewhere: the CSV writer in the main
+//   loop, a control socket client, anything else that subscribes
+// - A bounded ring of preallocated cells, each with its own sequence number:
+//   push and pop are one compare-and-swap each, no mutex, no allocation, so
+//   a detection thread never waits on a consumer
+// - Any number of producers and consumers; when full, the new event is
+//   dropped and counted rather than blocking detection
+//
+class MotionEventQueue
+{
+public:
+    // Capacity is rounded up to a power of two.
+    explicit MotionEventQueue(size_t capacity = 256);
+
+    MotionEventQueue(const MotionEventQueue&) = delete;
+    MotionEventQueue& operator=(const MotionEventQueue&) = delete;
+
+    // False (and counted) if the queue is full.
+    bool push(const MotionEvent& event);
+
+    // Oldest event, if any.
+    bool pop(MotionEvent& event);
+
+    size_t capacity() const { return mask + 1; }
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> seq;
+        MotionEvent event;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    alignas(64) std::atomic<uint64_t> head{0}; // next push
+    alignas(64) std::atomic<uint64_t> tail{0}; // next pop
+    alignas(64) std::atomic<uint64_t> droppedCount{0};
+};
+
+// ============================================================
+// MotionEventBus
+// ============================================================
+//
+// Fan-out: every subscriber gets its own MotionEventQueue, so a slow one only
+// fills (and drops from) its own. Subscribe before the first publish(); after
+// that the subscriber list is read-only and publish() is lock-free.
+//
+class MotionEventBus
+{
+public:
+    explicit MotionEventBus(size_t capacity = 256);
+
+    // A queue of its own for one consumer. Not thread-safe; set up first.
+    MotionEventQueue& subscribe();
+
+    // Stamp publishedAt and hand the event to every subscriber. Any thread.
+    void publish(MotionEvent event);
+
+    uint64_t published() const { return publishedCount.load(std::memory_order_relaxed); }
+
+private:
+    size_t capacity;
+    std::vector<std::unique_ptr<MotionEventQueue>> queues;
+    std::atomic<uint64_t> publishedCount{0};
+};
+
+// Consumer-side tally: events seen and trigger-to-event latency, i.e. from the
+// capture of the deciding frame to the consumer taking the event.
+struct MotionEventStats
+{
+    uint64_t starts = 0;
+    uint64_t ends = 0;
+    uint64_t dropped = 0;     // events the consumer's queue had no room for
+    double   latencyMsAvg = 0.0;
+    double   latencyMsMax = 0.0;
+
+    void add(const MotionEvent& event, std::chrono::steady_clock::time_point drainedAt);
+};
+
+// Header of <log>_events.csv.
+const char* motionEventColumns();
+
+// One <log>_events.csv row (no newline): CSV second, camera, event, its time
+// and decision time in seconds since `origin`, and the trigger-to-event
+// latency in ms at `drainedAt`.
+std::string formatMotionEventRow(const MotionEvent& event, const std::string& camera,
+                                 std::chrono::steady_clock::time_point origin,
+                                 std::chrono::steady_clock::time_point drainedAt);
+
+// One-line summary for logs.
+std::string formatMotionEventStats(const MotionEventStats& s);
@@ -0,0 +1,345 @@
+#include "motion_kernel.hpp"
+#include "motion_kernel_variants.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if MOTION_KERNEL_X86 && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#elif MOTION_KERNEL_ARM && defined(__linux__) && !defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+using namespace cv;
+
+namespace motion
+{
+// ============================================================
+// Runtime dispatch
+// ============================================================
+namespace
+{
+#if MOTION_KERNEL_X86 && defined(_MSC_VER)
+bool cpuHas(int leaf, int reg, int bit)
+{
+    int info[4];
+    __cpuidex(info, leaf, 0);
+    return (info[reg] >> bit) & 1;
+}
+
+// XCR0 bits the OS must save for the wider registers
+bool osSaves(unsigned long long mask)
+{
+    return cpuHas(1, 2, 27) && (_xgetbv(0) & mask) == mask;
+}
+#endif
+
+// Whether this CPU (and OS) runs a build.
+bool supported(const RowKernels& k)
+{
+    if (&k == &scalar::kRowKernels) return true;
+#if MOTION_KERNEL_X86
+#if defined(_MSC_VER)
+    if (&k == &sse41::kRowKernels) return cpuHas(1, 2, 19);
+    if (&k == &avx2::kRowKernels) return osSaves(0x6) && cpuHas(7, 1, 5);
+    if (&k == &avx512::kRowKernels) return osSaves(0xE6) && cpuHas(7, 1, 16) && cpuHas(7, 1, 30);
+#else
+    __builtin_cpu_init();
+    if (&k == &sse41::kRowKernels) return __builtin_cpu_supports("sse4.1");
+    if (&k == &avx2::kRowKernels) return __builtin_cpu_supports("avx2");
+    if (&k == &avx512::kRowKernels) return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+#elif MOTION_KERNEL_ARM
+#if defined(__aarch64__) || defined(_M_ARM64)
+    if (&k == &neon::kRowKernels) return true; // part of the base ISA
+#elif defined(__linux__)
+    if (&k == &neon::kRowKernels) return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+#endif
+    return false;
+}
+
+// Every build compiled in, slowest first.
+std::vector<const RowKernels*> compiledKernels()
+{
+    return {
+        &scalar::kRowKernels,
+#if MOTION_KERNEL_X86
+        &sse41::kRowKernels, &avx2::kRowKernels, &avx512::kRowKernels,
+#elif MOTION_KERNEL_ARM
+        &neon::kRowKernels,
+#endif
+    };
+}
+
+const RowKernels* findKernels(const std::string& name)
+{
+    for (const RowKernels* k : compiledKernels())
+        if (name == k->name && supported(*k)) return k;
+    return nullptr;
+}
+
+const RowKernels* selectKernels()
+{
+    const RowKernels* best = &scalar::kRowKernels;
+    for (const RowKernels* k : compiledKernels())
+        if (supported(*k)) best = k;
+
+    const char* forced = std::getenv("MOTION_KERNEL_ISA");
+    if (!forced || !*forced) return best;
+    if (const RowKernels* k = findKernels(forced)) return k;
+    std::cerr << "MOTION_KERNEL_ISA=" << forced << " is not available on this CPU; using " << best->name << "\n";
+    return best;
+}
+
+const RowKernels*& activeKernels()
+{
+    static const RowKernels* active = selectKernels();
+    return active;
+}
+} // namespace
+
+const RowKernels& rowKernels()
+{
+    return *activeKernels();
+}
+
+const char* kernelIsa()
+{
+    return rowKernels().name;
+}
+
+std::vector<std::string> kernelVariants()
+{
+    std::vector<std::string> names;
+    for (const RowKernels* k : compiledKernels())
+        if (supported(*k)) names.push_back(k->name);
+    return names;
+}
+
+bool useKernelVariant(const std::string& name)
+{
+    const RowKernels* k = findKernels(name);
+    if (!k) return false;
+    activeKernels() = k;
+    return true;
+}
+
+// ============================================================
+// Row kernels (forwarded to the active build)
+// ============================================================
+void bgrToLumaRow(const uint8_t* bgr, uint8_t* luma, int width)
+{
+    rowKernels().bgrToLuma(bgr, luma, width);
+}
+
+int lumaDiffCountRow(const uint8_t* bgr, const uint8_t* prev, uint8_t* cur, int width, int diffThresh)
+{
+    return rowKernels().lumaDiffCount(bgr, prev, cur, width, diffThresh);
+}
+
+int grayDiffCountRow(const uint8_t* gray, const uint8_t* prev, uint8_t* cur, int width, int diffThresh)
+{
+    return rowKernels().grayDiffCount(gray, prev, cur, width, diffThresh);
+}
+
+int backgroundDiffUpdateRow(const uint8_t* luma, uint16_t* bg, int width, int diffThresh, int alphaQ15)
+{
+    return rowKernels().backgroundDiffUpdate(luma, bg, width, diffThresh, alphaQ15);
+}
+
+void cellDiffCountRow(const uint8_t* cur, const uint8_t* prev, int x0, int x1, int diffThresh, int cellShift,
+                      uint16_t* cells)
+{
+    rowKernels().cellDiffCount(cur, prev, x0, x1, diffThresh, cellShift, cells);
+}
+
+void cellBackgroundCountRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh,
+                            int cellShift, uint16_t* cells)
+{
+    rowKernels().cellBackgroundCount(luma, bg, x0, x1, diffThresh, cellShift, cells);
+}
+
+void lumaSumsRow(const uint8_t* cur, const uint8_t* ref, int x0, int x1, uint64_t& curSum, uint64_t& refSum)
+{
+    rowKernels().lumaSums(cur, ref, x0, x1, curSum, refSum);
+}
+
+void backgroundSumsRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, uint64_t& curSum,
+                       uint64_t& refSum)
+{
+    rowKernels().backgroundSums(luma, bg, x0, x1, curSum, refSum);
+}
+
+int gainDiffCountRow(const uint8_t* cur, const uint8_t* ref, int x0, int x1, int diffThresh, int gainQ8)
+{
+    return rowKernels().gainDiffCount(cur, ref, x0, x1, diffThresh, gainQ8);
+}
+
+int gainBackgroundCountRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh, int gainQ8)
+{
+    return rowKernels().gainBackgroundCount(luma, bg, x0, x1, diffThresh, gainQ8);
+}
+
+BlockMatch blockMatch(const uint8_t* cur, size_t curStep, const uint8_t* ref, size_t refStep, int size, int dx0,
+                      int dx1, int dy0, int dy1)
+{
+    return rowKernels().blockMatch(cur, curStep, ref, refStep, size, dx0, dx1, dy0, dy1);
+}
+
+void decimateLumaRow(const uint8_t* const* srcRows, bool isBgr, int factor, int outWidth,
+                     uint8_t* out, DecimationScratch& scratch)
+{
+    rowKernels().decimateLuma(srcRows, isBgr, factor, outWidth, out, scratch);
+}
+
+// ============================================================
+// Mat-level wrappers
+// ============================================================
+void toLumaRows(const Mat& frame, Mat& luma, int rowBegin, int rowEnd)
+{
+    CV_Assert(frame.type() == CV_8UC3 || frame.type() == CV_8UC1);
+    CV_Assert(luma.type() == CV_8UC1 && luma.size() == frame.size());
+
+    // Continuous frames are processed as one long row per band.
+    int cols = frame.cols;
+    if (frame.isContinuous() && luma.isContinuous())
+    {
+        cols *= (rowEnd - rowBegin);
+        rowEnd = rowBegin + 1;
+    }
+
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        if (frame.type() == CV_8UC3)
+            bgrToLumaRow(frame.ptr<uint8_t>(y), luma.ptr<uint8_t>(y), cols);
+        else
+            std::copy(frame.ptr<uint8_t>(y), frame.ptr<uint8_t>(y) + cols, luma.ptr<uint8_t>(y));
+    }
+}
+
+int lumaDiffCountRows(const Mat& frame, const Mat& prevLuma, Mat& curLuma, int diffThresh,
+                      int rowBegin, int rowEnd)
+{
+    CV_Assert(frame.type() == CV_8UC3 || frame.type() == CV_8UC1);
+    CV_Assert(prevLuma.type() == CV_8UC1 && prevLuma.size() == frame.size());
+    CV_Assert(curLuma.type() == CV_8UC1 && curLuma.size() == frame.size());
+    CV_Assert(diffThresh >= 0 && diffThresh <= 255);
+
+    int cols = frame.cols;
+    if (frame.isContinuous() && prevLuma.isContinuous() && curLuma.isContinuous())
+    {
+        cols *= (rowEnd - rowBegin);
+        rowEnd = rowBegin + 1;
+    }
+
+    int changed = 0;
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        if (frame.type() == CV_8UC3)
+            changed += lumaDiffCountRow(frame.ptr<uint8_t>(y), prevLuma.ptr<uint8_t>(y),
+                                        curLuma.ptr<uint8_t>(y), cols, diffThresh);
+        else
+            changed += grayDiffCountRow(frame.ptr<uint8_t>(y), prevLuma.ptr<uint8_t>(y),
+                                        curLuma.ptr<uint8_t>(y), cols, diffThresh);
+    }
+    return changed;
+}
+
+void toLuma(const Mat& frame, Mat& luma)
+{
+    luma.create(frame.rows, frame.cols, CV_8UC1);
+    toLumaRows(frame, luma, 0, frame.rows);
+}
+
+int lumaDiffCount(const Mat& frame, const Mat& prevLuma, Mat& curLuma, int diffThresh)
+{
+    curLuma.create(frame.rows, frame.cols, CV_8UC1);
+    return lumaDiffCountRows(frame, prevLuma, curLuma, diffThresh, 0, frame.rows);
+}
+
+// ------------------------------------------------------------
+// Decimated (box-filtered) planes
+// ------------------------------------------------------------
+Size decimatedSize(Size full, int factor)
+{
+    return Size(full.width / factor, full.height / factor);
+}
+
+void toLumaDecimatedRows(const Mat& frame, Mat& luma, int factor, int rowBegin, int rowEnd,
+                         DecimationScratch& scratch)
+{
+    CV_Assert(frame.type() == CV_8UC3 || frame.type() == CV_8UC1);
+    CV_Assert(factor == 2 || factor == 4 || factor == 8);
+    CV_Assert(luma.type() == CV_8UC1 && luma.size() == decimatedSize(frame.size(), factor));
+
+    const int outWidth = luma.cols;
+
+    const uint8_t* rows[8];
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        for (int r = 0; r < factor; r++) rows[r] = frame.ptr<uint8_t>(y * factor + r);
+        decimateLumaRow(rows, frame.type() == CV_8UC3, factor, outWidth, luma.ptr<uint8_t>(y), scratch);
+    }
+}
+
+int lumaDecimatedDiffCountRows(const Mat& frame, const Mat& prevLuma, Mat& curLuma, int factor,
+                               int diffThresh, int rowBegin, int rowEnd, DecimationScratch& scratch)
+{
+    CV_Assert(prevLuma.type() == CV_8UC1 && prevLuma.size() == curLuma.size());
+    CV_Assert(diffThresh >= 0 && diffThresh <= 255);
+
+    int changed = 0;
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        // Build one decimated row, then diff it while it's still in L1.
+        toLumaDecimatedRows(frame, curLuma, factor, y, y + 1, scratch);
+        uint8_t* cur = curLuma.ptr<uint8_t>(y);
+        changed += grayDiffCountRow(cur, prevLuma.ptr<uint8_t>(y), cur, curLuma.cols, diffThresh);
+    }
+    return changed;
+}
+// ------------------------------------------------------------
+// Spans
+// ------------------------------------------------------------
+void toLumaSpan(const Mat& frame, Mat& luma, int factor, int y, int x0, int x1, DecimationScratch& scratch)
+{
+    const bool isBgr = frame.type() == CV_8UC3;
+    if (factor == 1)
+    {
+        const uint8_t* in = frame.ptr<uint8_t>(y);
+        if (isBgr)
+            bgrToLumaRow(in + 3 * x0, luma.ptr<uint8_t>(y) + x0, x1 - x0);
+        else
+            std::copy(in + x0, in + x1, luma.ptr<uint8_t>(y) + x0);
+        return;
+    }
+
+    // Output column x is the block of source columns [x * factor, (x + 1) * factor)
+    const int offset = x0 * factor * (isBgr ? 3 : 1);
+    const uint8_t* rows[8];
+    for (int r = 0; r < factor; r++) rows[r] = frame.ptr<uint8_t>(y * factor + r) + offset;
+    decimateLumaRow(rows, isBgr, factor, x1 - x0, luma.ptr<uint8_t>(y) + x0, scratch);
+}
+
+int lumaDiffCountSpan(const Mat& frame, const Mat& prevLuma, Mat& curLuma, int factor, int diffThresh, int y,
+                      int x0, int x1, DecimationScratch& scratch)
+{
+    const uint8_t* prev = prevLuma.ptr<uint8_t>(y) + x0;
+    uint8_t* cur = curLuma.ptr<uint8_t>(y) + x0;
+    if (factor == 1)
+    {
+        const uint8_t* in = frame.ptr<uint8_t>(y);
+        if (frame.type() == CV_8UC3) return lumaDiffCountRow(in + 3 * x0, prev, cur, x1 - x0, diffThresh);
+        return grayDiffCountRow(in + x0, prev, cur, x1 - x0, diffThresh);
+    }
+
+    toLumaSpan(frame, curLuma, factor, y, x0, x1, scratch);
+    return grayDiffCountRow(cur, prev, cur, x1 - x0, diffThresh);
+}
+} // namespace motion
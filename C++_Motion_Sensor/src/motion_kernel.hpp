@@ -0,0 +1,169 @@
+#pragma once
+
+// Fused motion-detection kernel.
+//
+// Replaces the four-pass chain
+//     cvtColor(BGR2GRAY) -> absdiff -> threshold(THRESH_BINARY) -> countNonZero
+// with one pass that converts each pixel to luma, diffs it against the previous
+// luma, thresholds it and counts it while the row is still in L1.
+//
+// Counts are bit-identical to the chain above: the luma weights are OpenCV's own
+// fixed-point BGR2GRAY weights (Q15), and "changed" means |cur - prev| > thresh,
+// which is exactly what THRESH_BINARY + countNonZero measures.
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace motion
+{
+// OpenCV's BGR2GRAY fixed-point weights (0.114, 0.587, 0.299 in Q15).
+constexpr int kLumaB = 3735;
+constexpr int kLumaG = 19235;
+constexpr int kLumaR = 9798;
+constexpr int kLumaShift = 15;
+
+inline uint8_t lumaOf(int b, int g, int r)
+{
+    return (uint8_t)((b * kLumaB + g * kLumaG + r * kLumaR + (1 << (kLumaShift - 1))) >> kLumaShift);
+}
+
+// ---- Row kernels (raw pointers, no OpenCV types)
+
+// BGR row -> luma row.
+void bgrToLumaRow(const uint8_t* bgr, uint8_t* luma, int width);
+
+// BGR row -> luma row written to `cur`, returns how many pixels differ from
+// `prev` by more than `diffThresh`.
+int lumaDiffCountRow(const uint8_t* bgr, const uint8_t* prev, uint8_t* cur, int width, int diffThresh);
+
+// Luma row already available (CV_8UC1 input): copy to `cur` and count.
+// `gray` and `cur` may be the same buffer.
+int grayDiffCountRow(const uint8_t* gray, const uint8_t* prev, uint8_t* cur, int width, int diffThresh);
+
+// Running-average background (background_model.hpp): `bg` holds luma in
+// fixed point, luma << kBackgroundShift. Counts the pixels whose luma differs
+// from the rounded background by more than `diffThresh`, then moves every
+// background pixel alphaQ15 / 32768 of the way toward the new luma, rounded
+// like SSSE3 pmulhrsw so all paths give the same model.
+constexpr int kBackgroundShift = 7;
+int backgroundDiffUpdateRow(const uint8_t* luma, uint16_t* bg, int width, int diffThresh, int alphaQ15);
+
+// Changed pixels per cell (blob extraction, motion_blobs.hpp): for columns
+// [x0, x1) of one row, adds each pixel whose luma differs by more than
+// `diffThresh` to cells[x >> cellShift] (cells of 8 or 16 columns). Row
+// pointers are at column 0. This re-reads what the fused pass just wrote, so
+// call it while the rows are still in cache.
+void cellDiffCountRow(const uint8_t* cur, const uint8_t* prev, int x0, int x1, int diffThresh, int cellShift,
+                      uint16_t* cells);
+
+// Same against a background row (luma << kBackgroundShift), before it learns
+// the frame.
+void cellBackgroundCountRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh,
+                            int cellShift, uint16_t* cells);
+
+// Lighting compensation: luma totals of columns [x0, x1) of a row and of its
+// baseline (the previous luma, or the background's rounded level), added to
+// curSum and refSum. Their ratio is the gain of the rows summed.
+void lumaSumsRow(const uint8_t* cur, const uint8_t* ref, int x0, int x1, uint64_t& curSum, uint64_t& refSum);
+void backgroundSumsRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, uint64_t& curSum,
+                       uint64_t& refSum);
+
+// Pixels of columns [x0, x1) whose luma differs by more than `diffThresh`
+// from the baseline times gainQ8 / 256 (rounded down, clipped at 255 like the
+// sensor would). Only re-reads rows, so call it while they are in cache.
+int gainDiffCountRow(const uint8_t* cur, const uint8_t* ref, int x0, int x1, int diffThresh, int gainQ8);
+int gainBackgroundCountRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh, int gainQ8);
+
+// Block matching (motion vectors, motion_vectors.hpp): the size x size block
+// (8 or 16) at `cur` against the block of `ref` at the same place shifted by
+// every (dx, dy) in [dx0, dx1] x [dy0, dy1]. The range must contain (0, 0)
+// and keep every shifted block inside `ref`. Best is the smallest sum of
+// absolute differences; the unshifted block wins ties, then the first shift
+// in row order, so every build picks the same one.
+struct BlockMatch
+{
+    int dx = 0, dy = 0;
+    int sad = 0;     // at (dx, dy)
+    int zeroSad = 0; // at (0, 0)
+};
+BlockMatch blockMatch(const uint8_t* cur, size_t curStep, const uint8_t* ref, size_t refStep, int size, int dx0,
+                      int dx1, int dy0, int dy1);
+
+// Scratch for decimateLumaRow(); sized on first use, reused afterwards.
+struct DecimationScratch
+{
+    std::vector<uint8_t>  averaged; // vertically averaged source rows
+    std::vector<uint8_t>  lumaRow;
+    std::vector<uint16_t> acc;
+};
+
+// `factor` source rows (BGR, or luma when !isBgr) -> one box-filtered luma row
+// of outWidth pixels, each the mean of a factor x factor block. Rows are
+// averaged pairwise with rounding before the luma conversion, so the result
+// can sit up to one level above the exact mean luma.
+void decimateLumaRow(const uint8_t* const* srcRows, bool isBgr, int factor, int outWidth,
+                     uint8_t* out, DecimationScratch& scratch);
+
+// ---- Instruction-set builds (motion_kernel_variants.hpp)
+//
+// The row kernels above are compiled once per instruction set ("scalar",
+// "sse41", "avx2", "avx512" on x86, "scalar", "neon" on ARM), and the best
+// build this CPU runs is picked on first use. Setting MOTION_KERNEL_ISA to a
+// build's name forces it (an unknown or unsupported name is reported and
+// ignored). Every build gives the same results.
+
+// Name of the build in use.
+const char* kernelIsa();
+
+// Builds this CPU can run, scalar first, best last.
+std::vector<std::string> kernelVariants();
+
+// Switch to another build (benchmarks, equivalence checks). Not thread-safe:
+// call before any detection starts. False if the name isn't available.
+bool useKernelVariant(const std::string& name);
+
+// ---- Mat-level wrappers (CV_8UC3 BGR or CV_8UC1 input)
+
+// Row-band versions: only rows [rowBegin, rowEnd) are touched. Output planes
+// must already be allocated at the frame size.
+void toLumaRows(const cv::Mat& frame, cv::Mat& luma, int rowBegin, int rowEnd);
+int lumaDiffCountRows(const cv::Mat& frame, const cv::Mat& prevLuma, cv::Mat& curLuma,
+                      int diffThresh, int rowBegin, int rowEnd);
+
+// ---- Decimated planes (factor 2, 4 or 8)
+//
+// The plane is built straight from the BGR frame: each output pixel is the
+// mean luma of a factor x factor block. Edge pixels that don't fill a whole
+// block are ignored.
+
+cv::Size decimatedSize(cv::Size full, int factor);
+
+// Output rows [rowBegin, rowEnd) of the decimated plane (luma pre-allocated).
+void toLumaDecimatedRows(const cv::Mat& frame, cv::Mat& luma, int factor, int rowBegin, int rowEnd,
+                         DecimationScratch& scratch);
+
+// Same, diffed against prevLuma; returns changed pixels in the decimated plane.
+int lumaDecimatedDiffCountRows(const cv::Mat& frame, const cv::Mat& prevLuma, cv::Mat& curLuma, int factor,
+                               int diffThresh, int rowBegin, int rowEnd, DecimationScratch& scratch);
+
+// ---- Span versions (ROI masks, roi_mask.hpp)
+//
+// Only columns [x0, x1) of plane row y, at full resolution (factor 1) or
+// decimated (2, 4, 8). Planes must already be allocated; nothing is checked
+// per call, the caller validates once per frame.
+
+void toLumaSpan(const cv::Mat& frame, cv::Mat& luma, int factor, int y, int x0, int x1,
+                DecimationScratch& scratch);
+int lumaDiffCountSpan(const cv::Mat& frame, const cv::Mat& prevLuma, cv::Mat& curLuma, int factor,
+                      int diffThresh, int y, int x0, int x1, DecimationScratch& scratch);
+
+// frame -> luma (CV_8UC1, same size). Reuses `luma`'s buffer when it fits.
+void toLuma(const cv::Mat& frame, cv::Mat& luma);
+
+// frame -> curLuma, returns number of pixels whose luma moved by more than
+// diffThresh relative to prevLuma (same size as frame).
+int lumaDiffCount(const cv::Mat& frame, const cv::Mat& prevLuma, cv::Mat& curLuma, int diffThresh);
+} // namespace motion
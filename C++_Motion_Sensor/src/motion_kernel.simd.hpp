@@ -0,0 +1,1157 @@
+#pragma once
+
+// Row kernels of motion_kernel.hpp, compiled once per instruction set.
+//
+// Not a normal header: each motion_kernel_<isa>.cpp defines
+// MOTION_KERNEL_VARIANT (the namespace of its build) and the
+// MOTION_KERNEL_<ISA> paths its compile flags allow, then includes this file.
+// motion_kernel.cpp picks one build at startup (motion_kernel_variants.hpp).
+
+#include "motion_kernel_variants.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#if MOTION_KERNEL_AVX2
+#include <immintrin.h>
+#elif MOTION_KERNEL_SSSE3
+#include <tmmintrin.h>
+#elif MOTION_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+#if MOTION_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define MOTION_KERNEL_STR2(x) #x
+#define MOTION_KERNEL_STR(x) MOTION_KERNEL_STR2(x)
+
+namespace motion
+{
+namespace MOTION_KERNEL_VARIANT
+{
+namespace
+{
+inline int popcount32(uint32_t v)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt(v);
+#else
+    return __builtin_popcount(v);
+#endif
+}
+
+inline int popcount64(uint64_t v)
+{
+    return popcount32((uint32_t)v) + popcount32((uint32_t)(v >> 32));
+}
+
+// ------------------------------------------------------------
+// Scalar tails (also the whole kernel when no SIMD is compiled in)
+// ------------------------------------------------------------
+inline int lumaDiffCountScalar(const uint8_t* bgr, const uint8_t* prev, uint8_t* cur,
+                               int x, int width, int diffThresh)
+{
+    int changed = 0;
+    for (; x < width; x++)
+    {
+        const uint8_t* p = bgr + 3 * x;
+        uint8_t y = lumaOf(p[0], p[1], p[2]);
+        cur[x] = y;
+        int d = (int)y - (int)prev[x];
+        changed += ((d < 0 ? -d : d) > diffThresh);
+    }
+    return changed;
+}
+
+inline int grayDiffCountScalar(const uint8_t* gray, const uint8_t* prev, uint8_t* cur,
+                               int x, int width, int diffThresh)
+{
+    int changed = 0;
+    for (; x < width; x++)
+    {
+        uint8_t y = gray[x];
+        cur[x] = y;
+        int d = (int)y - (int)prev[x];
+        changed += ((d < 0 ? -d : d) > diffThresh);
+    }
+    return changed;
+}
+
+#if MOTION_KERNEL_SSSE3
+// ------------------------------------------------------------
+// SSSE3: 16 pixels per step
+// ------------------------------------------------------------
+
+// Split 16 interleaved BGR pixels (48 bytes) into B, G and R planes.
+inline void deinterleave16(const uint8_t* bgr, __m128i& b, __m128i& g, __m128i& r)
+{
+    const __m128i v0 = _mm_loadu_si128((const __m128i*)(bgr));
+    const __m128i v1 = _mm_loadu_si128((const __m128i*)(bgr + 16));
+    const __m128i v2 = _mm_loadu_si128((const __m128i*)(bgr + 32));
+
+    const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+
+    const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+
+    const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+    b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, b0), _mm_shuffle_epi8(v1, b1)), _mm_shuffle_epi8(v2, b2));
+    g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, g0), _mm_shuffle_epi8(v1, g1)), _mm_shuffle_epi8(v2, g2));
+    r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, r0), _mm_shuffle_epi8(v1, r1)), _mm_shuffle_epi8(v2, r2));
+}
+
+// Four 32-bit luma values from four (b,g) and (r,1) 16-bit pairs.
+inline __m128i luma4(__m128i bg, __m128i r1)
+{
+    const __m128i wBG = _mm_setr_epi16(kLumaB, kLumaG, kLumaB, kLumaG, kLumaB, kLumaG, kLumaB, kLumaG);
+    const __m128i wR1 = _mm_setr_epi16(kLumaR, 1 << (kLumaShift - 1), kLumaR, 1 << (kLumaShift - 1),
+                                       kLumaR, 1 << (kLumaShift - 1), kLumaR, 1 << (kLumaShift - 1));
+    __m128i s = _mm_add_epi32(_mm_madd_epi16(bg, wBG), _mm_madd_epi16(r1, wR1));
+    return _mm_srli_epi32(s, kLumaShift);
+}
+
+// 16 BGR pixels -> 16 luma bytes (bit-exact with cvtColor BGR2GRAY).
+inline __m128i luma16(const uint8_t* bgr)
+{
+    __m128i b, g, r;
+    deinterleave16(bgr, b, g, r);
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+
+    const __m128i bLo = _mm_unpacklo_epi8(b, zero), bHi = _mm_unpackhi_epi8(b, zero);
+    const __m128i gLo = _mm_unpacklo_epi8(g, zero), gHi = _mm_unpackhi_epi8(g, zero);
+    const __m128i rLo = _mm_unpacklo_epi8(r, zero), rHi = _mm_unpackhi_epi8(r, zero);
+
+    __m128i y0 = luma4(_mm_unpacklo_epi16(bLo, gLo), _mm_unpacklo_epi16(rLo, one));
+    __m128i y1 = luma4(_mm_unpackhi_epi16(bLo, gLo), _mm_unpackhi_epi16(rLo, one));
+    __m128i y2 = luma4(_mm_unpacklo_epi16(bHi, gHi), _mm_unpacklo_epi16(rHi, one));
+    __m128i y3 = luma4(_mm_unpackhi_epi16(bHi, gHi), _mm_unpackhi_epi16(rHi, one));
+
+    return _mm_packus_epi16(_mm_packs_epi32(y0, y1), _mm_packs_epi32(y2, y3));
+}
+
+// Number of lanes where |cur - prev| > thresh.
+inline int countChanged16(__m128i cur, __m128i prev, __m128i thresh)
+{
+    __m128i d = _mm_or_si128(_mm_subs_epu8(cur, prev), _mm_subs_epu8(prev, cur));
+    __m128i same = _mm_cmpeq_epi8(_mm_subs_epu8(d, thresh), _mm_setzero_si128());
+    return 16 - popcount32((uint32_t)_mm_movemask_epi8(same));
+}
+#endif
+
+#if MOTION_KERNEL_AVX2
+// ------------------------------------------------------------
+// AVX2: 32 pixels per step (two SSSE3 deinterleaves, 256-bit math)
+// ------------------------------------------------------------
+inline __m256i luma32(const uint8_t* bgr)
+{
+    __m128i b0, g0, r0, b1, g1, r1;
+    deinterleave16(bgr, b0, g0, r0);
+    deinterleave16(bgr + 48, b1, g1, r1);
+
+    const __m256i wBG = _mm256_setr_epi16(kLumaB, kLumaG, kLumaB, kLumaG, kLumaB, kLumaG, kLumaB, kLumaG,
+                                          kLumaB, kLumaG, kLumaB, kLumaG, kLumaB, kLumaG, kLumaB, kLumaG);
+    const short rnd = 1 << (kLumaShift - 1);
+    const __m256i wR1 = _mm256_setr_epi16(kLumaR, rnd, kLumaR, rnd, kLumaR, rnd, kLumaR, rnd,
+                                          kLumaR, rnd, kLumaR, rnd, kLumaR, rnd, kLumaR, rnd);
+    const __m256i one = _mm256_set1_epi16(1);
+
+    auto luma16w = [&](__m128i b, __m128i g, __m128i r) {
+        const __m256i bw = _mm256_cvtepu8_epi16(b);
+        const __m256i gw = _mm256_cvtepu8_epi16(g);
+        const __m256i rw = _mm256_cvtepu8_epi16(r);
+        // In-lane unpacks: lo = pixels {0-3 | 8-11}, hi = {4-7 | 12-15}
+        __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(bw, gw), wBG),
+                                      _mm256_madd_epi16(_mm256_unpacklo_epi16(rw, one), wR1));
+        __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(bw, gw), wBG),
+                                      _mm256_madd_epi16(_mm256_unpackhi_epi16(rw, one), wR1));
+        // In-lane pack restores pixel order 0..15 as 16-bit lanes
+        return _mm256_packs_epi32(_mm256_srli_epi32(lo, kLumaShift), _mm256_srli_epi32(hi, kLumaShift));
+    };
+
+    __m256i y0 = luma16w(b0, g0, r0);
+    __m256i y1 = luma16w(b1, g1, r1);
+
+    // packus interleaves 8-pixel groups across lanes; permute back to 0..31
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(y0, y1), 0xD8);
+}
+
+inline int countChanged32(__m256i cur, __m256i prev, __m256i thresh)
+{
+    __m256i d = _mm256_or_si256(_mm256_subs_epu8(cur, prev), _mm256_subs_epu8(prev, cur));
+    __m256i same = _mm256_cmpeq_epi8(_mm256_subs_epu8(d, thresh), _mm256_setzero_si256());
+    return 32 - popcount32((uint32_t)_mm256_movemask_epi8(same));
+}
+#endif
+
+#if MOTION_KERNEL_AVX512
+// ------------------------------------------------------------
+// AVX-512BW: 64 pixels per step for the byte-plane kernels. The BGR kernels
+// keep the AVX2 path: joining two 32-pixel lumas costs more than it saves.
+// ------------------------------------------------------------
+inline int countChanged64(__m512i cur, __m512i prev, __m512i thresh)
+{
+    const __m512i d = _mm512_or_si512(_mm512_subs_epu8(cur, prev), _mm512_subs_epu8(prev, cur));
+    return popcount64(_mm512_cmpgt_epu8_mask(d, thresh));
+}
+#endif
+
+#if MOTION_KERNEL_NEON
+// ------------------------------------------------------------
+// NEON: 16 pixels per step
+// ------------------------------------------------------------
+inline uint8x16_t luma16(const uint8_t* bgr)
+{
+    const uint8x16x3_t px = vld3q_u8(bgr);
+
+    auto half = [](uint8x8_t b, uint8x8_t g, uint8x8_t r) {
+        const uint16x8_t bw = vmovl_u8(b), gw = vmovl_u8(g), rw = vmovl_u8(r);
+
+        uint32x4_t lo = vmull_n_u16(vget_low_u16(bw), kLumaB);
+        lo = vmlal_n_u16(lo, vget_low_u16(gw), kLumaG);
+        lo = vmlal_n_u16(lo, vget_low_u16(rw), kLumaR);
+
+        uint32x4_t hi = vmull_n_u16(vget_high_u16(bw), kLumaB);
+        hi = vmlal_n_u16(hi, vget_high_u16(gw), kLumaG);
+        hi = vmlal_n_u16(hi, vget_high_u16(rw), kLumaR);
+
+        // Rounding narrow: (x + 2^14) >> 15
+        return vqmovn_u16(vcombine_u16(vrshrn_n_u32(lo, kLumaShift), vrshrn_n_u32(hi, kLumaShift)));
+    };
+
+    return vcombine_u8(half(vget_low_u8(px.val[0]), vget_low_u8(px.val[1]), vget_low_u8(px.val[2])),
+                       half(vget_high_u8(px.val[0]), vget_high_u8(px.val[1]), vget_high_u8(px.val[2])));
+}
+
+// Adds the number of lanes where |cur - prev| > thresh into acc.
+inline uint32x4_t accumulateChanged16(uint32x4_t acc, uint8x16_t cur, uint8x16_t prev, uint8x16_t thresh)
+{
+    uint8x16_t changed = vshrq_n_u8(vcgtq_u8(vabdq_u8(cur, prev), thresh), 7);
+    return vpadalq_u16(acc, vpaddlq_u8(changed));
+}
+
+inline int horizontalSum(uint32x4_t v)
+{
+    uint64x2_t s = vpaddlq_u32(v);
+    return (int)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+}
+#endif
+} // namespace
+
+// ============================================================
+// Row kernels
+// ============================================================
+void bgrToLumaRow(const uint8_t* bgr, uint8_t* luma, int width)
+{
+    int x = 0;
+#if MOTION_KERNEL_AVX2
+    for (; x + 32 <= width; x += 32)
+        _mm256_storeu_si256((__m256i*)(luma + x), luma32(bgr + 3 * x));
+#endif
+#if MOTION_KERNEL_SSSE3
+    for (; x + 16 <= width; x += 16)
+        _mm_storeu_si128((__m128i*)(luma + x), luma16(bgr + 3 * x));
+#elif MOTION_KERNEL_NEON
+    for (; x + 16 <= width; x += 16)
+        vst1q_u8(luma + x, luma16(bgr + 3 * x));
+#endif
+    for (; x < width; x++)
+    {
+        const uint8_t* p = bgr + 3 * x;
+        luma[x] = lumaOf(p[0], p[1], p[2]);
+    }
+}
+
+int lumaDiffCountRow(const uint8_t* bgr, const uint8_t* prev, uint8_t* cur, int width, int diffThresh)
+{
+    int x = 0;
+    int changed = 0;
+
+#if MOTION_KERNEL_AVX2
+    {
+        const __m256i t = _mm256_set1_epi8((char)diffThresh);
+        for (; x + 32 <= width; x += 32)
+        {
+            __m256i y = luma32(bgr + 3 * x);
+            _mm256_storeu_si256((__m256i*)(cur + x), y);
+            changed += countChanged32(y, _mm256_loadu_si256((const __m256i*)(prev + x)), t);
+        }
+    }
+#endif
+#if MOTION_KERNEL_SSSE3
+    {
+        const __m128i t = _mm_set1_epi8((char)diffThresh);
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i y = luma16(bgr + 3 * x);
+            _mm_storeu_si128((__m128i*)(cur + x), y);
+            changed += countChanged16(y, _mm_loadu_si128((const __m128i*)(prev + x)), t);
+        }
+    }
+#elif MOTION_KERNEL_NEON
+    {
+        const uint8x16_t t = vdupq_n_u8((uint8_t)diffThresh);
+        uint32x4_t acc = vdupq_n_u32(0);
+        for (; x + 16 <= width; x += 16)
+        {
+            uint8x16_t y = luma16(bgr + 3 * x);
+            vst1q_u8(cur + x, y);
+            acc = accumulateChanged16(acc, y, vld1q_u8(prev + x), t);
+        }
+        changed += horizontalSum(acc);
+    }
+#endif
+
+    return changed + lumaDiffCountScalar(bgr, prev, cur, x, width, diffThresh);
+}
+
+int grayDiffCountRow(const uint8_t* gray, const uint8_t* prev, uint8_t* cur, int width, int diffThresh)
+{
+    int x = 0;
+    int changed = 0;
+
+#if MOTION_KERNEL_AVX512
+    {
+        const __m512i t = _mm512_set1_epi8((char)diffThresh);
+        for (; x + 64 <= width; x += 64)
+        {
+            const __m512i y = _mm512_loadu_si512(gray + x);
+            _mm512_storeu_si512(cur + x, y);
+            changed += countChanged64(y, _mm512_loadu_si512(prev + x), t);
+        }
+    }
+#endif
+#if MOTION_KERNEL_SSSE3
+    {
+        const __m128i t = _mm_set1_epi8((char)diffThresh);
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i y = _mm_loadu_si128((const __m128i*)(gray + x));
+            _mm_storeu_si128((__m128i*)(cur + x), y);
+            changed += countChanged16(y, _mm_loadu_si128((const __m128i*)(prev + x)), t);
+        }
+    }
+#elif MOTION_KERNEL_NEON
+    {
+        const uint8x16_t t = vdupq_n_u8((uint8_t)diffThresh);
+        uint32x4_t acc = vdupq_n_u32(0);
+        for (; x + 16 <= width; x += 16)
+        {
+            uint8x16_t y = vld1q_u8(gray + x);
+            vst1q_u8(cur + x, y);
+            acc = accumulateChanged16(acc, y, vld1q_u8(prev + x), t);
+        }
+        changed += horizontalSum(acc);
+    }
+#endif
+
+    return changed + grayDiffCountScalar(gray, prev, cur, x, width, diffThresh);
+}
+
+int backgroundDiffUpdateRow(const uint8_t* luma, uint16_t* bg, int width, int diffThresh, int alphaQ15)
+{
+    // bg <= 255 << 7, so the Q7 values, their rounding and the gap to the new
+    // luma all fit in signed 16-bit lanes.
+    int x = 0;
+    int changed = 0;
+
+#if MOTION_KERNEL_AVX512
+    {
+        const __m512i t = _mm512_set1_epi8((char)diffThresh);
+        const __m512i a = _mm512_set1_epi16((short)alphaQ15);
+        const __m512i rnd = _mm512_set1_epi16(1 << (kBackgroundShift - 1));
+        // packus works per 128-bit lane; this puts its quadwords back in pixel order
+        const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+        for (; x + 64 <= width; x += 64)
+        {
+            const __m512i cur = _mm512_loadu_si512(luma + x);
+            __m512i b0 = _mm512_loadu_si512(bg + x);
+            __m512i b1 = _mm512_loadu_si512(bg + x + 32);
+
+            const __m512i l0 = _mm512_srli_epi16(_mm512_add_epi16(b0, rnd), kBackgroundShift);
+            const __m512i l1 = _mm512_srli_epi16(_mm512_add_epi16(b1, rnd), kBackgroundShift);
+            changed += countChanged64(cur, _mm512_permutexvar_epi64(order, _mm512_packus_epi16(l0, l1)), t);
+
+            const __m512i c0 = _mm512_slli_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(cur)),
+                                                 kBackgroundShift);
+            const __m512i c1 = _mm512_slli_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(cur, 1)),
+                                                 kBackgroundShift);
+            b0 = _mm512_add_epi16(b0, _mm512_mulhrs_epi16(_mm512_sub_epi16(c0, b0), a));
+            b1 = _mm512_add_epi16(b1, _mm512_mulhrs_epi16(_mm512_sub_epi16(c1, b1), a));
+            _mm512_storeu_si512(bg + x, b0);
+            _mm512_storeu_si512(bg + x + 32, b1);
+        }
+    }
+#endif
+#if MOTION_KERNEL_AVX2
+    {
+        const __m256i t = _mm256_set1_epi8((char)diffThresh);
+        const __m256i a = _mm256_set1_epi16((short)alphaQ15);
+        const __m256i rnd = _mm256_set1_epi16(1 << (kBackgroundShift - 1));
+        for (; x + 32 <= width; x += 32)
+        {
+            const __m256i cur = _mm256_loadu_si256((const __m256i*)(luma + x));
+            __m256i b0 = _mm256_loadu_si256((const __m256i*)(bg + x));
+            __m256i b1 = _mm256_loadu_si256((const __m256i*)(bg + x + 16));
+
+            // Compare against the background as it was before this frame
+            const __m256i l0 = _mm256_srli_epi16(_mm256_add_epi16(b0, rnd), kBackgroundShift);
+            const __m256i l1 = _mm256_srli_epi16(_mm256_add_epi16(b1, rnd), kBackgroundShift);
+            changed += countChanged32(cur, _mm256_permute4x64_epi64(_mm256_packus_epi16(l0, l1), 0xD8), t);
+
+            const __m256i c0 = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(cur)), kBackgroundShift);
+            const __m256i c1 = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(cur, 1)), kBackgroundShift);
+            b0 = _mm256_add_epi16(b0, _mm256_mulhrs_epi16(_mm256_sub_epi16(c0, b0), a));
+            b1 = _mm256_add_epi16(b1, _mm256_mulhrs_epi16(_mm256_sub_epi16(c1, b1), a));
+            _mm256_storeu_si256((__m256i*)(bg + x), b0);
+            _mm256_storeu_si256((__m256i*)(bg + x + 16), b1);
+        }
+    }
+#endif
+#if MOTION_KERNEL_SSSE3
+    {
+        const __m128i t = _mm_set1_epi8((char)diffThresh);
+        const __m128i a = _mm_set1_epi16((short)alphaQ15);
+        const __m128i rnd = _mm_set1_epi16(1 << (kBackgroundShift - 1));
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16)
+        {
+            const __m128i cur = _mm_loadu_si128((const __m128i*)(luma + x));
+            __m128i b0 = _mm_loadu_si128((const __m128i*)(bg + x));
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(bg + x + 8));
+
+            const __m128i l0 = _mm_srli_epi16(_mm_add_epi16(b0, rnd), kBackgroundShift);
+            const __m128i l1 = _mm_srli_epi16(_mm_add_epi16(b1, rnd), kBackgroundShift);
+            changed += countChanged16(cur, _mm_packus_epi16(l0, l1), t);
+
+            const __m128i c0 = _mm_slli_epi16(_mm_unpacklo_epi8(cur, zero), kBackgroundShift);
+            const __m128i c1 = _mm_slli_epi16(_mm_unpackhi_epi8(cur, zero), kBackgroundShift);
+            b0 = _mm_add_epi16(b0, _mm_mulhrs_epi16(_mm_sub_epi16(c0, b0), a));
+            b1 = _mm_add_epi16(b1, _mm_mulhrs_epi16(_mm_sub_epi16(c1, b1), a));
+            _mm_storeu_si128((__m128i*)(bg + x), b0);
+            _mm_storeu_si128((__m128i*)(bg + x + 8), b1);
+        }
+    }
+#elif MOTION_KERNEL_NEON
+    {
+        const uint8x16_t t = vdupq_n_u8((uint8_t)diffThresh);
+        const int16x8_t a = vdupq_n_s16((int16_t)alphaQ15);
+        uint32x4_t acc = vdupq_n_u32(0);
+        for (; x + 16 <= width; x += 16)
+        {
+            const uint8x16_t cur = vld1q_u8(luma + x);
+            int16x8_t b0 = vreinterpretq_s16_u16(vld1q_u16(bg + x));
+            int16x8_t b1 = vreinterpretq_s16_u16(vld1q_u16(bg + x + 8));
+
+            const uint8x16_t level = vcombine_u8(vrshrn_n_u16(vreinterpretq_u16_s16(b0), kBackgroundShift),
+                                                 vrshrn_n_u16(vreinterpretq_u16_s16(b1), kBackgroundShift));
+            acc = accumulateChanged16(acc, cur, level, t);
+
+            // vqrdmulh: (2 * e * a + 2^15) >> 16, the same rounding as pmulhrsw
+            const int16x8_t c0 = vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(cur), kBackgroundShift));
+            const int16x8_t c1 = vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(cur), kBackgroundShift));
+            b0 = vaddq_s16(b0, vqrdmulhq_s16(vsubq_s16(c0, b0), a));
+            b1 = vaddq_s16(b1, vqrdmulhq_s16(vsubq_s16(c1, b1), a));
+            vst1q_u16(bg + x, vreinterpretq_u16_s16(b0));
+            vst1q_u16(bg + x + 8, vreinterpretq_u16_s16(b1));
+        }
+        changed += horizontalSum(acc);
+    }
+#elif MOTION_KERNEL_SSE2
+    {
+        // Baseline x86-64 builds: pmulhrsw from the 32-bit products
+        const __m128i t = _mm_set1_epi8((char)diffThresh);
+        const __m128i a = _mm_set1_epi16((short)alphaQ15);
+        const __m128i rnd = _mm_set1_epi16(1 << (kBackgroundShift - 1));
+        const __m128i half = _mm_set1_epi32(1 << 14);
+        const __m128i zero = _mm_setzero_si128();
+        auto mulhrs = [&](__m128i e) {
+            const __m128i lo = _mm_mullo_epi16(e, a), hi = _mm_mulhi_epi16(e, a);
+            const __m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), half), 15);
+            const __m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), half), 15);
+            return _mm_packs_epi32(p0, p1);
+        };
+        for (; x + 16 <= width; x += 16)
+        {
+            const __m128i cur = _mm_loadu_si128((const __m128i*)(luma + x));
+            __m128i b0 = _mm_loadu_si128((const __m128i*)(bg + x));
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(bg + x + 8));
+
+            const __m128i level = _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(b0, rnd), kBackgroundShift),
+                                                   _mm_srli_epi16(_mm_add_epi16(b1, rnd), kBackgroundShift));
+            const __m128i d = _mm_or_si128(_mm_subs_epu8(cur, level), _mm_subs_epu8(level, cur));
+            const __m128i same = _mm_cmpeq_epi8(_mm_subs_epu8(d, t), zero);
+            changed += 16 - popcount32((uint32_t)_mm_movemask_epi8(same));
+
+            const __m128i c0 = _mm_slli_epi16(_mm_unpacklo_epi8(cur, zero), kBackgroundShift);
+            const __m128i c1 = _mm_slli_epi16(_mm_unpackhi_epi8(cur, zero), kBackgroundShift);
+            b0 = _mm_add_epi16(b0, mulhrs(_mm_sub_epi16(c0, b0)));
+            b1 = _mm_add_epi16(b1, mulhrs(_mm_sub_epi16(c1, b1)));
+            _mm_storeu_si128((__m128i*)(bg + x), b0);
+            _mm_storeu_si128((__m128i*)(bg + x + 8), b1);
+        }
+    }
+#endif
+
+    const int rnd = 1 << (kBackgroundShift - 1);
+    for (; x < width; x++)
+    {
+        const int b = bg[x];
+        const int d = (int)luma[x] - ((b + rnd) >> kBackgroundShift);
+        changed += ((d < 0 ? -d : d) > diffThresh);
+        const int e = ((int)luma[x] << kBackgroundShift) - b;
+        bg[x] = (uint16_t)(b + ((e * alphaQ15 + (1 << 14)) >> 15));
+    }
+    return changed;
+}
+
+// ------------------------------------------------------------
+// Per-cell counts
+// ------------------------------------------------------------
+namespace
+{
+#if MOTION_KERNEL_SSE2
+// Changed lanes of 16 pixels, summed per 8 (psadbw) and added to the cells
+// they fall in: two cells of 8 columns, or one of 16.
+inline void addChangedCells16(__m128i cur, __m128i ref, __m128i thresh, int x, int cellShift, uint16_t* cells)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i d = _mm_or_si128(_mm_subs_epu8(cur, ref), _mm_subs_epu8(ref, cur));
+    const __m128i same = _mm_cmpeq_epi8(_mm_subs_epu8(d, thresh), zero);
+    const __m128i sums = _mm_sad_epu8(_mm_andnot_si128(same, _mm_set1_epi8(1)), zero);
+    const int lo = _mm_cvtsi128_si32(sums), hi = _mm_extract_epi16(sums, 4);
+    if (cellShift == 4)
+    {
+        cells[x >> 4] += (uint16_t)(lo + hi);
+        return;
+    }
+    cells[x >> 3] += (uint16_t)lo;
+    cells[(x >> 3) + 1] += (uint16_t)hi;
+}
+#endif
+
+#if MOTION_KERNEL_AVX2
+// Same for 32 pixels: four sums of 8.
+inline void addChangedCells32(__m256i cur, __m256i ref, __m256i thresh, int x, int cellShift, uint16_t* cells)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i d = _mm256_or_si256(_mm256_subs_epu8(cur, ref), _mm256_subs_epu8(ref, cur));
+    const __m256i same = _mm256_cmpeq_epi8(_mm256_subs_epu8(d, thresh), zero);
+    const __m256i sums = _mm256_sad_epu8(_mm256_andnot_si256(same, _mm256_set1_epi8(1)), zero);
+    const int s0 = _mm256_extract_epi16(sums, 0), s1 = _mm256_extract_epi16(sums, 4);
+    const int s2 = _mm256_extract_epi16(sums, 8), s3 = _mm256_extract_epi16(sums, 12);
+    if (cellShift == 4)
+    {
+        cells[x >> 4] += (uint16_t)(s0 + s1);
+        cells[(x >> 4) + 1] += (uint16_t)(s2 + s3);
+        return;
+    }
+    uint16_t* c = cells + (x >> 3);
+    c[0] += (uint16_t)s0;
+    c[1] += (uint16_t)s1;
+    c[2] += (uint16_t)s2;
+    c[3] += (uint16_t)s3;
+}
+#endif
+} // namespace
+
+void cellDiffCountRow(const uint8_t* cur, const uint8_t* prev, int x0, int x1, int diffThresh, int cellShift,
+                      uint16_t* cells)
+{
+    int x = x0;
+    auto scalar = [&](int end) {
+        for (; x < end; x++)
+        {
+            const int d = (int)cur[x] - (int)prev[x];
+            cells[x >> cellShift] += ((d < 0 ? -d : d) > diffThresh);
+        }
+    };
+
+#if MOTION_KERNEL_SSE2
+    // Up to a 16-column boundary, so each vector covers whole cells
+    scalar(std::min(x1, (x0 + 15) & ~15));
+#if MOTION_KERNEL_AVX2
+    const __m256i t32 = _mm256_set1_epi8((char)diffThresh);
+    for (; x + 32 <= x1; x += 32)
+        addChangedCells32(_mm256_loadu_si256((const __m256i*)(cur + x)),
+                          _mm256_loadu_si256((const __m256i*)(prev + x)), t32, x, cellShift, cells);
+#endif
+    const __m128i t = _mm_set1_epi8((char)diffThresh);
+    for (; x + 16 <= x1; x += 16)
+    {
+        addChangedCells16(_mm_loadu_si128((const __m128i*)(cur + x)), _mm_loadu_si128((const __m128i*)(prev + x)),
+                          t, x, cellShift, cells);
+    }
+#endif
+    scalar(x1);
+}
+
+void cellBackgroundCountRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh,
+                            int cellShift, uint16_t* cells)
+{
+    const int rnd = 1 << (kBackgroundShift - 1);
+    int x = x0;
+    auto scalar = [&](int end) {
+        for (; x < end; x++)
+        {
+            const int d = (int)luma[x] - ((bg[x] + rnd) >> kBackgroundShift);
+            cells[x >> cellShift] += ((d < 0 ? -d : d) > diffThresh);
+        }
+    };
+
+#if MOTION_KERNEL_SSE2
+    scalar(std::min(x1, (x0 + 15) & ~15));
+#if MOTION_KERNEL_AVX2
+    {
+        const __m256i t32 = _mm256_set1_epi8((char)diffThresh);
+        const __m256i r32 = _mm256_set1_epi16((short)rnd);
+        for (; x + 32 <= x1; x += 32)
+        {
+            const __m256i l0 = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(bg + x)), r32), kBackgroundShift);
+            const __m256i l1 = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(bg + x + 16)), r32), kBackgroundShift);
+            const __m256i level = _mm256_permute4x64_epi64(_mm256_packus_epi16(l0, l1), 0xD8);
+            addChangedCells32(_mm256_loadu_si256((const __m256i*)(luma + x)), level, t32, x, cellShift, cells);
+        }
+    }
+#endif
+    const __m128i t = _mm_set1_epi8((char)diffThresh);
+    const __m128i r = _mm_set1_epi16((short)rnd);
+    for (; x + 16 <= x1; x += 16)
+    {
+        const __m128i b0 = _mm_loadu_si128((const __m128i*)(bg + x));
+        const __m128i b1 = _mm_loadu_si128((const __m128i*)(bg + x + 8));
+        const __m128i level = _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(b0, r), kBackgroundShift),
+                                               _mm_srli_epi16(_mm_add_epi16(b1, r), kBackgroundShift));
+        addChangedCells16(_mm_loadu_si128((const __m128i*)(luma + x)), level, t, x, cellShift, cells);
+    }
+#endif
+    scalar(x1);
+}
+
+// ------------------------------------------------------------
+// Lighting compensation
+// ------------------------------------------------------------
+namespace
+{
+inline int scaleLevel(int v, int gainQ8)
+{
+    return std::min(255, (v * gainQ8) >> 8);
+}
+
+inline int backgroundLevel(uint16_t b)
+{
+    return (b + (1 << (kBackgroundShift - 1))) >> kBackgroundShift;
+}
+
+#if MOTION_KERNEL_SSE2
+// 16 background values (two loads of 8) -> 16 rounded luma levels.
+inline __m128i backgroundLevel16(const uint16_t* bg)
+{
+    const __m128i rnd = _mm_set1_epi16(1 << (kBackgroundShift - 1));
+    const __m128i b0 = _mm_loadu_si128((const __m128i*)bg);
+    const __m128i b1 = _mm_loadu_si128((const __m128i*)(bg + 8));
+    return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(b0, rnd), kBackgroundShift),
+                            _mm_srli_epi16(_mm_add_epi16(b1, rnd), kBackgroundShift));
+}
+
+// ref * gain / 256 per byte, saturated: (ref << 4) * (gain << 4) >> 16 is
+// exact for gains up to 16x in Q8.
+inline __m128i scaleLevel16(__m128i ref, __m128i gain16)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpacklo_epi8(ref, zero), 4), gain16);
+    const __m128i hi = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpackhi_epi8(ref, zero), 4), gain16);
+    return _mm_packus_epi16(lo, hi);
+}
+
+inline int changedLanes16(__m128i cur, __m128i ref, __m128i thresh)
+{
+    const __m128i d = _mm_or_si128(_mm_subs_epu8(cur, ref), _mm_subs_epu8(ref, cur));
+    const __m128i same = _mm_cmpeq_epi8(_mm_subs_epu8(d, thresh), _mm_setzero_si128());
+    return 16 - popcount32((uint32_t)_mm_movemask_epi8(same));
+}
+
+inline uint64_t horizontalSum64(__m128i v)
+{
+    return (uint64_t)_mm_cvtsi128_si32(v) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+}
+#endif
+
+#if MOTION_KERNEL_AVX2
+inline __m256i backgroundLevel32(const uint16_t* bg)
+{
+    const __m256i rnd = _mm256_set1_epi16(1 << (kBackgroundShift - 1));
+    const __m256i l0 = _mm256_srli_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i*)bg), rnd),
+                                         kBackgroundShift);
+    const __m256i l1 = _mm256_srli_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(bg + 16)), rnd),
+                                         kBackgroundShift);
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(l0, l1), 0xD8);
+}
+
+inline __m256i scaleLevel32(__m256i ref, __m256i gain16)
+{
+    const __m256i lo = _mm256_mulhi_epu16(_mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(ref)), 4),
+                                          gain16);
+    const __m256i hi = _mm256_mulhi_epu16(
+        _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(ref, 1)), 4), gain16);
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+}
+
+inline uint64_t horizontalSum64(__m256i v)
+{
+    return horizontalSum64(_mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+#endif
+} // namespace
+
+void lumaSumsRow(const uint8_t* cur, const uint8_t* ref, int x0, int x1, uint64_t& curSum, uint64_t& refSum)
+{
+    int x = x0;
+#if MOTION_KERNEL_AVX512
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        __m512i c = zero, r = zero;
+        for (; x + 64 <= x1; x += 64)
+        {
+            c = _mm512_add_epi64(c, _mm512_sad_epu8(_mm512_loadu_si512(cur + x), zero));
+            r = _mm512_add_epi64(r, _mm512_sad_epu8(_mm512_loadu_si512(ref + x), zero));
+        }
+        curSum += (uint64_t)_mm512_reduce_add_epi64(c);
+        refSum += (uint64_t)_mm512_reduce_add_epi64(r);
+    }
+#endif
+#if MOTION_KERNEL_AVX2
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i c = zero, r = zero;
+        for (; x + 32 <= x1; x += 32)
+        {
+            c = _mm256_add_epi64(c, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(cur + x)), zero));
+            r = _mm256_add_epi64(r, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(ref + x)), zero));
+        }
+        curSum += horizontalSum64(c);
+        refSum += horizontalSum64(r);
+    }
+#endif
+#if MOTION_KERNEL_SSE2
+    {
+        // psadbw against zero: two 16-bit sums per 16 bytes, widened into 64-bit lanes
+        const __m128i zero = _mm_setzero_si128();
+        __m128i c = zero, r = zero;
+        for (; x + 16 <= x1; x += 16)
+        {
+            c = _mm_add_epi64(c, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(cur + x)), zero));
+            r = _mm_add_epi64(r, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(ref + x)), zero));
+        }
+        curSum += horizontalSum64(c);
+        refSum += horizontalSum64(r);
+    }
+#endif
+    for (; x < x1; x++)
+    {
+        curSum += cur[x];
+        refSum += ref[x];
+    }
+}
+
+void backgroundSumsRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, uint64_t& curSum,
+                       uint64_t& refSum)
+{
+    int x = x0;
+#if MOTION_KERNEL_AVX2
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i c = zero, r = zero;
+        for (; x + 32 <= x1; x += 32)
+        {
+            c = _mm256_add_epi64(c, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(luma + x)), zero));
+            r = _mm256_add_epi64(r, _mm256_sad_epu8(backgroundLevel32(bg + x), zero));
+        }
+        curSum += horizontalSum64(c);
+        refSum += horizontalSum64(r);
+    }
+#endif
+#if MOTION_KERNEL_SSE2
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i c = zero, r = zero;
+        for (; x + 16 <= x1; x += 16)
+        {
+            c = _mm_add_epi64(c, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(luma + x)), zero));
+            r = _mm_add_epi64(r, _mm_sad_epu8(backgroundLevel16(bg + x), zero));
+        }
+        curSum += horizontalSum64(c);
+        refSum += horizontalSum64(r);
+    }
+#endif
+    for (; x < x1; x++)
+    {
+        curSum += luma[x];
+        refSum += (uint64_t)backgroundLevel(bg[x]);
+    }
+}
+
+int gainDiffCountRow(const uint8_t* cur, const uint8_t* ref, int x0, int x1, int diffThresh, int gainQ8)
+{
+    int x = x0;
+    int changed = 0;
+#if MOTION_KERNEL_AVX2
+    {
+        const __m256i t = _mm256_set1_epi8((char)diffThresh);
+        const __m256i g = _mm256_set1_epi16((short)(gainQ8 << 4));
+        for (; x + 32 <= x1; x += 32)
+        {
+            const __m256i scaled = scaleLevel32(_mm256_loadu_si256((const __m256i*)(ref + x)), g);
+            changed += countChanged32(_mm256_loadu_si256((const __m256i*)(cur + x)), scaled, t);
+        }
+    }
+#endif
+#if MOTION_KERNEL_SSE2
+    {
+        const __m128i t = _mm_set1_epi8((char)diffThresh);
+        const __m128i g = _mm_set1_epi16((short)(gainQ8 << 4));
+        for (; x + 16 <= x1; x += 16)
+        {
+            const __m128i scaled = scaleLevel16(_mm_loadu_si128((const __m128i*)(ref + x)), g);
+            changed += changedLanes16(_mm_loadu_si128((const __m128i*)(cur + x)), scaled, t);
+        }
+    }
+#endif
+    for (; x < x1; x++)
+    {
+        const int d = (int)cur[x] - scaleLevel(ref[x], gainQ8);
+        changed += ((d < 0 ? -d : d) > diffThresh);
+    }
+    return changed;
+}
+
+int gainBackgroundCountRow(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh, int gainQ8)
+{
+    int x = x0;
+    int changed = 0;
+#if MOTION_KERNEL_AVX2
+    {
+        const __m256i t = _mm256_set1_epi8((char)diffThresh);
+        const __m256i g = _mm256_set1_epi16((short)(gainQ8 << 4));
+        for (; x + 32 <= x1; x += 32)
+        {
+            const __m256i scaled = scaleLevel32(backgroundLevel32(bg + x), g);
+            changed += countChanged32(_mm256_loadu_si256((const __m256i*)(luma + x)), scaled, t);
+        }
+    }
+#endif
+#if MOTION_KERNEL_SSE2
+    {
+        const __m128i t = _mm_set1_epi8((char)diffThresh);
+        const __m128i g = _mm_set1_epi16((short)(gainQ8 << 4));
+        for (; x + 16 <= x1; x += 16)
+        {
+            const __m128i scaled = scaleLevel16(backgroundLevel16(bg + x), g);
+            changed += changedLanes16(_mm_loadu_si128((const __m128i*)(luma + x)), scaled, t);
+        }
+    }
+#endif
+    for (; x < x1; x++)
+    {
+        const int d = (int)luma[x] - scaleLevel(backgroundLevel(bg[x]), gainQ8);
+        changed += ((d < 0 ? -d : d) > diffThresh);
+    }
+    return changed;
+}
+
+// ------------------------------------------------------------
+// Box-filter helpers for the decimated planes
+// ------------------------------------------------------------
+namespace
+{
+// out = rounding average of two byte rows (pavgb semantics).
+inline void averageRows(const uint8_t* a, const uint8_t* b, uint8_t* out, int n)
+{
+    int x = 0;
+#if MOTION_KERNEL_AVX512
+    for (; x + 64 <= n; x += 64)
+        _mm512_storeu_si512(out + x, _mm512_avg_epu8(_mm512_loadu_si512(a + x), _mm512_loadu_si512(b + x)));
+#endif
+#if MOTION_KERNEL_SSE2
+    for (; x + 16 <= n; x += 16)
+        _mm_storeu_si128((__m128i*)(out + x),
+                         _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(a + x)),
+                                      _mm_loadu_si128((const __m128i*)(b + x))));
+#elif MOTION_KERNEL_NEON
+    for (; x + 16 <= n; x += 16)
+        vst1q_u8(out + x, vrhaddq_u8(vld1q_u8(a + x), vld1q_u8(b + x)));
+#endif
+    for (; x < n; x++)
+        out[x] = (uint8_t)((a[x] + b[x] + 1) >> 1);
+}
+
+// acc[i] = luma[2i] + luma[2i+1], widened to 16 bits.
+inline void pairSumBytes(const uint8_t* luma, uint16_t* acc, int outN)
+{
+    int i = 0;
+#if MOTION_KERNEL_SSE2
+    const __m128i lowMask = _mm_set1_epi16(0x00FF);
+    for (; i + 8 <= outN; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(luma + 2 * i));
+        __m128i s = _mm_add_epi16(_mm_and_si128(v, lowMask), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(acc + i), s);
+    }
+#elif MOTION_KERNEL_NEON
+    for (; i + 8 <= outN; i += 8)
+        vst1q_u16(acc + i, vpaddlq_u8(vld1q_u8(luma + 2 * i)));
+#endif
+    for (; i < outN; i++)
+        acc[i] = (uint16_t)(luma[2 * i] + luma[2 * i + 1]);
+}
+
+// out[i] = (acc[i] + half) >> shift, the rounded mean of 2^shift samples.
+inline void roundShiftRow(const uint16_t* acc, uint8_t* out, int n, int shift)
+{
+    const int rnd = 1 << (shift - 1);
+    int i = 0;
+#if MOTION_KERNEL_SSE2
+    const __m128i vr = _mm_set1_epi16((short)rnd);
+    const __m128i vs = _mm_cvtsi32_si128(shift);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_srl_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i*)(acc + i)), vr), vs);
+        __m128i b = _mm_srl_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i*)(acc + i + 8)), vr), vs);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+    }
+#elif MOTION_KERNEL_NEON
+    const int16x8_t vs = vdupq_n_s16((int16_t)-shift);
+    for (; i + 16 <= n; i += 16)
+    {
+        uint16x8_t a = vrshlq_u16(vld1q_u16(acc + i), vs);
+        uint16x8_t b = vrshlq_u16(vld1q_u16(acc + i + 8), vs);
+        vst1q_u8(out + i, vcombine_u8(vqmovn_u16(a), vqmovn_u16(b)));
+    }
+#endif
+    for (; i < n; i++)
+        out[i] = (uint8_t)((acc[i] + rnd) >> shift);
+}
+
+// acc[i] = acc[2i] + acc[2i+1] for i < outN (in place, front to back).
+inline void pairSumRow(uint16_t* acc, int outN)
+{
+    int i = 0;
+#if MOTION_KERNEL_SSE2
+    const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+    for (; i + 8 <= outN; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + 2 * i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(acc + 2 * i + 8));
+        __m128i sa = _mm_add_epi32(_mm_and_si128(a, lowMask), _mm_srli_epi32(a, 16));
+        __m128i sb = _mm_add_epi32(_mm_and_si128(b, lowMask), _mm_srli_epi32(b, 16));
+        // Sums are at most 8 * 255, so the signed pack never saturates.
+        _mm_storeu_si128((__m128i*)(acc + i), _mm_packs_epi32(sa, sb));
+    }
+#elif MOTION_KERNEL_NEON
+    for (; i + 8 <= outN; i += 8)
+    {
+        uint16x8x2_t ab = vld2q_u16(acc + 2 * i);
+        vst1q_u16(acc + i, vaddq_u16(ab.val[0], ab.val[1]));
+    }
+#endif
+    for (; i < outN; i++)
+        acc[i] = (uint16_t)(acc[2 * i] + acc[2 * i + 1]);
+}
+} // namespace
+
+void decimateLumaRow(const uint8_t* const* srcRows, bool isBgr, int factor, int outWidth,
+                     uint8_t* out, DecimationScratch& scratch)
+{
+    const int inWidth = outWidth * factor;
+    const int rowBytes = inWidth * (isBgr ? 3 : 1);
+
+    scratch.averaged.resize((size_t)rowBytes * (factor / 2));
+    scratch.lumaRow.resize((size_t)inWidth);
+    scratch.acc.resize((size_t)inWidth / 2);
+
+    // Vertical: pairwise rounding averages of the source rows, still in BGR.
+    // Every source byte is touched once by a single instruction per 16 bytes,
+    // so the luma math below runs on 1/factor of the pixels.
+    const uint8_t* row = srcRows[0];
+    if (factor > 1)
+    {
+        uint8_t* level = scratch.averaged.data();
+        for (int i = 0; i < factor; i += 2)
+            averageRows(srcRows[i], srcRows[i + 1], level + (i / 2) * rowBytes, rowBytes);
+        for (int n = factor / 2; n > 1; n /= 2)
+            for (int i = 0; i < n; i += 2)
+                averageRows(level + i * rowBytes, level + (i + 1) * rowBytes, level + (i / 2) * rowBytes, rowBytes);
+        row = level;
+    }
+
+    const uint8_t* luma = row;
+    if (isBgr)
+    {
+        bgrToLumaRow(row, scratch.lumaRow.data(), inWidth);
+        luma = scratch.lumaRow.data();
+    }
+
+    // Horizontal: pair-sum the bytes, keep halving in 16 bits until the row
+    // is outWidth long, then divide by factor with rounding.
+    uint16_t* acc = scratch.acc.data();
+    pairSumBytes(luma, acc, inWidth / 2);
+    int shift = 1;
+    for (int n = inWidth / 2; n > outWidth; n /= 2)
+    {
+        pairSumRow(acc, n / 2);
+        shift++;
+    }
+    roundShiftRow(acc, out, outWidth, shift);
+}
+
+// ------------------------------------------------------------
+// Block matching
+// ------------------------------------------------------------
+namespace
+{
+// Sum of absolute differences of two size x size blocks (8 or 16). psadbw
+// sums eight byte differences per 64-bit lane, so a 16-wide row is one
+// instruction, and rows are packed two (SSE2, NEON) or four (AVX2) per
+// register for the 8-wide blocks.
+inline int blockSad(const uint8_t* a, size_t aStep, const uint8_t* b, size_t bStep, int size)
+{
+#if MOTION_KERNEL_AVX2
+    __m256i acc = _mm256_setzero_si256();
+    if (size == 16)
+    {
+        for (int y = 0; y < 16; y += 2, a += 2 * aStep, b += 2 * bStep)
+        {
+            const __m256i ra = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)a)),
+                                                       _mm_loadu_si128((const __m128i*)(a + aStep)), 1);
+            const __m256i rb = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)b)),
+                                                       _mm_loadu_si128((const __m128i*)(b + bStep)), 1);
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(ra, rb));
+        }
+    }
+    else
+    {
+        for (int y = 0; y < 8; y += 4, a += 4 * aStep, b += 4 * bStep)
+        {
+            const __m128i a01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a),
+                                                   _mm_loadl_epi64((const __m128i*)(a + aStep)));
+            const __m128i a23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(a + 2 * aStep)),
+                                                   _mm_loadl_epi64((const __m128i*)(a + 3 * aStep)));
+            const __m128i b01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)b),
+                                                   _mm_loadl_epi64((const __m128i*)(b + bStep)));
+            const __m128i b23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(b + 2 * bStep)),
+                                                   _mm_loadl_epi64((const __m128i*)(b + 3 * bStep)));
+            const __m256i ra = _mm256_inserti128_si256(_mm256_castsi128_si256(a01), a23, 1);
+            const __m256i rb = _mm256_inserti128_si256(_mm256_castsi128_si256(b01), b23, 1);
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(ra, rb));
+        }
+    }
+    return (int)horizontalSum64(acc);
+#elif MOTION_KERNEL_SSE2
+    __m128i acc = _mm_setzero_si128();
+    if (size == 16)
+    {
+        for (int y = 0; y < 16; y++, a += aStep, b += bStep)
+        {
+            const __m128i ra = _mm_loadu_si128((const __m128i*)a);
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(ra, _mm_loadu_si128((const __m128i*)b)));
+        }
+    }
+    else
+    {
+        for (int y = 0; y < 8; y += 2, a += 2 * aStep, b += 2 * bStep)
+        {
+            const __m128i ra = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a),
+                                                  _mm_loadl_epi64((const __m128i*)(a + aStep)));
+            const __m128i rb = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)b),
+                                                  _mm_loadl_epi64((const __m128i*)(b + bStep)));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(ra, rb));
+        }
+    }
+    return (int)horizontalSum64(acc);
+#elif MOTION_KERNEL_NEON
+    // At most 2 * 16 differences of 255 per 16-bit lane
+    uint16x8_t acc = vdupq_n_u16(0);
+    if (size == 16)
+    {
+        for (int y = 0; y < 16; y++, a += aStep, b += bStep)
+            acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a), vld1q_u8(b)));
+    }
+    else
+    {
+        for (int y = 0; y < 8; y += 2, a += 2 * aStep, b += 2 * bStep)
+            acc = vpadalq_u8(acc, vabdq_u8(vcombine_u8(vld1_u8(a), vld1_u8(a + aStep)),
+                                           vcombine_u8(vld1_u8(b), vld1_u8(b + bStep))));
+    }
+    return horizontalSum(vpaddlq_u16(acc));
+#else
+    int sad = 0;
+    for (int y = 0; y < size; y++, a += aStep, b += bStep)
+        for (int x = 0; x < size; x++)
+        {
+            const int d = (int)a[x] - (int)b[x];
+            sad += d < 0 ? -d : d;
+        }
+    return sad;
+#endif
+}
+} // namespace
+
+BlockMatch blockMatch(const uint8_t* cur, size_t curStep, const uint8_t* ref, size_t refStep, int size, int dx0,
+                      int dx1, int dy0, int dy1)
+{
+    // Full search: every shift, the unshifted block first so it keeps ties
+    BlockMatch best;
+    best.sad = best.zeroSad = blockSad(cur, curStep, ref, refStep, size);
+    for (int dy = dy0; dy <= dy1; dy++)
+    {
+        const uint8_t* row = ref + (ptrdiff_t)dy * (ptrdiff_t)refStep;
+        for (int dx = dx0; dx <= dx1; dx++)
+        {
+            if (dx == 0 && dy == 0) continue;
+            const int sad = blockSad(cur, curStep, row + dx, refStep, size);
+            if (sad < best.sad)
+            {
+                best.sad = sad;
+                best.dx = dx;
+                best.dy = dy;
+            }
+        }
+    }
+    return best;
+}
+
+// ============================================================
+// Dispatch table of this build
+// ============================================================
+extern const RowKernels kRowKernels = {
+    MOTION_KERNEL_STR(MOTION_KERNEL_VARIANT),
+    bgrToLumaRow,
+    lumaDiffCountRow,
+    grayDiffCountRow,
+    backgroundDiffUpdateRow,
+    cellDiffCountRow,
+    cellBackgroundCountRow,
+    lumaSumsRow,
+    backgroundSumsRow,
+    gainDiffCountRow,
+    gainBackgroundCountRow,
+    decimateLumaRow,
+    blockMatch,
+};
+} // namespace MOTION_KERNEL_VARIANT
+} // namespace motion
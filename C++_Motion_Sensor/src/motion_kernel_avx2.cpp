@@ -0,0 +1,11 @@
+// AVX2 build of the row kernels (compiled with -mavx2; see CMakeLists.txt).
+
+#include "motion_kernel_variants.hpp"
+
+#if MOTION_KERNEL_X86
+#define MOTION_KERNEL_VARIANT avx2
+#define MOTION_KERNEL_AVX2 1
+#define MOTION_KERNEL_SSSE3 1
+#define MOTION_KERNEL_SSE2 1
+#include "motion_kernel.simd.hpp"
+#endif
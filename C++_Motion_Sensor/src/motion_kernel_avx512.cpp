@@ -0,0 +1,13 @@
+// AVX-512 build of the row kernels (compiled with -mavx512f -mavx512bw; see
+// CMakeLists.txt): 64-byte paths where a kernel has one, AVX2 elsewhere.
+
+#include "motion_kernel_variants.hpp"
+
+#if MOTION_KERNEL_X86
+#define MOTION_KERNEL_VARIANT avx512
+#define MOTION_KERNEL_AVX512 1
+#define MOTION_KERNEL_AVX2 1
+#define MOTION_KERNEL_SSSE3 1
+#define MOTION_KERNEL_SSE2 1
+#include "motion_kernel.simd.hpp"
+#endif
@@ -0,0 +1,10 @@
+// NEON build of the row kernels (AArch64, or 32-bit ARM compiled with
+// -mfpu=neon; see CMakeLists.txt).
+
+#include "motion_kernel_variants.hpp"
+
+#if MOTION_KERNEL_ARM
+#define MOTION_KERNEL_VARIANT neon
+#define MOTION_KERNEL_NEON 1
+#include "motion_kernel.simd.hpp"
+#endif
@@ -0,0 +1,5 @@
+// Portable build of the row kernels: no vector intrinsics. Every CPU runs it,
+// and the other builds are checked against it (bench_kernel_variants).
+
+#define MOTION_KERNEL_VARIANT scalar
+#include "motion_kernel.simd.hpp"
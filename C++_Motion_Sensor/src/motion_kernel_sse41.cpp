@@ -0,0 +1,11 @@
+// SSE4.1 build of the row kernels (the SSSE3 / SSE2 paths, compiled with
+// -msse4.1; see CMakeLists.txt).
+
+#include "motion_kernel_variants.hpp"
+
+#if MOTION_KERNEL_X86
+#define MOTION_KERNEL_VARIANT sse41
+#define MOTION_KERNEL_SSSE3 1
+#define MOTION_KERNEL_SSE2 1
+#include "motion_kernel.simd.hpp"
+#endif
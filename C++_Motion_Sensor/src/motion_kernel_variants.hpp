@@ -0,0 +1,65 @@
+#pragma once
+
+// Per-instruction-set builds of the row kernels (motion_kernel.simd.hpp).
+
+#include "motion_kernel.hpp"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MOTION_KERNEL_X86 1
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__arm__) || defined(_M_ARM)
+#define MOTION_KERNEL_ARM 1
+#endif
+
+namespace motion
+{
+// ============================================================
+// RowKernels
+// ============================================================
+//
+// Why this exists:
+// - One binary has to run on x86 servers with and without AVX2 / AVX-512
+//   and on a Raspberry Pi, so the kernel can't be picked at compile time
+// - Every row kernel is built once per instruction set, each build in its
+//   own namespace (scalar, sse41, avx2, avx512, neon) with its own flags
+// - The public row functions forward through the table picked at startup;
+//   one indirect call per row, span or block, never per pixel
+//
+struct RowKernels
+{
+    const char* name;
+    void (*bgrToLuma)(const uint8_t* bgr, uint8_t* luma, int width);
+    int  (*lumaDiffCount)(const uint8_t* bgr, const uint8_t* prev, uint8_t* cur, int width, int diffThresh);
+    int  (*grayDiffCount)(const uint8_t* gray, const uint8_t* prev, uint8_t* cur, int width, int diffThresh);
+    int  (*backgroundDiffUpdate)(const uint8_t* luma, uint16_t* bg, int width, int diffThresh, int alphaQ15);
+    void (*cellDiffCount)(const uint8_t* cur, const uint8_t* prev, int x0, int x1, int diffThresh, int cellShift,
+                          uint16_t* cells);
+    void (*cellBackgroundCount)(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh,
+                                int cellShift, uint16_t* cells);
+    void (*lumaSums)(const uint8_t* cur, const uint8_t* ref, int x0, int x1, uint64_t& curSum, uint64_t& refSum);
+    void (*backgroundSums)(const uint8_t* luma, const uint16_t* bg, int x0, int x1, uint64_t& curSum,
+                           uint64_t& refSum);
+    int  (*gainDiffCount)(const uint8_t* cur, const uint8_t* ref, int x0, int x1, int diffThresh, int gainQ8);
+    int  (*gainBackgroundCount)(const uint8_t* luma, const uint16_t* bg, int x0, int x1, int diffThresh,
+                                int gainQ8);
+    void (*decimateLuma)(const uint8_t* const* srcRows, bool isBgr, int factor, int outWidth, uint8_t* out,
+                         DecimationScratch& scratch);
+    BlockMatch (*blockMatch)(const uint8_t* cur, size_t curStep, const uint8_t* ref, size_t refStep, int size,
+                             int dx0, int dx1, int dy0, int dy1);
+};
+
+// The builds (only those of the target architecture are compiled in).
+namespace scalar { extern const RowKernels kRowKernels; }
+#if MOTION_KERNEL_X86
+namespace sse41  { extern const RowKernels kRowKernels; }
+namespace avx2   { extern const RowKernels kRowKernels; }
+namespace avx512 { extern const RowKernels kRowKernels; }
+#elif MOTION_KERNEL_ARM
+namespace neon   { extern const RowKernels kRowKernels; }
+#endif
+
+// Table the public row functions use: the best build this CPU runs, or the
+// one named by MOTION_KERNEL_ISA, chosen on first use (see useKernelVariant).
+const RowKernels& rowKernels();
+} // namespace motion
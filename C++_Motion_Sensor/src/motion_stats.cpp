@@ -0,0 +1,69 @@
+#include "motion_stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+namespace
+{
+// Bin b covers ratios [(b / kBins)^2, ((b + 1) / kBins)^2)
+int binOf(double ratio)
+{
+    const int b = (int)(sqrt(max(0.0, ratio)) * MotionWindowStats::kBins);
+    return min(b, MotionWindowStats::kBins - 1);
+}
+
+double binMiddle(int b)
+{
+    const double s = (b + 0.5) / MotionWindowStats::kBins;
+    return s * s;
+}
+} // namespace
+
+void MotionWindowStats::add(double ratio, bool motion)
+{
+    frames++;
+    if (motion) motionFrames++;
+    ratioSum += ratio;
+    ratioMax = max(ratioMax, ratio);
+    bins[binOf(ratio)]++;
+}
+
+void MotionWindowStats::merge(const MotionWindowStats& other)
+{
+    frames += other.frames;
+    motionFrames += other.motionFrames;
+    ratioSum += other.ratioSum;
+    ratioMax = max(ratioMax, other.ratioMax);
+    for (int b = 0; b < kBins; b++) bins[b] += other.bins[b];
+}
+
+double MotionWindowStats::percentile(double p) const
+{
+    if (frames == 0) return 0.0;
+
+    // Nearest rank: the ceil(p * frames)-th smallest ratio
+    const uint32_t rank = max(1u, (uint32_t)ceil(min(1.0, max(0.0, p)) * frames));
+    uint32_t seen = 0;
+    for (int b = 0; b < kBins; b++)
+    {
+        seen += bins[b];
+        if (seen >= rank) return min(binMiddle(b), ratioMax);
+    }
+    return ratioMax;
+}
+
+const char* windowStatsColumns()
+{
+    return "Frames,MotionFrames,MeanRatio,MaxRatio,P95Ratio";
+}
+
+string formatWindowStats(const MotionWindowStats& s)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%u,%u,%.5f,%.5f,%.5f", s.frames, s.motionFrames, s.mean(), s.ratioMax,
+             s.percentile(0.95));
+    return buf;
+}
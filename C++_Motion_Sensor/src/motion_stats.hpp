@@ -0,0 +1,50 @@
+#pragma once
+
+// Constant-memory statistics of the changed-pixel ratio over one per-second
+// window.
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// ============================================================
+// MotionWindowStats
+// ============================================================
+//
+// Why this exists:
+// - The per-second CSV collapses up to 60 frame ratios into one boolean;
+//   how strong the motion was (for tuning MOTION_RATIO, for scoring alerts)
+//   is thrown away
+// - This keeps count, frames at or over MOTION_RATIO, mean, max and an
+//   approximate percentile of the ratio in a fixed 256-bin histogram: one
+//   add per frame, no allocation, the same size at 5 fps or 120
+// - Bins are spaced on the square root of the ratio, so they are narrow
+//   where thresholds live (about 0.001 wide around a 2% ratio) and wider
+//   towards a fully changed frame
+//
+struct MotionWindowStats
+{
+    static constexpr int kBins = 256;
+
+    uint32_t frames = 0;       // frames measured this window
+    uint32_t motionFrames = 0; // of those, at or over MOTION_RATIO
+    double   ratioSum = 0.0;
+    double   ratioMax = 0.0;
+    std::array<uint32_t, kBins> bins{};
+
+    void add(double ratio, bool motion);
+    void merge(const MotionWindowStats& other);
+    void clear() { *this = MotionWindowStats(); }
+
+    double mean() const { return frames ? ratioSum / frames : 0.0; }
+
+    // Ratio at or below which `p` (0..1) of the frames fall: the middle of the
+    // bin holding that rank, capped at the exact max. 0 without frames.
+    double percentile(double p) const;
+};
+
+// Header of <log>_stats.csv after "Second,Camera".
+const char* windowStatsColumns();
+
+// The matching columns: frames, motion frames, mean, max and p95 ratio.
+std::string formatWindowStats(const MotionWindowStats& s);
@@ -0,0 +1,148 @@
+#include "motion_vectors.hpp"
+
+#include "motion_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+constexpr double kPi = 3.14159265358979323846;
+
+// Sector of a shift: 0 = E, 1 = NE, ... counter-clockwise (y points down)
+int sectorOf(float dx, float dy)
+{
+    const double deg = atan2(-(double)dy, (double)dx) * 180.0 / kPi;
+    const int s = (int)lround(deg / 45.0);
+    return (s + MotionFlowStats::kDirections) % MotionFlowStats::kDirections;
+}
+} // namespace
+
+// ------------------------------------------------------------
+// MotionVectorEstimator
+// ------------------------------------------------------------
+
+MotionVectorEstimator::MotionVectorEstimator(int range) : searchRange(min(32, max(1, range)))
+{
+}
+
+void MotionVectorEstimator::configure(int cols, int rows, int cellSize, int scale, Size planeSize)
+{
+    gridCols = max(0, cols);
+    gridRows = max(0, rows);
+    this->cellSize = cellSize;
+    this->scale = scale;
+    plane = planeSize;
+}
+
+void MotionVectorEstimator::estimate(const uint16_t* cells, int minCellCount, const Mat& cur, const Mat& ref,
+                                     vector<MotionVector>& out) const
+{
+    out.clear();
+    if (cur.size() != plane || ref.size() != plane) return;
+    minCellCount = max(1, minCellCount);
+
+    for (int r = 0; r < gridRows; r++)
+    {
+        const int y = r * cellSize;
+        if (y + cellSize > plane.height) break;
+        const uint16_t* row = cells + (size_t)r * gridCols;
+        const int dy0 = -min(searchRange, y);
+        const int dy1 = min(searchRange, plane.height - cellSize - y);
+
+        for (int c = 0; c < gridCols; c++)
+        {
+            const int x = c * cellSize;
+            if (row[c] < minCellCount || x + cellSize > plane.width) continue;
+            const int dx0 = -min(searchRange, x);
+            const int dx1 = min(searchRange, plane.width - cellSize - x);
+
+            const motion::BlockMatch m = motion::blockMatch(cur.ptr<uint8_t>(y) + x, cur.step, ref.ptr<uint8_t>(y) + x,
+                                                            ref.step, cellSize, dx0, dx1, dy0, dy1);
+            if ((m.dx == 0 && m.dy == 0) || 2 * m.sad >= m.zeroSad) continue;
+
+            // This block was at +(dx, dy) in the previous frame: it moved by -(dx, dy)
+            MotionVector v;
+            v.center = Point2f((float)((x * 2 + cellSize) * scale) * 0.5f, (float)((y * 2 + cellSize) * scale) * 0.5f);
+            v.shift = Point2f((float)(-m.dx * scale), (float)(-m.dy * scale));
+            v.sad = m.sad;
+            out.push_back(v);
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// MotionFlowStats
+// ------------------------------------------------------------
+
+void MotionFlowStats::add(const vector<MotionVector>& frameVectors)
+{
+    frames++;
+    for (const MotionVector& v : frameVectors)
+    {
+        const int s = sectorOf(v.shift.x, v.shift.y);
+        vectors++;
+        count[s]++;
+        sumDx[s] += v.shift.x;
+        sumDy[s] += v.shift.y;
+        sumLength[s] += sqrt((double)v.shift.x * v.shift.x + (double)v.shift.y * v.shift.y);
+    }
+}
+
+void MotionFlowStats::merge(const MotionFlowStats& other, double scale)
+{
+    frames += other.frames;
+    vectors += other.vectors;
+    for (int s = 0; s < kDirections; s++)
+    {
+        count[s] += other.count[s];
+        sumDx[s] += other.sumDx[s] * scale;
+        sumDy[s] += other.sumDy[s] * scale;
+        sumLength[s] += other.sumLength[s] * scale;
+    }
+}
+
+int MotionFlowStats::dominant() const
+{
+    if (vectors == 0) return -1;
+    return (int)(max_element(count.begin(), count.end()) - count.begin());
+}
+
+double MotionFlowStats::direction() const
+{
+    const int s = dominant();
+    if (s < 0) return 0.0;
+    const double deg = atan2(-sumDy[s], sumDx[s]) * 180.0 / kPi;
+    return deg < 0.0 ? deg + 360.0 : deg;
+}
+
+double MotionFlowStats::speed() const
+{
+    const int s = dominant();
+    return (s < 0) ? 0.0 : sumLength[s] / count[s];
+}
+
+const char* directionName(int sector)
+{
+    static const char* const names[MotionFlowStats::kDirections] = {"E", "NE", "N", "NW", "W", "SW", "S", "SE"};
+    return (sector < 0 || sector >= MotionFlowStats::kDirections) ? "-" : names[sector];
+}
+
+const char* flowColumns()
+{
+    return "Frames,Vectors,Direction,DirectionDeg,DirectionShare,SpeedPxPerSec";
+}
+
+string formatFlowStats(const MotionFlowStats& s)
+{
+    const int d = s.dominant();
+    const double share = (d < 0) ? 0.0 : (double)s.count[d] / s.vectors;
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%u,%u,%s,%.1f,%.3f,%.1f", s.frames, s.vectors, directionName(d), s.direction(), share,
+             s.speed() * s.frames);
+    return buf;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// Motion vectors: how far the changed cells moved since the previous frame,
+// and the dominant direction and speed over a per-second window.
+
+#include <opencv2/core.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Movement of one changed cell, in frame pixels.
+struct MotionVector
+{
+    cv::Point2f center; // cell centre in this frame
+    cv::Point2f shift;  // movement since the previous frame (x right, y down)
+    int sad = 0;        // block difference left at that shift (plane pixels)
+};
+
+// ============================================================
+// MotionVectorEstimator
+// ============================================================
+//
+// Why this exists:
+// - Blobs say where the motion is; tracking, alert rules ("someone walking
+//   towards the door") and false-alarm filters also need which way it goes
+//   and how fast
+// - Dense optical flow (calcOpticalFlowFarneback) costs tens of ms per frame
+//   and spends nearly all of it on pixels that didn't change
+// - The detector already counts changed pixels per 8x8 or 16x16 cell; only
+//   the cells that are on get a vector: a full search of the previous plane
+//   within +/- range pixels for the block that matches best (psadbw sums of
+//   absolute differences, motion_kernel.hpp)
+// - A vector only counts when the best shift explains at least half of the
+//   block's difference; flat interiors of a moving object match anywhere and
+//   are dropped instead of reported as still
+//
+// configure() sizes everything; estimate() never allocates.
+//
+class MotionVectorEstimator
+{
+public:
+    // Search +/- range plane pixels around each cell (1 .. 32).
+    explicit MotionVectorEstimator(int range = 8);
+
+    // Grid of cols x rows cells of `cellSize` plane pixels (8 or 16) over a
+    // plane of planeSize; `scale` maps plane pixels to frame pixels.
+    void configure(int cols, int rows, int cellSize, int scale, cv::Size planeSize);
+
+    // Vectors of the cells with minCellCount or more changed pixels, matching
+    // `cur` (this frame's plane) against `ref` (the previous one). Cells the
+    // plane edge cuts short get none.
+    void estimate(const uint16_t* cells, int minCellCount, const cv::Mat& cur, const cv::Mat& ref,
+                  std::vector<MotionVector>& out) const;
+
+    int range() const { return searchRange; }
+
+private:
+    int searchRange;
+    int gridCols = 0;
+    int gridRows = 0;
+    int cellSize = 8;
+    int scale = 1;
+    cv::Size plane;
+};
+
+// ============================================================
+// MotionFlowStats
+// ============================================================
+//
+// Vectors of a per-second window, binned by compass direction (8 sectors of
+// 45 degrees, E = right, N = up): the dominant direction is the sector with
+// the most vectors, and its speed the mean length of their shifts. Constant
+// size, one add per frame.
+//
+struct MotionFlowStats
+{
+    static constexpr int kDirections = 8;
+
+    uint32_t frames = 0;  // frames estimated this window
+    uint32_t vectors = 0;
+    std::array<uint32_t, kDirections> count{};
+    std::array<double, kDirections> sumDx{}; // frame pixels per frame
+    std::array<double, kDirections> sumDy{};
+    std::array<double, kDirections> sumLength{};
+
+    // One frame's vectors (none is still a frame).
+    void add(const std::vector<MotionVector>& frameVectors);
+
+    // Add another window's vectors, their shifts multiplied by `scale`.
+    void merge(const MotionFlowStats& other, double scale = 1.0);
+    void clear() { *this = MotionFlowStats(); }
+
+    // Sector with the most vectors (0 = E, counter-clockwise), -1 without any.
+    int dominant() const;
+
+    // Angle of the dominant sector's mean shift, degrees counter-clockwise
+    // from right (0 .. 360), and its mean length in frame pixels per frame.
+    double direction() const;
+    double speed() const;
+};
+
+// "E", "NE", "N", ... for a sector, "-" for -1.
+const char* directionName(int sector);
+
+// Header of <log>_flow.csv after "Second,Camera".
+const char* flowColumns();
+
+// The matching columns: frames, vectors, dominant direction, its angle, its
+// share of the vectors, and its speed in frame pixels per second (the mean
+// shift times the frames of the window, which spans one second).
+std::string formatFlowStats(const MotionFlowStats& s);
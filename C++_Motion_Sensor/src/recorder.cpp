@@ -0,0 +1,269 @@
+#include "recorder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+using Clock = chrono::steady_clock;
+
+// Output rates outside this range are measurement glitches, not cameras.
+constexpr double kMinFps = 1.0;
+constexpr double kMaxFps = 240.0;
+
+// Used only when a clip stops before two distinct frames were ever seen;
+// a single frame plays the same at any rate.
+constexpr double kFallbackFps = 30.0;
+} // namespace
+
+// ------------------------------------------------------------
+// FrameRateEstimator
+// ------------------------------------------------------------
+FrameRateEstimator::FrameRateEstimator(double warmupSec, double historySec)
+    : warmupSec(max(0.1, warmupSec)), historySec(max(this->warmupSec, historySec))
+{
+}
+
+void FrameRateEstimator::addSample(Clock::time_point captureTime)
+{
+    if (!samples.empty() && captureTime <= samples.back()) return;
+    samples.push_back(captureTime);
+
+    // Keep the shortest tail that still spans the history.
+    const auto history = chrono::duration<double>(historySec);
+    while (samples.size() > 2 && samples.back() - samples[1] >= history)
+        samples.pop_front();
+}
+
+bool FrameRateEstimator::ready() const
+{
+    return samples.size() >= 3 &&
+           samples.back() - samples.front() >= chrono::duration<double>(warmupSec);
+}
+
+double FrameRateEstimator::fps() const
+{
+    if (samples.size() < 2) return 0.0;
+    double span = chrono::duration<double>(samples.back() - samples.front()).count();
+    return (span > 0.0) ? (double)(samples.size() - 1) / span : 0.0;
+}
+
+// ------------------------------------------------------------
+// Recorder
+// ------------------------------------------------------------
+Recorder::Recorder(const RecorderOptions& options, const WriterOptions& writerOptions)
+    : options(options), writer(writerOptions), estimator(options.warmupSec)
+{
+}
+
+Recorder::~Recorder()
+{
+    stop();
+}
+
+bool Recorder::start(const string& videoPath, int fourcc, Size frameSize, bool isColor)
+{
+    stop();
+
+    this->videoPath = videoPath;
+    this->fourcc = fourcc;
+    this->frameSize = frameSize;
+    this->isColor = isColor;
+
+    outFps = 0.0;
+    slot = 0;
+    havePending = false;
+    pending = Pending();
+    warmup.clear();
+    sourceFrames = duplicated = skipped = 0;
+
+    recording = true;
+    openFailed = false;
+
+    // Rate already known: open now so a bad path is reported right away.
+    if (options.fixedFps > 0.0 || estimator.ready())
+    {
+        if (!openWriter())
+        {
+            recording = false;
+            openFailed = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Recorder::openWriter()
+{
+    double fps = (options.fixedFps > 0.0) ? options.fixedFps : estimator.fps();
+    if (fps <= 0.0) fps = kFallbackFps;
+    outFps = min(kMaxFps, max(kMinFps, fps));
+
+    const string indexPath = options.writeIndex ? frameIndexPath(videoPath) : string();
+    return writer.open(videoPath, fourcc, outFps, frameSize, isColor, indexPath);
+}
+
+void Recorder::addFrame(const Mat& frame, Clock::time_point captureTime, int logSecond, PixelFormat format)
+{
+    if (frame.empty()) return;
+
+    Pending p;
+    p.frame = frame;
+    p.format = format;
+    p.captureTime = captureTime;
+    p.logSecond = logSecond;
+    add(std::move(p));
+}
+
+void Recorder::addPacket(const EncodedFrame& packet, Clock::time_point captureTime, int logSecond)
+{
+    if (!packet || packet->empty()) return;
+
+    Pending p;
+    p.packet = packet;
+    p.captureTime = captureTime;
+    p.logSecond = logSecond;
+    add(std::move(p));
+}
+
+void Recorder::add(Pending p)
+{
+    // Program 3 can see the same ring slot twice; it's still one frame.
+    if (p.captureTime == lastCapture) return;
+    lastCapture = p.captureTime;
+
+    estimator.addSample(p.captureTime);
+    if (!recording) return;
+
+    sourceFrames++;
+
+    if (outFps > 0.0)
+    {
+        resample(p);
+        return;
+    }
+
+    // Still measuring: hold the frame (by reference) until the rate is known.
+    warmup.push_back(std::move(p));
+
+    if (!estimator.ready()) return;
+
+    if (!openWriter())
+    {
+        recording = false;
+        openFailed = true;
+        warmup.clear();
+        return;
+    }
+
+    vector<Pending> held;
+    held.swap(warmup);
+    for (const Pending& h : held)
+        resample(h);
+}
+
+void Recorder::resample(const Pending& p)
+{
+    if (!havePending)
+    {
+        firstSlot = p.captureTime;
+    }
+    else
+    {
+        // Slot k is filled by the newest frame captured before the midpoint
+        // between slots k and k+1, i.e. the frame nearest to slot k's time.
+        const chrono::duration<double> period(1.0 / outFps);
+        while (firstSlot + chrono::duration_cast<Clock::duration>(period * ((double)slot + 0.5)) <= p.captureTime)
+        {
+            emit(pending);
+            slot++;
+        }
+        if (!pending.emitted) skipped++;
+    }
+
+    pending = p;
+    pending.emitted = false;
+    havePending = true;
+}
+
+void Recorder::emit(Pending& p)
+{
+    FrameStamp stamp;
+    stamp.captureTime = p.captureTime;
+    stamp.logSecond = p.logSecond;
+    stamp.duplicate = p.emitted;
+    stamp.format = p.format;
+
+    if (p.frame.empty())
+        writer.write(p.packet, stamp);
+    else
+        writer.write(p.frame, stamp);
+    if (p.emitted) duplicated++;
+    p.emitted = true;
+}
+
+void Recorder::stop()
+{
+    if (!recording) return;
+
+    // Stopped during warm-up: write what we have at the best rate we know.
+    if (outFps <= 0.0 && !warmup.empty())
+    {
+        if (openWriter())
+        {
+            vector<Pending> held;
+            held.swap(warmup);
+            for (const Pending& h : held)
+                resample(h);
+        }
+        else
+        {
+            openFailed = true;
+        }
+        warmup.clear();
+    }
+
+    // The last frame still owns its slot.
+    if (havePending && !pending.emitted)
+        emit(pending);
+
+    pending = Pending();
+    havePending = false;
+
+    writer.release(); // drains the encoder queue
+    recording = false;
+}
+
+RecorderStats Recorder::stats() const
+{
+    RecorderStats s;
+    s.fps = outFps;
+    s.measured = (options.fixedFps <= 0.0);
+    s.sourceFrames = sourceFrames;
+    s.duplicated = duplicated;
+    s.skipped = skipped;
+    s.writer = writer.stats();
+    return s;
+}
+
+string frameIndexPath(const string& videoPath)
+{
+    fs::path p(videoPath);
+    p.replace_extension();
+    p += "_frames.csv";
+    return p.string();
+}
+
+string formatRecorderStats(const RecorderStats& s)
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%.2f fps (%s), %llu source frames, %llu duplicated, %llu skipped; ",
+             s.fps, s.measured ? "measured" : "fixed", (unsigned long long)s.sourceFrames,
+             (unsigned long long)s.duplicated, (unsigned long long)s.skipped);
+    return buf + formatWriterStats(s.writer);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+// Per-camera recording at the camera's real frame rate.
+
+#include "async_video_writer.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Recording-rate switches (see run_options.hpp for the command-line side).
+struct RecorderOptions
+{
+    // Output frame rate. 0 = measure the camera's cadence instead.
+    double fixedFps = 0.0;
+
+    // Capture history needed before the rate is trusted (seconds). The
+    // estimate keeps refining over up to 10 s of history after that.
+    double warmupSec = 1.0;
+
+    // Write "<video>_frames.csv" next to each video (see AsyncVideoWriter::open).
+    bool writeIndex = true;
+};
+
+// ============================================================
+// FrameRateEstimator
+// ============================================================
+//
+// Frames per second over the last `historySec` seconds of capture timestamps.
+// Timing jitter averages out over the span, so a longer history gives a
+// steadier rate. Repeated timestamps (the same frame seen twice) are ignored.
+//
+class FrameRateEstimator
+{
+public:
+    explicit FrameRateEstimator(double warmupSec = 1.0, double historySec = 10.0);
+
+    void addSample(std::chrono::steady_clock::time_point captureTime);
+
+    // True once the samples span at least warmupSec.
+    bool ready() const;
+
+    // Measured rate, 0 until at least two samples.
+    double fps() const;
+
+private:
+    double warmupSec;
+    double historySec;
+    std::deque<std::chrono::steady_clock::time_point> samples;
+};
+
+struct RecorderStats
+{
+    double   fps = 0.0;       // output rate (0 while still measuring)
+    bool     measured = false;
+    uint64_t sourceFrames = 0; // distinct capture frames offered while recording
+    uint64_t duplicated = 0;   // output slots filled by repeating a frame
+    uint64_t skipped = 0;      // capture frames replaced before their slot came up
+    AsyncWriterStats writer;
+};
+
+// ============================================================
+// Recorder
+// ============================================================
+//
+// Why this exists:
+// - Programs used to open VideoWriter at a hardcoded 60 fps; a 30 fps camera
+//   then played back at double speed and video time drifted from the CSV
+// - The recorder is fed every captured frame with its capture timestamp, keeps
+//   measuring the real cadence, and opens the writer at that rate
+// - Output is resampled to a constant rate on capture time: each output slot
+//   takes the frame captured nearest to it, so gaps are filled by duplicates
+//   and bursts are thinned by skipping, and video time tracks wall time
+// - If recording starts before the rate is known, frames are held (by
+//   reference) until the warm-up window is full, then written
+//
+class Recorder
+{
+public:
+    Recorder(const RecorderOptions& options = RecorderOptions(),
+             const WriterOptions& writerOptions = WriterOptions());
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    ~Recorder();
+
+    // Begin a clip. The writer opens as soon as the output rate is known
+    // (immediately with fixedFps or after enough frames). Returns false if it
+    // could not be opened right away.
+    bool start(const std::string& videoPath, int fourcc, cv::Size frameSize, bool isColor);
+
+    // Call for every frame the program sees, recording or not. Frames with a
+    // capture time already seen are ignored. `logSecond` is the motion-log
+    // second this frame is counted in (0 when the sensor isn't running).
+    // Raw YUV frames (`format`) are converted on the encoder thread.
+    void addFrame(const cv::Mat& frame, std::chrono::steady_clock::time_point captureTime, int logSecond = 0,
+                  PixelFormat format = PixelFormat::BGR);
+
+    // Same for a compressed frame (decoded on the encoder thread).
+    void addPacket(const EncodedFrame& packet, std::chrono::steady_clock::time_point captureTime, int logSecond = 0);
+
+    // Start from a rate already measured elsewhere (e.g. a recorder created
+    // on demand for an event clip), so no warm-up is needed.
+    void seedRate(const FrameRateEstimator& measured) { estimator = measured; }
+
+    // Flush and close the current clip.
+    void stop();
+
+    bool isRecording() const { return recording; }
+
+    // False if the writer failed to open after a deferred start.
+    bool ok() const { return !openFailed; }
+
+    RecorderStats stats() const;
+
+private:
+    struct Pending
+    {
+        cv::Mat frame;
+        EncodedFrame packet; // when frame is empty
+        PixelFormat format = PixelFormat::BGR;
+        std::chrono::steady_clock::time_point captureTime{};
+        int  logSecond = 0;
+        bool emitted = false;
+    };
+
+    bool openWriter();
+    void add(Pending p);
+    void resample(const Pending& p);
+    void emit(Pending& p);
+
+    RecorderOptions options;
+    AsyncVideoWriter writer;
+    FrameRateEstimator estimator;
+
+    // Current clip
+    bool recording = false;
+    bool openFailed = false;
+    std::string videoPath;
+    int fourcc = 0;
+    cv::Size frameSize;
+    bool isColor = true;
+
+    double outFps = 0.0;
+    std::chrono::steady_clock::time_point firstSlot{};
+    uint64_t slot = 0;        // next output slot
+    Pending pending;          // latest frame not yet superseded
+    bool havePending = false;
+    std::vector<Pending> warmup; // held until the rate is known
+
+    std::chrono::steady_clock::time_point lastCapture{};
+
+    uint64_t sourceFrames = 0;
+    uint64_t duplicated = 0;
+    uint64_t skipped = 0;
+};
+
+// Index file written next to a video: "Video1.mp4" -> "Video1_frames.csv".
+std::string frameIndexPath(const std::string& videoPath);
+
+// One-line summary for logs.
+std::string formatRecorderStats(const RecorderStats& s);
@@ -0,0 +1,185 @@
+#include "roi_mask.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+// "0.25,0.5" -> point
+bool parsePoint(const string& token, Point2f& p)
+{
+    float x = 0.f, y = 0.f;
+    char extra = 0;
+    if (sscanf(token.c_str(), "%f,%f%c", &x, &y, &extra) != 2) return false;
+    if (x < 0.f || x > 1.f || y < 0.f || y > 1.f) return false;
+    p = Point2f(x, y);
+    return true;
+}
+
+// Columns whose centers lie inside the polygon on row y: even-odd crossings
+// of the line through the row's pixel centers, paired left to right.
+void polygonSpans(const vector<Point2f>& pts, Size plane, int y, vector<float>& xs, vector<RoiMask::Span>& out)
+{
+    out.clear();
+    xs.clear();
+    const float yc = (float)y + 0.5f;
+    const size_t n = pts.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        const Point2f a(pts[i].x * plane.width, pts[i].y * plane.height);
+        const Point2f b(pts[(i + 1) % n].x * plane.width, pts[(i + 1) % n].y * plane.height);
+        if ((a.y <= yc && yc < b.y) || (b.y <= yc && yc < a.y))
+            xs.push_back(a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y));
+    }
+    sort(xs.begin(), xs.end());
+
+    for (size_t i = 0; i + 1 < xs.size(); i += 2)
+    {
+        // Center x + 0.5 in [xs[i], xs[i+1])
+        const int x0 = max(0, (int)ceil(xs[i] - 0.5f));
+        const int x1 = min(plane.width, (int)ceil(xs[i + 1] - 0.5f));
+        if (x1 > x0) out.push_back({x0, x1});
+    }
+}
+} // namespace
+
+bool loadRoiConfig(const string& path, RoiConfig& config, string& error)
+{
+    ifstream in(path);
+    if (!in)
+    {
+        error = "can't read " + path;
+        return false;
+    }
+
+    RoiConfig parsed;
+    string camera; // "" until the first "camera" line
+    string line;
+    int lineNo = 0;
+    while (getline(in, line))
+    {
+        lineNo++;
+        const size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+
+        istringstream words(line);
+        string keyword;
+        if (!(words >> keyword)) continue;
+
+        const string where = path + ":" + to_string(lineNo) + ": ";
+        if (keyword == "camera")
+        {
+            if (!(words >> camera))
+            {
+                error = where + "camera needs a name (Cam1, Cam2, ...)";
+                return false;
+            }
+            continue;
+        }
+        if (keyword != "include" && keyword != "exclude")
+        {
+            error = where + "expected include, exclude or camera, got '" + keyword + "'";
+            return false;
+        }
+
+        RoiPolygon poly;
+        poly.exclude = (keyword == "exclude");
+        string token;
+        while (words >> token)
+        {
+            Point2f p;
+            if (!parsePoint(token, p))
+            {
+                error = where + "'" + token + "' is not an x,y pair between 0 and 1";
+                return false;
+            }
+            poly.points.push_back(p);
+        }
+        if (poly.points.size() < 3)
+        {
+            error = where + "a polygon needs at least 3 corners";
+            return false;
+        }
+        parsed.byCamera[camera].push_back(std::move(poly));
+    }
+
+    config = std::move(parsed);
+    return true;
+}
+
+vector<RoiPolygon> regionsFor(const RoiConfig& config, const string& camera)
+{
+    vector<RoiPolygon> out;
+    for (const string& key : {string(), camera})
+    {
+        auto it = config.byCamera.find(key);
+        if (it != config.byCamera.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+        if (camera.empty()) break;
+    }
+    return out;
+}
+
+// ------------------------------------------------------------
+// RoiMask
+// ------------------------------------------------------------
+RoiMask::RoiMask(const vector<RoiPolygon>& polygons, Size plane) : planeSize(plane)
+{
+    const bool anyInclude = any_of(polygons.begin(), polygons.end(), [](const RoiPolygon& p) { return !p.exclude; });
+
+    rowStart.reserve((size_t)plane.height + 1);
+    activeBefore.reserve((size_t)plane.height + 1);
+    rowStart.push_back(0);
+    activeBefore.push_back(0);
+
+    // Rasterize one row at a time: includes first, then excludes cut them
+    vector<uint8_t> row((size_t)max(0, plane.width));
+    vector<float> xs;
+    vector<Span> polySpans;
+    for (int y = 0; y < plane.height; y++)
+    {
+        fill(row.begin(), row.end(), (uint8_t)(anyInclude ? 0 : 1));
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (const RoiPolygon& p : polygons)
+            {
+                if (p.exclude != (pass == 1)) continue;
+                polygonSpans(p.points, plane, y, xs, polySpans);
+                for (const Span& s : polySpans) fill(row.begin() + s.begin, row.begin() + s.end, (uint8_t)(pass == 0));
+            }
+        }
+
+        // Run-length encode the active columns
+        int active = 0;
+        for (int x = 0; x < plane.width;)
+        {
+            if (!row[x])
+            {
+                x++;
+                continue;
+            }
+            const int begin = x;
+            while (x < plane.width && row[x]) x++;
+            spans.push_back({begin, x});
+            active += x - begin;
+        }
+        rowStart.push_back((int)spans.size());
+        activeBefore.push_back(activeBefore.back() + active);
+    }
+}
+
+void RoiMask::toImage(Mat& dst) const
+{
+    dst.create(planeSize.height, planeSize.width, CV_8UC1);
+    for (int y = 0; y < planeSize.height; y++)
+    {
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        fill(out, out + planeSize.width, (uint8_t)0);
+        for (const Span* s = rowBegin(y); s != rowEnd(y); ++s) fill(out + s->begin, out + s->end, (uint8_t)255);
+    }
+}
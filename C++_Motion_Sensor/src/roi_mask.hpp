@@ -0,0 +1,91 @@
+#pragma once
+
+// Detection regions: polygons from a config file, compiled into per-row spans.
+
+#include <opencv2/core.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// One polygon, corners as fractions of the frame width and height (0..1),
+// so the same file works at any resolution and --decimate.
+struct RoiPolygon
+{
+    bool exclude = false;            // exclude: never detected; include: only these are
+    std::vector<cv::Point2f> points; // 3 or more corners
+};
+
+// --roi file contents. Polygons before any "camera" line apply to every
+// camera, the rest to the camera named above them:
+//
+//     # tree by the gate, and the street
+//     exclude 0.00,0.00 0.30,0.00 0.30,0.45 0.00,0.45
+//     exclude 0,0.8 1,0.8 1,1 0,1
+//     camera Cam2
+//     include 0.1,0.2 0.9,0.2 0.9,0.95 0.1,0.95
+//
+struct RoiConfig
+{
+    std::map<std::string, std::vector<RoiPolygon>> byCamera; // "" = every camera
+
+    bool empty() const { return byCamera.empty(); }
+};
+
+// False with a message (file and line) if the file can't be read or parsed.
+bool loadRoiConfig(const std::string& path, RoiConfig& config, std::string& error);
+
+// Polygons for one camera ("Cam1", ...): the shared ones, then its own.
+std::vector<RoiPolygon> regionsFor(const RoiConfig& config, const std::string& camera);
+
+// ============================================================
+// RoiMask
+// ============================================================
+//
+// Why this exists:
+// - Masking the thresholded image afterwards still converts, diffs and
+//   counts every pixel of a tree or a TV screen
+// - Compiled into runs of active columns per row, the detector hands each run
+//   to the row kernels and never touches an excluded pixel
+// - MOTION_RATIO is then measured against the active pixels, so excluding
+//   half the frame doesn't halve the sensitivity
+//
+// A pixel is active when its center lies inside an include polygon (or there
+// are none) and outside every exclude polygon.
+//
+class RoiMask
+{
+public:
+    struct Span
+    {
+        int begin; // first active column
+        int end;   // one past the last
+    };
+
+    RoiMask() = default;
+
+    // Rasterize the polygons for a plane of this size.
+    RoiMask(const std::vector<RoiPolygon>& polygons, cv::Size plane);
+
+    // Default-constructed: no mask, the whole plane is active.
+    bool empty() const { return rowStart.empty(); }
+    cv::Size size() const { return planeSize; }
+
+    int activePixels() const { return activeBefore.empty() ? 0 : activeBefore.back(); }
+
+    // Active pixels in rows [0, y).
+    int activeRowsBefore(int y) const { return activeBefore[y]; }
+
+    // Spans of row y, left to right.
+    const Span* rowBegin(int y) const { return spans.data() + rowStart[y]; }
+    const Span* rowEnd(int y) const { return spans.data() + rowStart[y + 1]; }
+
+    // 255 where active, 0 elsewhere (CV_8UC1), e.g. to check a mask file.
+    void toImage(cv::Mat& dst) const;
+
+private:
+    cv::Size planeSize;
+    std::vector<Span> spans;
+    std::vector<int> rowStart;     // rows + 1 offsets into spans
+    std::vector<int> activeBefore; // rows + 1 prefix counts
+};
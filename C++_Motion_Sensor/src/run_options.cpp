@@ -0,0 +1,354 @@
+#include "run_options.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+// "--name=value" -> value, if arg starts with "--name="
+bool valueOf(const string& arg, const string& name, string& value)
+{
+    const string prefix = name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+int toInt(const string& s, int fallback)
+{
+    try { return stoi(s); } catch (...) { return fallback; }
+}
+
+double toDouble(const string& s, double fallback)
+{
+    try { return stod(s); } catch (...) { return fallback; }
+}
+
+// "0,file:a.mp4" -> {"0", "file:a.mp4"}; false if any entry is empty
+bool toSpecList(const string& s, vector<string>& out)
+{
+    vector<string> list;
+    size_t pos = 0;
+    while (pos <= s.size())
+    {
+        size_t comma = s.find(',', pos);
+        if (comma == string::npos) comma = s.size();
+        if (comma == pos) return false;
+        list.push_back(s.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    out = list;
+    return true;
+}
+} // namespace
+
+RunOptions parseRunOptions(int argc, char** argv)
+{
+    RunOptions opt;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const string arg = argv[i];
+        string value;
+
+        if (arg == "-h" || arg == "--help")
+        {
+            opt.showHelp = true;
+        }
+        else if (arg == "--decision-mode")
+        {
+            opt.detector.decisionMode = true;
+        }
+        else if (valueOf(arg, "--tile-rows", value))
+        {
+            opt.detector.tileRows = max(1, toInt(value, opt.detector.tileRows));
+        }
+        else if (valueOf(arg, "--decimate", value))
+        {
+            int n = toInt(value, 1);
+            if (n == 1 || n == 2 || n == 4 || n == 8)
+                opt.detector.decimation = n;
+            else
+                cerr << "--decimate must be 1, 2, 4 or 8; keeping full resolution\n";
+        }
+        else if (arg == "--background")
+        {
+            opt.detector.background = true;
+        }
+        else if (valueOf(arg, "--learning-rate", value))
+        {
+            double rate = toDouble(value, -1.0);
+            if (rate > 0.0 && rate < 1.0)
+                opt.detector.learningRate = max(0.001, min(0.5, rate));
+            else
+                cerr << "--learning-rate must be between 0 and 1; keeping " << opt.detector.learningRate << "\n";
+        }
+        else if (valueOf(arg, "--background-state", value))
+        {
+            opt.detector.backgroundStateDir = value;
+        }
+        else if (valueOf(arg, "--roi", value))
+        {
+            opt.detector.roiFile = value;
+        }
+        else if (valueOf(arg, "--heatmap", value))
+        {
+            int cols = 0, rows = 0;
+            char extra = 0;
+            if (sscanf(value.c_str(), "%dx%d%c", &cols, &rows, &extra) == 2 && cols >= 1 && rows >= 1 &&
+                cols <= 64 && rows <= 64)
+            {
+                opt.detector.heatmapCols = cols;
+                opt.detector.heatmapRows = rows;
+            }
+            else
+                cerr << "--heatmap must be COLSxROWS between 1x1 and 64x64 (e.g. 16x12); heatmap off\n";
+        }
+        else if (arg == "--blobs")
+        {
+            opt.detector.blobs = true;
+        }
+        else if (valueOf(arg, "--blob-cell", value))
+        {
+            int n = toInt(value, 0);
+            if (n == 8 || n == 16)
+                opt.detector.blobCell = n;
+            else
+                cerr << "--blob-cell must be 8 or 16; keeping " << opt.detector.blobCell << "\n";
+        }
+        else if (arg == "--ratio-stats")
+        {
+            opt.detector.ratioStats = true;
+        }
+        else if (arg == "--motion-vectors")
+        {
+            opt.detector.vectors = true;
+        }
+        else if (valueOf(arg, "--vector-range", value))
+        {
+            int n = toInt(value, 0);
+            if (n >= 1 && n <= 32)
+                opt.detector.vectorRange = n;
+            else
+                cerr << "--vector-range must be 1 .. 32; keeping " << opt.detector.vectorRange << "\n";
+        }
+        else if (arg == "--lighting")
+        {
+            opt.detector.lighting = true;
+        }
+        else if (arg == "--motion-events")
+        {
+            opt.motionEvents.enabled = true;
+        }
+        else if (valueOf(arg, "--event-start", value))
+        {
+            opt.motionEvents.startFrames = max(1, toInt(value, opt.motionEvents.startFrames));
+        }
+        else if (valueOf(arg, "--event-end", value))
+        {
+            opt.motionEvents.endSec = max(0.0, toDouble(value, opt.motionEvents.endSec));
+        }
+        else if (valueOf(arg, "--event-keep", value))
+        {
+            opt.motionEvents.keepFraction = max(0.0, min(1.0, toDouble(value, opt.motionEvents.keepFraction)));
+        }
+        else if (valueOf(arg, "--detect-threads", value))
+        {
+            opt.detector.threads = max(0, toInt(value, opt.detector.threads));
+        }
+        else if (valueOf(arg, "--record-queue", value))
+        {
+            opt.writer.queueCapacity = max(1, toInt(value, opt.writer.queueCapacity));
+        }
+        else if (valueOf(arg, "--record-overflow", value))
+        {
+            if (value == "block")            opt.writer.overflow = OverflowPolicy::Block;
+            else if (value == "drop-oldest") opt.writer.overflow = OverflowPolicy::DropOldest;
+            else if (value == "drop-newest") opt.writer.overflow = OverflowPolicy::DropNewest;
+            else cerr << "--record-overflow must be block, drop-oldest or drop-newest; keeping block\n";
+        }
+        else if (valueOf(arg, "--record-fps", value))
+        {
+            double fps = toDouble(value, 0.0);
+            if (fps >= 0.0) opt.recorder.fixedFps = fps;
+        }
+        else if (valueOf(arg, "--fps-warmup", value))
+        {
+            opt.recorder.warmupSec = max(0.1, toDouble(value, opt.recorder.warmupSec));
+        }
+        else if (arg == "--no-frame-index")
+        {
+            opt.recorder.writeIndex = false;
+        }
+        else if (arg == "--segments")
+        {
+            opt.events.segments = true;
+        }
+        else if (valueOf(arg, "--preroll", value))
+        {
+            opt.events.preRollSec = max(0.0, toDouble(value, 0.0));
+        }
+        else if (valueOf(arg, "--postroll", value))
+        {
+            opt.events.postRollSec = max(0.0, toDouble(value, opt.events.postRollSec));
+        }
+        else if (valueOf(arg, "--preroll-mb", value))
+        {
+            opt.events.memoryCapMB = max(1, toInt(value, opt.events.memoryCapMB));
+        }
+        else if (valueOf(arg, "--preroll-quality", value))
+        {
+            opt.events.jpegQuality = max(1, min(100, toInt(value, opt.events.jpegQuality)));
+        }
+        else if (arg == "--headless")
+        {
+            opt.display.headless = true;
+        }
+        else if (valueOf(arg, "--preview-fps", value))
+        {
+            opt.display.previewFps = max(0.0, toDouble(value, 0.0));
+        }
+        else if (valueOf(arg, "--control-fifo", value))
+        {
+            opt.control.fifoPath = value;
+        }
+        else if (valueOf(arg, "--control-socket", value))
+        {
+            opt.control.socketPath = value;
+        }
+        else if (valueOf(arg, "--cameras", value))
+        {
+            if (!toSpecList(value, opt.sources.specs))
+                cerr << "--cameras must be a comma-separated list of sources; keeping the default\n";
+        }
+        else if (arg == "--fast-sources")
+        {
+            opt.sources.fast = true;
+        }
+        else if (arg == "--sync-capture")
+        {
+            opt.engine.syncCapture = true;
+        }
+        else if (valueOf(arg, "--sync-tolerance", value))
+        {
+            opt.engine.syncToleranceMs = max(0.0, toDouble(value, opt.engine.syncToleranceMs));
+        }
+        else if (arg == "--mjpeg-passthrough")
+        {
+            opt.sources.mjpegPassthrough = true;
+            opt.writer.passthrough = true;
+        }
+        else if (valueOf(arg, "--capture-format", value))
+        {
+            if (!parsePixelFormat(value, opt.sources.captureFormat))
+                cerr << "--capture-format must be bgr, yuyv or nv12; keeping bgr\n";
+        }
+        else if (valueOf(arg, "--threads", value))
+        {
+            opt.engine.threads = max(0, toInt(value, opt.engine.threads));
+        }
+        else
+        {
+            cerr << "Ignoring unknown option: " << arg << "\n";
+        }
+    }
+
+    if (!opt.detector.backgroundStateDir.empty() && !opt.detector.background)
+        cerr << "--background-state only applies with --background; no models will be saved\n";
+    if (opt.detector.heatmapCols > 0 && opt.detector.decisionMode)
+        cerr << "--heatmap with --decision-mode: cells only count the rows each shortened pass looked at\n";
+    if (opt.detector.threads != 1 && opt.detector.decisionMode)
+        cerr << "--detect-threads with --decision-mode: decision passes stay serial\n";
+    if (opt.detector.vectors && opt.detector.decisionMode)
+    {
+        cerr << "--motion-vectors needs every frame's full pass; ignored with --decision-mode\n";
+        opt.detector.vectors = false;
+    }
+    if (opt.motionEvents.enabled && opt.detector.decisionMode)
+    {
+        // Latched frames report motion without a look, shortened passes only a lower bound
+        cerr << "--motion-events needs every frame's full answer; ignored with --decision-mode\n";
+        opt.motionEvents.enabled = false;
+    }
+
+    return opt;
+}
+
+void printRunOptionsHelp(const string& programName)
+{
+    cout << "Usage: " << programName << " [options]\n"
+         << "  --decision-mode     stop differencing once the per-second answer is known\n"
+         << "  --tile-rows=N       rows per tile in decision mode (default 16)\n"
+         << "  --decimate=N        detect on a 1/N box-filtered luma plane (1, 2, 4, 8)\n"
+         << "  --background        compare frames against a running-average background instead of the previous frame\n"
+         << "  --learning-rate=X   fraction of each frame blended into the background (default 0.02, 0.001 .. 0.5)\n"
+         << "  --background-state=DIR\n"
+         << "                      with --background: load each camera's model from DIR at start, save it at exit\n"
+         << "  --roi=FILE          detect only inside the include / outside the exclude polygons in FILE\n"
+         << "  --heatmap=CxR       also log changed pixels per tile of a C x R grid, per second, to <log>_heatmap.csv\n"
+         << "  --blobs             also log each frame's motion regions (box, area, centroid) to <log>_blobs.csv\n"
+         << "  --blob-cell=N       blob grid cell in detection-plane pixels, 8 or 16 (default 8)\n"
+         << "  --ratio-stats       also log per-second ratio statistics (frames, motion frames, mean, max, p95) to\n"
+         << "                      <log>_stats.csv\n"
+         << "  --motion-vectors    also log each second's dominant direction and speed of motion (block matching on\n"
+         << "                      the blob cells) to <log>_flow.csv\n"
+         << "  --vector-range=N    motion vector search range in detection-plane pixels, 1 .. 32 (default 8)\n"
+         << "  --lighting          compensate brightness changes; log frames that were only lighting (Lighting column)\n"
+         << "  --motion-events     log each motion start / end with its frame's capture time to <log>_events.csv\n"
+         << "  --event-start=N     motion frames in a row before an event starts (default 3)\n"
+         << "  --event-end=S       seconds without a moving frame before it ends (default 1)\n"
+         << "  --event-keep=X      while an event runs, a frame at X times the motion ratio keeps it going\n"
+         << "                      (default 0.5)\n"
+         << "  --detect-threads=N  split each frame's rows into bands on N threads per camera (default 1, 0 = one per\n"
+         << "                      core); the threaded program caps N at the cores divided among the cameras\n"
+         << "  --record-queue=N    frames that may wait for the encoder thread (default 8)\n"
+         << "  --record-overflow=P block | drop-oldest | drop-newest when that queue is full (default block)\n"
+         << "  --record-fps=X      write videos at X fps instead of the measured camera rate\n"
+         << "  --fps-warmup=S      seconds of capture needed before the camera rate is trusted (default 1)\n"
+         << "  --no-frame-index    don't write the <video>_frames.csv capture-time index\n"
+         << "  --segments          record one clip per motion event instead of one video per run\n"
+         << "  --preroll=S         keep S seconds before motion and write event clips (default 0 = off)\n"
+         << "  --postroll=S        hold-off: keep an event clip running S seconds after the last motion (default 5)\n"
+         << "  --preroll-mb=N      memory cap for the pre-roll buffer per camera (default 64)\n"
+         << "  --preroll-quality=Q JPEG quality of buffered pre-roll frames (default 85)\n"
+         << "  --headless          no windows; control with signals, --control-fifo or --control-socket\n"
+         << "  --preview-fps=N     refresh the live windows (and read keys) N times per second (default: every frame)\n"
+         << "  --control-fifo=P    read record / motion / stop commands from named pipe P\n"
+         << "  --control-socket=P  accept record / motion / stop commands on Unix socket P\n"
+         << "  --cameras=LIST      sources, comma-separated: camera index, file:PATH, images:DIR|PATTERN[@FPS],\n"
+         << "                      synthetic[:WxH][@FPS] (default 0,1; Program 1 uses the first, Program 2 the first two)\n"
+         << "  --fast-sources      read files, images and synthetic scenes as fast as possible, not at their frame rate\n"
+         << "  --threads=N         worker threads for per-camera work in the threaded program (default: one per core)\n"
+         << "  --sync-capture      threaded program: grab all cameras together before decoding\n"
+         << "  --sync-tolerance=MS threaded program: max capture-time skew of a paired frame set (default 10)\n"
+         << "  --mjpeg-passthrough threaded program: keep camera JPEGs, mux them into .avi files without re-encoding\n"
+         << "                      and decode only the luma plane detection needs (at the --decimate scale)\n"
+         << "  --capture-format=F  threaded program: bgr | yuyv | nv12; with yuyv / nv12 cameras deliver raw YUV,\n"
+         << "                      detection reads the Y plane and only recording / preview convert to BGR\n"
+         << "  -h, --help          show this help\n";
+}
+
+std::filesystem::path sideLogPath(const std::filesystem::path& dataPath, const string& suffix)
+{
+    std::filesystem::path p = dataPath;
+    p.replace_extension();
+    p += suffix + ".csv";
+    return p;
+}
+
+ofstream openSideCsv(const std::filesystem::path& dataPath, const string& suffix, const string& header)
+{
+    const std::filesystem::path path = sideLogPath(dataPath, suffix);
+    ofstream out(path.string(), ios::out);
+    if (!out.is_open())
+    {
+        cerr << "Could not open " << path.string() << " for write\n";
+        return out;
+    }
+    out << header << "\n";
+    return out;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// Command-line switches shared by the motion sensor programs.
+//
+// Every switch defaults to the original behavior, except the recording rate:
+// videos are now written at the camera's measured frame rate rather than a
+// fixed 60 fps (--record-fps=60 brings the old rate back).
+
+#include "async_video_writer.hpp"
+#include "control.hpp"
+#include "display.hpp"
+#include "event_recorder.hpp"
+#include "frame_source.hpp"
+#include "motion_detector.hpp"
+#include "motion_engine.hpp"
+#include "motion_events.hpp"
+#include "recorder.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+struct RunOptions
+{
+    DetectorOptions detector;
+    WriterOptions   writer;
+    RecorderOptions recorder;
+    EventOptions    events;
+    MotionEventOptions motionEvents;
+    DisplayOptions  display;
+    ControlOptions  control;
+    EngineOptions   engine;
+    SourceOptions   sources;
+
+    bool showHelp = false;
+};
+
+// Parses argv. Unknown switches are reported on stderr and ignored.
+RunOptions parseRunOptions(int argc, char** argv);
+
+// One line per switch, for --help.
+void printRunOptionsHelp(const std::string& programName);
+
+// Side file of a motion log: Data3.csv + "_heatmap" -> Data3_heatmap.csv.
+std::filesystem::path sideLogPath(const std::filesystem::path& dataPath, const std::string& suffix);
+
+// Opens the side CSV of dataPath and writes its header row. On failure the
+// error is reported on stderr and the stream is returned closed.
+std::ofstream openSideCsv(const std::filesystem::path& dataPath, const std::string& suffix,
+                          const std::string& header);
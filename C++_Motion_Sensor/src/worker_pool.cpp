@@ -0,0 +1,80 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+WorkerPool::WorkerPool(int threads)
+{
+    if (threads <= 0) threads = (int)max(1u, thread::hardware_concurrency());
+
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(&WorkerPool::loop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> lock(m);
+        quit = true;
+    }
+    wake.notify_all();
+    for (thread& t : workers) t.join();
+}
+
+void WorkerPool::parallelFor(size_t n, const function<void(size_t)>& fn)
+{
+    if (n == 0) return;
+
+    // Nothing to share: skip the hand-off entirely.
+    if (n == 1 || workers.empty())
+    {
+        for (size_t i = 0; i < n; i++) fn(i);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(m);
+        job = &fn;
+        count = n;
+        next = 0;
+        finished = 0;
+        generation++;
+    }
+    wake.notify_all();
+
+    runItems();
+
+    // Every worker checks in, so none still holds `fn` once we return.
+    unique_lock<mutex> lock(m);
+    done.wait(lock, [&] { return finished == workers.size(); });
+    job = nullptr;
+}
+
+void WorkerPool::runItems()
+{
+    for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        (*job)(i);
+}
+
+void WorkerPool::loop()
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(m);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+
+        runItems();
+
+        {
+            lock_guard<mutex> lock(m);
+            finished++;
+        }
+        done.notify_one();
+    }
+}
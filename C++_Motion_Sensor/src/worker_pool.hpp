@@ -0,0 +1,58 @@
+#pragma once
+
+// Fixed-size fork/join thread pool for per-frame work.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================
+// WorkerPool
+// ============================================================
+//
+// Why this exists:
+// - Per-camera work (detection, recorder hand-off) used to run serially on
+//   the main thread, one hand-written block per camera
+// - Spawning a thread per camera per stage doesn't scale to 4-8 cameras on
+//   a box with fewer cores; a fixed pool sized to the core count does
+// - parallelFor() hands out item indexes to the workers and the calling
+//   thread, and returns once every item is done (no per-call allocation)
+//
+class WorkerPool
+{
+public:
+    // `threads` counts the calling thread; 0 = one per hardware thread.
+    explicit WorkerPool(int threads = 0);
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool();
+
+    int size() const { return (int)workers.size() + 1; }
+
+    // Runs fn(0) .. fn(count - 1), spread over the pool. Blocks until done.
+    // fn must not call parallelFor() on the same pool.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void loop();
+    void runItems();
+
+    std::vector<std::thread> workers;
+
+    std::mutex m;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    uint64_t generation = 0; // bumped per parallelFor()
+    size_t finished = 0;     // workers done with the current generation
+    bool quit = false;
+};